@@ -2,7 +2,10 @@
   "targets": [
     {
       "target_name": "bti_addon",
-      "sources": [ "src/addon.cpp" ],
+      "sources": [ "src/addon.cpp", "src/trace_events.cpp", "src/native_log.cpp", "src/device_session.cpp",
+                   "src/shared_memory.cpp", "src/capture_client.cpp", "src/shm_publisher.cpp", "src/value_table.cpp", "src/subscriber_bus.cpp", "src/change_tracker.cpp",
+                   "src/dio_monitor.cpp", "src/error_aggregator.cpp", "src/receiver_profile.cpp", "src/capture_file.cpp",
+                   "src/capture_export.cpp", "src/label_decoder.cpp", "src/derived_params.cpp", "src/alarm_engine.cpp", "src/downsample.cpp", "src/history_store.cpp" ],
       "include_dirs": [
         "vendor/include",
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -30,6 +33,28 @@
           }
         }]
       ]
+    },
+    {
+      "target_name": "bti_capture_daemon",
+      "type": "executable",
+      "sources": [ "src/capture_daemon.cpp", "src/device_session.cpp", "src/dio_monitor.cpp", "src/error_aggregator.cpp", "src/receiver_profile.cpp", "src/shm_publisher.cpp",
+                   "src/shared_memory.cpp", "src/native_log.cpp", "src/trace_events.cpp", "src/label_decoder.cpp", "src/alarm_engine.cpp" ],
+      "include_dirs": [
+        "vendor/include"
+      ],
+      "conditions": [
+        ['OS=="win"', {
+          "libraries": [
+            "-l../vendor/lib/win-x64/BTI42964.LIB",
+            "-l../vendor/lib/win-x64/BTICARD64.LIB"
+          ],
+          "msvs_settings": {
+            "VCCLCompilerTool": {
+              "ExceptionHandling": 1
+            }
+          }
+        }]
+      ]
     }
   ]
-} 
\ No newline at end of file
+}
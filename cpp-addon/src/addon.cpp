@@ -1,6 +1,22 @@
 #include "BTICARD.H" // Include the vendor header (Path relative to include_dirs)
 #include "BTI429.H" // Added BTI429 Header - Verify Name!
 #include "bti_constants.h" // Added constants header
+#include "monitor_stats.h" // Lock-free pipeline counters
+#include "device_session.h" // Per-core sessions and the merged stream
+#include "capture_client.h" // Client of the out-of-process capture daemon
+#include "value_table.h" // Shared-memory current-value table for other local processes
+#include "subscriber_bus.h" // Fan-out of the ingest stream to independent subscribers
+#include "change_tracker.h" // Pull-mode changed-entry snapshots (getChangesSince)
+#include "capture_file.h" // Block-compressed capture recording and decoding
+#include "capture_export.h" // Columnar export of capture files
+#include "label_decoder.h" // BNR/BCD/discrete decoding of label values
+#include "derived_params.h" // Expressions over labels evaluated at ingest
+#include "downsample.h" // Min/max and LTTB reduction of a label's series for plotting
+#include "history_store.h" // Bounded per-label history rings
+#include "dio_monitor.h" // Native discrete edge monitoring
+#include "error_aggregator.h" // Reader-side error counters and notices
+#include "trace_events.h" // Opt-in Chrome trace-event recording
+#include "native_log.h" // Asynchronous rate-limited logging (BTI_LOG_*)
 
 // Then include standard and N-API headers
 #include <napi.h>
@@ -14,86 +30,182 @@
 #include <atomic>           // For monitoringActive flag
 #include <mutex>            // Potentially needed for data structures if accessed outside monitor thread
 #include <condition_variable> // Potentially needed for signaling thread
+#include <fstream>          // For writing trace files
+#include <cstring>          // For _stricmp
+
+// --- Per-Environment Addon State ---
+// One instance per JS environment that loads the addon (the main thread and each worker_thread), stored
+// with SetInstanceData and freed when that environment shuts down. Per-core state (handles, lists, reader
+// threads, transmit) is process-wide and lives in the DeviceSession registry.
+struct AddonData {
+    // ThreadSafeFunctions for callbacks to JavaScript
+    Napi::ThreadSafeFunction tsfnDataUpdate = nullptr;
+    Napi::ThreadSafeFunction tsfnErrorUpdate = nullptr;
+    Napi::ThreadSafeFunction tsfnLog = nullptr; // Optional JS log hook; only used by the log drain thread via JsLogSink
+    Napi::ThreadSafeFunction tsfnEvents = nullptr; // Optional JS event log hook (setEventHandler); used by the reader threads
+    Napi::ThreadSafeFunction tsfnAlarms = nullptr; // Optional JS alarm hook (setAlarmHandler); used by the reader threads
+    DeliveryStats deliveryStats; // Merge/delivery instrumentation, read by getMonitorStats()
+    // Batch sequence numbers for trace flow events; the TSFN queue is FIFO so queue order == callback order
+    std::atomic<uint64_t> traceBatchQueuedSeq{0};
+    std::atomic<uint64_t> traceBatchDeliveredSeq{0};
+    std::map<int, struct Subscription*> subscriptions; // Bus subscriptions created by this environment (JS thread only)
+    uint32_t streamChannelMask = 0; // Channels the stream callbacks need polled promptly (0 = all); see setStreamChannels
+    std::map<HCORE, struct DioWatch*> dioWatches; // DIO monitors started by this environment (JS thread only)
+};
+
+// --- Process-Wide Environment Bookkeeping ---
+// The merged ARINC stream is delivered to one environment at a time: the one whose initializeReceiver
+// installed the callbacks. It keeps the stream until it stops monitoring, cleans up or shuts down.
+std::mutex g_envMutex;               // Guards g_streamOwner and g_envCount
+AddonData* g_streamOwner = nullptr;
+int g_envCount = 0;                  // Loaded environments; the last one to shut down closes the hardware
 
-// --- Define Constants ---
-const int ARINC_CHANNEL_COUNT = 8;
-
-// --- Define Custom Error Codes (Negative to avoid BTI conflicts) ---
-const int ERR_HWINIT = -1001; // Custom: Hardware not initialized
-const int ERR_PARAM = -1002; // Custom: Invalid parameter passed
-const int ERR_BUSY = -1003;  // Custom: Resource/channel already busy
-const int ERR_INFO = 0; // Placeholder if info is treated like success
-
-// --- Global State for ARINC Monitoring ---
-std::atomic<bool> monitoringActive(false);
-std::thread monitorThread;
-std::mutex dataMutex; // Mutex for protecting shared data structures if needed
-HCARD hCardGlobal = nullptr;
-HCORE hCoreGlobal = nullptr;
-std::vector<LISTADDR> receiveListAddrs(ARINC_CHANNEL_COUNT, 0); // Store List Addrs per channel
-std::map<int, std::map<int, ULONG>> latestWords; // channel -> label -> word
-std::map<int, std::map<int, std::chrono::steady_clock::time_point>> lastUpdateTimes; // channel -> label -> timestamp
-
-// --- Global State for ARINC Transmission ---
-std::map<int, bool> g_isTransmitting; // Map channel number to transmission status
-std::map<int, MSGADDR> g_transmitMsgAddr; // Store MSGADDR for active transmit channels
-std::map<int, LISTADDR> g_transmitListAddr; // Store LISTADDR for active transmit channels
-std::mutex g_transmitMutex; // Mutex for transmit state
-
-// ThreadSafeFunctions for callbacks to JavaScript
-Napi::ThreadSafeFunction tsfnDataUpdate = nullptr;
-Napi::ThreadSafeFunction tsfnErrorUpdate = nullptr;
+AddonData* GetAddonData(Napi::Env env) {
+    return env.GetInstanceData<AddonData>();
+}
 
 // --- Forward Declarations ---
-void MonitorLoop();
-long long steady_clock_to_epoch_ms(const std::chrono::steady_clock::time_point& tp);
 // Forward declarations for receiver control wrappers
 Napi::Value InitializeHardwareWrapped(const Napi::CallbackInfo& info);
 Napi::Value InitializeReceiverWrapped(const Napi::CallbackInfo& info);
 Napi::Value StartMonitoringWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetStreamChannelsWrapped(const Napi::CallbackInfo& info);
 Napi::Value StopMonitoringWrapped(const Napi::CallbackInfo& info);
 Napi::Value CleanupHardwareWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetMonitorStatsWrapped(const Napi::CallbackInfo& info);
+Napi::Value ListSessionsWrapped(const Napi::CallbackInfo& info);
+Napi::Value AttachCaptureDaemonWrapped(const Napi::CallbackInfo& info);
+Napi::Value DetachCaptureDaemonWrapped(const Napi::CallbackInfo& info);
+Napi::Value StopCaptureDaemonWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetCaptureDaemonStatusWrapped(const Napi::CallbackInfo& info);
+Napi::Value StartValuePublisherWrapped(const Napi::CallbackInfo& info);
+Napi::Value StopValuePublisherWrapped(const Napi::CallbackInfo& info);
+Napi::Value SubscribeWrapped(const Napi::CallbackInfo& info);
+Napi::Value UnsubscribeWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetSubscriptionsWrapped(const Napi::CallbackInfo& info);
+Napi::Value StartCaptureRecordingWrapped(const Napi::CallbackInfo& info);
+Napi::Value StopCaptureRecordingWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetCaptureRecordingStatsWrapped(const Napi::CallbackInfo& info);
+Napi::Value ReadCaptureFileWrapped(const Napi::CallbackInfo& info);
+Napi::Value ExportCaptureColumnarWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetChangesSinceWrapped(const Napi::CallbackInfo& info);
+Napi::Value DownsampleCaptureFileWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetHistoryWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetHistoryWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetHistoryStatsWrapped(const Napi::CallbackInfo& info);
+Napi::Value DownsampleHistoryWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetDerivedParametersWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetDerivedValuesWrapped(const Napi::CallbackInfo& info);
+Napi::Value StartDioMonitorWrapped(const Napi::CallbackInfo& info);
+Napi::Value StopDioMonitorWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetDioStateWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetDioPulseStatsWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetEventHandlerWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetErrorCountersWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetAdaptiveListsWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetChangeOnlyWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetChangeOnlyStatsWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetSnapshotIntervalWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetSnapshotWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetAlarmRulesWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetActiveAlarmsWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetAlarmHandlerWrapped(const Napi::CallbackInfo& info);
+Napi::Value PrepareReceiversWrapped(const Napi::CallbackInfo& info);
+Napi::Value ApplyReceiverConfigWrapped(const Napi::CallbackInfo& info);
+Napi::Value StartTracingWrapped(const Napi::CallbackInfo& info);
+Napi::Value StopTracingWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetLogHandlerWrapped(const Napi::CallbackInfo& info);
+Napi::Value SetLogLevelWrapped(const Napi::CallbackInfo& info);
+Napi::Value GetLogStatsWrapped(const Napi::CallbackInfo& info);
 // Add forward declarations for the transmit wrappers
 Napi::Value StartTransmitWrapped(const Napi::CallbackInfo& info);
 Napi::Value StopTransmitWrapped(const Napi::CallbackInfo& info);
+// Helpers used by cleanupHardware before their section
+void RemoveDioWatch(AddonData* addon, HCORE hCore);
 // Forward declaration for Init
 Napi::Object Init(Napi::Env env, Napi::Object exports);
 
-// Helper structure for passing data to JS callbacks
-struct ArincUpdateData {
-    int channel;
-    int label;
-    ULONG word;
-    long long timestamp_ms; // Use epoch ms
-};
-
-struct ArincErrorData {
-    int channel = -1; // Use -1 or similar for global errors
-    int status_code;
-    std::string message;
-};
-
 // Callback wrappers for ThreadSafeFunction
-void CallJsDataUpdate(Napi::Env env, Napi::Function jsCallback, std::vector<ArincUpdateData>* updates) {
-    if (!updates) return;
-
-    Napi::Array jsArray = Napi::Array::New(env, updates->size());
-    for (size_t i = 0; i < updates->size(); ++i) {
-        const auto& update = (*updates)[i];
+// Data records as handed to JS data callbacks (initializeReceiver and bus subscribers)
+Napi::Array UpdatesToArray(Napi::Env env, const std::vector<ArincUpdateData>& updates) {
+    Napi::Array jsArray = Napi::Array::New(env, updates.size());
+    for (size_t i = 0; i < updates.size(); ++i) {
+        const auto& update = updates[i];
         Napi::Object obj = Napi::Object::New(env);
+        if (IsDerivedValue(update)) {
+            // Derived parameter: id indexes the names returned by setDerivedParameters; value is float precision
+            float value = 0.0f;
+            uint32_t bits = (uint32_t)update.word;
+            std::memcpy(&value, &bits, sizeof(value));
+            obj.Set("derived", Napi::Boolean::New(env, true));
+            obj.Set("id", Napi::Number::New(env, (update.channel << 8) | update.label));
+            obj.Set("value", Napi::Number::New(env, value));
+            obj.Set("timestamp", Napi::Number::New(env, (double)update.timestamp_ms));
+            jsArray.Set(i, obj);
+            continue;
+        }
+        if (IsDioEdge(update)) {
+            // Recorded discrete edge (startDioMonitor with recordEdges); hwTime holds the timer's low 31 bits
+            obj.Set("dioEdge", Napi::Boolean::New(env, true));
+            obj.Set("dionum", Napi::Number::New(env, update.label));
+            obj.Set("rising", Napi::Boolean::New(env, (update.word & 0x80000000u) != 0));
+            obj.Set("hwTime", Napi::Number::New(env, update.word & 0x7FFFFFFFu));
+            obj.Set("timestamp", Napi::Number::New(env, (double)update.timestamp_ms));
+            obj.Set("card", Napi::Number::New(env, update.card));
+            obj.Set("core", Napi::Number::New(env, update.core));
+            jsArray.Set(i, obj);
+            continue;
+        }
         obj.Set("channel", Napi::Number::New(env, update.channel));
-        obj.Set("label", Napi::Number::New(env, update.label));
-        obj.Set("word", Napi::Number::New(env, update.word));
+        if (IsGapMarker(update)) {
+            // Words lost on this channel since its previous gap (receive list overflow); no label or value
+            obj.Set("gap", Napi::Boolean::New(env, true));
+            obj.Set("lostWords", Napi::Number::New(env, update.word));
+        } else {
+            obj.Set("label", Napi::Number::New(env, update.label));
+            obj.Set("word", Napi::Number::New(env, update.word));
+        }
         obj.Set("timestamp", Napi::Number::New(env, (double)update.timestamp_ms)); // Pass timestamp as number
+        obj.Set("card", Napi::Number::New(env, update.card));
+        obj.Set("core", Napi::Number::New(env, update.core));
         jsArray.Set(i, obj);
     }
+    return jsArray;
+}
+
+void CallJsDataUpdate(Napi::Env env, Napi::Function jsCallback, AddonData* addon, std::vector<ArincUpdateData>* updates) {
+    if (!updates) return;
+    addon->deliveryStats.tsfnQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+    uint64_t batchSeq = addon->traceBatchDeliveredSeq.fetch_add(1, std::memory_order_relaxed);
+
+    // env is null when the TSFN was aborted with this batch still queued
+    if (env == nullptr || jsCallback.IsEmpty()) {
+        StatsAdd(addon->deliveryStats.wordsDropped, updates->size());
+        delete updates;
+        return;
+    }
+    StatsAdd(addon->deliveryStats.batchesDelivered);
+    StatsAdd(addon->deliveryStats.wordsDelivered, updates->size());
 
-    jsCallback.Call({jsArray});
+    static thread_local bool traceThreadNamed = false;
+    if (!traceThreadNamed) {
+        TraceSetThreadName("JS env"); // Main thread or a worker_thread, whichever owns the stream
+        traceThreadNamed = true;
+    }
+    TRACE_FLOW("ArincBatch", 'f', batchSeq, TraceNowNs());
+    TRACE_SCOPE_ARG("CallJsDataUpdate", "words", updates->size());
+
+    jsCallback.Call({UpdatesToArray(env, *updates)});
     delete updates; // Clean up the heap-allocated vector
 }
 
 void CallJsErrorUpdate(Napi::Env env, Napi::Function jsCallback, ArincErrorData* errorData) {
     if (!errorData) return;
+    // env is null when the TSFN was aborted with this notice still queued
+    if (env == nullptr || jsCallback.IsEmpty()) {
+        delete errorData;
+        return;
+    }
 
     Napi::Object obj = Napi::Object::New(env);
     if (errorData->channel >= 0) { // Check if it's a channel-specific error
@@ -111,22 +223,22 @@ void CallJsErrorUpdate(Napi::Env env, Napi::Function jsCallback, ArincErrorData*
     obj.Set("status", Napi::String::New(env, statusStr));
     obj.Set("message", Napi::String::New(env, errorData->message));
     obj.Set("code", Napi::Number::New(env, errorData->status_code)); // Include the raw code
+    if (errorData->card >= 0) { // Errors raised by a session carry its card/core
+        obj.Set("card", Napi::Number::New(env, errorData->card));
+        obj.Set("core", Napi::Number::New(env, errorData->core));
+    }
+    // Session errors are aggregated: one notice when a channel/code starts failing, summaries while it keeps failing
+    const char* notice = "single";
+    if (errorData->notice == ErrorNotice::Raised) notice = "raised";
+    else if (errorData->notice == ErrorNotice::Summary) notice = "summary";
+    else if (errorData->notice == ErrorNotice::Cleared) notice = "cleared";
+    obj.Set("notice", Napi::String::New(env, notice));
+    obj.Set("count", Napi::Number::New(env, (double)errorData->count));
 
     jsCallback.Call({obj});
     delete errorData; // Clean up the heap-allocated data
 }
 
-// --- Timestamp Helper ---
-long long steady_clock_to_epoch_ms(const std::chrono::steady_clock::time_point& tp) {
-    // This conversion assumes steady_clock's epoch is reasonably close to system_clock's epoch
-    // or that the difference is consistent. A more robust solution might calibrate at startup.
-    auto duration = tp.time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-    // A potentially more accurate way (if needed and C++20 available):
-    // return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() +
-    //        std::chrono::duration_cast<std::chrono::milliseconds>(tp - std::chrono::steady_clock::now()).count();
-}
-
 // --- Async Worker for ListDataRd ---
 class ListDataRdWorker : public Napi::AsyncWorker {
 public:
@@ -461,6 +573,8 @@ Napi::Value CardResetWrapped(const Napi::CallbackInfo& info) {
 
     // Call the actual library function (returns VOID)
     BTICard_CardReset(coreHandle);
+    // The reset dropped the session's lists and filters; the next initializeReceiver must rebuild them
+    if (DeviceSession* session = Sessions().Find(coreHandle)) session->InvalidateLayout();
 
     // Since the function returns void, we don't have a status code to return directly.
     // We can return undefined or true to indicate the call was made.
@@ -1387,116 +1501,205 @@ Napi::Value GetAllDioStatesWrapped(const Napi::CallbackInfo& info) {
 
 // --- NEW ARINC Receive Functions ---
 
+// Resolves the session for a core handle argument; throws a JS TypeError and returns nullptr if unknown
+DeviceSession* SessionFromArg(Napi::Env env, const Napi::Value& value) {
+    bool lossless;
+    HCORE hCore = reinterpret_cast<HCORE>(value.As<Napi::BigInt>().Uint64Value(&lossless));
+    DeviceSession* session = (lossless && hCore) ? Sessions().Find(hCore) : nullptr;
+    if (!session) {
+        Napi::TypeError::New(env, "Invalid or unknown core handle provided.").ThrowAsJavaScriptException();
+    }
+    return session;
+}
+
+// Describes a session for JS: handles, card/core numbers and discovered channels
+Napi::Object SessionToObject(Napi::Env env, DeviceSession* session) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("card", Napi::Number::New(env, session->CardNum()));
+    obj.Set("core", Napi::Number::New(env, session->CoreNum()));
+    obj.Set("hCard", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(session->Card())));
+    obj.Set("hCore", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(session->Core())));
+    obj.Set("monitoring", Napi::Boolean::New(env, session->IsMonitoring()));
+    const auto& channels = session->Channels();
+    Napi::Array channelArray = Napi::Array::New(env, channels.size());
+    for (size_t i = 0; i < channels.size(); ++i) {
+        Napi::Object ch = Napi::Object::New(env);
+        ch.Set("channel", Napi::Number::New(env, channels[i].channel));
+        ch.Set("receive", Napi::Boolean::New(env, channels[i].receive));
+        ch.Set("transmit", Napi::Boolean::New(env, channels[i].transmit));
+        channelArray.Set(static_cast<uint32_t>(i), ch);
+    }
+    obj.Set("channelCount", Napi::Number::New(env, session->ChannelCount()));
+    obj.Set("channels", channelArray);
+    return obj;
+}
+
 // Exported Function: InitializeHardware
+// initializeHardware([cardNum = 0], [coreNum = 0]) opens one core as a device session. Call once per core to monitor several.
 Napi::Value InitializeHardwareWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    if (info.Length() > 2 || (info.Length() >= 1 && !info[0].IsNumber()) || (info.Length() == 2 && !info[1].IsNumber())) {
+        Napi::TypeError::New(env, "Expected: [cardNum (Number)], [coreNum (Number)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int cardNum = info.Length() >= 1 ? info[0].As<Napi::Number>().Int32Value() : 0; // Card 0 by default
+    int coreNum = info.Length() == 2 ? info[1].As<Napi::Number>().Int32Value() : 0; // ARINC core
+
     Napi::Object resultObj = Napi::Object::New(env);
 
     // Prevent re-initialization if already initialized
-    if (hCardGlobal != nullptr || hCoreGlobal != nullptr) {
-        resultObj.Set("success", Napi::Boolean::New(env, false));
-        resultObj.Set("hCard", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(hCardGlobal)));
-        resultObj.Set("hCore", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(hCoreGlobal)));
-        resultObj.Set("message", Napi::String::New(env, "Hardware already initialized."));
-        resultObj.Set("resultCode", Napi::Number::New(env, ERR_NONE)); // Or a custom code?
-        return resultObj;
+    for (DeviceSession* existing : Sessions().All()) {
+        if (existing->CardNum() == cardNum && existing->CoreNum() == coreNum) {
+            resultObj.Set("success", Napi::Boolean::New(env, false));
+            resultObj.Set("hCard", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(existing->Card())));
+            resultObj.Set("hCore", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(existing->Core())));
+            resultObj.Set("message", Napi::String::New(env, "Hardware already initialized."));
+            resultObj.Set("resultCode", Napi::Number::New(env, ERR_NONE)); // Or a custom code?
+            return resultObj;
+        }
     }
 
-    int cardNum = 0; // Use Card 0 as confirmed by user
-    HCARD hCard = nullptr;
-    ERRVAL result = BTICard_CardOpen(&hCard, cardNum);
-
-    if (result != ERR_NONE || hCard == nullptr) {
-        const char* errStr = BTICard_ErrDescStr(result, nullptr);
+    ERRVAL result = ERR_NONE;
+    std::string message;
+    DeviceSession* session = Sessions().Open(cardNum, coreNum, &result, &message);
+    if (!session) {
         resultObj.Set("success", Napi::Boolean::New(env, false));
         resultObj.Set("hCard", env.Null());
         resultObj.Set("hCore", env.Null());
-        resultObj.Set("message", Napi::String::New(env, errStr ? errStr : "Failed to open card."));
-        resultObj.Set("resultCode", Napi::Number::New(env, result));
-        hCardGlobal = nullptr;
-        hCoreGlobal = nullptr;
-        return resultObj;
-    }
-
-    hCardGlobal = hCard;
-
-    int coreNum = 0; // ARINC core
-    HCORE hCore = nullptr;
-    result = BTICard_CoreOpen(&hCore, coreNum, hCard);
-
-    if (result != ERR_NONE || hCore == nullptr) {
-        const char* errStr = BTICard_ErrDescStr(result, hCard);
-        resultObj.Set("success", Napi::Boolean::New(env, false));
-        resultObj.Set("hCard", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(hCard)));
-        resultObj.Set("hCore", env.Null());
-        resultObj.Set("message", Napi::String::New(env, errStr ? errStr : "Failed to open core."));
+        resultObj.Set("message", Napi::String::New(env, message));
         resultObj.Set("resultCode", Napi::Number::New(env, result));
-        // Don't null hCardGlobal here, it might be needed for cleanup attempt
-        hCoreGlobal = nullptr;
         return resultObj;
     }
 
-    hCoreGlobal = hCore;
-
-    // Optional Reset
-    BTICard_CardReset(hCore);
-
+    Napi::Object sessionObj = SessionToObject(env, session);
     resultObj.Set("success", Napi::Boolean::New(env, true));
-    resultObj.Set("hCard", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(hCard)));
-    resultObj.Set("hCore", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(hCore)));
-    resultObj.Set("message", Napi::String::New(env, "Hardware initialized successfully."));
+    resultObj.Set("hCard", sessionObj.Get("hCard"));
+    resultObj.Set("hCore", sessionObj.Get("hCore"));
+    resultObj.Set("card", sessionObj.Get("card"));
+    resultObj.Set("core", sessionObj.Get("core"));
+    resultObj.Set("channelCount", sessionObj.Get("channelCount"));
+    resultObj.Set("channels", sessionObj.Get("channels"));
+    resultObj.Set("message", Napi::String::New(env, message));
     resultObj.Set("resultCode", Napi::Number::New(env, ERR_NONE));
 
     return resultObj;
 }
 
-// Exported Function: InitializeReceiver
-Napi::Value InitializeReceiverWrapped(const Napi::CallbackInfo& info) {
+// Exported Function: ListSessions
+// Returns every open device session (card/core handles, monitoring state, discovered channels)
+Napi::Value ListSessionsWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
-    if (info.Length() != 3 || !info[0].IsBigInt() || !info[1].IsFunction() || !info[2].IsFunction()) {
-        Napi::TypeError::New(env, "Expected: hCore (BigInt), dataCallback (Function), errorCallback (Function)").ThrowAsJavaScriptException();
-        return env.Null();
+    std::vector<DeviceSession*> sessions = Sessions().All();
+    Napi::Array resultArray = Napi::Array::New(env, sessions.size());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        resultArray.Set(static_cast<uint32_t>(i), SessionToObject(env, sessions[i]));
     }
+    return resultArray;
+}
 
-    bool lossless;
-    HCORE hCore = reinterpret_cast<HCORE>(info[0].As<Napi::BigInt>().Uint64Value(&lossless));
-    if (!lossless || !hCore) {
-        Napi::TypeError::New(env, "Invalid core handle provided.").ThrowAsJavaScriptException();
-        return env.Null();
+// --- Merged Stream Delivery (called from the merge and reader threads via the session registry) ---
+
+void DeliverUpdateBatch(void* context, std::vector<ArincUpdateData>* updatesBatch) {
+    AddonData* addon = static_cast<AddonData*>(context);
+    size_t batchWords = updatesBatch->size();
+    if (!addon->tsfnDataUpdate) {
+        BTI_LOG_ERROR("tsfnDataUpdate is null, discarding batch.");
+        StatsAdd(addon->deliveryStats.wordsDropped, batchWords);
+        delete updatesBatch; // Clean up if TSFN is null
+        return;
     }
-     // Ensure global core handle matches if already set
-    if (hCoreGlobal && hCoreGlobal != hCore) {
-         Napi::Error::New(env, "Core handle mismatch with global state.").ThrowAsJavaScriptException();
-        return env.Null();
-    } else if (!hCoreGlobal) {
-        hCoreGlobal = hCore; // Set if not already set
+
+    // Count the batch as queued before the call; CallJsDataUpdate may run before BlockingCall returns
+    int64_t depth = addon->deliveryStats.tsfnQueueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    StatsUpdateMax(addon->deliveryStats.tsfnQueueDepthMax, depth);
+    TRACE_COUNTER("tsfnQueueDepth", depth);
+    int64_t queuedNs = TraceEnabled() ? TraceNowNs() : 0;
+    napi_status status;
+    {
+        TRACE_SCOPE_ARG("TSFN.BlockingCall", "words", batchWords);
+        status = addon->tsfnDataUpdate.BlockingCall(updatesBatch,
+            [addon](Napi::Env env, Napi::Function jsCallback, std::vector<ArincUpdateData>* updates) {
+                CallJsDataUpdate(env, jsCallback, addon, updates);
+            });
+    }
+    if (status != napi_ok) {
+        addon->deliveryStats.tsfnQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+        StatsAdd(addon->deliveryStats.wordsDropped, batchWords);
+    } else {
+        StatsAdd(addon->deliveryStats.batchesQueued);
+        uint64_t batchSeq = addon->traceBatchQueuedSeq.fetch_add(1, std::memory_order_relaxed);
+        TRACE_FLOW("ArincBatch", 's', batchSeq, queuedNs);
     }
+    if (status != napi_ok && status != napi_closing) { // Ignore error if stopping
+        BTI_LOG_ERROR("Failed to call tsfnDataUpdate! Status: %d", (int)status);
+        delete updatesBatch; // Clean up if call failed
+    } else if (status == napi_closing) {
+        BTI_LOG_DEBUG("tsfnDataUpdate closing, discarding batch.");
+        delete updatesBatch;
+    } // On napi_ok, updatesBatch is deleted inside CallJsDataUpdate
+}
 
-     // Cleanup previous TSFNs if they exist
-    if (tsfnDataUpdate) {
-        // Check if acquire returns napi_ok before releasing, otherwise it might already be released/dead
-        if (tsfnDataUpdate.Acquire() == napi_ok) {
-            tsfnDataUpdate.Release();
-        }
-        tsfnDataUpdate = nullptr;
+void DeliverError(void* context, ArincErrorData* errorData) {
+    AddonData* addon = static_cast<AddonData*>(context);
+    if (!addon->tsfnErrorUpdate || addon->tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate) != napi_ok) {
+        delete errorData;
     }
-    if (tsfnErrorUpdate) {
-        if (tsfnErrorUpdate.Acquire() == napi_ok) {
-             tsfnErrorUpdate.Release();
+}
+
+// Makes addon the stream owner and installs its sinks. Fails if another environment owns the stream.
+bool AttachStream(AddonData* addon) {
+    std::lock_guard<std::mutex> lock(g_envMutex);
+    if (g_streamOwner && g_streamOwner != addon) return false;
+    g_streamOwner = addon;
+    Sessions().SetSinks(DeliverUpdateBatch, DeliverError, addon);
+    Sessions().SetDemand(addon, -1, -1, addon->streamChannelMask);
+    return true;
+}
+
+// Detaches the stream from this environment (if it owns it) and releases its callbacks. Clearing the
+// sinks first waits out any in-flight delivery, so the TSFN handles are never swapped under a running BlockingCall.
+void ReleaseStreamCallbacks(AddonData* addon, bool abortQueued) {
+    {
+        std::lock_guard<std::mutex> lock(g_envMutex);
+        if (g_streamOwner == addon) {
+            Sessions().SetSinks(nullptr, nullptr, nullptr);
+            Sessions().ClearDemand(addon);
+            g_streamOwner = nullptr;
         }
-        tsfnErrorUpdate = nullptr;
     }
+    if (addon->tsfnDataUpdate) {
+        BTI_LOG_DEBUG("Releasing tsfnDataUpdate...");
+        if (abortQueued) addon->tsfnDataUpdate.Abort(); // Abort any queued calls
+        addon->tsfnDataUpdate.Release();
+        addon->tsfnDataUpdate = nullptr;
+    }
+    if (addon->tsfnErrorUpdate) {
+        BTI_LOG_DEBUG("Releasing tsfnErrorUpdate...");
+        if (abortQueued) addon->tsfnErrorUpdate.Abort();
+        addon->tsfnErrorUpdate.Release();
+        addon->tsfnErrorUpdate = nullptr;
+    }
+}
 
-    // Create new ThreadSafeFunctions with corrected argument count
-    Napi::Function jsDataCallback = info[1].As<Napi::Function>();
-    Napi::Function jsErrorCallback = info[2].As<Napi::Function>();
+// True if another environment's callbacks currently receive the stream
+bool StreamOwnedElsewhere(AddonData* addon) {
+    std::lock_guard<std::mutex> lock(g_envMutex);
+    return g_streamOwner && g_streamOwner != addon;
+}
+
+// True while anything still feeds the stream: a local reader or the capture daemon client
+bool StreamSourcesActive() {
+    return Sessions().AnyMonitoring() || Capture().IsAttached();
+}
 
+void CreateStreamCallbacks(Napi::Env env, AddonData* addon, Napi::Function jsDataCallback, Napi::Function jsErrorCallback) {
+    // Create new ThreadSafeFunctions with corrected argument count
     // Define the finalizer lambda explicitly
     auto dataFinalizer = [](Napi::Env env, void* finalize_data) { // Simplified signature
-        std::cout << "tsfnDataUpdate finalized." << std::endl;
+        BTI_LOG_DEBUG("tsfnDataUpdate finalized.");
     };
 
-    tsfnDataUpdate = Napi::ThreadSafeFunction::New(
+    addon->tsfnDataUpdate = Napi::ThreadSafeFunction::New(
         env,
         jsDataCallback,
         "ARINC Data Update", // Resource Name
@@ -1507,10 +1710,10 @@ Napi::Value InitializeReceiverWrapped(const Napi::CallbackInfo& info) {
     );
 
     auto errorFinalizer = [](Napi::Env env, void* finalize_data) { // Simplified signature
-        std::cout << "tsfnErrorUpdate finalized." << std::endl;
+        BTI_LOG_DEBUG("tsfnErrorUpdate finalized.");
     };
 
-    tsfnErrorUpdate = Napi::ThreadSafeFunction::New(
+    addon->tsfnErrorUpdate = Napi::ThreadSafeFunction::New(
         env,
         jsErrorCallback,
         "ARINC Error Update", // Resource Name
@@ -1519,68 +1722,279 @@ Napi::Value InitializeReceiverWrapped(const Napi::CallbackInfo& info) {
         errorFinalizer,
         (void*)nullptr // FinalizerDataType*
     );
+}
 
-    Napi::Object resultObj = Napi::Object::New(env);
-    bool success = true;
-    std::string errorMessage = "Receiver initialized successfully.";
-    int lastErrorCode = ERR_NONE;
-
-    // Configure Event Log first (Keep this)
-    ERRVAL logConfigResult = BTICard_EventLogConfig(LOGCFG_ENABLE, 1024, hCore);
-    if(logConfigResult != ERR_NONE) {
-        // ... (Handle event log config error)
-        goto end_init_receiver;
-    }
-
-    // Configure Channels & Lists
-    for (int i = 0; i < ARINC_CHANNEL_COUNT; ++i) {
-        // Config Channel
-        ULONG chFlags = CHCFG429_AUTOSPEED | CHCFG429_LOGERR;
-        ERRVAL chConfigResult = BTI429_ChConfig(chFlags, i, hCore);
-        if (chConfigResult != ERR_NONE) {
-            const char* errStr = BTICard_ErrDescStr(chConfigResult, hCore);
-            errorMessage = "Failed to configure channel " + std::to_string(i) + ": " + (errStr ? errStr : "Unknown error");
-            success = false;
-            lastErrorCode = chConfigResult;
-            break;
+// Receiver profile from JS: { eventLogSize, allChannels, channels: [{ channel, enabled, speed: 'auto'|'high'|'low',
+// listWords, logErrors, selfTest, records: ['elapse'|'max'|'min'], skipLabels: [label], snapshotLabels: [label],
+// snapshotOnly }] }. Values are checked by ResolveProfile. With a base layout (applyReceiverConfig), fields a channel entry leaves out keep their current value.
+bool ParseReceiverProfile(Napi::Value value, ReceiverProfile* profile, std::string* error, const ReceiverLayout* base = nullptr) {
+    if (value.IsUndefined() || value.IsNull()) return true; // Default profile
+    if (!value.IsObject()) {
+        *error = "profile must be an object";
+        return false;
+    }
+    Napi::Object obj = value.As<Napi::Object>();
+    if (obj.Has("eventLogSize") && obj.Get("eventLogSize").IsNumber()) {
+        profile->eventLogSize = obj.Get("eventLogSize").As<Napi::Number>().Int32Value();
+    }
+    if (obj.Has("allChannels") && obj.Get("allChannels").IsBoolean()) {
+        profile->allChannels = obj.Get("allChannels").As<Napi::Boolean>().Value();
+    }
+    if (!obj.Has("channels") || !obj.Get("channels").IsArray()) return true;
+    Napi::Array channels = obj.Get("channels").As<Napi::Array>();
+    for (uint32_t i = 0; i < channels.Length(); ++i) {
+        Napi::Value entry = channels.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("channel").IsNumber()) {
+            *error = "channels[" + std::to_string(i) + "] needs a numeric channel";
+            return false;
         }
-
-        // Create Default Filter FIRST
-        MSGADDR defaultMsgAddr = BTI429_FilterDefault(MSGCRT429_DEFAULT, i, hCore);
-        if (defaultMsgAddr == 0) {
-             errorMessage = "Failed to create default filter for channel " + std::to_string(i);
-             std::cerr << "BTI429_FilterDefault failed for channel " << i << std::endl;
-             success = false;
-             lastErrorCode = ERR_FAIL; // Or get last error if possible
-             break;
+        Napi::Object chObj = entry.As<Napi::Object>();
+        ChannelProfile channel;
+        channel.channel = chObj.Get("channel").As<Napi::Number>().Int32Value();
+        if (chObj.Get("enabled").IsBoolean() && !chObj.Get("enabled").As<Napi::Boolean>().Value()) {
+            profile->removeChannels.push_back(channel.channel);
+            continue;
         }
-        std::cout << "Created default filter for channel " << i << " with msg addr: " << defaultMsgAddr << std::endl;
-
-        // Create Receive List, passing the message address from the default filter
-        ULONG listFlags = LISTCRT429_FIFO; // Use FIFO mode
-        LISTADDR listAddr = BTI429_ListRcvCreate(listFlags, 1024, defaultMsgAddr, hCore);
-        if (listAddr == 0) {
-            errorMessage = "Failed to create receive list for channel " + std::to_string(i) + " (linked to default filter)";
-            std::cerr << "BTI429_ListRcvCreate failed for channel " << i << " with flags: " << listFlags << " msgAddr: " << defaultMsgAddr << std::endl;
-            success = false;
-            lastErrorCode = ERR_FAIL;
-            break;
+        if (base && channel.channel >= 0 && channel.channel < (int)base->channels.size() &&
+            base->channels[channel.channel].channel >= 0) {
+            channel = base->channels[channel.channel];
+        }
+        Napi::Value speed = chObj.Get("speed");
+        std::string speedName = speed.IsString() ? speed.As<Napi::String>().Utf8Value() : "";
+        if (speedName == "high") channel.speed = ChannelSpeed::High;
+        else if (speedName == "low") channel.speed = ChannelSpeed::Low;
+        else if (speedName == "auto") channel.speed = ChannelSpeed::Auto;
+        else if (!speed.IsUndefined()) {
+            *error = "speed must be 'auto', 'high' or 'low'";
+            return false;
+        }
+        if (chObj.Get("listWords").IsNumber()) channel.listWords = chObj.Get("listWords").As<Napi::Number>().Int32Value();
+        if (chObj.Get("logErrors").IsBoolean()) channel.logErrors = chObj.Get("logErrors").As<Napi::Boolean>().Value();
+        if (chObj.Get("selfTest").IsBoolean()) channel.selfTest = chObj.Get("selfTest").As<Napi::Boolean>().Value();
+        if (chObj.Get("records").IsArray()) {
+            Napi::Array records = chObj.Get("records").As<Napi::Array>();
+            channel.records = 0;
+            for (uint32_t r = 0; r < records.Length(); ++r) {
+                Napi::Value record = records.Get(r);
+                std::string name = record.IsString() ? record.As<Napi::String>().Utf8Value() : "";
+                if (name == "elapse") channel.records |= MSGCRT429_ELAPSE;
+                else if (name == "max") channel.records |= MSGCRT429_MAX;
+                else if (name == "min") channel.records |= MSGCRT429_MIN;
+                else {
+                    *error = "records may contain 'elapse', 'max' and 'min'";
+                    return false;
+                }
+            }
+        }
+        if (chObj.Get("skipLabels").IsArray()) {
+            Napi::Array labels = chObj.Get("skipLabels").As<Napi::Array>();
+            channel.skipLabels.clear();
+            for (uint32_t l = 0; l < labels.Length(); ++l) {
+                Napi::Value label = labels.Get(l);
+                channel.skipLabels.push_back(label.IsNumber() ? label.As<Napi::Number>().Int32Value() : -1);
+            }
+        }
+        if (chObj.Get("snapshotLabels").IsArray()) {
+            Napi::Array labels = chObj.Get("snapshotLabels").As<Napi::Array>();
+            channel.snapshotLabels.clear();
+            for (uint32_t l = 0; l < labels.Length(); ++l) {
+                Napi::Value label = labels.Get(l);
+                channel.snapshotLabels.push_back(label.IsNumber() ? label.As<Napi::Number>().Int32Value() : -1);
+            }
         }
-        receiveListAddrs[i] = listAddr; // Still store list address for reading
-        std::cout << "Created receive list for channel " << i << " linked to msg " << defaultMsgAddr << " with list address: " << listAddr << std::endl;
+        if (chObj.Get("snapshotOnly").IsBoolean()) channel.snapshotOnly = chObj.Get("snapshotOnly").As<Napi::Boolean>().Value();
+        profile->channels.push_back(channel);
     }
+    return true;
+}
 
-end_init_receiver:
-    resultObj.Set("success", Napi::Boolean::New(env, success));
-    resultObj.Set("message", Napi::String::New(env, errorMessage));
-    resultObj.Set("lastErrorCode", Napi::Number::New(env, lastErrorCode));
+// Setup report fields, added to an existing result object
+void SetSetupReport(Napi::Env env, Napi::Object resultObj, const SetupReport& report) {
+    resultObj.Set("success", Napi::Boolean::New(env, report.success));
+    resultObj.Set("pending", Napi::Boolean::New(env, report.pending));
+    resultObj.Set("message", Napi::String::New(env, report.message));
+    resultObj.Set("lastErrorCode", Napi::Number::New(env, report.errorCode));
+    resultObj.Set("channelsConfigured", Napi::Number::New(env, report.channelsConfigured));
+    resultObj.Set("channelsReused", Napi::Number::New(env, report.channelsReused));
+    resultObj.Set("totalUs", Napi::Number::New(env, report.totalNs / 1000.0));
+    Napi::Array steps = Napi::Array::New(env, report.steps.size());
+    for (size_t i = 0; i < report.steps.size(); ++i) {
+        const SetupStepResult& step = report.steps[i];
+        Napi::Object stepObj = Napi::Object::New(env);
+        stepObj.Set("step", Napi::String::New(env, SetupStepName(step.kind)));
+        stepObj.Set("channel", step.channel >= 0 ? Napi::Number::New(env, step.channel) : env.Null());
+        stepObj.Set("value", Napi::Number::New(env, step.value));
+        stepObj.Set("result", Napi::Number::New(env, step.result));
+        stepObj.Set("us", Napi::Number::New(env, step.durationNs / 1000.0));
+        steps.Set(static_cast<uint32_t>(i), stepObj);
+    }
+    resultObj.Set("steps", steps);
+}
+
+// Exported Function: InitializeReceiver
+// initializeReceiver(hCore, dataCallback, errorCallback, [profile]); see ParseReceiverProfile. Only the steps that
+// change the card's current receive layout run, so re-initializing with the same profile just clears the lists.
+// Callbacks are shared by every session: all cores report into the one merged stream, and the latest registration wins.
+// The stream belongs to one JS environment at a time; registering from another one fails until the owner releases it.
+Napi::Value InitializeReceiverWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() < 3 || info.Length() > 4 || !info[0].IsBigInt() || !info[1].IsFunction() || !info[2].IsFunction()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt), dataCallback (Function), errorCallback (Function), [profile (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+    ReceiverProfile profile;
+    std::string profileError;
+    if (!ParseReceiverProfile(info.Length() == 4 ? info[3] : env.Undefined(), &profile, &profileError)) {
+        Napi::TypeError::New(env, profileError).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    if (StreamOwnedElsewhere(addon)) {
+        Napi::Error::New(env, "ARINC callbacks are registered in another JS environment. Stop monitoring there first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+     // Cleanup previous TSFNs if they exist
+    ReleaseStreamCallbacks(addon, false);
+
+    CreateStreamCallbacks(env, addon, info[1].As<Napi::Function>(), info[2].As<Napi::Function>());
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    SetupReport report;
+    bool success = session->ApplyReceiverProfile(profile, &report);
+    SetSetupReport(env, resultObj, report);
+
+    // If initialization failed, release TSFNs immediately (unless another core is still streaming)
+    if (!success && !StreamSourcesActive()) {
+        ReleaseStreamCallbacks(addon, false);
+    } else if (!AttachStream(addon)) { // Another environment registered while this one was configuring
+        ReleaseStreamCallbacks(addon, false);
+        resultObj.Set("success", Napi::Boolean::New(env, false));
+        resultObj.Set("message", Napi::String::New(env, "ARINC callbacks are registered in another JS environment."));
+    }
+
+    return resultObj;
+}
+
+// Exported Function: PrepareReceivers
+// prepareReceivers([profile], [hCores]) applies a receiver profile to several cores at once (default: every open
+// session), one thread per core, without touching the stream callbacks. A later initializeReceiver with the same
+// profile then finds the layout in place. Returns [{ hCore, card, core, success, message, steps, ... }].
+Napi::Value PrepareReceiversWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 2 || (info.Length() == 2 && !info[1].IsArray() && !info[1].IsUndefined() && !info[1].IsNull())) {
+        Napi::TypeError::New(env, "Expected: [profile (Object)], [hCores (Array of BigInt)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    ReceiverProfile profile;
+    std::string profileError;
+    if (!ParseReceiverProfile(info.Length() >= 1 ? info[0] : env.Undefined(), &profile, &profileError)) {
+        Napi::TypeError::New(env, profileError).ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-    // If initialization failed, release TSFNs immediately
-    if (!success) {
-         if (tsfnDataUpdate) { tsfnDataUpdate.Release(); tsfnDataUpdate = nullptr; }
-         if (tsfnErrorUpdate) { tsfnErrorUpdate.Release(); tsfnErrorUpdate = nullptr; }
+    std::vector<DeviceSession*> sessions;
+    if (info.Length() == 2 && info[1].IsArray()) {
+        Napi::Array handles = info[1].As<Napi::Array>();
+        for (uint32_t i = 0; i < handles.Length(); ++i) {
+            Napi::Value handle = handles.Get(i);
+            if (!handle.IsBigInt()) {
+                Napi::TypeError::New(env, "hCores must be BigInts").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            DeviceSession* session = SessionFromArg(env, handle);
+            if (!session) return env.Null();
+            sessions.push_back(session);
+        }
+    } else {
+        sessions = Sessions().All();
+    }
+
+    // Cores are independent driver handles; their setup chains run side by side
+    std::vector<SetupReport> reports(sessions.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < sessions.size(); ++i) {
+        workers.emplace_back([&, i]() { sessions[i]->ApplyReceiverProfile(profile, &reports[i]); });
+    }
+    if (!sessions.empty()) sessions[0]->ApplyReceiverProfile(profile, &reports[0]);
+    for (std::thread& worker : workers) worker.join();
+
+    Napi::Array results = Napi::Array::New(env, sessions.size());
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        Napi::Object resultObj = Napi::Object::New(env);
+        resultObj.Set("hCore", Napi::BigInt::New(env, reinterpret_cast<uint64_t>(sessions[i]->Core())));
+        resultObj.Set("card", Napi::Number::New(env, sessions[i]->CardNum()));
+        resultObj.Set("core", Napi::Number::New(env, sessions[i]->CoreNum()));
+        SetSetupReport(env, resultObj, reports[i]);
+        results.Set(static_cast<uint32_t>(i), resultObj);
+    }
+    return results;
+}
+
+// Exported Function: ApplyReceiverConfig
+// applyReceiverConfig(hCore, changes): changes = { channels: [{ channel, ...fields to change }] }, same fields as a
+// profile plus enabled: false to switch a channel off. Works while monitoring: the reader thread quiesces, re-programs
+// and restarts only the channels that actually change; every other channel keeps streaming. Returns the setup report
+// (pending: true if the reader was still applying it when the wait timed out).
+Napi::Value ApplyReceiverConfigWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !info[0].IsBigInt() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt), changes (Object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+
+    ReceiverProfile changes;
+    std::string profileError;
+    ReceiverLayout current = session->Layout();
+    if (!ParseReceiverProfile(info[1], &changes, &profileError, &current)) {
+        Napi::TypeError::New(env, profileError).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    SetupReport report;
+    session->ApplyReceiverConfig(changes, &report);
+    Napi::Object resultObj = Napi::Object::New(env);
+    SetSetupReport(env, resultObj, report);
+    return resultObj;
+}
+
+// Exported Function: SetStreamChannels
+// setStreamChannels([channels]) narrows the channels the stream callbacks need (e.g. the one the UI shows);
+// no argument or null restores all. Other channels are then only polled at the background cadence, so their
+// words still arrive, just late. Subscribers and the value table register their own demand.
+Napi::Value SetStreamChannelsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    uint32_t mask = 0;
+    if (info.Length() >= 1 && info[0].IsArray()) {
+        Napi::Array channels = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < channels.Length(); ++i) {
+            Napi::Value value = channels.Get(i);
+            int channel = value.IsNumber() ? value.As<Napi::Number>().Int32Value() : -1;
+            if (channel < 0 || channel >= 32) {
+                Napi::TypeError::New(env, "Channels must be numbers in 0..31").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            mask |= 1u << channel;
+        }
+    } else if (info.Length() >= 1 && !info[0].IsNull() && !info[0].IsUndefined()) {
+        Napi::TypeError::New(env, "Expected: [channels (Array of Number)]").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
+    addon->streamChannelMask = mask;
+    {
+        std::lock_guard<std::mutex> lock(g_envMutex);
+        if (g_streamOwner == addon) Sessions().SetDemand(addon, -1, -1, mask);
+    }
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, mask == 0 ? "Stream uses all channels." : "Stream channels updated."));
     return resultObj;
 }
 
@@ -1592,121 +2006,61 @@ Napi::Value StartMonitoringWrapped(const Napi::CallbackInfo& info) {
         return env.Null();
     }
 
-    bool lossless;
-    HCORE hCore = reinterpret_cast<HCORE>(info[0].As<Napi::BigInt>().Uint64Value(&lossless));
-    if (!lossless || !hCore || hCore != hCoreGlobal) { // Ensure handle matches global
-        Napi::TypeError::New(env, "Invalid or mismatched core handle provided.").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+    AddonData* addon = GetAddonData(env);
 
     Napi::Object resultObj = Napi::Object::New(env);
 
-    if (monitoringActive.load()) {
+    if (Capture().IsAttached()) {
         resultObj.Set("success", Napi::Boolean::New(env, false));
-        resultObj.Set("message", Napi::String::New(env, "Monitoring is already active."));
+        resultObj.Set("message", Napi::String::New(env, "Attached to the capture daemon. Detach before monitoring locally."));
         return resultObj;
     }
-    if (!tsfnDataUpdate || !tsfnErrorUpdate) {
+    if (!addon->tsfnDataUpdate || !addon->tsfnErrorUpdate) {
          resultObj.Set("success", Napi::Boolean::New(env, false));
         resultObj.Set("message", Napi::String::New(env, "Callbacks not initialized. Call InitializeReceiver first."));
         return resultObj;
     }
 
-    ERRVAL startResult = BTICard_CardStart(hCore);
-    if (startResult != ERR_NONE) {
-        const char* errStr = BTICard_ErrDescStr(startResult, hCore);
-        resultObj.Set("success", Napi::Boolean::New(env, false));
-        resultObj.Set("message", Napi::String::New(env, std::string("Failed to start card: ") + (errStr ? errStr : "Unknown error")));
-        return resultObj;
-    }
-
-    monitoringActive.store(true);
-    try {
-        // Ensure previous thread is joined if somehow still exists
-        if (monitorThread.joinable()) {
-             std::cout << "Warning: Previous monitor thread was still joinable. Joining now." << std::endl;
-            monitorThread.join();
-        }
-        monitorThread = std::thread(MonitorLoop);
-    } catch (const std::exception& e) {
-         monitoringActive.store(false);
-         BTICard_CardStop(hCore); // Attempt to stop card if thread creation failed
-         const char* errStr = BTICard_ErrDescStr(startResult, hCore);
-         resultObj.Set("success", Napi::Boolean::New(env, false));
-         resultObj.Set("message", Napi::String::New(env, std::string("Failed to start monitoring thread: ") + e.what()));
-         return resultObj;
-    }
-
-    resultObj.Set("success", Napi::Boolean::New(env, true));
-    resultObj.Set("message", Napi::String::New(env, "ARINC monitoring started."));
+    std::string message;
+    bool success = session->StartMonitoring(&message);
+    resultObj.Set("success", Napi::Boolean::New(env, success));
+    resultObj.Set("message", Napi::String::New(env, message));
     return resultObj;
 }
 
 // Exported Function: StopMonitoring
+// Stops one core's reader. The shared callbacks are released once no core is monitoring
+// (only the owning environment's; another environment's callbacks stay registered until it releases them).
 Napi::Value StopMonitoringWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
     if (info.Length() != 1 || !info[0].IsBigInt()) {
         Napi::TypeError::New(env, "Expected: hCore (BigInt)").ThrowAsJavaScriptException();
         return env.Null();
     }
 
-    bool lossless;
-    HCORE hCore = reinterpret_cast<HCORE>(info[0].As<Napi::BigInt>().Uint64Value(&lossless));
-     if (!lossless || !hCore || hCore != hCoreGlobal) { // Check against global
-        Napi::TypeError::New(env, "Invalid or mismatched core handle provided.").ThrowAsJavaScriptException();
-        return env.Null();
-    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
 
     Napi::Object resultObj = Napi::Object::New(env);
 
-    if (!monitoringActive.load()) {
+    if (!session->IsMonitoring()) {
         resultObj.Set("success", Napi::Boolean::New(env, true)); // Already stopped
         resultObj.Set("message", Napi::String::New(env, "Monitoring was not active."));
         // Ensure TSFNs are released if somehow they weren't
-         if (tsfnDataUpdate) { tsfnDataUpdate.Abort(); tsfnDataUpdate.Release(); tsfnDataUpdate = nullptr; }
-         if (tsfnErrorUpdate) { tsfnErrorUpdate.Abort(); tsfnErrorUpdate.Release(); tsfnErrorUpdate = nullptr; }
+        if (!StreamSourcesActive()) ReleaseStreamCallbacks(addon, true);
         return resultObj;
     }
 
-    std::cout << "StopMonitoring called. Setting flag false." << std::endl;
-    monitoringActive.store(false);
-
-    // Abort TSFNs to unblock any pending calls immediately
-    if (tsfnDataUpdate) {
-        tsfnDataUpdate.Abort(); // Abort any queued calls
-    }
-    if (tsfnErrorUpdate) {
-        tsfnErrorUpdate.Abort();
-    }
-
-    if (monitorThread.joinable()) {
-        std::cout << "Joining monitor thread..." << std::endl;
-        try {
-             monitorThread.join();
-             std::cout << "Monitor thread joined." << std::endl;
-        } catch(const std::system_error& e) {
-            std::cerr << "Error joining monitor thread: " << e.what() << " (" << e.code() << ")" << std::endl;
-            // Proceed with stopping the card anyway
-        }
-    } else {
-         std::cout << "Monitor thread was not joinable." << std::endl;
-    }
-
-    // Stop the card
-     std::cout << "Stopping BTI Card..." << std::endl;
-    BTICard_CardStop(hCore);
-     std::cout << "BTI Card stopped." << std::endl;
+    BTI_LOG_INFO("StopMonitoring called (card %d core %d).", session->CardNum(), session->CoreNum());
+    session->StopMonitoring();
 
-    // Release ThreadSafeFunctions - crucial to prevent leaks/crashes
-    if (tsfnDataUpdate) {
-        std::cout << "Releasing tsfnDataUpdate..." << std::endl;
-        tsfnDataUpdate.Release();
-        tsfnDataUpdate = nullptr;
-    }
-    if (tsfnErrorUpdate) {
-         std::cout << "Releasing tsfnErrorUpdate..." << std::endl;
-        tsfnErrorUpdate.Release();
-        tsfnErrorUpdate = nullptr;
+    if (!Sessions().AnyMonitoring()) {
+        Sessions().StopMerger(); // Flushes the words still pending in the merge stage
+        // Release ThreadSafeFunctions - crucial to prevent leaks/crashes (unless the capture daemon still feeds them)
+        if (!Capture().IsAttached()) ReleaseStreamCallbacks(addon, true);
     }
 
     resultObj.Set("success", Napi::Boolean::New(env, true));
@@ -1715,347 +2069,2203 @@ Napi::Value StopMonitoringWrapped(const Napi::CallbackInfo& info) {
 }
 
 // Exported Function: CleanupHardware
+// Stops every session and closes every opened card.
 Napi::Value CleanupHardwareWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     Napi::Object resultObj = Napi::Object::New(env);
 
-    // Ensure monitoring is stopped first
-    if (monitoringActive.load() && hCoreGlobal) {
-         std::cout << "CleanupHardware: Stopping active monitoring first..." << std::endl;
-         // Need to recreate CallbackInfo or pass null if no args needed
-         // This is tricky. It's better if stop is called explicitly before cleanup.
-         // Forcing a stop here without proper JS context can be problematic.
-         // Let's just set the flag and rely on card close.
-         monitoringActive.store(false);
-         if (monitorThread.joinable()) monitorThread.join(); // Try to join if possible
-         BTICard_CardStop(hCoreGlobal);
-          if (tsfnDataUpdate) { tsfnDataUpdate.Abort(); tsfnDataUpdate.Release(); tsfnDataUpdate = nullptr; }
-         if (tsfnErrorUpdate) { tsfnErrorUpdate.Abort(); tsfnErrorUpdate.Release(); tsfnErrorUpdate = nullptr; }
-    }
-
-    if (hCardGlobal) {
-        std::cout << "CleanupHardware: Closing card..." << std::endl;
-        ERRVAL closeResult = BTICard_CardClose(hCardGlobal);
-        if (closeResult == ERR_NONE) {
-             resultObj.Set("success", Napi::Boolean::New(env, true));
-             resultObj.Set("message", Napi::String::New(env, "Hardware resources released."));
-        } else {
-            const char* errStr = BTICard_ErrDescStr(closeResult, hCardGlobal);
-            resultObj.Set("success", Napi::Boolean::New(env, false));
-            resultObj.Set("message", Napi::String::New(env, std::string("Error closing card: ") + (errStr ? errStr : "Unknown error")));
-        }
-        hCardGlobal = nullptr; // Clear global handles
-        hCoreGlobal = nullptr;
-    } else {
+    if (Sessions().All().empty()) {
          resultObj.Set("success", Napi::Boolean::New(env, true)); // No card was open
          resultObj.Set("message", Napi::String::New(env, "No hardware card was open."));
+         return resultObj;
     }
 
+    if (Sessions().AnyMonitoring()) {
+        BTI_LOG_INFO("CleanupHardware: Stopping active monitoring first...");
+    }
+    std::string errorMessage;
+    ERRVAL closeResult = Sessions().CloseAll(&errorMessage); // Also stops the DIO monitors
+    AddonData* addon = GetAddonData(env);
+    while (!addon->dioWatches.empty()) RemoveDioWatch(addon, addon->dioWatches.begin()->first);
+    if (!Capture().IsAttached()) ReleaseStreamCallbacks(addon, true);
+
+    if (closeResult == ERR_NONE) {
+         resultObj.Set("success", Napi::Boolean::New(env, true));
+         resultObj.Set("message", Napi::String::New(env, "Hardware resources released."));
+    } else {
+        resultObj.Set("success", Napi::Boolean::New(env, false));
+        resultObj.Set("message", Napi::String::New(env, errorMessage));
+    }
     return resultObj;
 }
 
-// --- ARINC Monitoring Thread Loop ---
-void MonitorLoop() {
-    if (!hCoreGlobal) {
-        std::cerr << "MonitorLoop started with null hCoreGlobal!" << std::endl;
-        return;
+// Exported Function: GetMonitorStats
+// Cheap snapshot of the lock-free pipeline counters, intended for ~10 Hz polling.
+// Counters are monotonic (compute rates from deltas); gauges are instantaneous.
+// getMonitorStats([hCore]) reports the given session (default: the first one); delivery counters cover the merged stream.
+Napi::Value GetMonitorStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    auto load = [](const auto& counter) { return static_cast<double>(counter.load(std::memory_order_relaxed)); };
+    if (info.Length() >= 1 && !info[0].IsBigInt() && !info[0].IsUndefined() && !info[0].IsNull()) {
+        Napi::TypeError::New(env, "Expected: [hCore (BigInt)]").ThrowAsJavaScriptException();
+        return env.Null();
     }
 
-    HCORE hCore = hCoreGlobal; // Use the global core handle
-    const int MAX_READ_COUNT = 512; // How many words to read per channel check
-    std::vector<ULONG> readBuffer(MAX_READ_COUNT);
-
-    std::cout << "ARINC Monitor Thread Started." << std::endl;
-
-    while (monitoringActive.load()) {
-        // Check if TSFNs are still valid before proceeding
-        if (!tsfnDataUpdate || !tsfnErrorUpdate) {
-             std::cerr << "MonitorLoop: TSFN became invalid. Exiting loop." << std::endl;
-             monitoringActive.store(false);
-             break;
-        }
-
-        bool dataProcessedInCycle = false;
-        auto updatesBatch = new std::vector<ArincUpdateData>(); // Allocate on heap for TSFN
-
-        // 1. Poll Event Log (Optional but good for responsiveness)
-        USHORT eventType = 0;
-        ULONG eventInfo = 0;
-        INT eventChannel = -1;
-        ULONG logEntryAddr = BTICard_EventLogRd(&eventType, &eventInfo, &eventChannel, hCore);
-
-        if (logEntryAddr != 0) {
-            dataProcessedInCycle = true; // Consider event log read as activity
-           // std::cout << "Event Logged: Type=" << eventType << ", Info=" << eventInfo << ", Chan=" << eventChannel << std::endl;
-            if (eventType == EVENTTYPE_429LIST) { // List full/empty
-                std::cout << "ARINC List event on channel " << eventChannel << " (Info: " << eventInfo << " -> " << (eventInfo == 0 ? "Empty?" : "Full?") << ")" << std::endl;
-                // Could potentially report this as a warning/info via tsfnErrorUpdate
-                // auto* errorData = new ArincErrorData{eventChannel, ERR_INFO, std::string("List Buffer Event: ") + (eventInfo == 0 ? "Empty/Underrun" : "Full/Overflow") };
-                // tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate);
-            }
-            else if (eventType == EVENTTYPE_429ERR) { // Decoder error
-                 auto* errorData = new ArincErrorData{eventChannel, ERR_FAIL, "ARINC Decoder Error (See message activity)" };
-                 tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate);
-            }
-            // Add more event handling here if needed
-        }
+    DeviceSession* session = nullptr;
+    if (info.Length() >= 1 && info[0].IsBigInt()) {
+        session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+    } else {
+        session = Sessions().Default();
+    }
+    AddonData* addon = GetAddonData(env); // Delivery counters are those of this environment's stream
+    static MonitorStats emptyStats; // Reported when no session is open
+    MonitorStats& monitorStats = session ? session->Stats() : emptyStats;
 
-        // 2. Periodically Check Receive Lists
-        for (int channel = 0; channel < ARINC_CHANNEL_COUNT; ++channel) { // Uses the new constant
-            if (!monitoringActive.load()) break; // Check flag again inside loop
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("monitoringActive", Napi::Boolean::New(env, session && session->IsMonitoring()));
+    if (session) {
+        resultObj.Set("card", Napi::Number::New(env, session->CardNum()));
+        resultObj.Set("core", Napi::Number::New(env, session->CoreNum()));
+    }
+    resultObj.Set("cycles", Napi::Number::New(env, load(monitorStats.cycles)));
+    resultObj.Set("lastCycleUs", Napi::Number::New(env, load(monitorStats.lastCycleUs)));
+    resultObj.Set("maxCycleUs", Napi::Number::New(env, load(monitorStats.maxCycleUs)));
+    resultObj.Set("eventLogEntries", Napi::Number::New(env, load(monitorStats.eventLogEntries)));
+    resultObj.Set("eventLogDrains", Napi::Number::New(env, load(monitorStats.eventLogDrains)));
+    resultObj.Set("eventLogMaxDrain", Napi::Number::New(env, load(monitorStats.eventLogMaxDrain)));
+    resultObj.Set("eventLogOverflows", Napi::Number::New(env, load(monitorStats.eventLogOverflows)));
+    resultObj.Set("eventsDropped", Napi::Number::New(env, load(monitorStats.eventsDropped)));
+    resultObj.Set("snapshotRefreshes", Napi::Number::New(env, load(monitorStats.snapshotRefreshes)));
+    resultObj.Set("snapshotGroupReads", Napi::Number::New(env, load(monitorStats.snapshotGroupReads)));
+    resultObj.Set("snapshotUpdates", Napi::Number::New(env, load(monitorStats.snapshotUpdates)));
+    resultObj.Set("alarmTransitions", Napi::Number::New(env, load(monitorStats.alarmTransitions)));
+    resultObj.Set("alarmsDropped", Napi::Number::New(env, load(monitorStats.alarmsDropped)));
+    resultObj.Set("tsfnQueueDepth", Napi::Number::New(env, load(addon->deliveryStats.tsfnQueueDepth)));
+    resultObj.Set("tsfnQueueDepthMax", Napi::Number::New(env, load(addon->deliveryStats.tsfnQueueDepthMax)));
+    resultObj.Set("batchesQueued", Napi::Number::New(env, load(addon->deliveryStats.batchesQueued)));
+    resultObj.Set("batchesDelivered", Napi::Number::New(env, load(addon->deliveryStats.batchesDelivered)));
+    resultObj.Set("wordsDelivered", Napi::Number::New(env, load(addon->deliveryStats.wordsDelivered)));
+    resultObj.Set("wordsDropped", Napi::Number::New(env, load(addon->deliveryStats.wordsDropped)));
+
+    // Histograms: bucket 0 is <1 (us or words), bucket i covers [2^(i-1), 2^i), the last bucket is open-ended
+    Napi::Float64Array cycleHist = Napi::Float64Array::New(env, STATS_CYCLE_HIST_BUCKETS);
+    for (int i = 0; i < STATS_CYCLE_HIST_BUCKETS; ++i) cycleHist[i] = load(monitorStats.cycleHistogram[i]);
+    resultObj.Set("cycleTimeHistogramUs", cycleHist);
+
+    Napi::Float64Array blockHist = Napi::Float64Array::New(env, STATS_BLOCK_HIST_BUCKETS);
+    for (int i = 0; i < STATS_BLOCK_HIST_BUCKETS; ++i) blockHist[i] = load(monitorStats.blockSizeHistogram[i]);
+    resultObj.Set("blockSizeHistogram", blockHist);
+
+    // Per-channel counters, row-major: channels[ch * channelFields + field]
+    // Fields: wordsRead, blockReads, lastBlockSize, maxBlockSize, listFullCount, listEvents, errEvents, statusErrors,
+    // statusPolls, pollIntervalUs, lostWords, gapMarkers, listSize, peakWordsPerSec, listResizes, wordsSuppressed
+    int channelCount = 0;
+    if (session && !session->Channels().empty()) channelCount = session->Channels().back().channel + 1;
+    if (channelCount > STATS_MAX_CHANNELS) channelCount = STATS_MAX_CHANNELS;
+    Napi::Float64Array channels = Napi::Float64Array::New(env, channelCount * STATS_CHANNEL_FIELDS);
+    for (int ch = 0; ch < channelCount; ++ch) {
+        const ChannelStats& c = monitorStats.channels[ch];
+        double* row = channels.Data() + ch * STATS_CHANNEL_FIELDS;
+        row[0] = load(c.wordsRead);
+        row[1] = load(c.blockReads);
+        row[2] = load(c.lastBlockSize);
+        row[3] = load(c.maxBlockSize);
+        row[4] = load(c.listFullCount);
+        row[5] = load(c.listEvents);
+        row[6] = load(c.errEvents);
+        row[7] = load(c.statusErrors);
+        row[8] = load(c.statusPolls);
+        row[9] = load(c.pollIntervalUs);
+        row[10] = load(c.lostWords);
+        row[11] = load(c.gapMarkers);
+        row[12] = load(c.listSize);
+        row[13] = load(c.peakWordsPerSec);
+        row[14] = load(c.listResizes);
+        row[15] = load(c.wordsSuppressed);
+    }
+    resultObj.Set("demandMask", Napi::Number::New(env, session ? session->DemandMask() : 0)); // Bit per channel polled promptly
+    resultObj.Set("adaptiveLists", Napi::Boolean::New(env, session && session->AdaptiveLists()));
+    resultObj.Set("channelCount", Napi::Number::New(env, channelCount));
+    resultObj.Set("channelFields", Napi::Number::New(env, STATS_CHANNEL_FIELDS));
+    resultObj.Set("channels", channels);
 
-            LISTADDR listAddr = receiveListAddrs[channel];
-            if (listAddr == 0) continue; // Skip if list wasn't created
+    return resultObj;
+}
 
-            int listStatus = BTI429_ListStatus(listAddr, hCore);
+// --- Capture Daemon Client ---
 
-            if (listStatus < 0) {
-                 // Error checking list status
-                 const char* errStr = BTICard_ErrDescStr(listStatus, hCore);
-                 auto* errorData = new ArincErrorData{channel, listStatus, std::string("Error checking list status: ") + (errStr ? errStr : "Unknown error")};
-                 if (tsfnErrorUpdate) tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate);
-                 continue; // Skip this channel on error
-            }
+// Exported Function: AttachCaptureDaemon
+// attachCaptureDaemon(dataCallback, errorCallback, [name]) maps a running bti_capture_daemon's shared memory and
+// delivers its words and errors through the same callbacks as local monitoring (data records carry card/core).
+Napi::Value AttachCaptureDaemonWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() < 2 || info.Length() > 3 || !info[0].IsFunction() || !info[1].IsFunction() ||
+        (info.Length() == 3 && !info[2].IsString() && !info[2].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: dataCallback (Function), errorCallback (Function), [name (String)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = (info.Length() == 3 && info[2].IsString()) ? info[2].As<Napi::String>().Utf8Value() : CAPSHM_DEFAULT_NAME;
 
-            if (listStatus == STAT_PARTIAL || listStatus == STAT_FULL) {
-                dataProcessedInCycle = true;
-                USHORT countActuallyRead = 0; // Initialize to 0 before passing address
-                // std::cout << "Ch " << channel << " Status: " << listStatus << ". Reading up to " << MAX_READ_COUNT << std::endl;
-                BOOL success = BTI429_ListDataBlkRd(readBuffer.data(), &countActuallyRead, listAddr, hCore);
-                 // std::cout << "Ch " << channel << " Read attempt done. Success: " << success << ", Count: " << countActuallyRead << std::endl;
-
-                if (success && countActuallyRead > 0) {
-                    //std::cout << "Read " << countActuallyRead << " words from Ch " << channel << std::endl;
-                    for (USHORT i = 0; i < countActuallyRead; ++i) {
-                        ULONG word = readBuffer[i];
-                        int label = BTI429_FldGetLabel(word); // Label is bits 0-7
-                        auto now = std::chrono::steady_clock::now();
-
-                        // Update map
-                        auto& lastWord = latestWords[channel][label];
-                        auto& lastTime = lastUpdateTimes[channel][label];
-
-                        // Store/update data and add to batch for JS update
-                        lastWord = word;
-                        lastTime = now;
-                        updatesBatch->push_back({channel, label, word, steady_clock_to_epoch_ms(now)});
-                    }
-                } else if (!success) {
-                    // Handle read failure - check status again?
-                    int postReadStatus = BTI429_ListStatus(listAddr, hCore);
-                    const char* errStr = BTICard_ErrDescStr(postReadStatus, hCore);
-                    std::string errMsg = "Error reading data block (ListDataBlkRd failed).";
-                    if(postReadStatus < 0) {
-                        errMsg += " BTI Error: " + (errStr ? std::string(errStr) : "Unknown");
-                    } else {
-                        errMsg += " Post-read status: " + std::to_string(postReadStatus);
-                    }
-                     auto* errorData = new ArincErrorData{channel, (postReadStatus < 0 ? postReadStatus : ERR_FAIL), errMsg};
-                     if (tsfnErrorUpdate) tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate);
-                } else if (countActuallyRead == 0 && listStatus == STAT_FULL) {
-                     // This case might indicate an issue, log or report it
-                     // std::cerr << "Warning: Ch " << channel << " status FULL but read 0 words." << std::endl;
-                     // auto* errorData = new ArincErrorData{channel, ERR_INFO, "List status FULL but read 0 words."};
-                     // if (tsfnErrorUpdate) tsfnErrorUpdate.BlockingCall(errorData, CallJsErrorUpdate);
-                }
-            }
-        }
-        if (!monitoringActive.load()) break; // Check flag again after loop
-
-        // 3. Send Batch Update if data was found/processed
-        if (!updatesBatch->empty()) {
-            if (tsfnDataUpdate) {
-               napi_status status = tsfnDataUpdate.BlockingCall(updatesBatch, CallJsDataUpdate);
-                if (status != napi_ok && status != napi_closing) { // Ignore error if stopping
-                    std::cerr << "Failed to call tsfnDataUpdate! Status: " << status << std::endl;
-                    delete updatesBatch; // Clean up if call failed
-                } else if (status == napi_closing) {
-                     std::cout << "tsfnDataUpdate closing, discarding batch." << std::endl;
-                      delete updatesBatch;
-                } // On napi_ok, updatesBatch is deleted inside CallJsDataUpdate
-            } else {
-                std::cerr << "tsfnDataUpdate is null, discarding batch." << std::endl;
-                delete updatesBatch; // Clean up if TSFN is null
-            }
-        } else {
-             delete updatesBatch; // Clean up if empty
-        }
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (Sessions().AnyMonitoring()) {
+        resultObj.Set("success", Napi::Boolean::New(env, false));
+        resultObj.Set("message", Napi::String::New(env, "Local monitoring is active. Stop it before attaching to the capture daemon."));
+        return resultObj;
+    }
+    if (StreamOwnedElsewhere(addon)) {
+        Napi::Error::New(env, "ARINC callbacks are registered in another JS environment. Stop monitoring there first.").ThrowAsJavaScriptException();
+        return env.Null();
+    }
 
-        // 4. Sleep
-        // Only sleep if no data was processed to stay responsive
-        if (!dataProcessedInCycle) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Polling interval when idle
-        } else {
-             std::this_thread::sleep_for(std::chrono::milliseconds(1)); // Shorter sleep if busy
-        }
+    ReleaseStreamCallbacks(addon, false);
+    CreateStreamCallbacks(env, addon, info[0].As<Napi::Function>(), info[1].As<Napi::Function>());
+    if (!AttachStream(addon)) {
+        ReleaseStreamCallbacks(addon, false);
+        resultObj.Set("success", Napi::Boolean::New(env, false));
+        resultObj.Set("message", Napi::String::New(env, "ARINC callbacks are registered in another JS environment."));
+        return resultObj;
     }
 
-    std::cout << "ARINC Monitor Thread Exiting." << std::endl;
+    std::string errorMessage;
+    bool success = Capture().Attach(name, &errorMessage);
+    if (!success) ReleaseStreamCallbacks(addon, false);
+    resultObj.Set("success", Napi::Boolean::New(env, success));
+    resultObj.Set("message", Napi::String::New(env, success ? "Attached to capture daemon " + name + "." : errorMessage));
+    return resultObj;
 }
-// --- Helper function to construct a 32-bit ARINC word ---
-// Relies on hardware/library to calculate Parity based on ChConfig setting
-uint32_t ConstructArincWord(uint8_t label, uint8_t sdi, uint32_t data, uint8_t ssm) {
-    uint32_t word = 0;
-    word |= (uint32_t)label;             // Bits 0-7
-    word |= ((uint32_t)sdi << 8);      // Bits 8-9
-    word |= ((data & 0x7FFFF) << 10);  // Bits 10-28 (mask data to 19 bits)
-    word |= ((uint32_t)ssm << 29);     // Bits 29-30
-    // Parity (Bit 31) is handled by hardware via CHCFG429_PAREVEN/PARODD
-    return word;
+
+// Exported Function: DetachCaptureDaemon
+// Stops following the daemon; the daemon itself keeps capturing.
+Napi::Value DetachCaptureDaemonWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object resultObj = Napi::Object::New(env);
+    bool wasAttached = Capture().IsAttached();
+    Capture().Detach();
+    if (!Sessions().AnyMonitoring()) ReleaseStreamCallbacks(GetAddonData(env), true);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, wasAttached ? "Detached from capture daemon." : "Capture daemon was not attached."));
+    return resultObj;
 }
-// --- NEW ARINC Transmit Functions ---
 
-// Exported Function: StartTransmit
-Napi::Value StartTransmitWrapped(const Napi::CallbackInfo& info) {
+// Exported Function: StopCaptureDaemon
+// Asks the attached daemon to stop capturing and exit. The client reports "Capture daemon stopped." through the error callback.
+Napi::Value StopCaptureDaemonWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     Napi::Object resultObj = Napi::Object::New(env);
-     std::cout << "[C++ Addon] StartTransmitWrapped called." << std::endl; // DEBUG
+    bool requested = Capture().RequestDaemonStop();
+    resultObj.Set("success", Napi::Boolean::New(env, requested));
+    resultObj.Set("message", Napi::String::New(env, requested ? "Stop requested." : "Capture daemon is not attached."));
+    return resultObj;
+}
 
-    if (hCoreGlobal == NULL) {
-        std::cerr << "[C++ Addon] Error: Hardware not initialized (Core handle is null)." << std::endl;
-        resultObj.Set("status", Napi::Number::New(env, ERR_HWINIT)); // Use a distinct error code
-        resultObj.Set("message", Napi::String::New(env, "Error: Hardware not initialized."));
-        return resultObj;
-    }
-    // Expecting: channel(int), label(int), sdi(int), data(int), ssm(int), parity(int - currently ignored)
-    if (info.Length() < 6 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber() || !info[4].IsNumber() || !info[5].IsNumber()) {
-        std::cerr << "[C++ Addon] Error: Incorrect arguments for StartTransmit." << std::endl;
-        resultObj.Set("status", Napi::Number::New(env, ERR_PARAM)); // Use a distinct error code
-        resultObj.Set("message", Napi::String::New(env, "Error: Requires channel(int), label(int), sdi(int), data(int), ssm(int), parity(int)."));
+// Exported Function: GetCaptureDaemonStatus
+// Daemon state, heartbeat age, client word/loss counters and the daemon's per-core stats.
+Napi::Value GetCaptureDaemonStatusWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    CaptureClientStatus status = Capture().Status();
+    static const char* stateNames[] = { "starting", "running", "stopped", "failed" };
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("attached", Napi::Boolean::New(env, status.attached));
+    resultObj.Set("name", Napi::String::New(env, status.name));
+    resultObj.Set("state", Napi::String::New(env, status.state <= CAPSHM_STATE_FAILED ? stateNames[status.state] : "unknown"));
+    resultObj.Set("daemonPid", Napi::Number::New(env, status.daemonPid));
+    resultObj.Set("heartbeatAgeMs", Napi::Number::New(env, (double)status.heartbeatAgeMs));
+    resultObj.Set("writeIndex", Napi::Number::New(env, (double)status.writeIndex));
+    resultObj.Set("wordsReceived", Napi::Number::New(env, (double)status.wordsReceived));
+    resultObj.Set("wordsLost", Napi::Number::New(env, (double)status.wordsLost));
+    resultObj.Set("errorCount", Napi::Number::New(env, (double)status.errorCount));
+
+    Napi::Array sessions = Napi::Array::New(env, status.sessions.size());
+    for (size_t i = 0; i < status.sessions.size(); ++i) {
+        const CapShmSession& s = status.sessions[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("card", Napi::Number::New(env, s.card));
+        obj.Set("core", Napi::Number::New(env, s.core));
+        obj.Set("monitoring", Napi::Boolean::New(env, s.monitoring != 0));
+        obj.Set("channelCount", Napi::Number::New(env, s.channelCount));
+        obj.Set("cycles", Napi::Number::New(env, (double)s.cycles));
+        obj.Set("lastCycleUs", Napi::Number::New(env, (double)s.lastCycleUs));
+        obj.Set("maxCycleUs", Napi::Number::New(env, (double)s.maxCycleUs));
+        obj.Set("eventLogEntries", Napi::Number::New(env, (double)s.eventLogEntries));
+        Napi::Float64Array wordsRead = Napi::Float64Array::New(env, CAPSHM_MAX_CHANNELS);
+        for (int ch = 0; ch < CAPSHM_MAX_CHANNELS; ++ch) wordsRead[ch] = (double)s.wordsRead[ch];
+        obj.Set("wordsRead", wordsRead);
+        sessions.Set(static_cast<uint32_t>(i), obj);
+    }
+    resultObj.Set("sessions", sessions);
+    return resultObj;
+}
+
+// --- Shared-Memory Current-Value Table ---
+
+// Exported Function: StartValuePublisher
+// startValuePublisher([name]) publishes every channel/label's latest word, timestamps and count (plus per-core
+// stats) to a named shared-memory region that local tools read lock-free with capture_shm_reader.h.
+// Covers locally monitored cores; while attached to the capture daemon, readers map the daemon's region instead.
+Napi::Value StartValuePublisherWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0].IsString() && !info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: [name (String)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string name = (info.Length() == 1 && info[0].IsString()) ? info[0].As<Napi::String>().Utf8Value() : VALUE_TABLE_DEFAULT_NAME;
+
+    std::string errorMessage;
+    bool success = ValueTable().Start(name, &errorMessage);
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, success));
+    resultObj.Set("message", Napi::String::New(env, success ? "Publishing current values to " + name + "." : errorMessage));
+    resultObj.Set("name", Napi::String::New(env, name));
+    return resultObj;
+}
+
+// Exported Function: StopValuePublisher
+// Marks the region stopped and unmaps it; readers still holding it see state STOPPED and a stale heartbeat.
+Napi::Value StopValuePublisherWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    bool wasPublishing = ValueTable().IsPublishing();
+    ValueTable().Stop();
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, wasPublishing ? "Current-value table stopped." : "Current-value table was not published."));
+    return resultObj;
+}
+
+// --- Subscriber Bus ---
+// Independent consumers of the ingest stream, each with its own filter, policy, queue and delivery thread.
+// Subscriptions work alongside initializeReceiver's callbacks and from any JS environment.
+
+struct Subscription {
+    int id = 0;
+    Napi::ThreadSafeFunction tsfn;
+};
+
+// Runs on the subscriber's delivery thread. The TSFN queue is short, so a slow JS consumer blocks here
+// and its bus queue absorbs (or sheds) the backlog.
+void DeliverSubscriberBatch(void* context, std::vector<ArincUpdateData>* batch) {
+    Subscription* subscription = static_cast<Subscription*>(context);
+    napi_status status = subscription->tsfn.BlockingCall(batch,
+        [](Napi::Env env, Napi::Function jsCallback, std::vector<ArincUpdateData>* updates) {
+            if (env != nullptr && !jsCallback.IsEmpty()) jsCallback.Call({UpdatesToArray(env, *updates)});
+            delete updates;
+        });
+    if (status != napi_ok) delete batch;
+}
+
+// Unblocks a delivery thread waiting in BlockingCall so Unsubscribe can join it (called on the JS thread)
+void CancelSubscriberDelivery(void* context) {
+    static_cast<Subscription*>(context)->tsfn.Abort();
+}
+
+bool ParseDeliveryPolicy(const std::string& name, DeliveryPolicy* policy) {
+    if (name == "every") *policy = DeliveryPolicy::EveryWord;
+    else if (name == "coalesced") *policy = DeliveryPolicy::Coalesced;
+    else if (name == "snapshot") *policy = DeliveryPolicy::Snapshot;
+    else return false;
+    return true;
+}
+
+const char* DeliveryPolicyName(DeliveryPolicy policy) {
+    switch (policy) {
+    case DeliveryPolicy::Coalesced: return "coalesced";
+    case DeliveryPolicy::Snapshot: return "snapshot";
+    default: return "every";
+    }
+}
+
+void RemoveSubscription(AddonData* addon, int id) {
+    auto it = addon->subscriptions.find(id);
+    if (it == addon->subscriptions.end()) return;
+    Bus().Unsubscribe(id); // Aborts the TSFN and joins the delivery thread
+    delete it->second;
+    addon->subscriptions.erase(it);
+}
+
+// Options shared by subscribe and startCaptureRecording: card, core, channels: [int], labels: [int], batchSize, maxQueue
+void ParseSubscriberFilter(Napi::Object options, SubscriberConfig* config) {
+    auto intOption = [&](const char* key, int* out) {
+        if (options.Has(key) && options.Get(key).IsNumber()) *out = options.Get(key).As<Napi::Number>().Int32Value();
+    };
+    intOption("card", &config->card);
+    intOption("core", &config->core);
+    int batchSize = (int)config->batchSize, maxQueue = (int)config->maxQueue;
+    intOption("batchSize", &batchSize);
+    intOption("maxQueue", &maxQueue);
+    config->batchSize = (size_t)std::max(batchSize, 1);
+    config->maxQueue = (size_t)std::max(maxQueue, 1);
+    if (options.Has("channels") && options.Get("channels").IsArray()) {
+        Napi::Array channels = options.Get("channels").As<Napi::Array>();
+        for (uint32_t i = 0; i < channels.Length(); ++i) {
+            Napi::Value value = channels.Get(i);
+            int channel = value.IsNumber() ? value.As<Napi::Number>().Int32Value() : -1;
+            if (channel >= 0 && channel < 32) config->channelMask |= 1u << channel;
+        }
+    }
+    if (options.Has("labels") && options.Get("labels").IsArray()) {
+        Napi::Array labels = options.Get("labels").As<Napi::Array>();
+        for (uint32_t i = 0; i < labels.Length(); ++i) {
+            Napi::Value value = labels.Get(i);
+            int label = value.IsNumber() ? value.As<Napi::Number>().Int32Value() : -1;
+            if (label >= 0 && label < 256) config->labels.set(label);
+        }
+    }
+}
+
+// Exported Function: Subscribe
+// subscribe(callback, [options]) -> { success, message, id }. options: { name, card, core, channels: [int],
+// labels: [int], policy: 'every' | 'coalesced' | 'snapshot', batchSize, intervalMs, maxQueue }.
+// The callback receives arrays shaped like initializeReceiver's data callback.
+Napi::Value SubscribeWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() < 1 || !info[0].IsFunction() || (info.Length() >= 2 && !info[1].IsObject() && !info[1].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: callback (Function), [options (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    SubscriberConfig config;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        ParseSubscriberFilter(options, &config);
+        if (options.Has("name") && options.Get("name").IsString()) config.name = options.Get("name").As<Napi::String>().Utf8Value();
+        if (options.Has("intervalMs") && options.Get("intervalMs").IsNumber()) config.intervalMs = options.Get("intervalMs").As<Napi::Number>().Int32Value();
+        Napi::Value policy = options.Get("policy");
+        if (!policy.IsUndefined() && (!policy.IsString() || !ParseDeliveryPolicy(policy.As<Napi::String>().Utf8Value(), &config.policy))) {
+            Napi::TypeError::New(env, "policy must be 'every', 'coalesced' or 'snapshot'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    Subscription* subscription = new Subscription();
+    subscription->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        info[0].As<Napi::Function>(),
+        "ARINC Subscriber", // Resource Name
+        2, // Max Queue Size: small, so a slow callback pushes back on this subscriber's own queue
+        1  // Initial Thread Count
+    );
+    subscription->id = Bus().Subscribe(config, DeliverSubscriberBatch, CancelSubscriberDelivery, subscription);
+    addon->subscriptions[subscription->id] = subscription;
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, "Subscribed (" + std::string(DeliveryPolicyName(config.policy)) + ")."));
+    resultObj.Set("id", Napi::Number::New(env, subscription->id));
+    return resultObj;
+}
+
+// Exported Function: Unsubscribe
+// unsubscribe(id); only subscriptions created in the calling JS environment can be removed from it
+Napi::Value UnsubscribeWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsNumber()) {
+        Napi::TypeError::New(env, "Expected: id (Number)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    AddonData* addon = GetAddonData(env);
+    int id = info[0].As<Napi::Number>().Int32Value();
+    bool found = addon->subscriptions.count(id) != 0;
+    RemoveSubscription(addon, id);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, found));
+    resultObj.Set("message", Napi::String::New(env, found ? "Unsubscribed." : "No such subscription in this environment."));
+    return resultObj;
+}
+
+// Exported Function: GetSubscriptions
+// Per-subscriber counters for every subscription in the process (all environments).
+Napi::Value GetSubscriptionsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<SubscriberStats> stats = Bus().Stats();
+    Napi::Array result = Napi::Array::New(env, stats.size());
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const SubscriberStats& s = stats[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("id", Napi::Number::New(env, s.id));
+        obj.Set("name", Napi::String::New(env, s.name));
+        obj.Set("policy", Napi::String::New(env, DeliveryPolicyName(s.policy)));
+        obj.Set("wordsMatched", Napi::Number::New(env, (double)s.wordsMatched));
+        obj.Set("wordsDelivered", Napi::Number::New(env, (double)s.wordsDelivered));
+        obj.Set("wordsDropped", Napi::Number::New(env, (double)s.wordsDropped));
+        obj.Set("wordsCoalesced", Napi::Number::New(env, (double)s.wordsCoalesced));
+        obj.Set("batchesDelivered", Napi::Number::New(env, (double)s.batchesDelivered));
+        obj.Set("queueDepth", Napi::Number::New(env, (double)s.queueDepth));
+        obj.Set("queueDepthMax", Napi::Number::New(env, (double)s.queueDepthMax));
+        result.Set(static_cast<uint32_t>(i), obj);
+    }
+    return result;
+}
+
+// --- Capture Files ---
+// Long recordings go to block-compressed files (capture_file.h) through a bus subscription; reading them back
+// decodes the blocks on a pool of threads off the JS thread.
+
+void SetCaptureRecordingStats(Napi::Env env, Napi::Object resultObj, const CaptureRecordingStats& stats) {
+    resultObj.Set("active", Napi::Boolean::New(env, stats.active));
+    resultObj.Set("path", Napi::String::New(env, stats.path));
+    resultObj.Set("words", Napi::Number::New(env, (double)stats.words));
+    resultObj.Set("blocks", Napi::Number::New(env, (double)stats.blocks));
+    resultObj.Set("fileBytes", Napi::Number::New(env, (double)stats.fileBytes));
+    resultObj.Set("wordsDropped", Napi::Number::New(env, (double)stats.wordsDropped));
+    // Against one 24-byte record per word (the readCaptureFile / getChangesSince record size)
+    resultObj.Set("compressionRatio", Napi::Number::New(env,
+        stats.fileBytes ? (double)(stats.words * sizeof(CaptureRecord)) / stats.fileBytes : 0.0));
+    if (!stats.error.empty()) resultObj.Set("error", Napi::String::New(env, stats.error));
+}
+
+// Exported Function: StartCaptureRecording
+// startCaptureRecording(path, [options]) records every word (and gap marker) of the ingest stream, local sessions or
+// the capture daemon, until stopCaptureRecording. options: { card, core, channels, labels, blockWords (default
+// 65536), maxQueue (default 1048576) }. One recording per process.
+Napi::Value StartCaptureRecordingWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString() || (info.Length() >= 2 && !info[1].IsObject() && !info[1].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: path (String), [options (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    SubscriberConfig filter;
+    filter.batchSize = 4096;
+    filter.maxQueue = 1 << 20; // A disk stall should not shed words the recording was meant to keep
+    uint32_t blockWords = CAPTURE_DEFAULT_BLOCK_WORDS;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        ParseSubscriberFilter(options, &filter);
+        if (options.Get("blockWords").IsNumber()) blockWords = options.Get("blockWords").As<Napi::Number>().Uint32Value();
+    }
+
+    std::string errorMessage;
+    bool success = Recorder().Start(path, filter, blockWords, &errorMessage);
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, success));
+    resultObj.Set("message", Napi::String::New(env, success ? "Recording to " + path + "." : errorMessage));
+    return resultObj;
+}
+
+// Exported Function: StopCaptureRecording
+// Writes the last block and closes the file; returns the recording's final stats.
+Napi::Value StopCaptureRecordingWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    CaptureRecordingStats stats;
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (!Recorder().Stats().active) {
+        resultObj.Set("success", Napi::Boolean::New(env, false));
+        resultObj.Set("message", Napi::String::New(env, "No capture recording is active."));
+        return resultObj;
+    }
+    bool success = Recorder().Stop(&stats);
+    SetCaptureRecordingStats(env, resultObj, stats);
+    resultObj.Set("success", Napi::Boolean::New(env, success));
+    resultObj.Set("message", Napi::String::New(env, success ? "Capture recording closed." : "Capture recording closed with errors."));
+    return resultObj;
+}
+
+// Exported Function: GetCaptureRecordingStats
+Napi::Value GetCaptureRecordingStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object resultObj = Napi::Object::New(env);
+    SetCaptureRecordingStats(env, resultObj, Recorder().Stats());
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    return resultObj;
+}
+
+class ReadCaptureWorker : public Napi::AsyncWorker {
+public:
+    ReadCaptureWorker(Napi::Env env, const std::string& path, int threads, size_t firstBlock, size_t blockCount)
+        : Napi::AsyncWorker(env), path_(path), threads_(threads), firstBlock_(firstBlock), blockCount_(blockCount),
+          deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    void Execute() override {
+        TRACE_SCOPE("ReadCaptureFile");
+        CaptureFileReader reader;
+        std::string error;
+        if (!reader.Open(path_, &error)) {
+            SetError(error);
+            return;
+        }
+        totalBlocks_ = reader.Blocks().size();
+        totalWords_ = reader.TotalWords();
+        firstBlock_ = std::min(firstBlock_, totalBlocks_);
+        blockCount_ = std::min(blockCount_, totalBlocks_ - firstBlock_);
+        std::vector<std::vector<ArincUpdateData>> blocks;
+        if (!reader.DecodeBlocks(firstBlock_, blockCount_, threads_, &blocks, &error)) {
+            SetError(error);
+            return;
+        }
+        size_t count = 0;
+        for (const auto& block : blocks) count += block.size();
+        records_.reserve(count);
+        for (const auto& block : blocks) {
+            for (const ArincUpdateData& update : block) records_.push_back(ToCaptureRecord(update));
+        }
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        size_t bytes = records_.size() * sizeof(CaptureRecord);
+        Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+        if (bytes) std::memcpy(buffer.Data(), records_.data(), bytes);
+        Napi::Object resultObj = Napi::Object::New(env);
+        resultObj.Set("success", Napi::Boolean::New(env, true));
+        resultObj.Set("count", Napi::Number::New(env, (double)records_.size()));
+        resultObj.Set("recordSize", Napi::Number::New(env, (double)sizeof(CaptureRecord)));
+        resultObj.Set("buffer", buffer);
+        resultObj.Set("firstBlock", Napi::Number::New(env, (double)firstBlock_));
+        resultObj.Set("blockCount", Napi::Number::New(env, (double)blockCount_));
+        resultObj.Set("totalBlocks", Napi::Number::New(env, (double)totalBlocks_));
+        resultObj.Set("totalWords", Napi::Number::New(env, (double)totalWords_));
+        deferred_.Resolve(resultObj);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        Napi::Object errorObj = Napi::Object::New(Env());
+        errorObj.Set("success", Napi::Boolean::New(Env(), false));
+        errorObj.Set("message", Napi::String::New(Env(), e.Message()));
+        deferred_.Reject(errorObj);
+    }
+
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+private:
+    std::string path_;
+    int threads_;
+    size_t firstBlock_;
+    size_t blockCount_;
+    size_t totalBlocks_ = 0;
+    uint64_t totalWords_ = 0;
+    std::vector<CaptureRecord> records_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Exported Function: ReadCaptureFile
+// readCaptureFile(path, [options { threads, firstBlock, blockCount }]) -> Promise<{ count, recordSize, buffer,
+// firstBlock, blockCount, totalBlocks, totalWords }>. buffer packs one 24-byte little-endian record per word:
+// i64 timestampNs, f64 timestampMs, u32 word, u8 card (| 0x80 = gap marker, word = words lost), u8 core,
+// u8 channel, u8 label. Large files are read a range of blocks at a time.
+Napi::Value ReadCaptureFileWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString() || (info.Length() >= 2 && !info[1].IsObject() && !info[1].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: path (String), [options (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    double firstBlock = 0, blockCount = 1e15;
+    if (info.Length() >= 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Get("threads").IsNumber()) threads = std::max(1, options.Get("threads").As<Napi::Number>().Int32Value());
+        if (options.Get("firstBlock").IsNumber()) firstBlock = std::max(0.0, options.Get("firstBlock").As<Napi::Number>().DoubleValue());
+        if (options.Get("blockCount").IsNumber()) blockCount = std::max(0.0, options.Get("blockCount").As<Napi::Number>().DoubleValue());
+    }
+    ReadCaptureWorker* worker = new ReadCaptureWorker(env, info[0].As<Napi::String>().Utf8Value(), threads,
+        (size_t)firstBlock, (size_t)blockCount);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+// Decoding of one label: { format: 'raw' | 'bnr' | 'bcd' | 'discrete', msb, lsb, resolution }. msb/lsb are ARINC
+// bit numbers (BNR default 28..11, others 29..11); resolution is the lsb weight (default 1).
+bool ParseLabelDecoding(Napi::Object obj, LabelDecoding* decoding, std::string* error) {
+    Napi::Value format = obj.Get("format");
+    if (!format.IsUndefined() && (!format.IsString() || !ParseLabelFormat(format.As<Napi::String>().Utf8Value(), &decoding->format))) {
+        *error = "format must be 'raw', 'bnr', 'bcd' or 'discrete'";
+        return false;
+    }
+    decoding->msb = decoding->format == LabelFormat::Bnr ? 28 : 29;
+    if (obj.Get("msb").IsNumber()) decoding->msb = obj.Get("msb").As<Napi::Number>().Int32Value();
+    if (obj.Get("lsb").IsNumber()) decoding->lsb = obj.Get("lsb").As<Napi::Number>().Int32Value();
+    if (obj.Get("resolution").IsNumber()) decoding->resolution = obj.Get("resolution").As<Napi::Number>().DoubleValue();
+    return ValidateDecoding(*decoding, error);
+}
+
+// Decoding rules: [{ channel?, label, ...decoding (see ParseLabelDecoding) }]
+bool ParseLabelDecodingRules(Napi::Value value, std::vector<LabelDecodingRule>* rules, std::string* error) {
+    if (value.IsUndefined() || value.IsNull()) return true;
+    if (!value.IsArray()) {
+        *error = "decode must be an array";
+        return false;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+        std::string where = "decode[" + std::to_string(i) + "]: ";
+        Napi::Value entry = array.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("label").IsNumber()) {
+            *error = where + "needs a numeric label";
+            return false;
+        }
+        Napi::Object ruleObj = entry.As<Napi::Object>();
+        LabelDecodingRule rule;
+        rule.label = ruleObj.Get("label").As<Napi::Number>().Int32Value();
+        if (rule.label < 0 || rule.label > 255) {
+            *error = where + "label must be 0..255";
+            return false;
+        }
+        if (ruleObj.Get("channel").IsNumber()) rule.channel = ruleObj.Get("channel").As<Napi::Number>().Int32Value();
+        if (!ParseLabelDecoding(ruleObj, &rule.decoding, error)) {
+            *error = where + *error;
+            return false;
+        }
+        rules->push_back(rule);
+    }
+    return true;
+}
+
+class ExportCaptureWorker : public Napi::AsyncProgressWorker<ExportProgress> {
+public:
+    ExportCaptureWorker(Napi::Env env, const std::string& capturePath, const std::string& outPath,
+                        const std::vector<LabelDecodingRule>& rules, int threads, Napi::Function progressCallback)
+        : Napi::AsyncProgressWorker<ExportProgress>(env), capturePath_(capturePath), outPath_(outPath), threads_(threads),
+          deferred_(Napi::Promise::Deferred::New(env)) {
+        for (const LabelDecodingRule& rule : rules) decoder_.Add(rule);
+        if (!progressCallback.IsEmpty()) progressCallback_ = Napi::Persistent(progressCallback);
+    }
+
+    void Execute(const ExecutionProgress& progress) override {
+        std::string error;
+        if (!ExportCaptureColumnar(capturePath_, outPath_, decoder_, threads_,
+                [&](const ExportProgress& status) { progress.Send(&status, 1); }, nullptr, &result_, &error)) {
+            SetError(error);
+        }
+    }
+
+    // Runs on the JS thread; progress reports may be coalesced, so only the latest is passed on
+    void OnProgress(const ExportProgress* data, size_t count) override {
+        if (!data || count == 0 || progressCallback_.IsEmpty()) return;
+        const ExportProgress& status = data[count - 1];
+        Napi::Object obj = Napi::Object::New(Env());
+        obj.Set("rowsDone", Napi::Number::New(Env(), (double)status.rowsDone));
+        obj.Set("rowsTotal", Napi::Number::New(Env(), (double)status.rowsTotal));
+        obj.Set("bytesWritten", Napi::Number::New(Env(), (double)status.bytesWritten));
+        progressCallback_.Value().Call({obj});
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        Napi::Object resultObj = Napi::Object::New(env);
+        resultObj.Set("success", Napi::Boolean::New(env, true));
+        resultObj.Set("path", Napi::String::New(env, outPath_));
+        resultObj.Set("rows", Napi::Number::New(env, (double)result_.rows));
+        resultObj.Set("rowGroups", Napi::Number::New(env, (double)result_.rowGroups));
+        resultObj.Set("bytesWritten", Napi::Number::New(env, (double)result_.bytesWritten));
+        resultObj.Set("elapsedMs", Napi::Number::New(env, (double)result_.elapsedMs));
+        deferred_.Resolve(resultObj);
+    }
+
+    void OnError(const Napi::Error& e) override {
+        Napi::Object errorObj = Napi::Object::New(Env());
+        errorObj.Set("success", Napi::Boolean::New(Env(), false));
+        errorObj.Set("message", Napi::String::New(Env(), e.Message()));
+        deferred_.Reject(errorObj);
+    }
+
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+private:
+    std::string capturePath_;
+    std::string outPath_;
+    int threads_;
+    LabelDecoderTable decoder_;
+    Napi::FunctionReference progressCallback_;
+    ExportResult result_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Exported Function: ExportCaptureColumnar
+// exportCaptureColumnar(capturePath, outPath, [options { threads, decode }], [progress({ rowsDone, rowsTotal,
+// bytesWritten })]) -> Promise<{ path, rows, rowGroups, bytesWritten, elapsedMs }>. Writes the "BTICOL" columnar
+// layout documented in capture_export.h (timestamp, card, core, channel, label, SDI, SSM, flags, raw word, value);
+// decode (see ParseLabelDecodingRules) selects how the value column is computed, raw data bits 11..29 otherwise.
+Napi::Value ExportCaptureColumnarWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsString() ||
+        (info.Length() >= 3 && !info[2].IsObject() && !info[2].IsUndefined() && !info[2].IsNull()) ||
+        (info.Length() >= 4 && !info[3].IsFunction() && !info[3].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: capturePath (String), outPath (String), [options (Object)], [progress (Function)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<LabelDecodingRule> rules;
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (options.Get("threads").IsNumber()) threads = std::max(1, options.Get("threads").As<Napi::Number>().Int32Value());
+        std::string error;
+        if (!ParseLabelDecodingRules(options.Get("decode"), &rules, &error)) {
+            Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+    Napi::Function progress = (info.Length() >= 4 && info[3].IsFunction()) ? info[3].As<Napi::Function>() : Napi::Function();
+    ExportCaptureWorker* worker = new ExportCaptureWorker(env, info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::String>().Utf8Value(), rules, threads, progress);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+// --- Plot Downsampling ---
+// One label's decoded values reduced to about one point per pixel (downsample.h), returned as Float64Arrays.
+
+struct DownsampleRequest {
+    SeriesSelector selector;
+    int width = 1000;             // Buckets (minmax) or points (lttb)
+    bool lttb = false;
+};
+
+struct DownsampleResult {
+    bool lttb = false;
+    size_t sourcePoints = 0;
+    Series points;                // lttb
+    MinMaxSeries buckets;         // minmax
+};
+
+// { channel?, label, card?, core?, sdi?, ...decoding (see ParseLabelDecoding), startMs?, endMs?, width, mode: 'minmax' | 'lttb' }
+bool ParseDownsampleRequest(Napi::Object options, DownsampleRequest* request, std::string* error) {
+    SeriesSelector& selector = request->selector;
+    if (!options.Get("label").IsNumber()) {
+        *error = "label is required";
+        return false;
+    }
+    selector.label = options.Get("label").As<Napi::Number>().Int32Value();
+    if (options.Get("channel").IsNumber()) selector.channel = options.Get("channel").As<Napi::Number>().Int32Value();
+    if (options.Get("card").IsNumber()) selector.card = options.Get("card").As<Napi::Number>().Int32Value();
+    if (options.Get("core").IsNumber()) selector.core = options.Get("core").As<Napi::Number>().Int32Value();
+    if (options.Get("sdi").IsNumber()) selector.sdi = options.Get("sdi").As<Napi::Number>().Int32Value();
+    if (options.Get("startMs").IsNumber()) selector.startMs = options.Get("startMs").As<Napi::Number>().DoubleValue();
+    if (options.Get("endMs").IsNumber()) selector.endMs = options.Get("endMs").As<Napi::Number>().DoubleValue();
+    if (options.Get("width").IsNumber()) request->width = options.Get("width").As<Napi::Number>().Int32Value();
+    Napi::Value mode = options.Get("mode");
+    if (!mode.IsUndefined()) {
+        std::string name = mode.IsString() ? mode.As<Napi::String>().Utf8Value() : "";
+        if (name != "minmax" && name != "lttb") {
+            *error = "mode must be 'minmax' or 'lttb'";
+            return false;
+        }
+        request->lttb = name == "lttb";
+    }
+    if (selector.label < 0 || selector.label > 255 || selector.sdi < -1 || selector.sdi > 3) {
+        *error = "label must be 0..255 and sdi 0..3";
+        return false;
+    }
+    if (request->width < 1 || request->width > 1000000) {
+        *error = "width must be 1..1000000";
+        return false;
+    }
+    if (!(selector.startMs <= selector.endMs)) {
+        *error = "startMs must not be after endMs";
+        return false;
+    }
+    return ParseLabelDecoding(options, &selector.decoding, error);
+}
+
+void RunDownsample(const DownsampleRequest& request, const Series& series, DownsampleResult* result) {
+    TRACE_SCOPE_ARG("Downsample", "points", series.timeMs.size());
+    result->lttb = request.lttb;
+    result->sourcePoints = series.timeMs.size();
+    if (request.lttb) {
+        DownsampleLttb(series, request.width, &result->points);
+    } else {
+        double startMs = std::isfinite(request.selector.startMs) ? request.selector.startMs : std::nan("");
+        double endMs = std::isfinite(request.selector.endMs) ? request.selector.endMs : std::nan("");
+        DownsampleMinMax(series, startMs, endMs, request.width, &result->buckets);
+    }
+}
+
+Napi::Float64Array ToFloat64Array(Napi::Env env, const std::vector<double>& values) {
+    Napi::Float64Array array = Napi::Float64Array::New(env, values.size());
+    if (!values.empty()) std::memcpy(array.Data(), values.data(), values.size() * sizeof(double));
+    return array;
+}
+
+// { success, mode, sourcePoints, count, time, value } (lttb) or { ..., time, min, max } (minmax; time = bucket start)
+Napi::Object DownsampleResultToObject(Napi::Env env, const DownsampleResult& result) {
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("mode", Napi::String::New(env, result.lttb ? "lttb" : "minmax"));
+    resultObj.Set("sourcePoints", Napi::Number::New(env, (double)result.sourcePoints));
+    if (result.lttb) {
+        resultObj.Set("count", Napi::Number::New(env, (double)result.points.timeMs.size()));
+        resultObj.Set("time", ToFloat64Array(env, result.points.timeMs));
+        resultObj.Set("value", ToFloat64Array(env, result.points.value));
+    } else {
+        resultObj.Set("count", Napi::Number::New(env, (double)result.buckets.timeMs.size()));
+        resultObj.Set("time", ToFloat64Array(env, result.buckets.timeMs));
+        resultObj.Set("min", ToFloat64Array(env, result.buckets.min));
+        resultObj.Set("max", ToFloat64Array(env, result.buckets.max));
+    }
+    return resultObj;
+}
+
+class DownsampleCaptureWorker : public Napi::AsyncWorker {
+public:
+    DownsampleCaptureWorker(Napi::Env env, const std::string& path, const DownsampleRequest& request, int threads)
+        : Napi::AsyncWorker(env), path_(path), request_(request), threads_(threads),
+          deferred_(Napi::Promise::Deferred::New(env)) {}
+
+    void Execute() override {
+        Series series;
+        std::string error;
+        if (!ReadCaptureSeries(path_, request_.selector, threads_, &series, &error)) {
+            SetError(error);
+            return;
+        }
+        RunDownsample(request_, series, &result_);
+    }
+
+    void OnOK() override {
+        deferred_.Resolve(DownsampleResultToObject(Env(), result_));
+    }
+
+    void OnError(const Napi::Error& e) override {
+        Napi::Object errorObj = Napi::Object::New(Env());
+        errorObj.Set("success", Napi::Boolean::New(Env(), false));
+        errorObj.Set("message", Napi::String::New(Env(), e.Message()));
+        deferred_.Reject(errorObj);
+    }
+
+    Napi::Promise GetPromise() { return deferred_.Promise(); }
+
+private:
+    std::string path_;
+    DownsampleRequest request_;
+    int threads_;
+    DownsampleResult result_;
+    Napi::Promise::Deferred deferred_;
+};
+
+// Exported Function: DownsampleCaptureFile
+// downsampleCaptureFile(path, options { ...see ParseDownsampleRequest, threads }) -> Promise<{ mode, sourcePoints,
+// count, time: Float64Array, value | min, max: Float64Array }>. Decodes only the blocks overlapping startMs..endMs
+// (ms on the data stream's timestamp clock), on a worker thread.
+Napi::Value DownsampleCaptureFileWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !info[0].IsString() || !info[1].IsObject()) {
+        Napi::TypeError::New(env, "Expected: path (String), options (Object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object options = info[1].As<Napi::Object>();
+    DownsampleRequest request;
+    std::string error;
+    if (!ParseDownsampleRequest(options, &request, &error)) {
+        Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    if (options.Get("threads").IsNumber()) threads = std::max(1, options.Get("threads").As<Napi::Number>().Int32Value());
+    DownsampleCaptureWorker* worker = new DownsampleCaptureWorker(env, info[0].As<Napi::String>().Utf8Value(), request, threads);
+    worker->Queue();
+    return worker->GetPromise();
+}
+
+// --- Label History ---
+// Native per-label rings (history_store.h) fed by a registry tap; queries return TypedArrays.
+
+// Exported Function: SetHistory
+// setHistory({ maxAgeSeconds, maxSamples, memoryLimitMB } | null). Starts recording the recent words of every label
+// (defaults 60 s, 65536 samples per label, 256 MB in all; maxAgeSeconds 0 = count budget only), applies new budgets
+// while recording, or stops and frees it (null).
+Napi::Value SetHistoryWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !(info[0].IsObject() || info[0].IsNull())) {
+        Napi::TypeError::New(env, "Expected: options (Object) | null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[0].IsNull()) {
+        History().Stop();
+        resultObj.Set("success", Napi::Boolean::New(env, true));
+        resultObj.Set("message", Napi::String::New(env, "Label history stopped."));
         return resultObj;
     }
+    Napi::Object options = info[0].As<Napi::Object>();
+    HistoryConfig config;
+    if (options.Get("maxAgeSeconds").IsNumber()) {
+        config.maxAgeNs = (int64_t)(options.Get("maxAgeSeconds").As<Napi::Number>().DoubleValue() * 1e9);
+    }
+    if (options.Get("maxSamples").IsNumber()) {
+        config.maxSamples = (uint32_t)std::min(std::max(options.Get("maxSamples").As<Napi::Number>().DoubleValue(), 0.0), 4294967295.0);
+    }
+    if (options.Get("memoryLimitMB").IsNumber()) {
+        config.memoryLimitBytes = (size_t)(std::max(options.Get("memoryLimitMB").As<Napi::Number>().DoubleValue(), 0.0) * 1048576.0);
+    }
+    std::string error;
+    bool started = History().Start(config, &error);
+    resultObj.Set("success", Napi::Boolean::New(env, started));
+    resultObj.Set("message", Napi::String::New(env, started ? "Label history recording." : error));
+    return resultObj;
+}
+
+// Exported Function: GetHistory
+// getHistory({ channel, label, card?, core?, seconds?, startMs?, endMs? }) -> { success, count, time: Float64Array,
+// word: Uint32Array }. The label's words over the last `seconds` (or startMs..endMs, ms on the data stream's
+// timestamp clock), oldest first; card/core omitted = every core's.
+Napi::Value GetHistoryWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsObject() || !info[0].As<Napi::Object>().Get("label").IsNumber()) {
+        Napi::TypeError::New(env, "Expected: options (Object) with a numeric label").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    int label = options.Get("label").As<Napi::Number>().Int32Value();
+    int channel = options.Get("channel").IsNumber() ? options.Get("channel").As<Napi::Number>().Int32Value() : -1;
+    int card = options.Get("card").IsNumber() ? options.Get("card").As<Napi::Number>().Int32Value() : -1;
+    int core = options.Get("core").IsNumber() ? options.Get("core").As<Napi::Number>().Int32Value() : -1;
+    int64_t startNs = INT64_MIN, endNs = INT64_MAX;
+    if (options.Get("seconds").IsNumber()) {
+        startNs = HostNowNs() - (int64_t)(options.Get("seconds").As<Napi::Number>().DoubleValue() * 1e9);
+    }
+    if (options.Get("startMs").IsNumber()) startNs = (int64_t)std::floor(options.Get("startMs").As<Napi::Number>().DoubleValue() * 1e6);
+    if (options.Get("endMs").IsNumber()) endNs = (int64_t)std::ceil(options.Get("endMs").As<Napi::Number>().DoubleValue() * 1e6);
+
+    std::vector<int64_t> timesNs;
+    std::vector<uint32_t> words;
+    History().Query(card, core, channel, label, startNs, endNs, &timesNs, &words);
+    Napi::Float64Array times = Napi::Float64Array::New(env, timesNs.size());
+    for (size_t i = 0; i < timesNs.size(); ++i) times[i] = timesNs[i] / 1e6;
+    Napi::Uint32Array wordArray = Napi::Uint32Array::New(env, words.size());
+    if (!words.empty()) std::memcpy(wordArray.Data(), words.data(), words.size() * sizeof(uint32_t));
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("recording", Napi::Boolean::New(env, History().IsRunning()));
+    resultObj.Set("count", Napi::Number::New(env, (double)timesNs.size()));
+    resultObj.Set("time", times);
+    resultObj.Set("word", wordArray);
+    return resultObj;
+}
+
+// Exported Function: GetHistoryStats
+// getHistoryStats() -> { recording, rings, samples, bytes, wordsStored, wordsRejected, evictedEarly, ringGrowths }.
+// evictedEarly counts samples overwritten within maxAge because the memory limit kept their ring from growing.
+Napi::Value GetHistoryStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    HistoryStats stats = History().Stats();
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("recording", Napi::Boolean::New(env, History().IsRunning()));
+    resultObj.Set("rings", Napi::Number::New(env, (double)stats.rings));
+    resultObj.Set("samples", Napi::Number::New(env, (double)stats.samples));
+    resultObj.Set("bytes", Napi::Number::New(env, (double)stats.bytes));
+    resultObj.Set("wordsStored", Napi::Number::New(env, (double)stats.wordsStored));
+    resultObj.Set("wordsRejected", Napi::Number::New(env, (double)stats.wordsRejected));
+    resultObj.Set("evictedEarly", Napi::Number::New(env, (double)stats.evictedEarly));
+    resultObj.Set("ringGrowths", Napi::Number::New(env, (double)stats.ringGrowths));
+    return resultObj;
+}
+
+// Exported Function: DownsampleHistory
+// downsampleHistory(options { ...see ParseDownsampleRequest, seconds? }) -> same result as downsampleCaptureFile,
+// computed synchronously from the label history; seconds = the last N seconds.
+Napi::Value DownsampleHistoryWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsObject()) {
+        Napi::TypeError::New(env, "Expected: options (Object)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    DownsampleRequest request;
+    std::string error;
+    if (!ParseDownsampleRequest(options, &request, &error)) {
+        Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    if (options.Get("seconds").IsNumber()) {
+        double nowMs = HostNowNs() / 1e6;
+        request.selector.startMs = nowMs - options.Get("seconds").As<Napi::Number>().DoubleValue() * 1000.0;
+        request.selector.endMs = nowMs;
+    }
+    Series series;
+    History().ReadSeries(request.selector, &series);
+    DownsampleResult result;
+    RunDownsample(request, series, &result);
+    return DownsampleResultToObject(env, result);
+}
+
+// --- Derived Parameters ---
+// Expressions over decoded labels (grammar in derived_params.h), evaluated by the merge thread as words arrive;
+// changed values join the word stream as { derived: true, id, value, timestamp } records.
+
+// [{ name, expr, inputs: [{ name, channel?, label, card?, core?, ...decoding (see ParseLabelDecoding) }] }]
+bool ParseDerivedParameters(Napi::Value value, std::vector<DerivedParameterSpec>* specs, std::string* error) {
+    if (!value.IsArray()) {
+        *error = "parameters must be an array";
+        return false;
+    }
+    Napi::Array array = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+        std::string where = "parameters[" + std::to_string(i) + "]: ";
+        Napi::Value entry = array.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("name").IsString() || !entry.As<Napi::Object>().Get("expr").IsString()) {
+            *error = where + "needs a name and an expr string";
+            return false;
+        }
+        Napi::Object paramObj = entry.As<Napi::Object>();
+        DerivedParameterSpec spec;
+        spec.name = paramObj.Get("name").As<Napi::String>().Utf8Value();
+        spec.expression = paramObj.Get("expr").As<Napi::String>().Utf8Value();
+        Napi::Value inputs = paramObj.Get("inputs");
+        if (!inputs.IsUndefined() && !inputs.IsArray()) {
+            *error = where + "inputs must be an array";
+            return false;
+        }
+        Napi::Array inputArray = inputs.IsArray() ? inputs.As<Napi::Array>() : Napi::Array::New(value.Env());
+        for (uint32_t j = 0; j < inputArray.Length(); ++j) {
+            std::string inputWhere = where + "inputs[" + std::to_string(j) + "]: ";
+            Napi::Value inputEntry = inputArray.Get(j);
+            if (!inputEntry.IsObject() || !inputEntry.As<Napi::Object>().Get("name").IsString() ||
+                !inputEntry.As<Napi::Object>().Get("label").IsNumber()) {
+                *error = inputWhere + "needs a name and a numeric label";
+                return false;
+            }
+            Napi::Object inputObj = inputEntry.As<Napi::Object>();
+            DerivedInputSpec input;
+            input.name = inputObj.Get("name").As<Napi::String>().Utf8Value();
+            input.label = inputObj.Get("label").As<Napi::Number>().Int32Value();
+            if (inputObj.Get("channel").IsNumber()) input.channel = inputObj.Get("channel").As<Napi::Number>().Int32Value();
+            if (inputObj.Get("card").IsNumber()) input.card = inputObj.Get("card").As<Napi::Number>().Int32Value();
+            if (inputObj.Get("core").IsNumber()) input.core = inputObj.Get("core").As<Napi::Number>().Int32Value();
+            if (!ParseLabelDecoding(inputObj, &input.decoding, error)) {
+                *error = inputWhere + *error;
+                return false;
+            }
+            spec.inputs.push_back(input);
+        }
+        specs->push_back(spec);
+    }
+    return true;
+}
+
+// Exported Function: SetDerivedParameters
+// setDerivedParameters(parameters | null) -> { success, message, names }. Compiles the whole set at once (an error
+// leaves the previous set running); names lists the parameters in id order, the order they are evaluated in.
+// null removes them all. Input values and derived values start over with every call.
+Napi::Value SetDerivedParametersWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !(info[0].IsArray() || info[0].IsNull())) {
+        Napi::TypeError::New(env, "Expected: parameters (Array) | null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    Napi::Object resultObj = Napi::Object::New(env);
+    std::shared_ptr<const DerivedProgram> program;
+    if (info[0].IsArray()) {
+        std::vector<DerivedParameterSpec> specs;
+        std::string error;
+        if (!ParseDerivedParameters(info[0], &specs, &error) || !CompileDerivedParameters(specs, &program, &error)) {
+            resultObj.Set("success", Napi::Boolean::New(env, false));
+            resultObj.Set("message", Napi::String::New(env, error));
+            return resultObj;
+        }
+    }
+    Derived().SetProgram(program);
+
+    Napi::Array names = Napi::Array::New(env, program ? program->parameters.size() : 0);
+    for (uint32_t id = 0; program && id < program->parameters.size(); ++id) {
+        names.Set(id, Napi::String::New(env, program->parameters[id].name));
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, program ? std::to_string(program->parameters.size()) +
+        " derived parameter(s) over " + std::to_string(program->inputs.size()) + " input(s)." : "Derived parameters removed."));
+    resultObj.Set("names", names);
+    return resultObj;
+}
+
+// Exported Function: GetDerivedValues
+// getDerivedValues() -> { names, values: Float64Array, timestamps: Float64Array, updates: Float64Array, inputWords,
+// evaluations, published }. Full double precision (the stream carries float); NaN / timestamp 0 until computed.
+Napi::Value GetDerivedValuesWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    std::vector<DerivedValueInfo> values = Derived().Values();
+    DerivedStats stats = Derived().Stats();
+    Napi::Array names = Napi::Array::New(env, values.size());
+    Napi::Float64Array current = Napi::Float64Array::New(env, values.size());
+    Napi::Float64Array timestamps = Napi::Float64Array::New(env, values.size());
+    Napi::Float64Array updates = Napi::Float64Array::New(env, values.size());
+    for (size_t id = 0; id < values.size(); ++id) {
+        names.Set((uint32_t)id, Napi::String::New(env, values[id].name));
+        current[id] = values[id].value;
+        timestamps[id] = (double)values[id].timestampMs;
+        updates[id] = (double)values[id].updates;
+    }
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("names", names);
+    resultObj.Set("values", current);
+    resultObj.Set("timestamps", timestamps);
+    resultObj.Set("updates", updates);
+    resultObj.Set("inputWords", Napi::Number::New(env, (double)stats.inputWords));
+    resultObj.Set("evaluations", Napi::Number::New(env, (double)stats.evaluations));
+    resultObj.Set("published", Napi::Number::New(env, (double)stats.published));
+    return resultObj;
+}
+
+// --- Native DIO Edge Monitoring ---
+// The session's DioMonitor detects edges (card edge events while the core runs, native sampling otherwise) and
+// delivers them in batches, so the renderer no longer has to poll getAllDioStates.
+
+struct DioWatch {
+    HCORE hCore = 0;
+    Napi::ThreadSafeFunction tsfn;
+};
+
+const char* DioEdgeSourceName(DioEdgeSource source) {
+    switch (source) {
+    case DioEdgeSource::CardEvent: return "card";
+    case DioEdgeSource::Resync: return "resync";
+    default: return "sampler";
+    }
+}
+
+// Runs on the DIO monitor thread; edges are rare, so the TSFN queue is unbounded and this never blocks
+void DeliverDioEdges(void* context, std::vector<DioEdgeEvent>* edges) {
+    DioWatch* watch = static_cast<DioWatch*>(context);
+    napi_status status = watch->tsfn.NonBlockingCall(edges,
+        [](Napi::Env env, Napi::Function jsCallback, std::vector<DioEdgeEvent>* batch) {
+            if (env != nullptr && !jsCallback.IsEmpty()) {
+                Napi::Array jsArray = Napi::Array::New(env, batch->size());
+                for (size_t i = 0; i < batch->size(); ++i) {
+                    const DioEdgeEvent& edge = (*batch)[i];
+                    Napi::Object obj = Napi::Object::New(env);
+                    obj.Set("index", Napi::Number::New(env, edge.index));
+                    obj.Set("apiDionum", Napi::Number::New(env, edge.dionum));
+                    obj.Set("value", Napi::Boolean::New(env, edge.rising));
+                    obj.Set("edge", Napi::String::New(env, edge.rising ? "rising" : "falling"));
+                    obj.Set("source", Napi::String::New(env, DioEdgeSourceName(edge.source)));
+                    obj.Set("hwTime", Napi::Number::New(env, (double)edge.hwTime));
+                    obj.Set("timestamp", Napi::Number::New(env, (double)edge.timestamp_ms));
+                    obj.Set("card", Napi::Number::New(env, edge.card));
+                    obj.Set("core", Napi::Number::New(env, edge.core));
+                    jsArray.Set(i, obj);
+                }
+                jsCallback.Call({jsArray});
+            }
+            delete batch;
+        });
+    if (status != napi_ok) delete edges;
+}
+
+// Stops the monitor (its sink is not called after this) and releases the callback
+void RemoveDioWatch(AddonData* addon, HCORE hCore) {
+    auto it = addon->dioWatches.find(hCore);
+    if (it == addon->dioWatches.end()) return;
+    if (DeviceSession* session = Sessions().Find(hCore)) session->Dio().Stop();
+    it->second->tsfn.Release();
+    delete it->second;
+    addon->dioWatches.erase(it);
+}
+
+// Exported Function: StartDioMonitor
+// startDioMonitor(hCore, callback, [options]) -> { success, message, mode }. options: { dionums: [int] (default the
+// 8 discretes getAllDioStates reads), mode: 'auto' | 'card' | 'sampler', sampleIntervalUs (default 1000; below 1000
+// the sampler thread spins), glitchUs (default 1000), recordEdges (also inject edges into the data stream as words on
+// channel 255: label = DIO number, bit 31 = new level, bits 0-30 = low card-timer bits; data callbacks get them as
+// { dioEdge: true, dionum, rising, hwTime, timestamp, card, core }, label consumers skip them) }.
+// The callback receives arrays of { index, apiDionum, value, edge, source, hwTime, timestamp, card, core };
+// hwTime is the card's 64-bit timer when the edge was detected.
+Napi::Value StartDioMonitorWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !info[0].IsBigInt() || !info[1].IsFunction() ||
+        (info.Length() >= 3 && !info[2].IsObject() && !info[2].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: coreHandle (BigInt), callback (Function), [options (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+    AddonData* addon = GetAddonData(env);
+
+    DioMonitorConfig config;
+    if (info.Length() >= 3 && info[2].IsObject()) {
+        Napi::Object options = info[2].As<Napi::Object>();
+        if (options.Has("dionums") && options.Get("dionums").IsArray()) {
+            Napi::Array dionums = options.Get("dionums").As<Napi::Array>();
+            config.dionums.clear();
+            for (uint32_t i = 0; i < dionums.Length(); ++i) {
+                Napi::Value value = dionums.Get(i);
+                config.dionums.push_back(value.IsNumber() ? value.As<Napi::Number>().Int32Value() : -1);
+            }
+        }
+        if (options.Has("sampleIntervalUs") && options.Get("sampleIntervalUs").IsNumber()) {
+            config.sampleIntervalUs = options.Get("sampleIntervalUs").As<Napi::Number>().Int32Value();
+        }
+        if (options.Has("glitchUs") && options.Get("glitchUs").IsNumber()) {
+            config.glitchUs = options.Get("glitchUs").As<Napi::Number>().Int32Value();
+        }
+        if (options.Has("recordEdges") && options.Get("recordEdges").IsBoolean()) {
+            config.recordEdges = options.Get("recordEdges").As<Napi::Boolean>().Value();
+        }
+        Napi::Value mode = options.Get("mode");
+        std::string modeName = mode.IsString() ? mode.As<Napi::String>().Utf8Value() : "";
+        if (modeName == "card") config.mode = DioMonitorMode::CardEvents;
+        else if (modeName == "sampler") config.mode = DioMonitorMode::Sampler;
+        else if (!mode.IsUndefined() && modeName != "auto") {
+            Napi::TypeError::New(env, "mode must be 'auto', 'card' or 'sampler'").ThrowAsJavaScriptException();
+            return env.Null();
+        }
+    }
+
+    RemoveDioWatch(addon, session->Core()); // Restarting replaces this environment's previous callback
+    DioWatch* watch = new DioWatch();
+    watch->hCore = session->Core();
+    watch->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        info[1].As<Napi::Function>(),
+        "DIO Edge Callback", // Resource Name
+        0, // Max Queue Size (0 = unlimited)
+        1  // Initial Thread Count
+    );
+
+    std::string message;
+    bool started = session->Dio().Start(config, DeliverDioEdges, watch, &message);
+    if (started) {
+        addon->dioWatches[watch->hCore] = watch;
+    } else {
+        watch->tsfn.Release();
+        delete watch;
+    }
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, started));
+    resultObj.Set("message", Napi::String::New(env, message));
+    if (started) resultObj.Set("mode", Napi::String::New(env, session->Dio().Status().cardEvents ? "card" : "sampler"));
+    return resultObj;
+}
+
+// Exported Function: StopDioMonitor
+// stopDioMonitor(hCore); only a monitor started from the calling JS environment can be stopped from it
+Napi::Value StopDioMonitorWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: coreHandle (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+    AddonData* addon = GetAddonData(env);
+    bool found = addon->dioWatches.count(session->Core()) != 0;
+    RemoveDioWatch(addon, session->Core());
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, found));
+    resultObj.Set("message", Napi::String::New(env, found ? "DIO monitor stopped." : "No DIO monitor started from this environment."));
+    return resultObj;
+}
+
+// Exported Function: GetDioState
+// getDioState(hCore) -> { running, mode, sampling, valid, states: [{ index, apiDionum, value, risingEdges,
+// fallingEdges }], unresolvedEdges }. Served from the monitor's cached state: no driver calls.
+Napi::Value GetDioStateWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: coreHandle (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+
+    DioMonitorStatus status = session->Dio().Status();
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("running", Napi::Boolean::New(env, status.running));
+    resultObj.Set("mode", status.running ? Napi::String::New(env, status.cardEvents ? "card" : "sampler") : env.Null());
+    resultObj.Set("sampling", Napi::Boolean::New(env, status.sampling));
+    resultObj.Set("valid", Napi::Boolean::New(env, status.stateValid));
+    Napi::Array states = Napi::Array::New(env, status.dionums.size());
+    for (size_t i = 0; i < status.dionums.size(); ++i) {
+        Napi::Object dio = Napi::Object::New(env);
+        dio.Set("index", Napi::Number::New(env, (double)i));
+        dio.Set("apiDionum", Napi::Number::New(env, status.dionums[i]));
+        dio.Set("value", Napi::Boolean::New(env, (status.stateMask & (1u << i)) != 0));
+        dio.Set("risingEdges", Napi::Number::New(env, (double)status.risingEdges[i]));
+        dio.Set("fallingEdges", Napi::Number::New(env, (double)status.fallingEdges[i]));
+        states.Set(static_cast<uint32_t>(i), dio);
+    }
+    resultObj.Set("states", states);
+    resultObj.Set("unresolvedEdges", Napi::Number::New(env, (double)status.unresolvedEvents));
+    return resultObj;
+}
+
+// Exported Function: GetDioPulseStats
+// getDioPulseStats(hCore) -> { count, recordSize, buffer }. buffer (ArrayBuffer) packs one 224-byte little-endian
+// record per monitored discrete: u8 index, u8 apiDionum, u8 level, u8 reserved, u32 glitches, u64 risingEdges,
+// u64 fallingEdges, f64 lastHighUs, lastLowUs, periodUs, frequencyHz, dutyCycle, minHighUs, maxHighUs, minLowUs,
+// maxLowUs, u32 highHistogram[16], u32 lowHistogram[16] (bucket k: widths in [2^k, 2^(k+1)) us).
+Napi::Value GetDioPulseStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: coreHandle (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+
+    std::vector<DioPulseRecord> records = session->Dio().PulseStats();
+    size_t bytes = records.size() * sizeof(DioPulseRecord);
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+    if (bytes) std::memcpy(buffer.Data(), records.data(), bytes);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("count", Napi::Number::New(env, (double)records.size()));
+    resultObj.Set("recordSize", Napi::Number::New(env, (double)sizeof(DioPulseRecord)));
+    resultObj.Set("buffer", buffer);
+    return resultObj;
+}
+
+// --- Pull-Mode Change Snapshots ---
+
+// Exported Function: GetChangesSince
+// getChangesSince([version]) -> { version, count, recordSize, buffer }. buffer (ArrayBuffer) packs one 24-byte
+// little-endian record per card/core/channel/label whose value changed after `version` (omit or 0 for all):
+// u8 card, u8 core, u8 channel, u8 label, u32 word, f64 timestampMs, u32 count, u32 reserved.
+// Meant to be polled once per animation frame; pass the returned version back next time.
+// The first call starts tracking (and polling of all channels), so it only reports words from then on.
+Napi::Value GetChangesSinceWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    uint64_t since = 0;
+    if (info.Length() >= 1 && info[0].IsNumber()) {
+        double value = info[0].As<Napi::Number>().DoubleValue();
+        since = value > 0 ? (uint64_t)value : 0;
+    } else if (info.Length() >= 1 && info[0].IsBigInt()) {
+        bool lossless = false;
+        since = info[0].As<Napi::BigInt>().Uint64Value(&lossless);
+    } else if (info.Length() >= 1 && !info[0].IsUndefined() && !info[0].IsNull()) {
+        Napi::TypeError::New(env, "Expected: [version (Number)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Changes().Enable();
+    std::vector<ChangeRecord> records;
+    uint64_t version = Changes().ChangesSince(since, &records);
+
+    size_t bytes = records.size() * sizeof(ChangeRecord);
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+    if (bytes) std::memcpy(buffer.Data(), records.data(), bytes);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("version", Napi::Number::New(env, (double)version));
+    resultObj.Set("count", Napi::Number::New(env, (double)records.size()));
+    resultObj.Set("recordSize", Napi::Number::New(env, (double)sizeof(ChangeRecord)));
+    resultObj.Set("buffer", buffer);
+    return resultObj;
+}
+
+// --- Typed Event Log Stream ---
+// Every reader cycle drains its core's event log completely and hands the decoded entries over as one batch.
+
+const char* CardEventTypeName(USHORT type) {
+    switch (type) {
+    case EVENTTYPE_429MSG: return "message";
+    case EVENTTYPE_429OPCODE: return "opcode";
+    case EVENTTYPE_429HALT: return "halt";
+    case EVENTTYPE_429PAUSE: return "pause";
+    case EVENTTYPE_429LIST: return "list";
+    case EVENTTYPE_429ERR: return "decoderError";
+    case EVENTTYPE_SEQFULL: return "seqFull";
+    case EVENTTYPE_SEQFREQ: return "seqFreq";
+    case EVENTTYPE_DIOEDGE: return "dioEdge";
+    case EVENTTYPE_DIOFAULT: return "dioFault";
+    case EVENTTYPE_BITERROR: return "bitError";
+    default: return "other";
+    }
+}
+
+// Runs on the JS thread
+void CallJsEvents(Napi::Env env, Napi::Function jsCallback, std::vector<CardEvent>* events) {
+    if (!events) return;
+    if (env == nullptr || jsCallback.IsEmpty()) {
+        delete events;
+        return;
+    }
+    Napi::Array jsEvents = Napi::Array::New(env, events->size());
+    for (size_t i = 0; i < events->size(); ++i) {
+        const CardEvent& event = (*events)[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("type", Napi::String::New(env, CardEventTypeName(event.type)));
+        obj.Set("typeValue", Napi::Number::New(env, event.type));
+        obj.Set("channel", Napi::Number::New(env, event.channel));
+        obj.Set("info", Napi::Number::New(env, event.info));
+        obj.Set("hwTime", Napi::Number::New(env, (double)event.hwTime));
+        obj.Set("timestamp", Napi::Number::New(env, (double)event.timestamp_ms));
+        obj.Set("card", Napi::Number::New(env, event.card));
+        obj.Set("core", Napi::Number::New(env, event.core));
+        jsEvents.Set(static_cast<uint32_t>(i), obj);
+    }
+    delete events;
+    jsCallback.Call({jsEvents});
+}
+
+// Called by the reader threads under the registry's sink lock; never blocks
+bool JsEventSink(void* context, std::vector<CardEvent>* batch) {
+    AddonData* addon = static_cast<AddonData*>(context);
+    if (!addon->tsfnEvents) return false;
+    return addon->tsfnEvents.NonBlockingCall(batch, CallJsEvents) == napi_ok;
+}
+
+void ReleaseEventHandler(AddonData* addon) {
+    Sessions().ClearEventSink(addon); // Waits for any in-flight sink call before the TSFN goes away
+    if (addon->tsfnEvents) {
+        addon->tsfnEvents.Release();
+        addon->tsfnEvents = nullptr;
+    }
+}
+
+// Exported Function: SetEventHandler
+// setEventHandler(handler(events[]) | null). Each event: { type, typeValue, channel, info, hwTime, timestamp, card, core };
+// hwTime/timestamp are read once per drained batch. Batches that do not fit the bounded queue are counted in
+// getMonitorStats().eventsDropped; eventLogOverflows counts cycles that found the card's log full.
+// The event stream is process-wide: the most recent handler from any JS environment receives the events.
+Napi::Value SetEventHandlerWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() != 1 || !(info[0].IsFunction() || info[0].IsNull() || info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: handler (Function | null)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ReleaseEventHandler(addon);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[0].IsFunction()) {
+        addon->tsfnEvents = Napi::ThreadSafeFunction::New(
+            env,
+            info[0].As<Napi::Function>(),
+            "BTI Event Log", // Resource Name
+            64, // Max Queue Size: bounded so a slow handler costs dropped batches, not a stalled reader
+            1   // Initial Thread Count
+        );
+        addon->tsfnEvents.Unref(env); // The handler alone should not keep the process alive
+        Sessions().SetEventSink(JsEventSink, addon);
+        resultObj.Set("message", Napi::String::New(env, "Event handler installed."));
+    } else {
+        resultObj.Set("message", Napi::String::New(env, "Event handler removed."));
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    return resultObj;
+}
+
+// Exported Function: GetErrorCounters
+// getErrorCounters([hCore]) -> { unkeyed, counters: [{ channel, code, source, message, count, active }] }.
+// Occurrence totals per channel/code since the session opened (default: the first session); unkeyed counts
+// occurrences that found every counter slot taken.
+Napi::Value GetErrorCountersWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    DeviceSession* session = nullptr;
+    if (info.Length() >= 1 && info[0].IsBigInt()) {
+        session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+    } else {
+        session = Sessions().Default();
+    }
+
+    std::vector<ErrorCounter> counters;
+    if (session) counters = session->Errors().Counters();
+    Napi::Array counterArray = Napi::Array::New(env, counters.size());
+    for (size_t i = 0; i < counters.size(); ++i) {
+        const ErrorCounter& counter = counters[i];
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("channel", counter.channel >= 0 ? Napi::Number::New(env, counter.channel) : env.Null());
+        obj.Set("code", Napi::Number::New(env, counter.code));
+        obj.Set("source", Napi::String::New(env, counter.source));
+        obj.Set("message", Napi::String::New(env, counter.message));
+        obj.Set("count", Napi::Number::New(env, (double)counter.count));
+        obj.Set("active", Napi::Boolean::New(env, counter.active));
+        counterArray.Set(static_cast<uint32_t>(i), obj);
+    }
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("unkeyed", Napi::Number::New(env, session ? (double)session->Errors().Unkeyed() : 0.0));
+    resultObj.Set("counters", counterArray);
+    return resultObj;
+}
+
+// Exported Function: SetAdaptiveLists
+// setAdaptiveLists(hCore | null, enabled, [maxWords]). null applies to every open session. When enabled, a receive
+// list whose peak word rate (or an overflow) outgrows it is re-created larger, up to maxWords (default 16384): the
+// core is stopped for the few driver calls this takes, and the replaced list's card memory is only reclaimed by a reset.
+Napi::Value SetAdaptiveListsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !(info[0].IsBigInt() || info[0].IsNull()) || !info[1].IsBoolean() ||
+        (info.Length() >= 3 && !info[2].IsNumber() && !info[2].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt) | null, enabled (Boolean), [maxWords (Number)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    bool enabled = info[1].As<Napi::Boolean>().Value();
+    int maxWords = (info.Length() >= 3 && info[2].IsNumber()) ? info[2].As<Napi::Number>().Int32Value() : 16384;
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[0].IsBigInt()) {
+        DeviceSession* session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+        session->SetAdaptiveLists(enabled, maxWords);
+        resultObj.Set("maxWords", Napi::Number::New(env, session->MaxListWords()));
+    } else {
+        int applied = 0;
+        Sessions().WithSessions([&](const std::vector<DeviceSession*>& sessions) {
+            for (DeviceSession* session : sessions) {
+                session->SetAdaptiveLists(enabled, maxWords);
+                applied = session->MaxListWords();
+            }
+        });
+        resultObj.Set("maxWords", Napi::Number::New(env, applied));
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, enabled ? "Adaptive receive lists enabled." : "Adaptive receive lists disabled."));
+    return resultObj;
+}
 
-    int channel = info[0].As<Napi::Number>().Int32Value();
-    int label_in = info[1].As<Napi::Number>().Int32Value(); // Passed as decimal from JS
-    int sdi_in = info[2].As<Napi::Number>().Int32Value();
-    uint32_t data_in = info[3].As<Napi::Number>().Uint32Value();
-    int ssm_in = info[4].As<Napi::Number>().Int32Value();
-    // int parity_in = info[5].As<Napi::Number>().Int32Value(); // Parity handled by ChConfig
+// Report-on-change rules: [{ channel?, labels?, ignoreMask?, heartbeatMs?, enabled? }]. A rule without channel or
+// labels covers all of them; later rules override earlier ones, so a broad rule can be narrowed by the ones after it.
+bool ParseChangeOnlyRules(Napi::Value value, ChangeOnlyConfig* config, std::string* error) {
+    if (!value.IsArray()) {
+        *error = "rules must be an array";
+        return false;
+    }
+    Napi::Array rules = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < rules.Length(); ++i) {
+        std::string where = "rules[" + std::to_string(i) + "]: ";
+        Napi::Value entry = rules.Get(i);
+        if (!entry.IsObject()) {
+            *error = where + "must be an object";
+            return false;
+        }
+        Napi::Object ruleObj = entry.As<Napi::Object>();
+        ChangeOnlyRule rule;
+        rule.enabled = !ruleObj.Get("enabled").IsBoolean() || ruleObj.Get("enabled").As<Napi::Boolean>().Value();
+        if (ruleObj.Get("ignoreMask").IsNumber()) rule.ignoreMask = ruleObj.Get("ignoreMask").As<Napi::Number>().Uint32Value();
+        double heartbeatMs = ruleObj.Get("heartbeatMs").IsNumber() ? ruleObj.Get("heartbeatMs").As<Napi::Number>().DoubleValue() : 1000.0;
+        if (heartbeatMs < 0) {
+            *error = where + "heartbeatMs must be >= 0 (0 = no heartbeat)";
+            return false;
+        }
+        rule.heartbeatNs = (int64_t)(heartbeatMs * 1e6);
+
+        int firstChannel = 0, lastChannel = STATS_MAX_CHANNELS - 1;
+        if (ruleObj.Get("channel").IsNumber()) {
+            firstChannel = lastChannel = ruleObj.Get("channel").As<Napi::Number>().Int32Value();
+            if (firstChannel < 0 || firstChannel >= STATS_MAX_CHANNELS) {
+                *error = where + "channel must be 0.." + std::to_string(STATS_MAX_CHANNELS - 1);
+                return false;
+            }
+        }
+        std::vector<int> labels;
+        if (ruleObj.Get("labels").IsArray()) {
+            Napi::Array labelArray = ruleObj.Get("labels").As<Napi::Array>();
+            for (uint32_t l = 0; l < labelArray.Length(); ++l) {
+                Napi::Value label = labelArray.Get(l);
+                int labelValue = label.IsNumber() ? label.As<Napi::Number>().Int32Value() : -1;
+                if (labelValue < 0 || labelValue >= CHANGE_ONLY_LABELS) {
+                    *error = where + "labels must be 0..255";
+                    return false;
+                }
+                labels.push_back(labelValue);
+            }
+        } else {
+            for (int label = 0; label < CHANGE_ONLY_LABELS; ++label) labels.push_back(label);
+        }
+        for (int ch = firstChannel; ch <= lastChannel; ++ch) {
+            for (int label : labels) config->rules[ch][label] = rule;
+        }
+    }
+    return true;
+}
 
-    std::lock_guard<std::mutex> lock(g_transmitMutex);
+// Exported Function: SetChangeOnly
+// setChangeOnly(hCore | null, rules | null). null hCore applies to every open session; null rules turns the mode off.
+// Matching words equal (outside ignoreMask) to the last word passed on for their channel/label are dropped by the
+// reader before capture, the value table and subscribers see them; heartbeatMs (default 1000, 0 = off) still passes
+// an unchanged word on that often so a quiet label reads as alive. Takes effect on the reader's next cycle.
+Napi::Value SetChangeOnlyWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !(info[0].IsBigInt() || info[0].IsNull()) || !(info[1].IsArray() || info[1].IsNull())) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt) | null, rules (Array) | null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::shared_ptr<ChangeOnlyConfig> config;
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[1].IsArray()) {
+        config = std::make_shared<ChangeOnlyConfig>();
+        std::string error;
+        if (!ParseChangeOnlyRules(info[1], config.get(), &error)) {
+            resultObj.Set("success", Napi::Boolean::New(env, false));
+            resultObj.Set("message", Napi::String::New(env, error));
+            return resultObj;
+        }
+    }
 
-    // Check if already transmitting using find to avoid inserting if not present
-    if (g_isTransmitting.count(channel) && g_isTransmitting.at(channel)) {
-         std::cerr << "[C++ Addon] Error: Already transmitting on channel " << channel << std::endl;
-         resultObj.Set("status", Napi::Number::New(env, ERR_BUSY)); // Use a distinct error code
-         resultObj.Set("message", Napi::String::New(env, "Error: Already transmitting on channel " + std::to_string(channel)));
-         return resultObj;
+    if (info[0].IsBigInt()) {
+        DeviceSession* session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+        session->SetChangeOnly(config);
+    } else {
+        Sessions().WithSessions([&](const std::vector<DeviceSession*>& sessions) {
+            for (DeviceSession* session : sessions) session->SetChangeOnly(config);
+        });
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("message", Napi::String::New(env, config ? "Report-on-change rules applied." : "Report-on-change disabled."));
+    return resultObj;
+}
+
+// Exported Function: GetChangeOnlyStats
+// getChangeOnlyStats(hCore) -> { enabled, suppressed, labels: Float64Array }. labels[ch * 256 + label] counts the
+// repeats dropped since the session opened (32-bit, wraps); suppressed is their sum.
+Napi::Value GetChangeOnlyStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+
+    int channelCount = session->Channels().empty() ? 0 : session->Channels().back().channel + 1;
+    if (channelCount > STATS_MAX_CHANNELS) channelCount = STATS_MAX_CHANNELS;
+    Napi::Float64Array labels = Napi::Float64Array::New(env, channelCount * CHANGE_ONLY_LABELS);
+    double total = 0;
+    for (int ch = 0; ch < channelCount; ++ch) {
+        for (int label = 0; label < CHANGE_ONLY_LABELS; ++label) {
+            double count = session->SuppressedRepeats(ch, label);
+            labels[ch * CHANGE_ONLY_LABELS + label] = count;
+            total += count;
+        }
+    }
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("enabled", Napi::Boolean::New(env, session->ChangeOnly() != nullptr));
+    resultObj.Set("suppressed", Napi::Number::New(env, total));
+    resultObj.Set("channelCount", Napi::Number::New(env, channelCount));
+    resultObj.Set("labels", labels);
+    return resultObj;
+}
+
+// Exported Function: SetSnapshotInterval
+// setSnapshotInterval(hCore | null, intervalMs). How often the reader refreshes the card-resident snapshot records
+// (receiver profile snapshotLabels); null applies to every open session. Default 50 ms, at least 1 ms.
+Napi::Value SetSnapshotIntervalWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() < 2 || !(info[0].IsBigInt() || info[0].IsNull()) || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt) | null, intervalMs (Number)").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    double intervalMs = info[1].As<Napi::Number>().DoubleValue();
+    int intervalUs = (int)std::min(std::max(intervalMs, 0.0) * 1000.0, 3600e6);
 
-    std::cout << "[C++ Addon] Attempting to start transmission on channel " << channel << "..." << std::endl;
+    Napi::Object resultObj = Napi::Object::New(env);
+    int applied = SNAPSHOT_DEFAULT_INTERVAL_US;
+    if (info[0].IsBigInt()) {
+        DeviceSession* session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+        session->SetSnapshotInterval(intervalUs);
+        applied = session->SnapshotInterval();
+    } else {
+        Sessions().WithSessions([&](const std::vector<DeviceSession*>& sessions) {
+            for (DeviceSession* session : sessions) {
+                session->SetSnapshotInterval(intervalUs);
+                applied = session->SnapshotInterval();
+            }
+        });
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("intervalMs", Napi::Number::New(env, applied / 1000.0));
+    resultObj.Set("message", Napi::String::New(env, "Snapshot refresh interval set."));
+    return resultObj;
+}
 
-    // 1. Configure Channel for Transmit
-    // Assuming High Speed, Schedule Mode, Even Parity, Active
-    ULONG configFlags = CHCFG429_SCHEDULE | CHCFG429_HIGHSPEED | CHCFG429_PAREVEN | CHCFG429_ACTIVE;
-    std::cout << "[C++ Addon] Calling BTI429_ChConfig(0x" << std::hex << configFlags << std::dec << ", " << channel << ", hCore=" << hCoreGlobal << ")" << std::endl; // DEBUG
-    ERRVAL configResult = BTI429_ChConfig(configFlags, channel, hCoreGlobal);
-    std::cout << "[C++ Addon] BTI429_ChConfig(Transmit) for Ch " << channel << " returned: " << configResult << std::endl;
-    if (configResult != ERR_NONE) {
-        std::string errorMsg = "Failed to configure channel " + std::to_string(channel) + " for transmit.";
-        std::cerr << "[C++ Addon] Error: " << errorMsg << " BTI Code: " << configResult << std::endl;
-        resultObj.Set("status", Napi::Number::New(env, configResult));
-        resultObj.Set("message", Napi::String::New(env, errorMsg + " BTI Code: " + std::to_string(configResult)));
-        return resultObj;
+// Exported Function: GetSnapshot
+// getSnapshot(hCore) -> { success, count, recordSize, intervalMs, buffer }. buffer (ArrayBuffer) packs one 32-byte
+// little-endian record per snapshot label, in channel/label order, as of the reader's last refresh:
+// u32 word, u8 channel, u8 label, u16 activity (MSGACT429_*), u64 timetag (card clock, 0 = never received),
+// i64 hostNs, u32 updates, u32 reserved. Empty until monitoring has started on a profile with snapshotLabels.
+Napi::Value GetSnapshotWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
     }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
 
-    // 2. Create Message Record
-    ULONG msgCreateFlags = MSGCRT429_DEFAULT; // Simple flags
-     std::cout << "[C++ Addon] Calling BTI429_MsgCreate(0x" << std::hex << msgCreateFlags << std::dec << ", hCore=" << hCoreGlobal << ")" << std::endl; // DEBUG
-    MSGADDR msgAddr = BTI429_MsgCreate(msgCreateFlags, hCoreGlobal);
-    std::cout << "[C++ Addon] BTI429_MsgCreate for Ch " << channel << " returned MSGADDR: " << msgAddr << std::endl;
-    if (msgAddr == 0) {
-        std::string errorMsg = "Failed to create message record for channel " + std::to_string(channel) + ".";
-        std::cerr << "[C++ Addon] Error: " << errorMsg << std::endl;
-        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCoreGlobal); // Attempt cleanup
-        resultObj.Set("status", Napi::Number::New(env, ERR_FAIL)); // Generic failure for now
-        resultObj.Set("message", Napi::String::New(env, errorMsg));
+    std::vector<SnapshotRecord> records = session->Snapshot();
+    size_t bytes = records.size() * sizeof(SnapshotRecord);
+    Napi::ArrayBuffer buffer = Napi::ArrayBuffer::New(env, bytes);
+    if (bytes) std::memcpy(buffer.Data(), records.data(), bytes);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("count", Napi::Number::New(env, (double)records.size()));
+    resultObj.Set("recordSize", Napi::Number::New(env, (double)sizeof(SnapshotRecord)));
+    resultObj.Set("intervalMs", Napi::Number::New(env, session->SnapshotInterval() / 1000.0));
+    resultObj.Set("buffer", buffer);
+    return resultObj;
+}
+
+// --- Alarm Monitoring ---
+
+// Alarm rules: [{ kind: 'range' | 'ssm' | 'rate' | 'stale' | 'parity', channel?, label, sdi?, ...decoding (see
+// ParseLabelDecoding), low?, high?, hysteresis?, maxRate?, ssm: [state], staleMs }]
+bool ParseAlarmRules(Napi::Value value, std::vector<AlarmRule>* rules, std::string* error) {
+    Napi::Array array = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); ++i) {
+        std::string where = "rules[" + std::to_string(i) + "]: ";
+        Napi::Value entry = array.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("label").IsNumber()) {
+            *error = where + "needs a numeric label";
+            return false;
+        }
+        Napi::Object ruleObj = entry.As<Napi::Object>();
+        AlarmRule rule;
+        rule.id = (int)i;
+        Napi::Value kind = ruleObj.Get("kind");
+        if (!kind.IsString() || !ParseAlarmKind(kind.As<Napi::String>().Utf8Value(), &rule.kind)) {
+            *error = where + "kind must be 'range', 'ssm', 'rate', 'stale' or 'parity'";
+            return false;
+        }
+        rule.label = ruleObj.Get("label").As<Napi::Number>().Int32Value();
+        if (ruleObj.Get("channel").IsNumber()) rule.channel = ruleObj.Get("channel").As<Napi::Number>().Int32Value();
+        if (ruleObj.Get("sdi").IsNumber()) rule.sdi = ruleObj.Get("sdi").As<Napi::Number>().Int32Value();
+        if (!ParseLabelDecoding(ruleObj, &rule.decoding, error)) {
+            *error = where + *error;
+            return false;
+        }
+        if (ruleObj.Get("low").IsNumber()) rule.low = ruleObj.Get("low").As<Napi::Number>().DoubleValue();
+        if (ruleObj.Get("high").IsNumber()) rule.high = ruleObj.Get("high").As<Napi::Number>().DoubleValue();
+        if (ruleObj.Get("hysteresis").IsNumber()) rule.hysteresis = ruleObj.Get("hysteresis").As<Napi::Number>().DoubleValue();
+        if (ruleObj.Get("maxRate").IsNumber()) rule.maxRate = ruleObj.Get("maxRate").As<Napi::Number>().DoubleValue();
+        if (ruleObj.Get("staleMs").IsNumber()) {
+            rule.staleNs = (int64_t)(ruleObj.Get("staleMs").As<Napi::Number>().DoubleValue() * 1e6);
+        }
+        if (ruleObj.Get("ssm").IsArray()) {
+            Napi::Array states = ruleObj.Get("ssm").As<Napi::Array>();
+            for (uint32_t j = 0; j < states.Length(); ++j) {
+                int state = states.Get(j).IsNumber() ? states.Get(j).As<Napi::Number>().Int32Value() : -1;
+                if (state < 0 || state > 3) {
+                    *error = where + "ssm states must be 0..3";
+                    return false;
+                }
+                rule.ssmMask |= (uint8_t)(1 << state);
+            }
+        }
+        rules->push_back(rule);
+    }
+    return true;
+}
+
+Napi::Object AlarmToObject(Napi::Env env, const AlarmTransition& transition) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("rule", Napi::Number::New(env, transition.rule));
+    obj.Set("kind", Napi::String::New(env, AlarmKindName(transition.kind)));
+    obj.Set("active", Napi::Boolean::New(env, transition.active));
+    obj.Set("channel", Napi::Number::New(env, transition.channel));
+    obj.Set("label", Napi::Number::New(env, transition.label));
+    obj.Set("word", Napi::Number::New(env, transition.word));
+    obj.Set("value", Napi::Number::New(env, transition.value));
+    obj.Set("hwTime", Napi::Number::New(env, (double)transition.hwTime));
+    obj.Set("timestamp", Napi::Number::New(env, (double)transition.timestamp_ms));
+    obj.Set("card", Napi::Number::New(env, transition.card));
+    obj.Set("core", Napi::Number::New(env, transition.core));
+    return obj;
+}
+
+// Runs on the JS thread
+void CallJsAlarms(Napi::Env env, Napi::Function jsCallback, std::vector<AlarmTransition>* alarms) {
+    if (!alarms) return;
+    if (env == nullptr || jsCallback.IsEmpty()) {
+        delete alarms;
+        return;
+    }
+    Napi::Array jsAlarms = Napi::Array::New(env, alarms->size());
+    for (size_t i = 0; i < alarms->size(); ++i) jsAlarms.Set(static_cast<uint32_t>(i), AlarmToObject(env, (*alarms)[i]));
+    delete alarms;
+    jsCallback.Call({jsAlarms});
+}
+
+// Called by the reader threads under the registry's sink lock; never blocks
+bool JsAlarmSink(void* context, std::vector<AlarmTransition>* batch) {
+    AddonData* addon = static_cast<AddonData*>(context);
+    if (!addon->tsfnAlarms) return false;
+    return addon->tsfnAlarms.NonBlockingCall(batch, CallJsAlarms) == napi_ok;
+}
+
+void ReleaseAlarmHandler(AddonData* addon) {
+    Sessions().ClearAlarmSink(addon); // Waits for any in-flight sink call before the TSFN goes away
+    if (addon->tsfnAlarms) {
+        addon->tsfnAlarms.Release();
+        addon->tsfnAlarms = nullptr;
+    }
+}
+
+// Exported Function: SetAlarmRules
+// setAlarmRules(hCore | null, rules | null) -> { success, message, instances }. null hCore applies to every open
+// session and to those opened later, replacing their own rules; null rules removes them. Rules (see ParseAlarmRules
+// and alarm_engine.h) are checked by the reader on every word it reads, ahead of report-on-change, and keep the
+// channels they read demanded (polled at their word rate); a rule without channel applies to each channel (instances counts the
+// copies). Replacing the rules clears every alarm without a cleared transition.
+Napi::Value SetAlarmRulesWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 2 || !(info[0].IsBigInt() || info[0].IsNull()) || !(info[1].IsArray() || info[1].IsNull())) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt) | null, rules (Array) | null").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    std::shared_ptr<const AlarmConfig> config;
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[1].IsArray()) {
+        std::vector<AlarmRule> rules;
+        std::string error;
+        if (!ParseAlarmRules(info[1], &rules, &error) || !BuildAlarmConfig(rules, &config, &error)) {
+            resultObj.Set("success", Napi::Boolean::New(env, false));
+            resultObj.Set("message", Napi::String::New(env, error));
+            return resultObj;
+        }
+    }
+
+    DeviceSession* session = nullptr;
+    if (info[0].IsBigInt()) {
+        session = SessionFromArg(env, info[0]);
+        if (!session) return env.Null();
+    }
+    Sessions().SetAlarms(session, config);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("instances", Napi::Number::New(env, config ? (double)config->rules.size() : 0.0));
+    resultObj.Set("message", Napi::String::New(env, config ? "Alarm rules applied." : "Alarm rules removed."));
+    return resultObj;
+}
+
+// Exported Function: GetActiveAlarms
+// getActiveAlarms(hCore) -> { success, alarms: [transition] }: the raising transition of each alarm active after
+// the reader's last cycle (same fields as setAlarmHandler's).
+Napi::Value GetActiveAlarmsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() != 1 || !info[0].IsBigInt()) {
+        Napi::TypeError::New(env, "Expected: hCore (BigInt)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    DeviceSession* session = SessionFromArg(env, info[0]);
+    if (!session) return env.Null();
+
+    std::vector<AlarmTransition> active = session->ActiveAlarms();
+    Napi::Array jsAlarms = Napi::Array::New(env, active.size());
+    for (size_t i = 0; i < active.size(); ++i) jsAlarms.Set(static_cast<uint32_t>(i), AlarmToObject(env, active[i]));
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    resultObj.Set("alarms", jsAlarms);
+    return resultObj;
+}
+
+// Exported Function: SetAlarmHandler
+// setAlarmHandler(handler(transitions[]) | null). Each transition: { rule, kind, active, channel, label, word, value,
+// hwTime, timestamp, card, core }; rule indexes the setAlarmRules array, value is the decoded value (range), rate per
+// second (rate), SSM (ssm) or seconds without a word (stale). hwTime is the card timer: the word's timetag for
+// snapshot labels, otherwise read once when the reader cycle ended. One batch per reader cycle with transitions; the
+// queue is unbounded since transitions are rare. Process-wide like setEventHandler.
+Napi::Value SetAlarmHandlerWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() != 1 || !(info[0].IsFunction() || info[0].IsNull() || info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: handler (Function | null)").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    ReleaseAlarmHandler(addon);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[0].IsFunction()) {
+        addon->tsfnAlarms = Napi::ThreadSafeFunction::New(
+            env,
+            info[0].As<Napi::Function>(),
+            "BTI Alarms", // Resource Name
+            0, // Max Queue Size: unbounded, a transition must not be lost to a busy JS thread
+            1  // Initial Thread Count
+        );
+        addon->tsfnAlarms.Unref(env); // The handler alone should not keep the process alive
+        Sessions().SetAlarmSink(JsAlarmSink, addon);
+        resultObj.Set("message", Napi::String::New(env, "Alarm handler installed."));
+    } else {
+        resultObj.Set("message", Napi::String::New(env, "Alarm handler removed."));
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    return resultObj;
+}
+
+// Exported Function: StartTracing
+// Enables trace recording. Optional arg: events per thread buffer (default 65536); full buffers drop new events.
+Napi::Value StartTracingWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0].IsNumber() && !info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: [eventsPerThread (Number)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    int64_t eventsPerThread = 65536;
+    if (info.Length() == 1 && info[0].IsNumber()) {
+        eventsPerThread = info[0].As<Napi::Number>().Int64Value();
+    }
+    if (eventsPerThread <= 0 || eventsPerThread > (1 << 24)) {
+        Napi::RangeError::New(env, "eventsPerThread must be between 1 and 16777216").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    bool started = TraceStart(static_cast<size_t>(eventsPerThread));
+    resultObj.Set("success", Napi::Boolean::New(env, started));
+    resultObj.Set("message", Napi::String::New(env, started ? "Tracing started." : "Tracing is already active."));
+    return resultObj;
+}
+
+// Exported Function: StopTracing
+// Disables recording and serializes the session as Chrome trace-event JSON.
+// With a file path argument the JSON is written there; otherwise it is returned as a string.
+Napi::Value StopTracingWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    if (info.Length() > 1 || (info.Length() == 1 && !info[0].IsString() && !info[0].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: [filePath (String)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    TraceStop();
+    size_t eventCount = 0;
+    uint64_t droppedCount = 0;
+    std::string json = TraceToJson(&eventCount, &droppedCount);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("eventCount", Napi::Number::New(env, (double)eventCount));
+    resultObj.Set("droppedEvents", Napi::Number::New(env, (double)droppedCount));
+
+    if (info.Length() == 1 && info[0].IsString()) {
+        std::string filePath = info[0].As<Napi::String>().Utf8Value();
+        std::ofstream out(filePath, std::ios::binary | std::ios::trunc);
+        out.write(json.data(), json.size());
+        bool ok = out.good();
+        resultObj.Set("success", Napi::Boolean::New(env, ok));
+        resultObj.Set("filePath", Napi::String::New(env, filePath));
+        resultObj.Set("message", Napi::String::New(env, ok ? "Trace written." : "Failed to write trace file."));
+    } else {
+        resultObj.Set("success", Napi::Boolean::New(env, true));
+        resultObj.Set("json", Napi::String::New(env, json));
+    }
+    return resultObj;
+}
+
+// --- Native Log Routing ---
+
+// Runs on the JS thread: hands a batch of drained log records to the registered handler as one array
+void CallJsLog(Napi::Env env, Napi::Function jsCallback, std::vector<LogRecord>* records) {
+    if (!records) return;
+    if (env == nullptr || jsCallback.IsEmpty()) {
+        delete records;
+        return;
+    }
+
+    Napi::Array jsRecords = Napi::Array::New(env, records->size());
+    uint32_t index = 0;
+    for (const auto& rec : *records) {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set("level", Napi::String::New(env, LogLevelName(rec.level)));
+        obj.Set("levelValue", Napi::Number::New(env, static_cast<int>(rec.level)));
+        obj.Set("message", Napi::String::New(env, rec.message));
+        obj.Set("timestamp_ms", Napi::Number::New(env, (double)rec.timeMs));
+        obj.Set("threadId", Napi::Number::New(env, rec.threadId));
+        obj.Set("file", Napi::String::New(env, rec.file ? rec.file : ""));
+        obj.Set("line", Napi::Number::New(env, rec.line));
+        obj.Set("suppressed", Napi::Number::New(env, rec.suppressed));
+        jsRecords.Set(index++, obj);
+    }
+    delete records;
+
+    jsCallback.Call({jsRecords});
+}
+
+// Called by the log drain thread (under the logger's sink lock); never blocks
+bool JsLogSink(void* context, std::vector<LogRecord>* batch) {
+    AddonData* addon = static_cast<AddonData*>(context);
+    if (!addon->tsfnLog) return false;
+    return addon->tsfnLog.NonBlockingCall(batch, CallJsLog) == napi_ok;
+}
+
+// Accepts "trace" | "debug" | "info" | "warn" | "error" | "off" or the numeric level
+bool ParseLogLevel(const Napi::Value& value, LogLevel* level) {
+    if (value.IsNumber()) {
+        int v = value.As<Napi::Number>().Int32Value();
+        if (v < static_cast<int>(LogLevel::Trace) || v > static_cast<int>(LogLevel::Off)) return false;
+        *level = static_cast<LogLevel>(v);
+        return true;
+    }
+    if (!value.IsString()) return false;
+    std::string name = value.As<Napi::String>().Utf8Value();
+    for (int v = static_cast<int>(LogLevel::Trace); v <= static_cast<int>(LogLevel::Off); ++v) {
+        if (_stricmp(name.c_str(), LogLevelName(static_cast<LogLevel>(v))) == 0) {
+            *level = static_cast<LogLevel>(v);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReleaseLogHandler(AddonData* addon) {
+    LogClearSink(addon); // Waits for any in-flight sink call before the TSFN goes away
+    if (addon->tsfnLog) {
+        addon->tsfnLog.Release();
+        addon->tsfnLog = nullptr;
+    }
+}
+
+// Exported Function: SetLogHandler
+// setLogHandler(handler(records[]) | null, [options { level, echoToConsole }])
+// Routes native log records to JS in batches. Records that do not fit the bounded queue are counted, not blocked on.
+// The logger is process-wide: the most recent handler from any JS environment receives the records.
+Napi::Value SetLogHandlerWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    AddonData* addon = GetAddonData(env);
+    if (info.Length() < 1 || info.Length() > 2 ||
+        !(info[0].IsFunction() || info[0].IsNull() || info[0].IsUndefined()) ||
+        (info.Length() == 2 && !info[1].IsObject() && !info[1].IsUndefined())) {
+        Napi::TypeError::New(env, "Expected: handler (Function | null), [options (Object)]").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+
+    bool echoToConsole = false;
+    if (info.Length() == 2 && info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        if (options.Has("level")) {
+            LogLevel level;
+            if (!ParseLogLevel(options.Get("level"), &level)) {
+                Napi::TypeError::New(env, "options.level must be a level name or number").ThrowAsJavaScriptException();
+                return env.Null();
+            }
+            LogSetMinLevel(level);
+        }
+        if (options.Has("echoToConsole")) {
+            echoToConsole = options.Get("echoToConsole").As<Napi::Boolean>().Value();
+        }
+    }
+
+    ReleaseLogHandler(addon);
+
+    Napi::Object resultObj = Napi::Object::New(env);
+    if (info[0].IsFunction()) {
+        addon->tsfnLog = Napi::ThreadSafeFunction::New(
+            env,
+            info[0].As<Napi::Function>(),
+            "BTI Native Log", // Resource Name
+            64, // Max Queue Size: bounded so a slow handler costs dropped batches, not memory
+            1   // Initial Thread Count
+        );
+        addon->tsfnLog.Unref(env); // Logging alone should not keep the process alive
+        LogSetSink(JsLogSink, addon, echoToConsole);
+        resultObj.Set("message", Napi::String::New(env, "Log handler installed."));
+    } else {
+        resultObj.Set("message", Napi::String::New(env, "Log handler removed; logging to console."));
+    }
+    resultObj.Set("success", Napi::Boolean::New(env, true));
+    return resultObj;
+}
+
+// Exported Function: SetLogLevel
+Napi::Value SetLogLevelWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    LogLevel level;
+    if (info.Length() != 1 || !ParseLogLevel(info[0], &level)) {
+        Napi::TypeError::New(env, "Expected: level ('trace' | 'debug' | 'info' | 'warn' | 'error' | 'off')").ThrowAsJavaScriptException();
+        return env.Null();
+    }
+    LogSetMinLevel(level);
+    return Napi::Boolean::New(env, true);
+}
+
+// Exported Function: GetLogStats
+Napi::Value GetLogStatsWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    LogStats stats = LogGetStats();
+    Napi::Object resultObj = Napi::Object::New(env);
+    resultObj.Set("level", Napi::String::New(env, LogLevelName(static_cast<LogLevel>(g_logMinLevel.load()))));
+    resultObj.Set("written", Napi::Number::New(env, (double)stats.written));
+    resultObj.Set("dropped", Napi::Number::New(env, (double)stats.dropped));
+    resultObj.Set("suppressed", Napi::Number::New(env, (double)stats.suppressed));
+    resultObj.Set("handlerDropped", Napi::Number::New(env, (double)stats.sinkDropped));
+    return resultObj;
+}
+
+// --- Helper function to construct a 32-bit ARINC word ---
+// Relies on hardware/library to calculate Parity based on ChConfig setting
+uint32_t ConstructArincWord(uint8_t label, uint8_t sdi, uint32_t data, uint8_t ssm) {
+    uint32_t word = 0;
+    word |= (uint32_t)label;             // Bits 0-7
+    word |= ((uint32_t)sdi << 8);      // Bits 8-9
+    word |= ((data & 0x7FFFF) << 10);  // Bits 10-28 (mask data to 19 bits)
+    word |= ((uint32_t)ssm << 29);     // Bits 29-30
+    // Parity (Bit 31) is handled by hardware via CHCFG429_PAREVEN/PARODD
+    return word;
+}
+// --- NEW ARINC Transmit Functions ---
+
+// Exported Function: StartTransmit
+// startTransmit(channel, label, sdi, data, ssm, parity, [hCore]); without hCore the first opened core is used
+Napi::Value StartTransmitWrapped(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+    Napi::Object resultObj = Napi::Object::New(env);
+     BTI_LOG_DEBUG("StartTransmitWrapped called.");
+
+    DeviceSession* session = nullptr;
+    if (info.Length() >= 7 && info[6].IsBigInt()) {
+        session = SessionFromArg(env, info[6]);
+        if (!session) return env.Null();
+    } else {
+        session = Sessions().Default();
+    }
+    if (session == nullptr) {
+        BTI_LOG_ERROR("Hardware not initialized (Core handle is null).");
+        resultObj.Set("status", Napi::Number::New(env, ERR_HWINIT)); // Use a distinct error code
+        resultObj.Set("message", Napi::String::New(env, "Error: Hardware not initialized."));
         return resultObj;
     }
-    g_transmitMsgAddr[channel] = msgAddr; // Store only on success
-
-    // 3. Create Transmit List (Circular, size 2 for 1 entry + loop)
-    ULONG listCreateFlags = LISTCRT429_CIRCULAR; // Circular mode
-     std::cout << "[C++ Addon] Calling BTI429_ListXmtCreate(0x" << std::hex << listCreateFlags << std::dec << ", Count=2, MsgAddr=" << msgAddr << ", hCore=" << hCoreGlobal << ")" << std::endl; // DEBUG
-    LISTADDR listAddr = BTI429_ListXmtCreate(listCreateFlags, 2, msgAddr, hCoreGlobal);
-     std::cout << "[C++ Addon] BTI429_ListXmtCreate for Ch " << channel << " returned LISTADDR: " << listAddr << std::endl;
-    if (listAddr == 0) {
-        std::string errorMsg = "Failed to create transmit list for channel " + std::to_string(channel) + ".";
-        std::cerr << "[C++ Addon] Error: " << errorMsg << std::endl;
-        // TODO: Add BTI429_MsgRelease(msgAddr, hCoreGlobal) if available
-        g_transmitMsgAddr.erase(channel);
-        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCoreGlobal); // Attempt cleanup
-        resultObj.Set("status", Napi::Number::New(env, ERR_FAIL)); // Generic failure
-        resultObj.Set("message", Napi::String::New(env, errorMsg));
+    // Expecting: channel(int), label(int), sdi(int), data(int), ssm(int), parity(int - currently ignored)
+    if (info.Length() < 6 || !info[0].IsNumber() || !info[1].IsNumber() || !info[2].IsNumber() || !info[3].IsNumber() || !info[4].IsNumber() || !info[5].IsNumber()) {
+        BTI_LOG_ERROR("Incorrect arguments for StartTransmit.");
+        resultObj.Set("status", Napi::Number::New(env, ERR_PARAM)); // Use a distinct error code
+        resultObj.Set("message", Napi::String::New(env, "Error: Requires channel(int), label(int), sdi(int), data(int), ssm(int), parity(int)."));
         return resultObj;
     }
-    g_transmitListAddr[channel] = listAddr; // Store only on success
 
-    // 4. Construct and Write Word to List
+    int channel = info[0].As<Napi::Number>().Int32Value();
+    int label_in = info[1].As<Napi::Number>().Int32Value(); // Passed as decimal from JS
+    int sdi_in = info[2].As<Napi::Number>().Int32Value();
+    uint32_t data_in = info[3].As<Napi::Number>().Uint32Value();
+    int ssm_in = info[4].As<Napi::Number>().Int32Value();
+    // int parity_in = info[5].As<Napi::Number>().Int32Value(); // Parity handled by ChConfig
+
     uint32_t arincWord = ConstructArincWord(
         static_cast<uint8_t>(label_in & 0xFF),
         static_cast<uint8_t>(sdi_in & 0x03),
         data_in,
         static_cast<uint8_t>(ssm_in & 0x03)
     );
-     std::cout << "[C++ Addon] Constructed ARINC Word for Ch " << channel << ": 0x" << std::hex << arincWord << std::dec << std::endl;
-
-     std::cout << "[C++ Addon] Calling BTI429_ListDataWr(Word=0x" << std::hex << arincWord << std::dec << ", ListAddr=" << listAddr << ", hCore=" << hCoreGlobal << ")" << std::endl; // DEBUG
-    BOOL writeResult = BTI429_ListDataWr(arincWord, listAddr, hCoreGlobal);
-     std::cout << "[C++ Addon] BTI429_ListDataWr for Ch " << channel << " returned: " << writeResult << std::endl;
-    if (!writeResult) {
-         std::string errorMsg = "Failed to write data to transmit list for channel " + std::to_string(channel) + ".";
-        std::cerr << "[C++ Addon] Error: " << errorMsg << std::endl;
-        // TODO: Add BTI429_ListRelease(listAddr, hCoreGlobal) if available
-        // TODO: Add BTI429_MsgRelease(msgAddr, hCoreGlobal) if available
-         g_transmitListAddr.erase(channel);
-         g_transmitMsgAddr.erase(channel);
-        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCoreGlobal); // Attempt cleanup
-        resultObj.Set("status", Napi::Number::New(env, ERR_FAIL)); // Generic failure
-        resultObj.Set("message", Napi::String::New(env, errorMsg));
-        return resultObj;
-    }
-
-    // 5. Add Message/List to Schedule
-     std::cout << "[C++ Addon] Calling BTI429_SchedMsg(MsgAddr=" << msgAddr << ", Channel=" << channel << ", hCore=" << hCoreGlobal << ")" << std::endl; // DEBUG
-    SCHNDX schedIndex = BTI429_SchedMsg(msgAddr, channel, hCoreGlobal);
-     std::cout << "[C++ Addon] BTI429_SchedMsg for Ch " << channel << " returned index: " << schedIndex << std::endl;
-    if (schedIndex < 0) {
-         ERRVAL err = schedIndex; // SchedMsg returns error code directly
-         std::string errorMsg = "Failed to schedule message for channel " + std::to_string(channel) + ".";
-         std::cerr << "[C++ Addon] Error: " << errorMsg << " BTI Code: " << err << std::endl;
-        // TODO: Add BTI429_ListRelease(listAddr, hCoreGlobal) if available
-        // TODO: Add BTI429_MsgRelease(msgAddr, hCoreGlobal) if available
-         g_transmitListAddr.erase(channel);
-         g_transmitMsgAddr.erase(channel);
-        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCoreGlobal); // Attempt cleanup
-         resultObj.Set("status", Napi::Number::New(env, err));
-         resultObj.Set("message", Napi::String::New(env, errorMsg + " BTI Code: " + std::to_string(err)));
-        return resultObj;
-    }
+     BTI_LOG_DEBUG("Constructed ARINC Word for Ch %d: 0x%08x", channel, (unsigned)arincWord);
 
-    // 6. Mark as transmitting (CardStart should already be active from receiver)
-    g_isTransmitting[channel] = true;
-     std::cout << "[C++ Addon] Transmission successfully started on channel " << channel << std::endl;
-
-    resultObj.Set("status", Napi::Number::New(env, ERR_NONE));
-    resultObj.Set("message", Napi::String::New(env, "Transmission started successfully on channel " + std::to_string(channel)));
+    std::string message;
+    int status = session->StartTransmit(channel, arincWord, &message);
+    resultObj.Set("status", Napi::Number::New(env, status));
+    resultObj.Set("message", Napi::String::New(env, message));
     return resultObj;
 }
 
 // Exported Function: StopTransmit
+// stopTransmit(channel, [hCore]); without hCore the first opened core is used
 Napi::Value StopTransmitWrapped(const Napi::CallbackInfo& info) {
     Napi::Env env = info.Env();
     Napi::Object resultObj = Napi::Object::New(env);
-    std::cout << "[C++ Addon] StopTransmitWrapped called." << std::endl; // DEBUG
+    BTI_LOG_DEBUG("StopTransmitWrapped called.");
 
-     if (hCoreGlobal == NULL) {
-        std::cerr << "[C++ Addon] Error: Hardware not initialized (Core handle is null)." << std::endl;
+    DeviceSession* session = nullptr;
+    if (info.Length() >= 2 && info[1].IsBigInt()) {
+        session = SessionFromArg(env, info[1]);
+        if (!session) return env.Null();
+    } else {
+        session = Sessions().Default();
+    }
+     if (session == nullptr) {
+        BTI_LOG_ERROR("Hardware not initialized (Core handle is null).");
         resultObj.Set("status", Napi::Number::New(env, ERR_HWINIT));
         resultObj.Set("message", Napi::String::New(env, "Error: Hardware not initialized."));
         return resultObj;
      }
     if (info.Length() < 1 || !info[0].IsNumber()) {
-         std::cerr << "[C++ Addon] Error: Incorrect arguments for StopTransmit." << std::endl;
+         BTI_LOG_ERROR("Incorrect arguments for StopTransmit.");
         resultObj.Set("status", Napi::Number::New(env, ERR_PARAM));
         resultObj.Set("message", Napi::String::New(env, "Error: Requires channel(int)."));
         return resultObj;
@@ -2063,46 +4273,10 @@ Napi::Value StopTransmitWrapped(const Napi::CallbackInfo& info) {
 
     int channel = info[0].As<Napi::Number>().Int32Value();
 
-    std::lock_guard<std::mutex> lock(g_transmitMutex);
-
-    // Check if we were actually transmitting on this channel
-    if (!g_isTransmitting.count(channel) || !g_isTransmitting.at(channel)) {
-        std::cout << "[C++ Addon] Warning: StopTransmit called for channel " << channel << " which is not marked as transmitting." << std::endl;
-        resultObj.Set("status", Napi::Number::New(env, ERR_NONE)); // Not an error, just wasn't transmitting
-        resultObj.Set("message", Napi::String::New(env, "Warning: Channel " + std::to_string(channel) + " was not transmitting."));
-        return resultObj;
-    }
-
-     std::cout << "[C++ Addon] Attempting to stop transmission on channel " << channel << "..." << std::endl;
-
-    // 1. Deactivate/Reconfigure the channel to stop transmission and release resources
-    //    Using CHCFG429_INACTIVE is simplest. Assumes receiver setup will handle re-enabling receive if needed.
-    ULONG inactiveFlags = CHCFG429_INACTIVE;
-    std::cout << "[C++ Addon] Calling BTI429_ChConfig(0x" << std::hex << inactiveFlags << std::dec << ", " << channel << ", hCore=" << hCoreGlobal << ") to stop transmission." << std::endl; // DEBUG
-    ERRVAL configResult = BTI429_ChConfig(inactiveFlags, channel, hCoreGlobal);
-    std::cout << "[C++ Addon] BTI429_ChConfig(Inactive) for Ch " << channel << " returned: " << configResult << std::endl;
-
-    // TODO: Explicitly release list/msg if BTI functions exist?
-    // BTI429_ListRelease(g_transmitListAddr[channel], hCoreGlobal);
-    // BTI429_MsgRelease(g_transmitMsgAddr[channel], hCoreGlobal);
-
-    // 2. Clear internal state regardless of ChConfig result, as we are stopping logically
-    g_isTransmitting.erase(channel);
-    g_transmitMsgAddr.erase(channel);
-    g_transmitListAddr.erase(channel);
-
-    if (configResult != ERR_NONE) {
-        // Log the error, but still report logical success to JS, as we cleared internal state
-        std::string errorMsg = "Error during ChConfig(Inactive) on channel " + std::to_string(channel) + ".";
-        std::cerr << "[C++ Addon] Warning: " << errorMsg << " BTI Code: " << configResult << std::endl;
-         resultObj.Set("status", Napi::Number::New(env, ERR_NONE)); // Report logical success
-         resultObj.Set("message", Napi::String::New(env, "Transmission stopped on channel " + std::to_string(channel) + " (with potential ChConfig warning: " + std::to_string(configResult) + ")"));
-    } else {
-        std::cout << "[C++ Addon] Transmission stopped successfully on channel " << channel << std::endl;
-        resultObj.Set("status", Napi::Number::New(env, ERR_NONE));
-        resultObj.Set("message", Napi::String::New(env, "Transmission stopped successfully on channel " + std::to_string(channel)));
-    }
-
+    std::string message;
+    int status = session->StopTransmit(channel, &message);
+    resultObj.Set("status", Napi::Number::New(env, status));
+    resultObj.Set("message", Napi::String::New(env, message));
     return resultObj;
 }
 
@@ -2156,14 +4330,96 @@ Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set(Napi::String::New(env, "initializeHardware"), Napi::Function::New(env, InitializeHardwareWrapped));
   exports.Set(Napi::String::New(env, "initializeReceiver"), Napi::Function::New(env, InitializeReceiverWrapped));
   exports.Set(Napi::String::New(env, "startMonitoring"), Napi::Function::New(env, StartMonitoringWrapped));
+  exports.Set(Napi::String::New(env, "setStreamChannels"), Napi::Function::New(env, SetStreamChannelsWrapped));
   exports.Set(Napi::String::New(env, "stopMonitoring"), Napi::Function::New(env, StopMonitoringWrapped));
   exports.Set(Napi::String::New(env, "cleanupHardware"), Napi::Function::New(env, CleanupHardwareWrapped)); // Renamed for consistency
+  exports.Set(Napi::String::New(env, "getMonitorStats"), Napi::Function::New(env, GetMonitorStatsWrapped));
+  exports.Set(Napi::String::New(env, "listSessions"), Napi::Function::New(env, ListSessionsWrapped));
+  exports.Set(Napi::String::New(env, "attachCaptureDaemon"), Napi::Function::New(env, AttachCaptureDaemonWrapped));
+  exports.Set(Napi::String::New(env, "detachCaptureDaemon"), Napi::Function::New(env, DetachCaptureDaemonWrapped));
+  exports.Set(Napi::String::New(env, "stopCaptureDaemon"), Napi::Function::New(env, StopCaptureDaemonWrapped));
+  exports.Set(Napi::String::New(env, "getCaptureDaemonStatus"), Napi::Function::New(env, GetCaptureDaemonStatusWrapped));
+  exports.Set(Napi::String::New(env, "startValuePublisher"), Napi::Function::New(env, StartValuePublisherWrapped));
+  exports.Set(Napi::String::New(env, "stopValuePublisher"), Napi::Function::New(env, StopValuePublisherWrapped));
+  exports.Set(Napi::String::New(env, "subscribe"), Napi::Function::New(env, SubscribeWrapped));
+  exports.Set(Napi::String::New(env, "unsubscribe"), Napi::Function::New(env, UnsubscribeWrapped));
+  exports.Set(Napi::String::New(env, "getSubscriptions"), Napi::Function::New(env, GetSubscriptionsWrapped));
+  exports.Set(Napi::String::New(env, "startCaptureRecording"), Napi::Function::New(env, StartCaptureRecordingWrapped));
+  exports.Set(Napi::String::New(env, "stopCaptureRecording"), Napi::Function::New(env, StopCaptureRecordingWrapped));
+  exports.Set(Napi::String::New(env, "getCaptureRecordingStats"), Napi::Function::New(env, GetCaptureRecordingStatsWrapped));
+  exports.Set(Napi::String::New(env, "readCaptureFile"), Napi::Function::New(env, ReadCaptureFileWrapped));
+  exports.Set(Napi::String::New(env, "exportCaptureColumnar"), Napi::Function::New(env, ExportCaptureColumnarWrapped));
+  exports.Set(Napi::String::New(env, "getChangesSince"), Napi::Function::New(env, GetChangesSinceWrapped));
+  exports.Set(Napi::String::New(env, "downsampleCaptureFile"), Napi::Function::New(env, DownsampleCaptureFileWrapped));
+  exports.Set(Napi::String::New(env, "setHistory"), Napi::Function::New(env, SetHistoryWrapped));
+  exports.Set(Napi::String::New(env, "getHistory"), Napi::Function::New(env, GetHistoryWrapped));
+  exports.Set(Napi::String::New(env, "getHistoryStats"), Napi::Function::New(env, GetHistoryStatsWrapped));
+  exports.Set(Napi::String::New(env, "downsampleHistory"), Napi::Function::New(env, DownsampleHistoryWrapped));
+  exports.Set(Napi::String::New(env, "setDerivedParameters"), Napi::Function::New(env, SetDerivedParametersWrapped));
+  exports.Set(Napi::String::New(env, "getDerivedValues"), Napi::Function::New(env, GetDerivedValuesWrapped));
+  exports.Set(Napi::String::New(env, "startDioMonitor"), Napi::Function::New(env, StartDioMonitorWrapped));
+  exports.Set(Napi::String::New(env, "stopDioMonitor"), Napi::Function::New(env, StopDioMonitorWrapped));
+  exports.Set(Napi::String::New(env, "getDioState"), Napi::Function::New(env, GetDioStateWrapped));
+  exports.Set(Napi::String::New(env, "getDioPulseStats"), Napi::Function::New(env, GetDioPulseStatsWrapped));
+  exports.Set(Napi::String::New(env, "setEventHandler"), Napi::Function::New(env, SetEventHandlerWrapped));
+  exports.Set(Napi::String::New(env, "getErrorCounters"), Napi::Function::New(env, GetErrorCountersWrapped));
+  exports.Set(Napi::String::New(env, "setAdaptiveLists"), Napi::Function::New(env, SetAdaptiveListsWrapped));
+  exports.Set(Napi::String::New(env, "setChangeOnly"), Napi::Function::New(env, SetChangeOnlyWrapped));
+  exports.Set(Napi::String::New(env, "getChangeOnlyStats"), Napi::Function::New(env, GetChangeOnlyStatsWrapped));
+  exports.Set(Napi::String::New(env, "setSnapshotInterval"), Napi::Function::New(env, SetSnapshotIntervalWrapped));
+  exports.Set(Napi::String::New(env, "getSnapshot"), Napi::Function::New(env, GetSnapshotWrapped));
+  exports.Set(Napi::String::New(env, "setAlarmRules"), Napi::Function::New(env, SetAlarmRulesWrapped));
+  exports.Set(Napi::String::New(env, "getActiveAlarms"), Napi::Function::New(env, GetActiveAlarmsWrapped));
+  exports.Set(Napi::String::New(env, "setAlarmHandler"), Napi::Function::New(env, SetAlarmHandlerWrapped));
+  exports.Set(Napi::String::New(env, "prepareReceivers"), Napi::Function::New(env, PrepareReceiversWrapped));
+  exports.Set(Napi::String::New(env, "applyReceiverConfig"), Napi::Function::New(env, ApplyReceiverConfigWrapped));
+  exports.Set(Napi::String::New(env, "startTracing"), Napi::Function::New(env, StartTracingWrapped));
+  exports.Set(Napi::String::New(env, "stopTracing"), Napi::Function::New(env, StopTracingWrapped));
+  exports.Set(Napi::String::New(env, "setLogHandler"), Napi::Function::New(env, SetLogHandlerWrapped));
+  exports.Set(Napi::String::New(env, "setLogLevel"), Napi::Function::New(env, SetLogLevelWrapped));
+  exports.Set(Napi::String::New(env, "getLogStats"), Napi::Function::New(env, GetLogStatsWrapped));
 
   // --- Export NEW ARINC Transmit control functions ---
   exports.Set(Napi::String::New(env, "startTransmit"), Napi::Function::New(env, StartTransmitWrapped)); // Export StartTransmitWrapped as startTransmit
   exports.Set(Napi::String::New(env, "stopTransmit"), Napi::Function::New(env, StopTransmitWrapped)); // Export StopTransmitWrapped as stopTransmit
   // --- END Export Transmit ---
 
+  // Per-environment state; freed by N-API after this environment's cleanup hooks have run
+  AddonData* addon = new AddonData();
+  env.SetInstanceData(addon);
+  {
+      std::lock_guard<std::mutex> lock(g_envMutex);
+      ++g_envCount;
+  }
+
+  // Start the native log drain thread (shared by all environments). When this environment shuts down, detach
+  // its callbacks; the last one to go also stops the hardware and flushes the logger.
+  LogStart();
+  env.AddCleanupHook([addon]() {
+      ReleaseLogHandler(addon);
+      ReleaseEventHandler(addon);
+      ReleaseAlarmHandler(addon);
+      while (!addon->subscriptions.empty()) RemoveSubscription(addon, addon->subscriptions.begin()->first);
+      while (!addon->dioWatches.empty()) RemoveDioWatch(addon, addon->dioWatches.begin()->first);
+      bool ownsStream, lastEnv;
+      {
+          std::lock_guard<std::mutex> lock(g_envMutex);
+          ownsStream = g_streamOwner == addon;
+          lastEnv = --g_envCount == 0;
+      }
+      if (ownsStream || lastEnv) Capture().Detach(); // Nobody left to deliver daemon words to
+      ReleaseStreamCallbacks(addon, true);
+      if (lastEnv) {
+          std::string errorMessage;
+          ValueTable().Stop();
+          History().Stop();
+          Sessions().CloseAll(&errorMessage);
+          CaptureRecordingStats captureStats;
+          Recorder().Stop(&captureStats); // Writes the last block so the file ends cleanly
+          LogShutdown();
+      }
+  });
+
   return exports;
 }
 
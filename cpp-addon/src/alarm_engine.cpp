@@ -0,0 +1,180 @@
+#include "alarm_engine.h"
+
+#include <cmath>
+
+bool BuildAlarmConfig(const std::vector<AlarmRule>& rules, std::shared_ptr<const AlarmConfig>* config, std::string* errorMessage) {
+    auto built = std::make_shared<AlarmConfig>();
+    built->byKey.resize(ALARM_MAX_CHANNELS * 256);
+    for (const AlarmRule& rule : rules) {
+        std::string where = "rules[" + std::to_string(rule.id) + "]: ";
+        if (rule.label < 0 || rule.label > 255 || rule.channel < -1 || rule.channel >= ALARM_MAX_CHANNELS) {
+            *errorMessage = where + "needs label 0..255 and channel 0..31";
+            return false;
+        }
+        if (rule.sdi < -1 || rule.sdi > 3) {
+            *errorMessage = where + "sdi must be 0..3";
+            return false;
+        }
+        if (!ValidateDecoding(rule.decoding, errorMessage)) {
+            *errorMessage = where + *errorMessage;
+            return false;
+        }
+        switch (rule.kind) {
+        case AlarmKind::Range:
+            if (!(rule.low <= rule.high) || !(rule.hysteresis >= 0.0) || rule.low + rule.hysteresis > rule.high - rule.hysteresis) {
+                *errorMessage = where + "range needs low <= high and a hysteresis of at most half the band";
+                return false;
+            }
+            break;
+        case AlarmKind::Rate:
+            if (!(rule.maxRate > 0.0) || !(rule.hysteresis >= 0.0) || rule.hysteresis >= rule.maxRate) {
+                *errorMessage = where + "rate needs maxRate > 0 and 0 <= hysteresis < maxRate";
+                return false;
+            }
+            break;
+        case AlarmKind::Ssm:
+            if (rule.ssmMask == 0 || rule.ssmMask > 0xF) {
+                *errorMessage = where + "ssm needs one or more states 0..3";
+                return false;
+            }
+            break;
+        case AlarmKind::Stale:
+            if (rule.staleNs <= 0 || rule.channel < 0) {
+                *errorMessage = where + "stale needs a channel and staleMs > 0";
+                return false;
+            }
+            break;
+        case AlarmKind::Parity:
+            break;
+        }
+
+        int first = rule.channel < 0 ? 0 : rule.channel;
+        int last = rule.channel < 0 ? ALARM_MAX_CHANNELS - 1 : rule.channel;
+        for (int channel = first; channel <= last; ++channel) {
+            if (built->rules.size() >= (size_t)ALARM_MAX_RULES) {
+                *errorMessage = "At most " + std::to_string(ALARM_MAX_RULES) + " rules (counting one per channel)";
+                return false;
+            }
+            AlarmRule copy = rule;
+            copy.channel = channel;
+            built->channelMask |= 1u << channel;
+            int index = (int)built->rules.size();
+            built->rules.push_back(copy);
+            built->byKey[channel * 256 + rule.label].push_back(index);
+            if (rule.kind == AlarmKind::Stale) built->staleRules.push_back(index);
+        }
+    }
+    *config = built;
+    return true;
+}
+
+const char* AlarmKindName(AlarmKind kind) {
+    switch (kind) {
+    case AlarmKind::Ssm: return "ssm";
+    case AlarmKind::Rate: return "rate";
+    case AlarmKind::Stale: return "stale";
+    case AlarmKind::Parity: return "parity";
+    default: return "range";
+    }
+}
+
+bool ParseAlarmKind(const std::string& name, AlarmKind* kind) {
+    if (name == "range") *kind = AlarmKind::Range;
+    else if (name == "ssm") *kind = AlarmKind::Ssm;
+    else if (name == "rate") *kind = AlarmKind::Rate;
+    else if (name == "stale") *kind = AlarmKind::Stale;
+    else if (name == "parity") *kind = AlarmKind::Parity;
+    else return false;
+    return true;
+}
+
+void AlarmEvaluator::Reset(std::shared_ptr<const AlarmConfig> config, int64_t nowNs) {
+    config_ = std::move(config);
+    states_.assign(config_ ? config_->rules.size() : 0, RuleState());
+    for (RuleState& state : states_) state.lastNs = nowNs; // Staleness counts from when the rules were applied
+}
+
+void AlarmEvaluator::Transition(const AlarmRule& rule, RuleState& state, bool active, uint32_t word, double value,
+                                uint64_t hwTime, int64_t nowNs, long long nowMs, std::vector<AlarmTransition>* out) {
+    if (state.active == active) return;
+    state.active = active;
+    AlarmTransition transition = {rule.id, rule.kind, active, rule.channel, rule.label, word, value, hwTime, nowMs, nowNs, -1, -1};
+    if (active) state.raised = transition;
+    out->push_back(transition);
+}
+
+void AlarmEvaluator::OnWord(int channel, uint32_t word, uint64_t hwTime, int64_t nowNs, long long nowMs,
+                            std::vector<AlarmTransition>* out) {
+    if (!config_ || channel < 0 || channel >= ALARM_MAX_CHANNELS) return;
+    const std::vector<int>& rules = config_->byKey[channel * 256 + WordLabel(word)];
+    for (int index : rules) {
+        const AlarmRule& rule = config_->rules[index];
+        if (rule.sdi >= 0 && WordSdi(word) != rule.sdi) continue;
+        RuleState& state = states_[index];
+        switch (rule.kind) {
+        case AlarmKind::Range: {
+            double value = DecodeWord(word, rule.decoding);
+            if (std::isnan(value)) break;
+            if (value < rule.low || value > rule.high) {
+                Transition(rule, state, true, word, value, hwTime, nowNs, nowMs, out);
+            } else if (value >= rule.low + rule.hysteresis && value <= rule.high - rule.hysteresis) {
+                Transition(rule, state, false, word, value, hwTime, nowNs, nowMs, out);
+            }
+            break;
+        }
+        case AlarmKind::Ssm: {
+            bool raised = (rule.ssmMask >> WordSsm(word)) & 1;
+            Transition(rule, state, raised, word, (double)WordSsm(word), hwTime, nowNs, nowMs, out);
+            break;
+        }
+        case AlarmKind::Rate: {
+            double value = DecodeWord(word, rule.decoding);
+            if (std::isnan(value)) break;
+            if (!state.hasSample) {
+                state.hasSample = true;
+                state.sample = value;
+                state.sampleNs = nowNs;
+                break;
+            }
+            int64_t elapsedNs = nowNs - state.sampleNs;
+            if (elapsedNs < ALARM_RATE_MIN_INTERVAL_NS) break;
+            double rate = std::fabs(value - state.sample) / (elapsedNs / 1e9);
+            state.sample = value;
+            state.sampleNs = nowNs;
+            if (rate > rule.maxRate) {
+                Transition(rule, state, true, word, rate, hwTime, nowNs, nowMs, out);
+            } else if (rate <= rule.maxRate - rule.hysteresis) {
+                Transition(rule, state, false, word, rate, hwTime, nowNs, nowMs, out);
+            }
+            break;
+        }
+        case AlarmKind::Stale:
+            Transition(rule, state, false, word, (nowNs - state.lastNs) / 1e9, hwTime, nowNs, nowMs, out);
+            state.lastNs = nowNs;
+            state.lastWord = word;
+            break;
+        case AlarmKind::Parity:
+            Transition(rule, state, !WordParityOk(word), word, 0.0, hwTime, nowNs, nowMs, out);
+            break;
+        }
+    }
+}
+
+void AlarmEvaluator::CheckStale(int64_t nowNs, long long nowMs, std::vector<AlarmTransition>* out) {
+    if (!config_) return;
+    for (int index : config_->staleRules) {
+        const AlarmRule& rule = config_->rules[index];
+        RuleState& state = states_[index];
+        if (!state.active && nowNs - state.lastNs > rule.staleNs) {
+            Transition(rule, state, true, state.lastWord, (nowNs - state.lastNs) / 1e9, 0, nowNs, nowMs, out);
+        }
+    }
+}
+
+std::vector<AlarmTransition> AlarmEvaluator::Active() const {
+    std::vector<AlarmTransition> active;
+    for (const RuleState& state : states_) {
+        if (state.active) active.push_back(state.raised);
+    }
+    return active;
+}
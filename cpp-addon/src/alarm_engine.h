@@ -0,0 +1,100 @@
+#ifndef ALARM_ENGINE_H
+#define ALARM_ENGINE_H
+
+// Exceedance monitoring in the reader thread. Each session runs its AlarmEvaluator on every word it reads (before
+// report-on-change drops repeats) and once per cycle for staleness; only transitions (raised / cleared) leave the
+// reader, stamped with the card timer, so alarm latency does not depend on how busy the JS side is.
+//
+//   range    decoded value outside [low, high]; clears once back inside by `hysteresis`
+//   ssm      the word's SSM is one of the states in ssmMask; clears on a word with another state
+//   rate     |change| per second above maxRate; clears below maxRate - hysteresis. Rates are taken between words
+//            at least ALARM_RATE_MIN_INTERVAL_NS apart (list words are timed when drained, not when received)
+//   stale    no word for staleNs; clears on the next word
+//   parity   a word failing odd parity; clears on the next good word
+
+#include "label_decoder.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+const int ALARM_MAX_CHANNELS = 32;
+const int ALARM_MAX_RULES = 4096;
+const int64_t ALARM_RATE_MIN_INTERVAL_NS = 5000000;
+
+enum class AlarmKind { Range, Ssm, Rate, Stale, Parity };
+
+struct AlarmRule {
+    int id = 0;                   // Index in the caller's rule list; copies made for "any channel" share it
+    AlarmKind kind = AlarmKind::Range;
+    int channel = -1;             // -1 = every channel (not for stale rules)
+    int label = 0;
+    int sdi = -1;                 // -1 = any
+    LabelDecoding decoding;       // Range and rate rules work on the decoded value
+    double low = -INFINITY;
+    double high = INFINITY;
+    double hysteresis = 0.0;
+    double maxRate = 0.0;         // Decoded units per second
+    uint8_t ssmMask = 0;          // Bit per SSM state 0..3
+    int64_t staleNs = 0;
+};
+
+struct AlarmConfig {
+    std::vector<AlarmRule> rules;             // One per channel they apply to
+    std::vector<std::vector<int>> byKey;      // [channel * 256 + label] -> rules
+    std::vector<int> staleRules;
+    uint32_t channelMask = 0;                 // Bit per channel some rule reads
+};
+
+// Validates rules and indexes them by channel/label; "any channel" rules are copied per channel
+bool BuildAlarmConfig(const std::vector<AlarmRule>& rules, std::shared_ptr<const AlarmConfig>* config, std::string* errorMessage);
+
+struct AlarmTransition {
+    int rule;                     // AlarmRule::id
+    AlarmKind kind;
+    bool active;                  // true = raised, false = cleared
+    int channel;
+    int label;
+    uint32_t word;                // Word that caused it (stale: the last word seen, 0 if none)
+    double value;                 // Decoded value, rate per second, or seconds without a word (stale)
+    uint64_t hwTime;              // Card timer: the word's timetag for snapshot labels, else read when the cycle ended
+    long long timestamp_ms;
+    int64_t timestamp_ns;
+    int card;
+    int core;
+};
+
+const char* AlarmKindName(AlarmKind kind);
+bool ParseAlarmKind(const std::string& name, AlarmKind* kind);
+
+// State of one session's rules; reader thread only
+class AlarmEvaluator {
+public:
+    void Reset(std::shared_ptr<const AlarmConfig> config, int64_t nowNs);
+    bool Empty() const { return !config_ || config_->rules.empty(); }
+    // hwTime 0 = unknown (stamped by the caller later)
+    void OnWord(int channel, uint32_t word, uint64_t hwTime, int64_t nowNs, long long nowMs, std::vector<AlarmTransition>* out);
+    void CheckStale(int64_t nowNs, long long nowMs, std::vector<AlarmTransition>* out);
+    // The raising transition of every active alarm
+    std::vector<AlarmTransition> Active() const;
+
+private:
+    struct RuleState {
+        bool active = false;
+        bool hasSample = false;
+        double sample = 0.0;          // Rate: value and time of the reference word
+        int64_t sampleNs = 0;
+        int64_t lastNs = 0;           // Stale: last word (or when the rules were applied)
+        uint32_t lastWord = 0;
+        AlarmTransition raised;
+    };
+    void Transition(const AlarmRule& rule, RuleState& state, bool active, uint32_t word, double value,
+                    uint64_t hwTime, int64_t nowNs, long long nowMs, std::vector<AlarmTransition>* out);
+
+    std::shared_ptr<const AlarmConfig> config_;
+    std::vector<RuleState> states_;
+};
+
+#endif // ALARM_ENGINE_H
@@ -0,0 +1,188 @@
+#include "capture_client.h"
+#include "device_session.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+const size_t CLIENT_MAX_BATCH = 4096;        // Words per delivered batch
+const int64_t HEARTBEAT_TIMEOUT_MS = 2000;   // Daemon considered stalled after this long without a heartbeat
+
+int64_t EpochNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Copies a seqlock-protected block; returns false if the writer kept it busy
+template <typename Block>
+bool ReadSeqlocked(const Block* src, Block* dst) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        uint32_t before = src->seq;
+        if (before & 1) continue;
+        CAPSHM_BARRIER();
+        std::memcpy((void*)dst, (const void*)src, sizeof(Block));
+        CAPSHM_BARRIER();
+        if (src->seq == before) return true;
+    }
+    return false;
+}
+
+// Copies the header, with the last-error fields consistent under errorSeq
+bool ReadSeqlockedError(const CapShmHeader* src, CapShmHeader* dst) {
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        uint32_t before = src->errorSeq;
+        if (before & 1) continue;
+        CAPSHM_BARRIER();
+        std::memcpy((void*)dst, (const void*)src, sizeof(CapShmHeader));
+        CAPSHM_BARRIER();
+        if (src->errorSeq == before) return true;
+    }
+    return false;
+}
+}
+
+CaptureClient& Capture() {
+    static CaptureClient* client = new CaptureClient(); // Leaked: the read thread may outlive static destruction
+    return *client;
+}
+
+bool CaptureClient::Attach(const std::string& name, std::string* errorMessage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) {
+        *errorMessage = "Already attached to capture daemon " + name_ + ".";
+        return false;
+    }
+    if (!region_.Open(name, errorMessage)) return false;
+
+    CapShmHeader* header = static_cast<CapShmHeader*>(region_.Data());
+    if (header->magic != CAPSHM_MAGIC || header->version != CAPSHM_VERSION ||
+        (region_.Size() != 0 && region_.Size() < header->totalSize)) {
+        *errorMessage = "Shared memory " + name + " is not a compatible capture region.";
+        region_.Close();
+        return false;
+    }
+
+    header_ = header;
+    name_ = name;
+    wordsReceived_.store(0);
+    wordsLost_.store(0);
+    running_.store(true);
+    thread_ = std::thread(&CaptureClient::ReadLoop, this);
+    BTI_LOG_INFO("Attached to capture daemon %s (pid %u).", name.c_str(), (unsigned)header->daemonPid);
+    return true;
+}
+
+void CaptureClient::Detach() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    header_ = nullptr;
+    region_.Close();
+    BTI_LOG_INFO("Detached from capture daemon %s.", name_.c_str());
+}
+
+bool CaptureClient::RequestDaemonStop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!header_) return false;
+    header_->stopRequest = 1;
+    return true;
+}
+
+CaptureClientStatus CaptureClient::Status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CaptureClientStatus status;
+    status.name = name_;
+    if (!header_) return status;
+
+    status.attached = running_.load();
+    status.state = header_->state;
+    status.daemonPid = header_->daemonPid;
+    status.heartbeatAgeMs = EpochNowMs() - header_->heartbeatMs;
+    status.writeIndex = header_->writeIndex;
+    status.errorCount = header_->errorCount;
+    status.wordsReceived = wordsReceived_.load(std::memory_order_relaxed);
+    status.wordsLost = wordsLost_.load(std::memory_order_relaxed);
+    uint32_t sessionCount = header_->sessionCount;
+    for (uint32_t i = 0; i < sessionCount && i < CAPSHM_MAX_SESSIONS; ++i) {
+        CapShmSession block;
+        if (ReadSeqlocked(CapShmSessionAt(header_, (int)i), &block)) status.sessions.push_back(block);
+    }
+    return status;
+}
+
+void CaptureClient::ReadLoop() {
+    TraceSetThreadName("CaptureClient");
+    CapShmHeader* header = header_;
+    uint64_t readIndex = header->writeIndex; // Start at the live position; history is not replayed
+    uint64_t seenErrors = header->errorCount;
+    bool daemonLost = false;
+
+    while (running_.load()) {
+        uint64_t writeIndex = header->writeIndex;
+        CAPSHM_BARRIER();
+
+        if (writeIndex - readIndex > CAPSHM_RING_CAPACITY) { // Lapped: the oldest unread words are gone
+            uint64_t skipped = writeIndex - readIndex - CAPSHM_RING_CAPACITY;
+            wordsLost_.fetch_add(skipped, std::memory_order_relaxed);
+            readIndex += skipped;
+        }
+
+        if (readIndex != writeIndex) {
+            TRACE_SCOPE_ARG("CaptureClient.Read", "words", writeIndex - readIndex);
+            auto* batch = new std::vector<ArincUpdateData>();
+            batch->reserve(std::min<uint64_t>(writeIndex - readIndex, CLIENT_MAX_BATCH));
+            for (; readIndex != writeIndex && batch->size() < CLIENT_MAX_BATCH; ++readIndex) {
+                const CapShmWord* slot = CapShmRingSlot(header, readIndex);
+                uint64_t before = slot->seq;
+                CAPSHM_BARRIER();
+                CapShmWord entry;
+                std::memcpy((void*)&entry, (const void*)slot, sizeof(entry));
+                CAPSHM_BARRIER();
+                if (before != readIndex + 1 || slot->seq != before) { // Overwritten while we were reading
+                    wordsLost_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                bool gap = (entry.card & CAPSHM_WORD_GAP) != 0;
+                batch->push_back(ArincUpdateData{entry.channel, gap ? ARINC_GAP_LABEL : entry.label, (ULONG)entry.word,
+                    entry.timestampMs, entry.timestampNs, (int)(entry.card & ~CAPSHM_WORD_GAP), entry.core});
+            }
+            wordsReceived_.fetch_add(batch->size(), std::memory_order_relaxed);
+            if (batch->empty()) {
+                delete batch;
+            } else {
+                Sessions().DeliverExternal(batch);
+            }
+            continue; // Keep draining before sleeping
+        }
+
+        uint64_t errorCount = header->errorCount;
+        if (errorCount != seenErrors) {
+            CapShmHeader errorCopy;
+            if (ReadSeqlockedError(header, &errorCopy)) {
+                std::string message(errorCopy.errorText, strnlen(errorCopy.errorText, CAPSHM_ERROR_TEXT));
+                if (errorCount - seenErrors > 1) {
+                    message += " (" + std::to_string(errorCount - seenErrors - 1) + " earlier daemon error(s) not shown)";
+                }
+                Sessions().ReportError(new ArincErrorData{errorCopy.errorChannel, errorCopy.errorCode, message,
+                    errorCopy.errorCard, errorCopy.errorCore});
+            }
+            seenErrors = errorCount;
+        }
+
+        uint32_t state = header->state;
+        bool stalled = state == CAPSHM_STATE_RUNNING && EpochNowMs() - header->heartbeatMs > HEARTBEAT_TIMEOUT_MS;
+        bool lost = stalled || state == CAPSHM_STATE_STOPPED || state == CAPSHM_STATE_FAILED;
+        if (lost && !daemonLost) {
+            std::string message = stalled ? "Capture daemon heartbeat lost." :
+                (state == CAPSHM_STATE_FAILED ? "Capture daemon failed." : "Capture daemon stopped.");
+            BTI_LOG_WARN("%s", message.c_str());
+            Sessions().ReportError(new ArincErrorData{-1, ERR_FAIL, message, -1, -1});
+        }
+        daemonLost = lost;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef CAPTURE_CLIENT_H
+#define CAPTURE_CLIENT_H
+
+// Client side of the out-of-process capture daemon. Maps the daemon's shared-memory region, follows its
+// word ring on a background thread and feeds the words and errors into the session registry's sinks,
+// so JS receives them exactly like locally captured data. A stalled or crashed client never affects
+// the daemon: the ring simply overwrites, and the client counts what it missed.
+
+#include "capture_shm.h"
+#include "shared_memory.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct CaptureClientStatus {
+    bool attached = false;
+    std::string name;
+    uint32_t state = CAPSHM_STATE_STOPPED;
+    uint32_t daemonPid = 0;
+    int64_t heartbeatAgeMs = -1;
+    uint64_t writeIndex = 0;
+    uint64_t wordsReceived = 0;
+    uint64_t wordsLost = 0;      // Overwritten in the ring before this client read them
+    uint64_t errorCount = 0;
+    std::vector<CapShmSession> sessions; // Consistent per-block snapshots
+};
+
+class CaptureClient {
+public:
+    bool Attach(const std::string& name, std::string* errorMessage);
+    void Detach();
+    bool IsAttached() const { return running_.load(); }
+    bool RequestDaemonStop();
+    CaptureClientStatus Status();
+
+private:
+    void ReadLoop();
+
+    std::mutex mutex_; // Guards attach/detach and the mapping while Status() reads it
+    SharedMemoryRegion region_;
+    CapShmHeader* header_ = nullptr;
+    std::string name_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> wordsReceived_{0};
+    std::atomic<uint64_t> wordsLost_{0};
+};
+
+CaptureClient& Capture();
+
+#endif // CAPTURE_CLIENT_H
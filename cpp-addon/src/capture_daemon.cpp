@@ -0,0 +1,161 @@
+// Standalone ARINC capture process (bti_capture_daemon).
+// Runs the same DeviceSession engine as the addon, but outside Electron: it opens the requested cores,
+// monitors them, and publishes words, current values, errors and stats to a shared-memory region
+// (capture_shm.h). The addon attaches to that region as a client (attachCaptureDaemon), so a stalled or
+// crashed UI process never stops capture.
+//
+// Usage: bti_capture_daemon [--name <region>] [--core <card>:<core>]... [--priority normal|high|realtime]
+// Exits when a client sets stopRequest, on Ctrl+C / console close, or when startup fails.
+
+#include "capture_shm.h"
+#include "device_session.h"
+#include "native_log.h"
+#include "shm_publisher.h"
+
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const int STATS_PUBLISH_INTERVAL_MS = 100; // Session stats and heartbeat cadence
+
+std::atomic<bool> g_consoleStop(false);
+
+BOOL WINAPI ConsoleCtrlHandler(DWORD ctrlType) {
+    if (ctrlType == CTRL_C_EVENT || ctrlType == CTRL_BREAK_EVENT ||
+        ctrlType == CTRL_CLOSE_EVENT || ctrlType == CTRL_SHUTDOWN_EVENT) {
+        g_consoleStop.store(true);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// Registry sinks: the merge thread publishes straight into shared memory
+void PublishBatchSink(void* context, std::vector<ArincUpdateData>* batch) {
+    static_cast<ShmPublisher*>(context)->PublishWords(*batch, true);
+    delete batch;
+}
+
+void PublishErrorSink(void* context, ArincErrorData* error) {
+    BTI_LOG_WARN("Card %d core %d channel %d: %s (code %d)", error->card, error->core, error->channel,
+        error->message.c_str(), error->status_code);
+    static_cast<ShmPublisher*>(context)->PublishError(*error);
+    delete error;
+}
+
+struct DaemonOptions {
+    std::string name = CAPSHM_DEFAULT_NAME;
+    std::vector<std::pair<int, int>> cores; // card, core
+    DWORD priorityClass = HIGH_PRIORITY_CLASS;
+};
+
+bool ParseArgs(int argc, char** argv, DaemonOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--name" && hasValue) {
+            options->name = argv[++i];
+        } else if (arg == "--core" && hasValue) {
+            int card = 0, core = 0;
+            if (std::sscanf(argv[++i], "%d:%d", &card, &core) != 2 || card < 0 || core < 0) return false;
+            options->cores.emplace_back(card, core);
+        } else if (arg == "--priority" && hasValue) {
+            std::string priority = argv[++i];
+            if (priority == "normal") options->priorityClass = NORMAL_PRIORITY_CLASS;
+            else if (priority == "high") options->priorityClass = HIGH_PRIORITY_CLASS;
+            else if (priority == "realtime") options->priorityClass = REALTIME_PRIORITY_CLASS;
+            else return false;
+        } else {
+            return false;
+        }
+    }
+    if (options->cores.empty()) options->cores.emplace_back(0, 0);
+    return true;
+}
+
+// Opens, configures and starts every requested core; on failure the message is published and logged
+bool StartCapture(const DaemonOptions& options, ShmPublisher& publisher) {
+    for (const auto& cardCore : options.cores) {
+        ERRVAL result = ERR_NONE;
+        std::string message;
+        DeviceSession* session = Sessions().Open(cardCore.first, cardCore.second, &result, &message);
+        int errorCode = result;
+        bool ok = session && session->ConfigureReceivers(&message, &errorCode) && session->StartMonitoring(&message);
+        if (!ok) {
+            message = "Card " + std::to_string(cardCore.first) + " core " + std::to_string(cardCore.second) + ": " + message;
+            BTI_LOG_ERROR("%s", message.c_str());
+            publisher.PublishError(ArincErrorData{-1, errorCode == ERR_NONE ? ERR_FAIL : errorCode, message,
+                cardCore.first, cardCore.second});
+            return false;
+        }
+        BTI_LOG_INFO("Capturing card %d core %d (%d channels).", cardCore.first, cardCore.second, session->ChannelCount());
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    DaemonOptions options;
+    if (!ParseArgs(argc, argv, &options)) {
+        std::fprintf(stderr, "Usage: bti_capture_daemon [--name <region>] [--core <card>:<core>]... [--priority normal|high|realtime]\n");
+        return 2;
+    }
+
+    LogStart();
+    SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+    if (!SetPriorityClass(GetCurrentProcess(), options.priorityClass)) {
+        BTI_LOG_WARN("SetPriorityClass failed (error %lu); continuing at default priority.", (unsigned long)GetLastError());
+    }
+
+    ShmPublisher publisher;
+    std::string errorMessage;
+    if (!publisher.Create(options.name, &errorMessage)) {
+        BTI_LOG_ERROR("%s", errorMessage.c_str());
+        LogShutdown();
+        return 1;
+    }
+
+    // Sinks go in before the readers start so no merged batch is lost
+    Sessions().SetSinks(PublishBatchSink, PublishErrorSink, &publisher);
+    Sessions().SetDemand(&publisher, -1, -1, 0); // The daemon captures every channel at full rate
+    bool started = StartCapture(options, publisher);
+    publisher.PublishSessions(Sessions().All());
+    int exitCode = 0;
+
+    if (started) {
+        publisher.SetState(CAPSHM_STATE_RUNNING);
+        BTI_LOG_INFO("Capture daemon running; shared memory %s.", options.name.c_str());
+        while (!g_consoleStop.load() && !publisher.StopRequested()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(STATS_PUBLISH_INTERVAL_MS));
+            publisher.PublishSessions(Sessions().All());
+            publisher.Heartbeat();
+        }
+        BTI_LOG_INFO("Capture daemon stopping (%s).", g_consoleStop.load() ? "console signal" : "client request");
+    } else {
+        exitCode = 1;
+    }
+
+    // Stops the readers and the merge thread; the merger's final flush still publishes through the sinks
+    std::string closeMessage;
+    std::vector<DeviceSession*> sessions = Sessions().All();
+    for (DeviceSession* session : sessions) session->StopMonitoring();
+    Sessions().StopMerger();
+    publisher.PublishSessions(sessions);
+    Sessions().SetSinks(nullptr, nullptr, nullptr);
+    if (Sessions().CloseAll(&closeMessage) != ERR_NONE) {
+        BTI_LOG_WARN("%s", closeMessage.c_str());
+    }
+
+    publisher.Close(started ? CAPSHM_STATE_STOPPED : CAPSHM_STATE_FAILED);
+    LogShutdown();
+    return exitCode;
+}
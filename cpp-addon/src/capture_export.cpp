@@ -0,0 +1,200 @@
+#include "capture_export.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace {
+struct ColumnSpec {
+    const char* name;
+    ColumnarType type;
+    uint32_t width;
+};
+
+// Same order as ColumnarColumn
+const ColumnSpec COLUMN_SPECS[COLUMNAR_COLUMN_COUNT] = {
+    {"timestamp_ns", COLUMNAR_I64, 8},
+    {"timestamp_ms", COLUMNAR_F64, 8},
+    {"card", COLUMNAR_U8, 1},
+    {"core", COLUMNAR_U8, 1},
+    {"channel", COLUMNAR_U8, 1},
+    {"label", COLUMNAR_U8, 1},
+    {"sdi", COLUMNAR_U8, 1},
+    {"ssm", COLUMNAR_U8, 1},
+    {"flags", COLUMNAR_U8, 1},
+    {"word", COLUMNAR_U32, 4},
+    {"value", COLUMNAR_F64, 8},
+};
+
+inline size_t Align8(size_t bytes) { return (bytes + 7) & ~(size_t)7; }
+
+size_t RowGroupBytes(size_t rows) {
+    size_t bytes = 0;
+    for (const ColumnSpec& spec : COLUMN_SPECS) bytes += Align8(rows * spec.width);
+    return bytes;
+}
+
+// Lays out one decoded block as a row group
+void BuildRowGroup(const std::vector<ArincUpdateData>& words, const LabelDecoderTable& decoder, std::vector<uint8_t>* out) {
+    size_t rows = words.size();
+    out->assign(RowGroupBytes(rows), 0);
+    uint8_t* columns[COLUMNAR_COLUMN_COUNT];
+    size_t offset = 0;
+    for (int c = 0; c < COLUMNAR_COLUMN_COUNT; ++c) {
+        columns[c] = out->data() + offset;
+        offset += Align8(rows * COLUMN_SPECS[c].width);
+    }
+    int64_t* timestampNs = (int64_t*)columns[COLUMN_TIMESTAMP_NS];
+    double* timestampMs = (double*)columns[COLUMN_TIMESTAMP_MS];
+    uint32_t* wordColumn = (uint32_t*)columns[COLUMN_WORD];
+    double* values = (double*)columns[COLUMN_VALUE];
+    for (size_t i = 0; i < rows; ++i) {
+        const ArincUpdateData& update = words[i];
+        uint32_t word = (uint32_t)update.word;
+        bool gap = IsGapMarker(update);
+        timestampNs[i] = update.timestamp_ns;
+        timestampMs[i] = (double)update.timestamp_ms;
+        columns[COLUMN_CARD][i] = (uint8_t)update.card;
+        columns[COLUMN_CORE][i] = (uint8_t)update.core;
+        columns[COLUMN_CHANNEL][i] = (uint8_t)update.channel;
+        wordColumn[i] = word;
+        if (gap) {
+            columns[COLUMN_FLAGS][i] = COLUMNAR_FLAG_GAP;
+            values[i] = std::nan("");
+            continue;
+        }
+        columns[COLUMN_LABEL][i] = (uint8_t)update.label;
+        if (IsDioEdge(update)) {
+            columns[COLUMN_FLAGS][i] = COLUMNAR_FLAG_DIO_EDGE;
+            values[i] = std::nan("");
+            continue;
+        }
+        columns[COLUMN_SDI][i] = (uint8_t)WordSdi(word);
+        columns[COLUMN_SSM][i] = (uint8_t)WordSsm(word);
+        columns[COLUMN_FLAGS][i] = WordParityOk(word) ? 0 : COLUMNAR_FLAG_PARITY_ERROR;
+        values[i] = decoder.Decode(update.channel, word);
+    }
+}
+}
+
+bool ExportCaptureColumnar(const std::string& capturePath, const std::string& outPath, const LabelDecoderTable& decoder,
+                           int threads, const std::function<void(const ExportProgress&)>& progress,
+                           const std::atomic<bool>* cancel, ExportResult* result, std::string* errorMessage) {
+    TRACE_SCOPE("ExportCaptureColumnar");
+    auto startTime = std::chrono::steady_clock::now();
+    CaptureFileReader reader;
+    if (!reader.Open(capturePath, errorMessage)) return false;
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        *errorMessage = "Cannot create " + outPath;
+        return false;
+    }
+
+    ColumnarFileHeader header = {};
+    header.magic = COLUMNAR_MAGIC;
+    header.version = COLUMNAR_VERSION;
+    header.columnCount = COLUMNAR_COLUMN_COUNT;
+    out.write((const char*)&header, sizeof(header));
+
+    // Batches of row groups: threads decode and lay out, this thread writes them in order
+    threads = std::max(threads, 1);
+    size_t blockCount = reader.Blocks().size();
+    size_t batchSize = (size_t)threads * 2;
+    std::vector<std::vector<uint8_t>> groups(batchSize);
+    std::vector<uint64_t> groupRows(batchSize);
+    std::vector<ColumnarRowGroupDesc> index;
+    ExportProgress status;
+    status.rowsTotal = reader.TotalWords();
+    status.bytesWritten = sizeof(header);
+    bool ok = true;
+
+    for (size_t first = 0; first < blockCount && ok; first += batchSize) {
+        if (cancel && cancel->load()) {
+            *errorMessage = "Export cancelled";
+            ok = false;
+            break;
+        }
+        size_t count = std::min(batchSize, blockCount - first);
+        std::atomic<size_t> next{0};
+        std::atomic<bool> failed{false};
+        std::string workerError;
+        std::mutex errorMutex;
+        auto work = [&] {
+            std::vector<ArincUpdateData> words;
+            for (size_t i = next++; i < count && !failed.load(); i = next++) {
+                std::string error;
+                if (!reader.DecodeBlock(first + i, &words, &error)) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!failed.exchange(true)) workerError = error;
+                    return;
+                }
+                BuildRowGroup(words, decoder, &groups[i]);
+                groupRows[i] = words.size();
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < std::min<size_t>(count, (size_t)threads); ++t) workers.emplace_back(work);
+        work();
+        for (std::thread& worker : workers) worker.join();
+        if (failed.load()) {
+            *errorMessage = workerError;
+            ok = false;
+            break;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            index.push_back({status.bytesWritten, groupRows[i]});
+            out.write((const char*)groups[i].data(), groups[i].size());
+            status.bytesWritten += groups[i].size();
+            status.rowsDone += groupRows[i];
+        }
+        if (!out) {
+            *errorMessage = "Write failed on " + outPath + " (disk full?)";
+            ok = false;
+            break;
+        }
+        if (progress) progress(status);
+    }
+
+    if (ok) {
+        header.rowCount = status.rowsDone;
+        header.rowGroupCount = index.size();
+        header.footerOffset = status.bytesWritten;
+        for (const ColumnSpec& spec : COLUMN_SPECS) {
+            ColumnarColumnDesc desc = {};
+            std::strncpy(desc.name, spec.name, sizeof(desc.name) - 1);
+            desc.type = spec.type;
+            desc.width = spec.width;
+            out.write((const char*)&desc, sizeof(desc));
+        }
+        out.write((const char*)index.data(), index.size() * sizeof(ColumnarRowGroupDesc));
+        status.bytesWritten += COLUMNAR_COLUMN_COUNT * sizeof(ColumnarColumnDesc) + index.size() * sizeof(ColumnarRowGroupDesc);
+        out.seekp(0);
+        out.write((const char*)&header, sizeof(header)); // Complete: footerOffset set last
+        out.flush();
+        if (!out) {
+            *errorMessage = "Write failed on " + outPath;
+            ok = false;
+        }
+    }
+    out.close();
+    if (!ok) {
+        std::remove(outPath.c_str());
+        return false;
+    }
+
+    result->rows = status.rowsDone;
+    result->rowGroups = index.size();
+    result->bytesWritten = status.bytesWritten;
+    result->elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    BTI_LOG_INFO("Exported %llu rows from %s to %s in %lld ms.", (unsigned long long)result->rows,
+        capturePath.c_str(), outPath.c_str(), (long long)result->elapsedMs);
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef CAPTURE_EXPORT_H
+#define CAPTURE_EXPORT_H
+
+// Columnar export of capture files (capture_file.h) for offline analysis. The output ("BTICOL") is deliberately
+// plain so numpy/pandas can memory-map it without a library:
+//
+//   ColumnarFileHeader                    64 bytes
+//   row group 0 .. n-1                    one per capture block; inside a group each column is contiguous,
+//                                         in ColumnarColumn order, each starting on an 8-byte boundary
+//   ColumnarColumnDesc[columnCount]       at footerOffset
+//   ColumnarRowGroupDesc[rowGroupCount]
+//
+// Column data is little-endian. Row groups are decoded and laid out on a pool of threads; the file is written in
+// order by the calling thread, so an export runs at the slower of disk speed and (decode speed x threads).
+
+#include "capture_file.h"
+#include "label_decoder.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+const uint64_t COLUMNAR_MAGIC = 0x31304C4F43495442ull; // "BTICOL01"
+const uint32_t COLUMNAR_VERSION = 1;
+
+enum ColumnarType : uint32_t { COLUMNAR_I64 = 1, COLUMNAR_F64 = 2, COLUMNAR_U8 = 3, COLUMNAR_U32 = 4 };
+
+// Column order within every row group
+enum ColumnarColumn {
+    COLUMN_TIMESTAMP_NS,  // i64 host steady clock
+    COLUMN_TIMESTAMP_MS,  // f64 epoch ms
+    COLUMN_CARD,          // u8
+    COLUMN_CORE,          // u8
+    COLUMN_CHANNEL,       // u8
+    COLUMN_LABEL,         // u8
+    COLUMN_SDI,           // u8
+    COLUMN_SSM,           // u8
+    COLUMN_FLAGS,         // u8 COLUMNAR_FLAG_*
+    COLUMN_WORD,          // u32 raw word (gap rows: words lost)
+    COLUMN_VALUE,         // f64 decoded with the export's LabelDecoderTable (NaN for gap rows)
+    COLUMNAR_COLUMN_COUNT
+};
+
+const uint8_t COLUMNAR_FLAG_GAP = 1 << 0;          // Receive-list overflow marker, not a word
+const uint8_t COLUMNAR_FLAG_PARITY_ERROR = 1 << 1; // Word fails odd parity
+const uint8_t COLUMNAR_FLAG_DIO_EDGE = 1 << 2;     // DIO edge: label = dionum, word bit 31 = rising, low bits = hwTime
+
+#pragma pack(push, 1)
+struct ColumnarFileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rowCount;
+    uint64_t rowGroupCount;
+    uint64_t footerOffset;      // 0 while the export is being written
+    uint8_t reserved[24];
+};
+
+struct ColumnarColumnDesc {
+    char name[16];              // NUL-padded
+    uint32_t type;              // ColumnarType
+    uint32_t width;             // Bytes per value
+};
+
+struct ColumnarRowGroupDesc {
+    uint64_t offset;            // Of the group's first column
+    uint64_t rows;
+};
+#pragma pack(pop)
+
+struct ExportProgress {
+    uint64_t rowsDone = 0;
+    uint64_t rowsTotal = 0;
+    uint64_t bytesWritten = 0;
+};
+
+struct ExportResult {
+    uint64_t rows = 0;
+    uint64_t rowGroups = 0;
+    uint64_t bytesWritten = 0;
+    int64_t elapsedMs = 0;
+};
+
+// Exports capturePath to outPath. progress is called on the calling thread after each batch of row groups;
+// setting *cancel stops the export at the next batch (the partial file is removed).
+bool ExportCaptureColumnar(const std::string& capturePath, const std::string& outPath, const LabelDecoderTable& decoder,
+                           int threads, const std::function<void(const ExportProgress&)>& progress,
+                           const std::atomic<bool>* cancel, ExportResult* result, std::string* errorMessage);
+
+#endif // CAPTURE_EXPORT_H
@@ -0,0 +1,547 @@
+#include "capture_file.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+const int LZ_HASH_BITS = 14;
+const size_t LZ_MIN_MATCH = 4;
+const size_t LZ_MAX_OFFSET = 65535;
+
+inline uint32_t Read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+inline uint32_t LzHash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Length beyond what fits in a token nibble: runs of 255 and a final byte
+void PutLength(size_t length, std::vector<uint8_t>* out) {
+    for (; length >= 255; length -= 255) out->push_back(255);
+    out->push_back((uint8_t)length);
+}
+
+bool GetLength(const uint8_t* src, size_t size, size_t* ip, size_t* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= size) return false;
+        byte = src[(*ip)++];
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+void EmitSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength, std::vector<uint8_t>* out) {
+    size_t matchCode = matchLength ? matchLength - LZ_MIN_MATCH : 0;
+    out->push_back((uint8_t)((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) PutLength(literalCount - 15, out);
+    out->insert(out->end(), literals, literals + literalCount);
+    if (!matchLength) return; // Last sequence: literals only
+    out->push_back((uint8_t)(offset & 0xFF));
+    out->push_back((uint8_t)(offset >> 8));
+    if (matchCode >= 15) PutLength(matchCode - 15, out);
+}
+
+void PutVarint(uint64_t value, std::vector<uint8_t>* out) {
+    while (value >= 0x80) {
+        out->push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back((uint8_t)value);
+}
+
+bool GetVarint(const uint8_t* src, size_t size, size_t* ip, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*ip >= size) return false;
+        uint8_t byte = src[(*ip)++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+uint32_t Fnv1a(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+// DIO edges carry their own flag rather than channel 255, which does not fit beside the flags; ARINC channels stay
+// well below CAPTURE_KEY_DIO
+uint32_t KeyOf(const ArincUpdateData& update) {
+    bool gap = IsGapMarker(update);
+    uint8_t channel = IsDioEdge(update) ? CAPTURE_KEY_DIO : (uint8_t)((update.channel & 0x3F) | (gap ? CAPTURE_KEY_GAP : 0));
+    return (uint32_t)(update.card & 0xFF) | (uint32_t)(update.core & 0xFF) << 8 |
+        (uint32_t)channel << 16 | (uint32_t)(gap ? 0 : update.label & 0xFF) << 24;
+}
+
+const uint64_t VARINT_MAX_BYTES = 10;
+
+// Largest column layout EncodeCaptureBlock can produce for `count` words: both first timestamps, the key count, then
+// at most one key per word plus each word's index, two timestamp deltas and XORed word
+uint64_t MaxRawBytes(uint64_t count) {
+    return 16 + VARINT_MAX_BYTES + count * (4 + 3 * VARINT_MAX_BYTES + 4);
+}
+
+// A block header's sizes come from the file, so they are checked before any of them sizes a buffer
+bool BlockSizesValid(const CaptureBlockHeader& block, uint32_t blockWords, uint64_t payloadBytesLeft) {
+    if (block.wordCount == 0 || block.wordCount > blockWords) return false;
+    if (block.rawBytes > MaxRawBytes(block.wordCount) || block.packedBytes > payloadBytesLeft) return false;
+    return !(block.flags & CAPTURE_BLOCK_STORED) || block.packedBytes == block.rawBytes;
+}
+}
+
+// --- LZ codec ---
+
+void LzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>* out) {
+    out->clear();
+    out->reserve(size + size / 255 + 16);
+    std::vector<uint32_t> table(1u << LZ_HASH_BITS, 0); // Position + 1 of the last sequence with this hash
+    size_t anchor = 0;
+    size_t ip = 0;
+    while (ip + LZ_MIN_MATCH <= size) {
+        uint32_t sequence = Read32(src + ip);
+        uint32_t& slot = table[LzHash(sequence)];
+        size_t candidate = slot;
+        slot = (uint32_t)(ip + 1);
+        if (candidate == 0 || ip - (candidate - 1) > LZ_MAX_OFFSET || Read32(src + candidate - 1) != sequence) {
+            ++ip;
+            continue;
+        }
+        size_t ref = candidate - 1;
+        size_t length = LZ_MIN_MATCH;
+        while (ip + length < size && src[ref + length] == src[ip + length]) ++length;
+        EmitSequence(src + anchor, ip - anchor, ip - ref, length, out);
+        ip += length;
+        anchor = ip;
+    }
+    EmitSequence(src + anchor, size - anchor, 0, 0, out);
+}
+
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+    size_t ip = 0;
+    size_t op = 0;
+    while (ip < size) {
+        uint8_t token = src[ip++];
+        size_t literals = token >> 4;
+        if (literals == 15 && !GetLength(src, size, &ip, &literals)) return false;
+        if (literals > size - ip || literals > dstSize - op) return false;
+        std::memcpy(dst + op, src + ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == size) break; // Last sequence
+
+        if (size - ip < 2) return false;
+        size_t offset = src[ip] | (size_t)src[ip + 1] << 8;
+        ip += 2;
+        size_t length = token & 0x0F;
+        if (length == 15 && !GetLength(src, size, &ip, &length)) return false;
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > op || length > dstSize - op) return false;
+        for (size_t i = 0; i < length; ++i, ++op) dst[op] = dst[op - offset]; // May overlap
+    }
+    return op == dstSize;
+}
+
+// --- Block columns ---
+
+void EncodeCaptureBlock(const ArincUpdateData* words, size_t count, std::vector<uint8_t>* raw) {
+    raw->clear();
+    if (count == 0) return;
+    std::unordered_map<uint32_t, uint32_t> keyIndex;
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> indices(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t key = KeyOf(words[i]);
+        auto it = keyIndex.find(key);
+        if (it == keyIndex.end()) {
+            it = keyIndex.emplace(key, (uint32_t)keys.size()).first;
+            keys.push_back(key);
+        }
+        indices[i] = it->second;
+    }
+
+    int64_t firstNs = words[0].timestamp_ns;
+    int64_t firstMs = words[0].timestamp_ms;
+    raw->insert(raw->end(), (const uint8_t*)&firstNs, (const uint8_t*)&firstNs + 8);
+    raw->insert(raw->end(), (const uint8_t*)&firstMs, (const uint8_t*)&firstMs + 8);
+    PutVarint(keys.size(), raw);
+    for (uint32_t key : keys) raw->insert(raw->end(), (const uint8_t*)&key, (const uint8_t*)&key + 4);
+    for (uint32_t index : indices) PutVarint(index, raw);
+    int64_t previousNs = firstNs, previousMs = firstMs;
+    for (size_t i = 0; i < count; ++i) {
+        PutVarint(ZigZag(words[i].timestamp_ns - previousNs), raw);
+        previousNs = words[i].timestamp_ns;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        PutVarint(ZigZag(words[i].timestamp_ms - previousMs), raw);
+        previousMs = words[i].timestamp_ms;
+    }
+
+    // Word column grouped by key: start offsets from the per-key counts, then XOR with the key's previous word
+    std::vector<uint32_t> starts(keys.size() + 1, 0);
+    for (uint32_t index : indices) ++starts[index + 1];
+    for (size_t k = 1; k < starts.size(); ++k) starts[k] += starts[k - 1];
+    std::vector<uint32_t> previous(keys.size(), 0);
+    size_t base = raw->size();
+    raw->resize(base + count * 4);
+    uint8_t* column = raw->data() + base;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t index = indices[i];
+        uint32_t word = (uint32_t)words[i].word;
+        uint32_t delta = word ^ previous[index];
+        previous[index] = word;
+        std::memcpy(column + 4 * (size_t)starts[index]++, &delta, 4);
+    }
+}
+
+bool DecodeCaptureBlock(const uint8_t* raw, size_t size, size_t count, std::vector<ArincUpdateData>* words) {
+    words->clear();
+    if (count == 0) return size == 0;
+    if (size < 16) return false;
+    int64_t firstNs, firstMs;
+    std::memcpy(&firstNs, raw, 8);
+    std::memcpy(&firstMs, raw + 8, 8);
+    size_t ip = 16;
+    uint64_t keyCount = 0;
+    if (!GetVarint(raw, size, &ip, &keyCount) || keyCount == 0 || keyCount > count || keyCount * 4 > size - ip) return false;
+    std::vector<uint32_t> keys(keyCount);
+    std::memcpy(keys.data(), raw + ip, keyCount * 4);
+    ip += keyCount * 4;
+
+    std::vector<uint32_t> indices(count);
+    std::vector<uint32_t> starts(keyCount + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t index;
+        if (!GetVarint(raw, size, &ip, &index) || index >= keyCount) return false;
+        indices[i] = (uint32_t)index;
+        ++starts[index + 1];
+    }
+    for (size_t k = 1; k < starts.size(); ++k) starts[k] += starts[k - 1];
+
+    words->resize(count);
+    int64_t timestamp = firstNs;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        if (!GetVarint(raw, size, &ip, &delta)) return false;
+        timestamp += UnZigZag(delta);
+        (*words)[i].timestamp_ns = timestamp;
+    }
+    timestamp = firstMs;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        if (!GetVarint(raw, size, &ip, &delta)) return false;
+        timestamp += UnZigZag(delta);
+        (*words)[i].timestamp_ms = timestamp;
+    }
+
+    if (size - ip != count * 4) return false;
+    const uint8_t* column = raw + ip;
+    std::vector<uint32_t> previous(keyCount, 0);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t index = indices[i];
+        uint32_t delta;
+        std::memcpy(&delta, column + 4 * (size_t)starts[index]++, 4);
+        previous[index] ^= delta;
+
+        uint32_t key = keys[index];
+        uint8_t channel = (uint8_t)(key >> 16);
+        ArincUpdateData& update = (*words)[i];
+        update.card = key & 0xFF;
+        update.core = (key >> 8) & 0xFF;
+        update.channel = (channel & CAPTURE_KEY_DIO) ? DIO_CAPTURE_CHANNEL : channel & ~CAPTURE_KEY_GAP;
+        update.label = (channel & CAPTURE_KEY_GAP) ? ARINC_GAP_LABEL : (int)(key >> 24);
+        update.word = previous[index];
+    }
+    return true;
+}
+
+CaptureRecord ToCaptureRecord(const ArincUpdateData& update) {
+    bool gap = IsGapMarker(update);
+    return CaptureRecord{update.timestamp_ns, (double)update.timestamp_ms, (uint32_t)update.word,
+        (uint8_t)((update.card & 0x7F) | (gap ? CAPTURE_RECORD_GAP : 0)), (uint8_t)update.core,
+        (uint8_t)update.channel, (uint8_t)(gap ? 0 : update.label)};
+}
+
+// --- CaptureFileWriter ---
+
+bool CaptureFileWriter::Open(const std::string& path, uint32_t blockWords, std::string* errorMessage) {
+    blockWords_ = std::max(1u, std::min(blockWords, CAPTURE_MAX_BLOCK_WORDS));
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        *errorMessage = "Cannot create " + path;
+        return false;
+    }
+    CaptureFileHeader header = {};
+    header.magic = CAPTURE_FILE_MAGIC;
+    header.version = CAPTURE_FILE_VERSION;
+    header.headerSize = sizeof(CaptureFileHeader);
+    header.blockWords = blockWords_;
+    header.createdMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    out_.write((const char*)&header, sizeof(header));
+    if (!out_) {
+        *errorMessage = "Cannot write " + path;
+        return false;
+    }
+    fileBytes_.store(sizeof(header), std::memory_order_relaxed);
+    pending_.reserve(blockWords_);
+    return true;
+}
+
+bool CaptureFileWriter::Append(const std::vector<ArincUpdateData>& batch) {
+    if (failed_) {
+        wordsDropped_.fetch_add(batch.size(), std::memory_order_relaxed);
+        return false;
+    }
+    for (const ArincUpdateData& update : batch) {
+        pending_.push_back(update);
+        if (pending_.size() >= blockWords_ && !FlushBlock()) {
+            wordsDropped_.fetch_add(batch.size() - (&update - batch.data()) - 1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CaptureFileWriter::FlushBlock() {
+    if (pending_.empty()) return true;
+    TRACE_SCOPE_ARG("CaptureBlock", "words", pending_.size());
+    EncodeCaptureBlock(pending_.data(), pending_.size(), &raw_);
+    LzCompress(raw_.data(), raw_.size(), &packed_);
+
+    CaptureBlockHeader header = {};
+    header.magic = CAPTURE_BLOCK_MAGIC;
+    header.wordCount = (uint32_t)pending_.size();
+    header.rawBytes = (uint32_t)raw_.size();
+    header.checksum = Fnv1a(raw_.data(), raw_.size());
+    header.firstNs = pending_.front().timestamp_ns;
+    header.lastNs = pending_.back().timestamp_ns;
+    const std::vector<uint8_t>& payload = packed_.size() < raw_.size() ? packed_ : raw_;
+    if (&payload == &raw_) header.flags |= CAPTURE_BLOCK_STORED;
+    header.packedBytes = (uint32_t)payload.size();
+
+    out_.write((const char*)&header, sizeof(header));
+    out_.write((const char*)payload.data(), payload.size());
+    if (!out_) {
+        failed_ = true;
+        wordsDropped_.fetch_add(pending_.size(), std::memory_order_relaxed);
+        pending_.clear();
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        error_ = "Capture file write failed (disk full?)";
+        BTI_LOG_ERROR("%s", error_.c_str());
+        return false;
+    }
+    words_.fetch_add(pending_.size(), std::memory_order_relaxed);
+    blocks_.fetch_add(1, std::memory_order_relaxed);
+    fileBytes_.fetch_add(sizeof(header) + payload.size(), std::memory_order_relaxed);
+    pending_.clear();
+    return true;
+}
+
+bool CaptureFileWriter::Close() {
+    bool ok = FlushBlock();
+    out_.flush();
+    ok = ok && !failed_ && out_.good();
+    out_.close();
+    return ok;
+}
+
+std::string CaptureFileWriter::Error() {
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    return error_;
+}
+
+// --- CaptureFileReader ---
+
+bool CaptureFileReader::Open(const std::string& path, std::string* errorMessage) {
+    in_.open(path, std::ios::binary);
+    if (!in_) {
+        *errorMessage = "Cannot open " + path;
+        return false;
+    }
+    if (!in_.read((char*)&header_, sizeof(header_)) || header_.magic != CAPTURE_FILE_MAGIC) {
+        *errorMessage = path + " is not a capture file";
+        return false;
+    }
+    if (header_.version != CAPTURE_FILE_VERSION || header_.headerSize < sizeof(CaptureFileHeader)) {
+        *errorMessage = "Unsupported capture file version " + std::to_string(header_.version);
+        return false;
+    }
+    if (header_.blockWords == 0 || header_.blockWords > CAPTURE_MAX_BLOCK_WORDS) {
+        *errorMessage = path + " has an invalid block size (" + std::to_string(header_.blockWords) + " words)";
+        return false;
+    }
+
+    // Index the blocks; a block cut short by a crash, or whose header does not add up, ends the file
+    uint64_t offset = header_.headerSize;
+    CaptureBlockHeader block;
+    in_.seekg(0, std::ios::end);
+    uint64_t fileSize = (uint64_t)in_.tellg();
+    fileSize_ = fileSize;
+    while (offset + sizeof(block) <= fileSize) {
+        in_.seekg(offset);
+        if (!in_.read((char*)&block, sizeof(block)) || block.magic != CAPTURE_BLOCK_MAGIC) break;
+        if (!BlockSizesValid(block, header_.blockWords, fileSize - offset - sizeof(block))) break;
+        blocks_.push_back({offset, block.wordCount, block.firstNs, block.lastNs});
+        totalWords_ += block.wordCount;
+        offset += sizeof(block) + block.packedBytes;
+    }
+    in_.clear();
+    if (offset < fileSize) BTI_LOG_WARN("Capture file %s: %llu trailing bytes ignored.", path.c_str(), (unsigned long long)(fileSize - offset));
+    return true;
+}
+
+bool CaptureFileReader::DecodeBlock(size_t index, std::vector<ArincUpdateData>* words, std::string* errorMessage) {
+    if (index >= blocks_.size()) {
+        *errorMessage = "Block index out of range";
+        return false;
+    }
+    CaptureBlockHeader header;
+    std::vector<uint8_t> payload;
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        uint64_t offset = blocks_[index].offset;
+        in_.seekg(offset);
+        // Checked again in case the file changed since Open indexed it
+        if (!in_.read((char*)&header, sizeof(header)) || header.magic != CAPTURE_BLOCK_MAGIC ||
+            header.wordCount != blocks_[index].wordCount ||
+            !BlockSizesValid(header, header_.blockWords, fileSize_ - offset - sizeof(header))) {
+            in_.clear();
+            *errorMessage = "Block " + std::to_string(index) + " is corrupt (header)";
+            return false;
+        }
+        payload.resize(header.packedBytes);
+        in_.read((char*)payload.data(), payload.size());
+        if (!in_) {
+            in_.clear();
+            *errorMessage = "Read failed at block " + std::to_string(index);
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> raw;
+    if (header.flags & CAPTURE_BLOCK_STORED) {
+        raw.swap(payload);
+    } else {
+        raw.resize(header.rawBytes);
+        if (!LzDecompress(payload.data(), payload.size(), raw.data(), raw.size())) {
+            *errorMessage = "Block " + std::to_string(index) + " is corrupt (decompression)";
+            return false;
+        }
+    }
+    if (raw.size() != header.rawBytes || Fnv1a(raw.data(), raw.size()) != header.checksum ||
+        !DecodeCaptureBlock(raw.data(), raw.size(), header.wordCount, words)) {
+        *errorMessage = "Block " + std::to_string(index) + " is corrupt";
+        return false;
+    }
+    return true;
+}
+
+bool CaptureFileReader::DecodeBlocks(size_t first, size_t count, int threads,
+                                     std::vector<std::vector<ArincUpdateData>>* out, std::string* errorMessage) {
+    if (first > blocks_.size() || count > blocks_.size() - first) {
+        *errorMessage = "Block range out of range";
+        return false;
+    }
+    out->assign(count, std::vector<ArincUpdateData>());
+    int workerCount = (int)std::min<size_t>(count, (size_t)std::max(threads, 1));
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    auto work = [&] {
+        for (size_t i = next++; i < count && !failed.load(); i = next++) {
+            std::string error;
+            if (!DecodeBlock(first + i, &(*out)[i], &error)) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed.exchange(true)) *errorMessage = error;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < workerCount; ++t) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+    return !failed.load();
+}
+
+// --- CaptureRecorder ---
+
+CaptureRecorder& Recorder() {
+    static CaptureRecorder* recorder = new CaptureRecorder(); // Leaked: bus delivery threads may outlive static destruction
+    return *recorder;
+}
+
+void CaptureRecorder::Deliver(void* context, std::vector<ArincUpdateData>* batch) {
+    static_cast<CaptureFileWriter*>(context)->Append(*batch);
+    delete batch;
+}
+
+bool CaptureRecorder::Start(const std::string& path, const SubscriberConfig& filter, uint32_t blockWords, std::string* errorMessage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (subscription_) {
+        *errorMessage = "Already recording to " + path_;
+        return false;
+    }
+    std::unique_ptr<CaptureFileWriter> writer(new CaptureFileWriter());
+    if (!writer->Open(path, blockWords, errorMessage)) return false;
+    writer_ = std::move(writer);
+    path_ = path;
+    SubscriberConfig config = filter;
+    config.name = "capture:" + path;
+    config.policy = DeliveryPolicy::EveryWord;
+    config.drainOnStop = true; // The tail of the recording is written before the file closes
+    subscription_ = Bus().Subscribe(config, &CaptureRecorder::Deliver, &CaptureRecorder::Cancel, writer_.get());
+    BTI_LOG_INFO("Recording capture to %s (%u words per block).", path.c_str(), blockWords);
+    return true;
+}
+
+bool CaptureRecorder::Stop(CaptureRecordingStats* stats) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!subscription_) return false;
+    SubscriberStats subscriber;
+    Bus().Unsubscribe(subscription_, &subscriber); // Delivers the queue's tail, then joins: no Append runs after this
+    uint64_t shed = subscriber.wordsDropped;
+    subscription_ = 0;
+    bool ok = writer_->Close();
+    stats->active = false;
+    stats->path = path_;
+    stats->words = writer_->Words();
+    stats->blocks = writer_->Blocks();
+    stats->fileBytes = writer_->FileBytes();
+    stats->wordsDropped = writer_->WordsDropped() + shed;
+    stats->error = writer_->Error();
+    BTI_LOG_INFO("Capture %s closed: %llu words in %llu bytes.", path_.c_str(),
+        (unsigned long long)stats->words, (unsigned long long)stats->fileBytes);
+    writer_.reset();
+    return ok;
+}
+
+CaptureRecordingStats CaptureRecorder::Stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CaptureRecordingStats stats;
+    if (!subscription_) return stats;
+    stats.active = true;
+    stats.path = path_;
+    stats.words = writer_->Words();
+    stats.blocks = writer_->Blocks();
+    stats.fileBytes = writer_->FileBytes();
+    stats.wordsDropped = writer_->WordsDropped();
+    for (const SubscriberStats& subscriber : Bus().Stats()) {
+        if (subscriber.id == subscription_) stats.wordsDropped += subscriber.wordsDropped;
+    }
+    stats.error = writer_->Error();
+    return stats;
+}
@@ -0,0 +1,174 @@
+#ifndef CAPTURE_FILE_H
+#define CAPTURE_FILE_H
+
+// Block-compressed capture files for long recordings. A file is a CaptureFileHeader followed by independent blocks
+// (CaptureBlockHeader + payload), each holding up to blockWords words in arrival order, laid out by column before
+// compression:
+//
+//   i64 firstNs, i64 firstMs                    Timestamps of the block's first word
+//   varint keyCount, u8[4] key * keyCount       card, core, channel (| CAPTURE_KEY_*), label
+//   varint keyIndex * n                         Which key each word belongs to
+//   varint zigzag(ns - previous ns) * n
+//   varint zigzag(ms - previous ms) * n
+//   u32 word ^ previous word of the same key    Grouped by key, so repeated values become runs of zeros
+//
+// and then packed with an in-tree LZ77 codec (LZ4-style tokens). Blocks decode on their own, so the reader decodes
+// them in parallel. The encoder runs on a subscriber bus delivery thread; nothing here depends on N-API.
+
+#include "device_session.h"
+#include "subscriber_bus.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+const uint32_t CAPTURE_FILE_MAGIC = 0x5A495442u;  // "BTIZ"
+const uint32_t CAPTURE_BLOCK_MAGIC = 0x4B4C4254u; // "TBLK"
+const uint16_t CAPTURE_FILE_VERSION = 1;
+const uint32_t CAPTURE_DEFAULT_BLOCK_WORDS = 65536;
+const uint32_t CAPTURE_MAX_BLOCK_WORDS = 1u << 20;
+const uint8_t CAPTURE_KEY_GAP = 0x80;            // Key channel flag: gap marker, word = words lost
+const uint8_t CAPTURE_KEY_DIO = 0x40;            // Key channel flag: DIO edge, channel DIO_CAPTURE_CHANNEL
+const uint8_t CAPTURE_RECORD_GAP = 0x80;         // CaptureRecord.card flag, as CAPSHM_WORD_GAP
+
+const uint32_t CAPTURE_BLOCK_STORED = 1u << 0;    // Payload is the raw columns (LZ did not shrink them)
+
+#pragma pack(push, 1)
+struct CaptureFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t blockWords;
+    uint32_t reserved;
+    int64_t createdMs;          // Epoch ms
+    uint64_t reserved2;
+};
+
+struct CaptureBlockHeader {
+    uint32_t magic;
+    uint32_t wordCount;
+    uint32_t rawBytes;          // Column bytes before compression
+    uint32_t packedBytes;       // Payload bytes that follow
+    uint32_t checksum;          // FNV-1a of the raw columns
+    uint32_t flags;             // CAPTURE_BLOCK_*
+    int64_t firstNs;
+    int64_t lastNs;
+};
+
+// One decoded word as handed to JS (little-endian, 24 bytes)
+struct CaptureRecord {
+    int64_t timestampNs;        // Host steady clock
+    double timestampMs;         // Epoch ms
+    uint32_t word;              // Gap markers: words lost
+    uint8_t card;               // | CAPTURE_RECORD_GAP for gap markers
+    uint8_t core;
+    uint8_t channel;
+    uint8_t label;
+};
+#pragma pack(pop)
+
+// LZ77 with 64 KB window; Decompress validates every length and offset against both buffers
+void LzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>* out);
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize);
+
+// Column layout of one block (before compression) and its inverse
+void EncodeCaptureBlock(const ArincUpdateData* words, size_t count, std::vector<uint8_t>* raw);
+bool DecodeCaptureBlock(const uint8_t* raw, size_t size, size_t count, std::vector<ArincUpdateData>* words);
+
+CaptureRecord ToCaptureRecord(const ArincUpdateData& update);
+
+// Streaming encoder; Append is called from one thread at a time
+class CaptureFileWriter {
+public:
+    bool Open(const std::string& path, uint32_t blockWords, std::string* errorMessage);
+    // False once a write has failed (see Error()); later words are counted as dropped
+    bool Append(const std::vector<ArincUpdateData>& batch);
+    bool Close();  // Writes the last partial block
+
+    uint64_t Words() const { return words_.load(std::memory_order_relaxed); }
+    uint64_t Blocks() const { return blocks_.load(std::memory_order_relaxed); }
+    uint64_t FileBytes() const { return fileBytes_.load(std::memory_order_relaxed); }
+    uint64_t WordsDropped() const { return wordsDropped_.load(std::memory_order_relaxed); }
+    std::string Error();
+
+private:
+    bool FlushBlock();
+
+    std::ofstream out_;
+    uint32_t blockWords_ = CAPTURE_DEFAULT_BLOCK_WORDS;
+    std::vector<ArincUpdateData> pending_;
+    std::vector<uint8_t> raw_;
+    std::vector<uint8_t> packed_;
+    std::atomic<uint64_t> words_{0};
+    std::atomic<uint64_t> blocks_{0};
+    std::atomic<uint64_t> fileBytes_{0};
+    std::atomic<uint64_t> wordsDropped_{0};
+    std::mutex errorMutex_;
+    std::string error_;
+    bool failed_ = false;
+};
+
+struct CaptureBlockInfo {
+    uint64_t offset;            // Of the block header
+    uint32_t wordCount;
+    int64_t firstNs;
+    int64_t lastNs;
+};
+
+// Random access to a capture file's blocks; DecodeBlocks may be called from several threads
+class CaptureFileReader {
+public:
+    bool Open(const std::string& path, std::string* errorMessage);
+    const std::vector<CaptureBlockInfo>& Blocks() const { return blocks_; }
+    uint64_t TotalWords() const { return totalWords_; }
+    uint32_t BlockWords() const { return header_.blockWords; }
+
+    bool DecodeBlock(size_t index, std::vector<ArincUpdateData>* words, std::string* errorMessage);
+    // Decodes blocks [first, first + count) on up to `threads` threads; out[i] holds block first + i
+    bool DecodeBlocks(size_t first, size_t count, int threads,
+                      std::vector<std::vector<ArincUpdateData>>* out, std::string* errorMessage);
+
+private:
+    std::mutex fileMutex_; // Guards the stream position
+    std::ifstream in_;
+    CaptureFileHeader header_ = {};
+    std::vector<CaptureBlockInfo> blocks_;
+    uint64_t totalWords_ = 0;
+    uint64_t fileSize_ = 0;  // At Open; bounds every block's payload
+};
+
+struct CaptureRecordingStats {
+    bool active = false;
+    std::string path;
+    uint64_t words = 0;
+    uint64_t blocks = 0;
+    uint64_t fileBytes = 0;
+    uint64_t wordsDropped = 0;  // Write failures plus words shed by the bus queue
+    std::string error;
+};
+
+// Records the ingest stream (local sessions or the capture daemon) to a capture file through a bus subscription
+class CaptureRecorder {
+public:
+    bool Start(const std::string& path, const SubscriberConfig& filter, uint32_t blockWords, std::string* errorMessage);
+    // Unsubscribes, writes the last block and closes the file
+    bool Stop(CaptureRecordingStats* stats);
+    CaptureRecordingStats Stats();
+
+private:
+    static void Deliver(void* context, std::vector<ArincUpdateData>* batch);
+    static void Cancel(void*) {} // Deliver never blocks on anything but the disk
+
+    std::mutex mutex_; // Guards start/stop
+    std::unique_ptr<CaptureFileWriter> writer_;
+    std::string path_;
+    int subscription_ = 0;
+};
+
+CaptureRecorder& Recorder();
+
+#endif // CAPTURE_FILE_H
@@ -0,0 +1,140 @@
+#ifndef CAPTURE_SHM_H
+#define CAPTURE_SHM_H
+
+/*
+ * Shared-memory layout published by the capture daemon (bti_capture_daemon) and mapped by its clients.
+ * Plain C so other local tools can map it too. One region, laid out as:
+ *
+ *   CapShmHeader                       fixed 256 bytes
+ *   CapShmSession[CAPSHM_MAX_SESSIONS] per-core stats, one seqlock per block
+ *   CapShmValue[sessions][channels][labels]  current value per label, one seqlock per entry
+ *   CapShmWord[CAPSHM_RING_CAPACITY]   word ring, single producer, any number of readers
+ *
+ * There is a single writer (the daemon's merge thread for the ring and values, its main thread for the
+ * header and session blocks). Readers never write, except CapShmHeader.stopRequest.
+ * Ordering relies on x86/x64 store and load ordering; CAPSHM_BARRIER() only stops compiler reordering.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CAPSHM_BARRIER() _ReadWriteBarrier()
+#else
+#define CAPSHM_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+#define CAPSHM_MAGIC          0x43495442u /* "BTIC" */
+#define CAPSHM_VERSION        2u
+#define CAPSHM_DEFAULT_NAME   "Local\\BtiArincCapture"
+#define CAPSHM_MAX_SESSIONS   8
+#define CAPSHM_MAX_CHANNELS   16
+#define CAPSHM_LABELS         256
+#define CAPSHM_RING_CAPACITY  65536u      /* Words; power of two */
+#define CAPSHM_ERROR_TEXT     128
+
+/* CapShmHeader.state */
+#define CAPSHM_STATE_STARTING 0u
+#define CAPSHM_STATE_RUNNING  1u
+#define CAPSHM_STATE_STOPPED  2u
+#define CAPSHM_STATE_FAILED   3u
+
+/* CapShmWord.card flag: the entry is a gap marker, word = receive-list words lost on the channel */
+#define CAPSHM_WORD_GAP       0x80u
+
+/* One received word. seq is written last: it equals the ring index + 1 once the slot is complete. */
+typedef struct CapShmWord {
+    volatile uint64_t seq;
+    int64_t timestampNs;        /* Host steady clock */
+    int64_t timestampMs;        /* Epoch ms */
+    uint32_t word;
+    uint8_t channel;
+    uint8_t label;
+    uint8_t card;
+    uint8_t core;
+} CapShmWord;
+
+/* Latest word of one channel/label. seq is odd while the writer is updating the entry. */
+typedef struct CapShmValue {
+    volatile uint32_t seq;
+    uint32_t word;
+    int64_t timestampMs;
+    int64_t timestampNs;
+    uint32_t count;             /* Words received for this label (wraps) */
+    uint32_t reserved;
+} CapShmValue;
+
+/* Per-core stats snapshot, republished about every 100 ms. seq is odd while being updated. */
+typedef struct CapShmSession {
+    volatile uint32_t seq;
+    int32_t card;
+    int32_t core;
+    uint32_t monitoring;
+    uint32_t channelCount;      /* Discovered channels */
+    uint32_t rcvMask;           /* Bit per channel: receive capable */
+    uint32_t xmtMask;           /* Bit per channel: transmit capable */
+    uint32_t reserved;
+    uint64_t cycles;
+    uint64_t lastCycleUs;
+    uint64_t maxCycleUs;
+    uint64_t eventLogEntries;
+    uint64_t wordsRead[CAPSHM_MAX_CHANNELS];
+    uint64_t listFullCount[CAPSHM_MAX_CHANNELS];
+    uint64_t errEvents[CAPSHM_MAX_CHANNELS];
+} CapShmSession;
+
+typedef struct CapShmHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t totalSize;
+    uint32_t ringCapacity;
+    uint32_t maxSessions;
+    uint32_t maxChannels;
+    uint32_t labels;
+    uint32_t daemonPid;
+    volatile uint32_t state;          /* CAPSHM_STATE_* */
+    volatile uint32_t stopRequest;    /* Set non-zero by a client to ask the daemon to exit */
+    volatile uint32_t sessionCount;
+    volatile int64_t heartbeatMs;     /* Epoch ms, refreshed about every 100 ms while the daemon runs */
+    volatile uint64_t writeIndex;     /* Words published to the ring so far */
+    volatile uint64_t errorCount;     /* Errors published so far; the last one is below */
+    volatile uint32_t errorSeq;       /* Seqlock over the error fields */
+    int32_t errorCode;
+    int32_t errorChannel;             /* -1 for core-wide errors */
+    int32_t errorCard;
+    int32_t errorCore;
+    uint32_t reserved0;
+    char errorText[CAPSHM_ERROR_TEXT];
+    uint8_t reserved[32];
+} CapShmHeader;
+
+#define CAPSHM_HEADER_SIZE     256u
+#define CAPSHM_SESSIONS_OFFSET CAPSHM_HEADER_SIZE
+#define CAPSHM_VALUES_OFFSET   (CAPSHM_SESSIONS_OFFSET + CAPSHM_MAX_SESSIONS * sizeof(CapShmSession))
+#define CAPSHM_RING_OFFSET     (CAPSHM_VALUES_OFFSET + (size_t)CAPSHM_MAX_SESSIONS * CAPSHM_MAX_CHANNELS * CAPSHM_LABELS * sizeof(CapShmValue))
+#define CAPSHM_TOTAL_SIZE      (CAPSHM_RING_OFFSET + (size_t)CAPSHM_RING_CAPACITY * sizeof(CapShmWord))
+
+static inline CapShmSession* CapShmSessionAt(CapShmHeader* h, int session) {
+    return (CapShmSession*)((char*)h + CAPSHM_SESSIONS_OFFSET) + session;
+}
+
+static inline CapShmValue* CapShmValueAt(CapShmHeader* h, int session, int channel, int label) {
+    return (CapShmValue*)((char*)h + CAPSHM_VALUES_OFFSET) +
+        ((size_t)session * CAPSHM_MAX_CHANNELS + (size_t)channel) * CAPSHM_LABELS + (size_t)label;
+}
+
+static inline CapShmWord* CapShmRingSlot(CapShmHeader* h, uint64_t index) {
+    return (CapShmWord*)((char*)h + CAPSHM_RING_OFFSET) + (index & (CAPSHM_RING_CAPACITY - 1));
+}
+
+#ifdef __cplusplus
+static_assert(sizeof(CapShmHeader) == CAPSHM_HEADER_SIZE, "CapShmHeader must stay 256 bytes");
+static_assert(sizeof(CapShmWord) == 32, "CapShmWord layout changed");
+static_assert(sizeof(CapShmValue) == 32, "CapShmValue layout changed");
+static_assert((CAPSHM_RING_CAPACITY & (CAPSHM_RING_CAPACITY - 1)) == 0, "CAPSHM_RING_CAPACITY must be a power of two");
+static_assert(CAPSHM_VALUES_OFFSET % 64 == 0 && CAPSHM_RING_OFFSET % 64 == 0, "Sections must stay cache-line aligned");
+#endif
+
+#endif /* CAPTURE_SHM_H */
@@ -0,0 +1,159 @@
+#ifndef CAPTURE_SHM_READER_H
+#define CAPTURE_SHM_READER_H
+
+/*
+ * Header-only C reader for the capture shared-memory regions (layout in capture_shm.h): the addon's
+ * current-value table ("Local\\BtiArincValues", see startValuePublisher) and the capture daemon's region.
+ * Readers never block or signal the writer; each call retries its seqlock a bounded number of times.
+ *
+ *   CapShmReader reader;
+ *   if (CapShmReaderOpen(&reader, "Local\\BtiArincValues") == CAPSHM_READ_OK) {
+ *       int session = CapShmFindSession(&reader, 0, 0);
+ *       CapShmValue value;
+ *       if (session >= 0 && CapShmReadValue(&reader, session, 1, 0310, &value) == CAPSHM_READ_OK) { ... }
+ *       CapShmReaderClose(&reader);
+ *   }
+ *
+ * On non-Windows hosts names map to POSIX shm the same way the writer does it ("Local\Name" -> "/Local_Name");
+ * link with -lrt where shm_open needs it.
+ */
+
+#include "capture_shm.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CAPSHM_READ_OK          0
+#define CAPSHM_READ_NOT_FOUND  -1   /* Region does not exist (publisher not running) */
+#define CAPSHM_READ_INCOMPATIBLE -2 /* Wrong magic, version or size */
+#define CAPSHM_READ_EMPTY      -3   /* Valid slot, but nothing published there yet */
+#define CAPSHM_READ_BUSY       -4   /* Writer held the seqlock through every retry */
+#define CAPSHM_READ_PARAM      -5
+
+#define CAPSHM_READ_RETRIES    100
+
+typedef struct CapShmReader {
+    CapShmHeader* header;
+    size_t size;
+#ifdef _WIN32
+    HANDLE mapping;
+#endif
+} CapShmReader;
+
+static inline int CapShmReaderOpen(CapShmReader* reader, const char* name) {
+    memset(reader, 0, sizeof(*reader));
+#ifdef _WIN32
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, name);
+    if (mapping == NULL) return CAPSHM_READ_NOT_FOUND;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return CAPSHM_READ_NOT_FOUND;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    reader->mapping = mapping;
+    reader->size = VirtualQuery(view, &info, sizeof(info)) ? info.RegionSize : 0;
+#else
+    char posixName[256];
+    size_t i = 0;
+    posixName[i++] = '/';
+    for (; *name && i < sizeof(posixName) - 1; ++name) posixName[i++] = (*name == '\\' || *name == '/') ? '_' : *name;
+    posixName[i] = '\0';
+    int fd = shm_open(posixName, O_RDWR, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        return CAPSHM_READ_NOT_FOUND;
+    }
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return CAPSHM_READ_NOT_FOUND;
+    reader->size = (size_t)st.st_size;
+#endif
+    reader->header = (CapShmHeader*)view;
+    if (reader->header->magic != CAPSHM_MAGIC || reader->header->version != CAPSHM_VERSION ||
+        (reader->size != 0 && reader->size < reader->header->totalSize)) {
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+        CloseHandle(reader->mapping);
+#else
+        munmap(view, reader->size);
+#endif
+        memset(reader, 0, sizeof(*reader));
+        return CAPSHM_READ_INCOMPATIBLE;
+    }
+    return CAPSHM_READ_OK;
+}
+
+static inline void CapShmReaderClose(CapShmReader* reader) {
+    if (reader->header == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile(reader->header);
+    CloseHandle(reader->mapping);
+#else
+    munmap(reader->header, reader->size);
+#endif
+    memset(reader, 0, sizeof(*reader));
+}
+
+/* Copies one seqlocked block (first member is the 32-bit seq) into dst */
+static inline int CapShmReadBlock(const volatile uint32_t* seq, const void* src, void* dst, size_t size) {
+    int attempt;
+    for (attempt = 0; attempt < CAPSHM_READ_RETRIES; ++attempt) {
+        uint32_t before = *seq;
+        if (before & 1u) continue;
+        CAPSHM_BARRIER();
+        memcpy(dst, src, size);
+        CAPSHM_BARRIER();
+        if (*seq == before) return CAPSHM_READ_OK;
+    }
+    return CAPSHM_READ_BUSY;
+}
+
+static inline int CapShmReadSession(const CapShmReader* reader, int session, CapShmSession* out) {
+    if (reader->header == NULL || session < 0 || session >= CAPSHM_MAX_SESSIONS) return CAPSHM_READ_PARAM;
+    const CapShmSession* block = CapShmSessionAt(reader->header, session);
+    int result = CapShmReadBlock(&block->seq, (const void*)block, out, sizeof(*out));
+    if (result == CAPSHM_READ_OK && out->seq == 0) return CAPSHM_READ_EMPTY;
+    return result;
+}
+
+/* Session slot that carries card/core, or -1 */
+static inline int CapShmFindSession(const CapShmReader* reader, int card, int core) {
+    CapShmSession block;
+    int session;
+    if (reader->header == NULL) return -1;
+    for (session = 0; session < (int)reader->header->sessionCount && session < CAPSHM_MAX_SESSIONS; ++session) {
+        if (CapShmReadSession(reader, session, &block) == CAPSHM_READ_OK && block.card == card && block.core == core) {
+            return session;
+        }
+    }
+    return -1;
+}
+
+/* Latest word of channel/label; CAPSHM_READ_EMPTY until the first word for it arrives */
+static inline int CapShmReadValue(const CapShmReader* reader, int session, int channel, int label, CapShmValue* out) {
+    if (reader->header == NULL || session < 0 || session >= CAPSHM_MAX_SESSIONS ||
+        channel < 0 || channel >= CAPSHM_MAX_CHANNELS || label < 0 || label >= CAPSHM_LABELS) {
+        return CAPSHM_READ_PARAM;
+    }
+    const CapShmValue* value = CapShmValueAt(reader->header, session, channel, label);
+    int result = CapShmReadBlock(&value->seq, (const void*)value, out, sizeof(*out));
+    if (result == CAPSHM_READ_OK && out->seq == 0) return CAPSHM_READ_EMPTY;
+    return result;
+}
+
+/* Milliseconds since the publisher's last heartbeat; compare against the caller's epoch-ms clock */
+static inline int64_t CapShmHeartbeatAgeMs(const CapShmReader* reader, int64_t nowEpochMs) {
+    return reader->header ? nowEpochMs - reader->header->heartbeatMs : -1;
+}
+
+#endif /* CAPTURE_SHM_READER_H */
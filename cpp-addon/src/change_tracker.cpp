@@ -0,0 +1,100 @@
+#include "change_tracker.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+static_assert(sizeof(ChangeRecord) == 24, "ChangeRecord is a wire format; keep it 24 bytes");
+
+ChangeTracker& Changes() {
+    static ChangeTracker* tracker = new ChangeTracker(); // Leaked, like the session registry it taps
+    return *tracker;
+}
+
+void ChangeTracker::Enable() {
+    std::call_once(enableOnce_, [this] {
+        Sessions().AddBatchTap(&ChangeTracker::Tap, this);
+        Sessions().SetDemand(this, -1, -1, 0); // A pulling UI has no stream callbacks to demand channels for it
+        enabled_.store(true);
+        BTI_LOG_INFO("Change tracking enabled.");
+    });
+}
+
+void ChangeTracker::Tap(void* context, const std::vector<ArincUpdateData>& batch) {
+    static_cast<ChangeTracker*>(context)->Apply(batch);
+}
+
+ChangeTracker::Block* ChangeTracker::BlockFor(int card, int core) {
+    for (auto& block : blocks_) {
+        if (block->card == card && block->core == core) return block.get();
+    }
+    blocks_.push_back(std::unique_ptr<Block>(new Block()));
+    blocks_.back()->card = card;
+    blocks_.back()->core = core;
+    return blocks_.back().get();
+}
+
+void ChangeTracker::Apply(const std::vector<ArincUpdateData>& batch) {
+    if (batch.empty()) return;
+    TRACE_SCOPE_ARG("ChangeTrack", "words", batch.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t generation = version_.load(std::memory_order_relaxed) + 1;
+
+    Block* block = nullptr;
+    bool changed = false;
+    for (const ArincUpdateData& update : batch) {
+        if (update.channel < 0 || update.channel >= CHANGE_MAX_CHANNELS || IsGapMarker(update) || IsDioEdge(update)) continue;
+        if (!block || block->card != update.card || block->core != update.core) block = BlockFor(update.card, update.core);
+        int label = update.label & 0xFF;
+        int group = label >> 6;
+        Channel& channel = block->channels[update.channel];
+        Entry& entry = channel.labels[label];
+        uint32_t word = (uint32_t)update.word;
+        bool first = entry.generation == 0;
+        entry.timestampMs = update.timestamp_ms;
+        entry.count++;
+        // A repeat refreshes the count and time but is not a change: pollers only fetch labels whose value moved
+        if (!first && word == entry.word) continue;
+        entry.generation = generation;
+        entry.word = word;
+        channel.seen[group] |= 1ull << (label & 63);
+        channel.groupGeneration[group] = generation;
+        channel.generation = generation;
+        block->generation = generation;
+        changed = true;
+    }
+    if (changed) version_.store(generation, std::memory_order_release);
+}
+
+uint64_t ChangeTracker::ChangesSince(uint64_t since, std::vector<ChangeRecord>* out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t version = version_.load(std::memory_order_relaxed);
+    if (since > version) since = 0;
+
+    for (const auto& block : blocks_) {
+        if (block->generation <= since) continue;
+        for (int ch = 0; ch < CHANGE_MAX_CHANNELS; ++ch) {
+            const Channel& channel = block->channels[ch];
+            if (channel.generation <= since) continue;
+            for (int group = 0; group < CHANGE_LABEL_GROUPS; ++group) {
+                if (channel.groupGeneration[group] <= since) continue;
+                uint64_t bits = channel.seen[group];
+                for (int bit = 0; bits != 0; ++bit, bits >>= 1) {
+                    if (!(bits & 1)) continue;
+                    int label = (group << 6) | bit;
+                    const Entry& entry = channel.labels[label];
+                    if (entry.generation <= since) continue;
+                    ChangeRecord record;
+                    record.card = (uint8_t)block->card;
+                    record.core = (uint8_t)block->core;
+                    record.channel = (uint8_t)ch;
+                    record.label = (uint8_t)label;
+                    record.word = entry.word;
+                    record.timestampMs = (double)entry.timestampMs;
+                    record.count = entry.count;
+                    record.reserved = 0;
+                    out->push_back(record);
+                }
+            }
+        }
+    }
+    return version;
+}
@@ -0,0 +1,78 @@
+#ifndef CHANGE_TRACKER_H
+#define CHANGE_TRACKER_H
+
+// Pull-mode view of the ingest stream for frame-rate-aligned UIs. A registry tap keeps the latest word of every
+// card/core/channel/label together with the generation (tracker version) in which it last changed. Each channel
+// also keeps a generation per 64-label group and a bitmap of the labels it has seen, so ChangesSince() only
+// visits groups that changed and only their present labels: the cost follows the number of changes, not the bus rate.
+
+#include "device_session.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+const int CHANGE_MAX_CHANNELS = 32;
+const int CHANGE_LABEL_GROUPS = 4; // 64 labels each
+
+// One packed record in the buffer returned by ChangesSince (little-endian, 24 bytes)
+#pragma pack(push, 1)
+struct ChangeRecord {
+    uint8_t card;
+    uint8_t core;
+    uint8_t channel;
+    uint8_t label;
+    uint32_t word;
+    double timestampMs;  // Epoch ms of the latest word
+    uint32_t count;      // Words received for this label (wraps)
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+class ChangeTracker {
+public:
+    // Installs the tap (and an all-channel polling demand) on first use
+    void Enable();
+    bool IsEnabled() const { return enabled_.load(); }
+    uint64_t Version() const { return version_.load(std::memory_order_acquire); }
+
+    // Appends every entry that changed after `since` (0 = everything) and returns the version to pass next time.
+    // A `since` from the future (e.g. from before a process restart) is treated as 0.
+    uint64_t ChangesSince(uint64_t since, std::vector<ChangeRecord>* out);
+
+private:
+    struct Entry {
+        uint64_t generation = 0;
+        uint32_t word = 0;
+        uint32_t count = 0;
+        long long timestampMs = 0;
+    };
+    struct Channel {
+        uint64_t generation = 0;
+        uint64_t groupGeneration[CHANGE_LABEL_GROUPS] = {};
+        uint64_t seen[CHANGE_LABEL_GROUPS] = {}; // Bit per label that has ever been received
+        Entry labels[256];
+    };
+    struct Block {
+        int card;
+        int core;
+        uint64_t generation = 0;
+        Channel channels[CHANGE_MAX_CHANNELS];
+    };
+
+    static void Tap(void* context, const std::vector<ArincUpdateData>& batch);
+    void Apply(const std::vector<ArincUpdateData>& batch);
+    Block* BlockFor(int card, int core); // Caller holds mutex_
+
+    std::mutex mutex_; // Guards blocks_; held by the tap for one batch and by ChangesSince for one scan
+    std::vector<std::unique_ptr<Block>> blocks_;
+    std::atomic<uint64_t> version_{0};
+    std::atomic<bool> enabled_{false};
+    std::once_flag enableOnce_;
+};
+
+ChangeTracker& Changes();
+
+#endif // CHANGE_TRACKER_H
@@ -0,0 +1,670 @@
+#include "derived_params.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+
+namespace {
+const double PI = 3.14159265358979323846;
+
+struct FunctionSpec {
+    const char* name;
+    DerivedOp op;
+    int id;
+};
+
+const FunctionSpec FUNCTIONS[] = {
+    {"abs", DerivedOp::Call1, 0}, {"sqrt", DerivedOp::Call1, 1}, {"floor", DerivedOp::Call1, 2},
+    {"ceil", DerivedOp::Call1, 3}, {"round", DerivedOp::Call1, 4}, {"sin", DerivedOp::Call1, 5},
+    {"cos", DerivedOp::Call1, 6}, {"tan", DerivedOp::Call1, 7}, {"asin", DerivedOp::Call1, 8},
+    {"acos", DerivedOp::Call1, 9}, {"atan", DerivedOp::Call1, 10}, {"deg", DerivedOp::Call1, 11},
+    {"rad", DerivedOp::Call1, 12},
+    {"min", DerivedOp::Call2, 0}, {"max", DerivedOp::Call2, 1}, {"atan2", DerivedOp::Call2, 2},
+    {"hypot", DerivedOp::Call2, 3}, {"pow", DerivedOp::Call2, 4},
+    {"clamp", DerivedOp::Call3, 0},
+};
+
+// Accessors taking an input name
+const FunctionSpec ACCESSORS[] = {
+    {"raw", DerivedOp::InputRaw, 0}, {"ssm", DerivedOp::InputSsm, 0}, {"sdi", DerivedOp::InputSdi, 0},
+    {"parity", DerivedOp::InputParity, 0}, {"seen", DerivedOp::InputSeen, 0}, {"age", DerivedOp::InputAge, 0},
+    {"bits", DerivedOp::InputBits, 0},
+};
+
+bool IsIdentifier(const std::string& name) {
+    if (name.empty() || !(std::isalpha((unsigned char)name[0]) || name[0] == '_')) return false;
+    for (char c : name) {
+        if (!(std::isalnum((unsigned char)c) || c == '_')) return false;
+    }
+    return true;
+}
+
+bool SameInput(const DerivedInputSlot& slot, const DerivedInputSpec& spec) {
+    return slot.card == spec.card && slot.core == spec.core && slot.channel == spec.channel && slot.label == spec.label &&
+        slot.decoding.format == spec.decoding.format && slot.decoding.msb == spec.decoding.msb &&
+        slot.decoding.lsb == spec.decoding.lsb && slot.decoding.resolution == spec.decoding.resolution;
+}
+
+bool SameValue(double a, double b) {
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+// Recursive descent straight to stack code; parameter references carry the spec index until the order is known
+class ExpressionCompiler {
+public:
+    ExpressionCompiler(const std::string& text, const std::map<std::string, int>& inputs, const std::map<std::string, int>& parameters)
+        : text_(text), inputs_(inputs), parameters_(parameters) {}
+
+    bool Compile(std::vector<DerivedInstr>* code, std::string* error) {
+        code_ = code;
+        if (!Ternary()) {
+            *error = error_;
+            return false;
+        }
+        SkipSpace();
+        if (pos_ != text_.size()) {
+            *error = "unexpected '" + text_.substr(pos_, 1) + "' at " + std::to_string(pos_);
+            return false;
+        }
+        return true;
+    }
+    int MaxDepth() const { return maxDepth_; }
+    const std::vector<int>& ParameterRefs() const { return parameterRefs_; }
+    const std::vector<int>& InputRefs() const { return inputRefs_; }
+    const std::vector<int>& AgeRefs() const { return ageRefs_; }
+
+private:
+    void SkipSpace() {
+        while (pos_ < text_.size() && std::isspace((unsigned char)text_[pos_])) ++pos_;
+    }
+    bool Accept(const char* token) {
+        SkipSpace();
+        size_t length = std::strlen(token);
+        if (text_.compare(pos_, length, token) != 0) return false;
+        // '<' must not take the start of '<=', '!' not that of '!='
+        if (length == 1 && pos_ + 1 < text_.size() && text_[pos_ + 1] == '=' && std::strchr("<>!=", token[0])) return false;
+        pos_ += length;
+        return true;
+    }
+    bool Fail(const std::string& message) {
+        if (error_.empty()) error_ = message + " at " + std::to_string(pos_);
+        return false;
+    }
+    // One level of recursion for the lifetime of a parse function
+    struct Nested {
+        explicit Nested(int& nesting) : nesting(nesting) { ++nesting; }
+        ~Nested() { --nesting; }
+        int& nesting;
+    };
+    bool TooDeep() {
+        if (nesting_ <= DERIVED_MAX_NESTING) return false;
+        Fail("expression nested deeper than " + std::to_string(DERIVED_MAX_NESTING) + " levels");
+        return true;
+    }
+    void Emit(DerivedOp op, int arg, double value, int stackDelta) {
+        code_->push_back({op, arg, value});
+        depth_ += stackDelta;
+        maxDepth_ = std::max(maxDepth_, depth_);
+    }
+    void Uses(std::vector<int>& refs, int index) {
+        if (std::find(refs.begin(), refs.end(), index) == refs.end()) refs.push_back(index);
+    }
+
+    bool Ternary() {
+        if (!Or()) return false;
+        if (!Accept("?")) return true;
+        Nested nested(nesting_);
+        if (TooDeep() || !Ternary()) return false;
+        if (!Accept(":")) return Fail("expected ':'");
+        if (!Ternary()) return false;
+        Emit(DerivedOp::Select, 0, 0, -2);
+        return true;
+    }
+    bool Or() {
+        if (!And()) return false;
+        while (Accept("||")) {
+            if (!And()) return false;
+            Emit(DerivedOp::Or, 0, 0, -1);
+        }
+        return true;
+    }
+    bool And() {
+        if (!Comparison()) return false;
+        while (Accept("&&")) {
+            if (!Comparison()) return false;
+            Emit(DerivedOp::And, 0, 0, -1);
+        }
+        return true;
+    }
+    bool Comparison() {
+        if (!Sum()) return false;
+        for (;;) {
+            DerivedOp op;
+            if (Accept("<=")) op = DerivedOp::Le;
+            else if (Accept(">=")) op = DerivedOp::Ge;
+            else if (Accept("==")) op = DerivedOp::Eq;
+            else if (Accept("!=")) op = DerivedOp::Ne;
+            else if (Accept("<")) op = DerivedOp::Lt;
+            else if (Accept(">")) op = DerivedOp::Gt;
+            else return true;
+            if (!Sum()) return false;
+            Emit(op, 0, 0, -1);
+        }
+    }
+    bool Sum() {
+        if (!Product()) return false;
+        for (;;) {
+            DerivedOp op;
+            if (Accept("+")) op = DerivedOp::Add;
+            else if (Accept("-")) op = DerivedOp::Sub;
+            else return true;
+            if (!Product()) return false;
+            Emit(op, 0, 0, -1);
+        }
+    }
+    bool Product() {
+        if (!Unary()) return false;
+        for (;;) {
+            DerivedOp op;
+            if (Accept("*")) op = DerivedOp::Mul;
+            else if (Accept("/")) op = DerivedOp::Div;
+            else if (Accept("%")) op = DerivedOp::Mod;
+            else return true;
+            if (!Unary()) return false;
+            Emit(op, 0, 0, -1);
+        }
+    }
+    bool Unary() {
+        Nested nested(nesting_);
+        if (TooDeep()) return false;
+        if (Accept("-")) {
+            if (!Unary()) return false;
+            Emit(DerivedOp::Neg, 0, 0, 0);
+            return true;
+        }
+        if (Accept("!")) {
+            if (!Unary()) return false;
+            Emit(DerivedOp::Not, 0, 0, 0);
+            return true;
+        }
+        if (Accept("+")) return Unary();
+        return Primary();
+    }
+    bool Number() {
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        double value = std::strtod(start, &end);
+        if (end == start) return Fail("expected a number");
+        pos_ += end - start;
+        Emit(DerivedOp::Const, 0, value, 1);
+        return true;
+    }
+    std::string Identifier() {
+        size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum((unsigned char)text_[pos_]) || text_[pos_] == '_')) ++pos_;
+        return text_.substr(start, pos_ - start);
+    }
+    bool InputArgument(int* slot) {
+        SkipSpace();
+        std::string name = Identifier();
+        auto input = inputs_.find(name);
+        if (input == inputs_.end()) return Fail("'" + name + "' is not an input of this parameter");
+        *slot = input->second;
+        return true;
+    }
+    bool IntegerArgument(int* value) {
+        SkipSpace();
+        const char* start = text_.c_str() + pos_;
+        char* end = nullptr;
+        long parsed = std::strtol(start, &end, 10);
+        if (end == start) return Fail("expected a bit number");
+        pos_ += end - start;
+        *value = (int)parsed;
+        return true;
+    }
+    bool Call(const std::string& name) {
+        for (const FunctionSpec& accessor : ACCESSORS) {
+            if (name != accessor.name) continue;
+            int slot = 0;
+            if (!InputArgument(&slot)) return false;
+            int arg = slot;
+            if (accessor.op == DerivedOp::InputBits) {
+                int msb = 0, lsb = 0;
+                if (!Accept(",") || !IntegerArgument(&msb) || !Accept(",") || !IntegerArgument(&lsb)) {
+                    return Fail("bits() takes an input, msb and lsb");
+                }
+                if (lsb < 1 || msb > 32 || msb < lsb) return Fail("bits() needs 1 <= lsb <= msb <= 32");
+                arg = (slot << 16) | (msb << 8) | lsb;
+            }
+            if (!Accept(")")) return Fail("expected ')'");
+            if (accessor.op == DerivedOp::InputAge) Uses(ageRefs_, slot);
+            Uses(inputRefs_, slot);
+            Emit(accessor.op, arg, 0, 1);
+            return true;
+        }
+        for (const FunctionSpec& function : FUNCTIONS) {
+            if (name != function.name) continue;
+            int arity = function.op == DerivedOp::Call1 ? 1 : function.op == DerivedOp::Call2 ? 2 : 3;
+            for (int i = 0; i < arity; ++i) {
+                if (i > 0 && !Accept(",")) return Fail(name + "() takes " + std::to_string(arity) + " argument(s)");
+                if (!Ternary()) return false;
+            }
+            if (!Accept(")")) return Fail("expected ')'");
+            Emit(function.op, function.id, 0, 1 - arity);
+            return true;
+        }
+        return Fail("unknown function '" + name + "'");
+    }
+    bool Primary() {
+        SkipSpace();
+        if (pos_ >= text_.size()) return Fail("unexpected end of expression");
+        char c = text_[pos_];
+        if (c == '(') {
+            ++pos_;
+            if (!Ternary()) return false;
+            if (!Accept(")")) return Fail("expected ')'");
+            return true;
+        }
+        if (std::isdigit((unsigned char)c) || c == '.') return Number();
+        if (!(std::isalpha((unsigned char)c) || c == '_')) return Fail("unexpected '" + std::string(1, c) + "'");
+        std::string name = Identifier();
+        if (Accept("(")) return Call(name);
+        auto input = inputs_.find(name);
+        if (input != inputs_.end()) {
+            Uses(inputRefs_, input->second);
+            Emit(DerivedOp::Input, input->second, 0, 1);
+            return true;
+        }
+        auto parameter = parameters_.find(name);
+        if (parameter != parameters_.end()) {
+            Uses(parameterRefs_, parameter->second);
+            Emit(DerivedOp::Param, parameter->second, 0, 1);
+            return true;
+        }
+        if (name == "pi") {
+            Emit(DerivedOp::Const, 0, PI, 1);
+            return true;
+        }
+        if (name == "nan") {
+            Emit(DerivedOp::Const, 0, std::nan(""), 1);
+            return true;
+        }
+        return Fail("unknown name '" + name + "'");
+    }
+
+    const std::string& text_;
+    const std::map<std::string, int>& inputs_;
+    const std::map<std::string, int>& parameters_;
+    std::vector<DerivedInstr>* code_ = nullptr;
+    size_t pos_ = 0;
+    int depth_ = 0;
+    int maxDepth_ = 0;
+    int nesting_ = 0;     // Open operands (every paren, call and prefix operator passes Unary) and ternaries
+    std::string error_;
+    std::vector<int> parameterRefs_; // Spec indices
+    std::vector<int> inputRefs_;     // Program input slots
+    std::vector<int> ageRefs_;
+};
+}
+
+bool CompileDerivedParameters(const std::vector<DerivedParameterSpec>& specs, std::shared_ptr<const DerivedProgram>* program,
+                              std::string* errorMessage) {
+    if (specs.size() > (size_t)DERIVED_MAX_PARAMETERS) {
+        *errorMessage = "At most " + std::to_string(DERIVED_MAX_PARAMETERS) + " derived parameters";
+        return false;
+    }
+    std::map<std::string, int> parameterIndex;
+    for (size_t i = 0; i < specs.size(); ++i) {
+        if (!IsIdentifier(specs[i].name)) {
+            *errorMessage = "Parameter " + std::to_string(i) + ": name must be an identifier";
+            return false;
+        }
+        if (!parameterIndex.emplace(specs[i].name, (int)i).second) {
+            *errorMessage = specs[i].name + ": defined more than once";
+            return false;
+        }
+    }
+
+    auto compiled = std::make_shared<DerivedProgram>();
+    std::vector<DerivedParameter> unordered(specs.size());
+    std::vector<std::vector<int>> parameterRefs(specs.size()), inputRefs(specs.size());
+    for (size_t i = 0; i < specs.size(); ++i) {
+        const DerivedParameterSpec& spec = specs[i];
+        std::map<std::string, int> inputs;
+        for (const DerivedInputSpec& input : spec.inputs) {
+            std::string where = spec.name + ": input '" + input.name + "': ";
+            if (!IsIdentifier(input.name) || inputs.count(input.name)) {
+                *errorMessage = where + "names must be unique identifiers";
+                return false;
+            }
+            if (input.label < 0 || input.label > 255 || input.channel < -1 || input.channel >= 32) {
+                *errorMessage = where + "needs label 0..255 and channel 0..31 (or any)";
+                return false;
+            }
+            if (!ValidateDecoding(input.decoding, errorMessage)) {
+                *errorMessage = where + *errorMessage;
+                return false;
+            }
+            auto existing = std::find_if(compiled->inputs.begin(), compiled->inputs.end(),
+                [&](const DerivedInputSlot& slot) { return SameInput(slot, input); });
+            if (existing == compiled->inputs.end()) {
+                if (compiled->inputs.size() >= (size_t)DERIVED_MAX_INPUTS) {
+                    *errorMessage = "At most " + std::to_string(DERIVED_MAX_INPUTS) + " distinct inputs";
+                    return false;
+                }
+                compiled->inputs.push_back({input.card, input.core, input.channel, input.label, input.decoding, false, {}});
+                existing = compiled->inputs.end() - 1;
+            }
+            inputs[input.name] = (int)(existing - compiled->inputs.begin());
+        }
+
+        ExpressionCompiler compiler(spec.expression, inputs, parameterIndex);
+        std::string error;
+        if (!compiler.Compile(&unordered[i].code, &error)) {
+            *errorMessage = spec.name + ": " + error;
+            return false;
+        }
+        unordered[i].name = spec.name;
+        unordered[i].stackDepth = compiler.MaxDepth();
+        parameterRefs[i] = compiler.ParameterRefs();
+        inputRefs[i] = compiler.InputRefs();
+        for (int slot : compiler.AgeRefs()) compiled->inputs[slot].everyWord = true;
+        if (!compiler.AgeRefs().empty()) compiled->ageReaders.push_back((int)i);
+        if (std::find(parameterRefs[i].begin(), parameterRefs[i].end(), (int)i) != parameterRefs[i].end()) {
+            *errorMessage = spec.name + ": refers to itself";
+            return false;
+        }
+    }
+
+    // Evaluation order: repeatedly take the first parameter whose references are all placed
+    std::vector<int> order, rank(specs.size(), -1);
+    while (order.size() < specs.size()) {
+        bool placed = false;
+        for (size_t i = 0; i < specs.size(); ++i) {
+            if (rank[i] >= 0) continue;
+            bool ready = std::all_of(parameterRefs[i].begin(), parameterRefs[i].end(), [&](int ref) { return rank[ref] >= 0; });
+            if (!ready) continue;
+            rank[i] = (int)order.size();
+            order.push_back((int)i);
+            placed = true;
+        }
+        if (!placed) {
+            for (size_t i = 0; i < specs.size(); ++i) {
+                if (rank[i] < 0) {
+                    *errorMessage = specs[i].name + ": cyclic reference";
+                    return false;
+                }
+            }
+        }
+    }
+
+    for (int index : order) {
+        DerivedParameter parameter = std::move(unordered[index]);
+        for (DerivedInstr& instr : parameter.code) {
+            if (instr.op == DerivedOp::Param) instr.arg = rank[instr.arg];
+        }
+        compiled->maxStack = std::max(compiled->maxStack, parameter.stackDepth);
+        compiled->parameters.push_back(std::move(parameter));
+    }
+    for (size_t i = 0; i < specs.size(); ++i) {
+        for (int ref : parameterRefs[i]) compiled->parameters[rank[ref]].dependents.push_back(rank[i]);
+        for (int slot : inputRefs[i]) compiled->inputs[slot].dependents.push_back(rank[i]);
+    }
+    for (int& id : compiled->ageReaders) id = rank[id];
+    for (size_t slot = 0; slot < compiled->inputs.size(); ++slot) {
+        compiled->byLabel[compiled->inputs[slot].label].push_back((int)slot);
+    }
+    *program = compiled;
+    return true;
+}
+
+DerivedEngine& Derived() {
+    static DerivedEngine* engine = new DerivedEngine(); // Leaked, like the session registry it transforms
+    return *engine;
+}
+
+void DerivedEngine::SetProgram(std::shared_ptr<const DerivedProgram> program) {
+    // Outside mutex_: the merge thread holds the sink lock while it waits for ours
+    if (program) std::call_once(installOnce_, [this] { Sessions().SetBatchTransform(&DerivedEngine::Transform, this, &DerivedEngine::Tick); });
+
+    uint32_t channelMask = 0;
+    if (program) {
+        for (const DerivedInputSlot& input : program->inputs) {
+            if (input.channel < 0) {
+                channelMask = 0; // Any channel: demand them all
+                break;
+            }
+            channelMask |= 1u << input.channel;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        program_ = program;
+        inputs_.assign(program ? program->inputs.size() : 0, InputState());
+        parameters_.assign(program ? program->parameters.size() : 0, ParameterState());
+        stack_.assign(program ? program->maxStack + 1 : 0, 0.0);
+        dirty_.clear();
+        lastTickNs_ = 0;
+        stats_ = DerivedStats();
+    }
+    if (program) {
+        Sessions().SetDemand(this, -1, -1, channelMask);
+        BTI_LOG_INFO("Derived parameters: %zu parameter(s) over %zu input(s).", program->parameters.size(), program->inputs.size());
+    } else {
+        Sessions().ClearDemand(this);
+    }
+}
+
+bool DerivedEngine::IsActive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return program_ != nullptr;
+}
+
+std::vector<DerivedValueInfo> DerivedEngine::Values() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DerivedValueInfo> values;
+    if (!program_) return values;
+    for (size_t id = 0; id < parameters_.size(); ++id) {
+        const ParameterState& state = parameters_[id];
+        values.push_back({program_->parameters[id].name, state.updates ? state.value : std::nan(""), state.timestampMs, state.updates});
+    }
+    return values;
+}
+
+DerivedStats DerivedEngine::Stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DerivedEngine::Transform(void* context, std::vector<ArincUpdateData>& batch) {
+    static_cast<DerivedEngine*>(context)->Apply(batch);
+}
+
+void DerivedEngine::Tick(void* context, int64_t nowNs, std::vector<ArincUpdateData>& batch) {
+    static_cast<DerivedEngine*>(context)->ApplyTick(nowNs, batch);
+}
+
+double DerivedEngine::Evaluate(const DerivedParameter& parameter, int64_t nowNs) {
+    double* s = stack_.data();
+    int top = 0;
+    const double nan = std::nan("");
+    for (const DerivedInstr& instr : parameter.code) {
+        switch (instr.op) {
+        case DerivedOp::Const: s[top++] = instr.value; break;
+        case DerivedOp::Param: {
+            const ParameterState& state = parameters_[instr.arg];
+            s[top++] = state.updates ? state.value : nan;
+            break;
+        }
+        case DerivedOp::Input: case DerivedOp::InputRaw: case DerivedOp::InputSsm: case DerivedOp::InputSdi:
+        case DerivedOp::InputParity: case DerivedOp::InputSeen: case DerivedOp::InputAge: case DerivedOp::InputBits: {
+            int slot = instr.op == DerivedOp::InputBits ? instr.arg >> 16 : instr.arg;
+            const InputState& in = inputs_[slot];
+            double value = nan;
+            if (instr.op == DerivedOp::InputSeen) value = in.seen ? 1.0 : 0.0;
+            else if (instr.op == DerivedOp::InputAge) value = in.seen ? (nowNs - in.timestampNs) / 1e9 : INFINITY;
+            else if (in.seen) {
+                switch (instr.op) {
+                case DerivedOp::Input: value = in.value; break;
+                case DerivedOp::InputRaw: value = (double)in.word; break;
+                case DerivedOp::InputSsm: value = WordSsm(in.word); break;
+                case DerivedOp::InputSdi: value = WordSdi(in.word); break;
+                case DerivedOp::InputParity: value = WordParityOk(in.word) ? 1.0 : 0.0; break;
+                default: value = (double)WordField(in.word, (instr.arg >> 8) & 0xFF, instr.arg & 0xFF); break;
+                }
+            }
+            s[top++] = value;
+            break;
+        }
+        case DerivedOp::Neg: s[top - 1] = -s[top - 1]; break;
+        case DerivedOp::Not: s[top - 1] = s[top - 1] == 0.0 ? 1.0 : 0.0; break;
+        case DerivedOp::Select:
+            top -= 2;
+            s[top - 1] = s[top - 1] != 0.0 ? s[top] : s[top + 1];
+            break;
+        case DerivedOp::Call1: {
+            double& x = s[top - 1];
+            switch (instr.arg) {
+            case 0: x = std::fabs(x); break;
+            case 1: x = std::sqrt(x); break;
+            case 2: x = std::floor(x); break;
+            case 3: x = std::ceil(x); break;
+            case 4: x = std::round(x); break;
+            case 5: x = std::sin(x); break;
+            case 6: x = std::cos(x); break;
+            case 7: x = std::tan(x); break;
+            case 8: x = std::asin(x); break;
+            case 9: x = std::acos(x); break;
+            case 10: x = std::atan(x); break;
+            case 11: x = x * (180.0 / PI); break;
+            default: x = x * (PI / 180.0); break;
+            }
+            break;
+        }
+        case DerivedOp::Call3:
+            top -= 2;
+            s[top - 1] = std::min(std::max(s[top - 1], s[top]), s[top + 1]);
+            break;
+        default: {
+            // Binary operators and two-argument functions
+            double b = s[--top];
+            double& a = s[top - 1];
+            switch (instr.op) {
+            case DerivedOp::Add: a = a + b; break;
+            case DerivedOp::Sub: a = a - b; break;
+            case DerivedOp::Mul: a = a * b; break;
+            case DerivedOp::Div: a = a / b; break;
+            case DerivedOp::Mod: a = std::fmod(a, b); break;
+            case DerivedOp::Lt: a = a < b ? 1.0 : 0.0; break;
+            case DerivedOp::Le: a = a <= b ? 1.0 : 0.0; break;
+            case DerivedOp::Gt: a = a > b ? 1.0 : 0.0; break;
+            case DerivedOp::Ge: a = a >= b ? 1.0 : 0.0; break;
+            case DerivedOp::Eq: a = a == b ? 1.0 : 0.0; break;
+            case DerivedOp::Ne: a = a != b ? 1.0 : 0.0; break;
+            case DerivedOp::And: a = (a != 0.0 && b != 0.0) ? 1.0 : 0.0; break;
+            case DerivedOp::Or: a = (a != 0.0 || b != 0.0) ? 1.0 : 0.0; break;
+            case DerivedOp::Call2:
+                switch (instr.arg) {
+                case 0: a = std::min(a, b); break;
+                case 1: a = std::max(a, b); break;
+                case 2: a = std::atan2(a, b); break;
+                case 3: a = std::hypot(a, b); break;
+                default: a = std::pow(a, b); break;
+                }
+                break;
+            default: break;
+            }
+            break;
+        }
+        }
+    }
+    return top > 0 ? s[top - 1] : nan;
+}
+
+void DerivedEngine::MarkDirty(int id) {
+    if (parameters_[id].dirty) return;
+    parameters_[id].dirty = true;
+    dirty_.push_back(id);
+    std::push_heap(dirty_.begin(), dirty_.end(), std::greater<int>());
+}
+
+// Evaluates the dirty parameters in id order (dependents always come later) and appends every changed value to out
+bool DerivedEngine::EvaluateDirty(int64_t nowNs, long long nowMs, std::vector<ArincUpdateData>& out) {
+    const DerivedProgram& program = *program_;
+    bool published = false;
+    while (!dirty_.empty()) {
+        std::pop_heap(dirty_.begin(), dirty_.end(), std::greater<int>());
+        int id = dirty_.back();
+        dirty_.pop_back();
+        ParameterState& state = parameters_[id];
+        state.dirty = false;
+        const DerivedParameter& parameter = program.parameters[id];
+        double value = Evaluate(parameter, nowNs);
+        stats_.evaluations++;
+        // Unchanged, or still undefined because some input has not arrived yet
+        if (state.updates > 0 ? SameValue(value, state.value) : std::isnan(value)) continue;
+        state.value = value;
+        state.timestampMs = nowMs;
+        state.updates++;
+        stats_.published++;
+        published = true;
+        float narrow = (float)value;
+        uint32_t bits = 0;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        out.push_back({id >> 8, id & 0xFF, (ULONG)bits, nowMs, nowNs, DERIVED_CARD, 0});
+        for (int dependent : parameter.dependents) MarkDirty(dependent);
+    }
+    return published;
+}
+
+// Each matching word updates its inputs; the parameters that depend on a changed input are re-evaluated and every
+// changed value is inserted right after the word that caused it
+void DerivedEngine::Apply(std::vector<ArincUpdateData>& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!program_ || batch.empty()) return;
+    TRACE_SCOPE_ARG("DerivedParams", "words", batch.size());
+    const DerivedProgram& program = *program_;
+    bool published = false;
+    scratch_.clear();
+    for (const ArincUpdateData& update : batch) {
+        scratch_.push_back(update);
+        if (IsGapMarker(update) || IsDerivedValue(update) || IsDioEdge(update) || update.label < 0 || update.label > 255) continue;
+        const std::vector<int>& slots = program.byLabel[update.label];
+        if (slots.empty()) continue;
+
+        uint32_t word = (uint32_t)update.word;
+        for (int slot : slots) {
+            const DerivedInputSlot& input = program.inputs[slot];
+            if ((input.channel >= 0 && input.channel != update.channel) || (input.card >= 0 && input.card != update.card) ||
+                (input.core >= 0 && input.core != update.core)) continue;
+            InputState& state = inputs_[slot];
+            stats_.inputWords++;
+            bool changed = !state.seen || state.word != word || input.everyWord;
+            state.timestampNs = update.timestamp_ns;
+            if (!changed) continue;
+            state.word = word;
+            state.value = DecodeWord(word, input.decoding);
+            state.seen = true;
+            for (int id : input.dependents) MarkDirty(id);
+        }
+        if (EvaluateDirty(update.timestamp_ns, update.timestamp_ms, scratch_)) published = true;
+    }
+    if (published) batch.swap(scratch_);
+}
+
+// Re-evaluates the age() readers once per DERIVED_AGE_TICK_MS of stream time; nowNs is never behind a word already
+// delivered, so the values appended here stay in timestamp order
+void DerivedEngine::ApplyTick(int64_t nowNs, std::vector<ArincUpdateData>& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!program_ || program_->ageReaders.empty() || nowNs - lastTickNs_ < DERIVED_AGE_TICK_MS * 1000000LL) return;
+    lastTickNs_ = nowNs;
+    for (int id : program_->ageReaders) MarkDirty(id);
+    long long nowMs = steady_clock_to_epoch_ms(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(nowNs)));
+    EvaluateDirty(nowNs, nowMs, batch);
+}
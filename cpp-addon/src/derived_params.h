@@ -0,0 +1,150 @@
+#ifndef DERIVED_PARAMS_H
+#define DERIVED_PARAMS_H
+
+// Derived parameters: values computed from decoded labels (and from each other) by small expressions, compiled once
+// into a dependency graph and evaluated on the delivering thread as the words arrive. A parameter is recomputed only
+// when one of its inputs got a different word (or any word, for inputs whose age() it reads) and is published only
+// when its value changed, as an update of the virtual card DERIVED_CARD, so taps, subscribers, captures and the JS
+// stream receive it like any label. Parameters that read age() are also re-evaluated every DERIVED_AGE_TICK_MS of
+// stream time, so a timeout fires when its input goes quiet rather than when the input's next word arrives.
+//
+// Expressions: numbers (decimal or 0x hex), + - * / %, comparisons, && || !, c ? a : b and parentheses over
+//   input names          decoded value of the input (NaN until first received)
+//   parameter names      another derived parameter (cycles are rejected)
+//   pi, nan              constants
+//   abs sqrt floor ceil round sin cos tan asin acos atan deg rad (x), min max atan2 hypot pow (x, y), clamp (x, lo, hi)
+//   raw(in) ssm(in) sdi(in) parity(in) seen(in) age(in)    raw word, its SSM / SDI, 1 if odd parity holds,
+//                                                          1 once received, seconds since the input's last word
+//   bits(in, msb, lsb)                                     unsigned ARINC bits msb..lsb of the raw word
+// Comparisons and logic yield 1 or 0; any non-zero value is true.
+
+#include "device_session.h"
+#include "label_decoder.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+const int DERIVED_MAX_PARAMETERS = 1024;   // Ids fit the virtual card's channels 0..3
+const int DERIVED_MAX_INPUTS = 4096;
+const int DERIVED_MAX_NESTING = 256;       // Parentheses, calls, ternaries and unary operators; the compiler recurses
+const int DERIVED_AGE_TICK_MS = 100;       // Re-evaluation period of parameters that read age()
+
+struct DerivedInputSpec {
+    std::string name;
+    int card = -1;                // -1 = any
+    int core = -1;
+    int channel = -1;             // -1 = any
+    int label = 0;
+    LabelDecoding decoding;
+};
+
+struct DerivedParameterSpec {
+    std::string name;
+    std::string expression;
+    std::vector<DerivedInputSpec> inputs; // Names local to this parameter
+};
+
+enum class DerivedOp : uint8_t {
+    Const, Input, Param,
+    InputRaw, InputSsm, InputSdi, InputParity, InputSeen, InputAge, InputBits,
+    Neg, Not, Add, Sub, Mul, Div, Mod, Lt, Le, Gt, Ge, Eq, Ne, And, Or, Select,
+    Call1, Call2, Call3
+};
+
+struct DerivedInstr {
+    DerivedOp op;
+    int arg;                      // Input slot, parameter id, function; bits(): slot << 16 | msb << 8 | lsb
+    double value;                 // Const
+};
+
+struct DerivedInputSlot {
+    int card, core, channel, label;
+    LabelDecoding decoding;
+    bool everyWord = false;       // Some dependent reads age(): any word counts as a change
+    std::vector<int> dependents;  // Parameter ids
+};
+
+struct DerivedParameter {
+    std::string name;
+    std::vector<DerivedInstr> code;
+    int stackDepth = 0;
+    std::vector<int> dependents;  // Parameter ids, all greater than this one
+};
+
+// Parameters are numbered in evaluation order (every parameter after those it reads)
+struct DerivedProgram {
+    std::vector<DerivedInputSlot> inputs;
+    std::vector<DerivedParameter> parameters;
+    std::vector<int> byLabel[256]; // Input slots per label
+    std::vector<int> ageReaders;   // Parameter ids that read some input's age()
+    int maxStack = 0;
+};
+
+// Validates, resolves names, orders the parameters and merges identical inputs; false with a message naming the
+// parameter and position on any error
+bool CompileDerivedParameters(const std::vector<DerivedParameterSpec>& specs, std::shared_ptr<const DerivedProgram>* program,
+                              std::string* errorMessage);
+
+struct DerivedValueInfo {
+    std::string name;
+    double value;
+    long long timestampMs;        // Of the word that last changed it; 0 = never computed
+    uint64_t updates;             // Times it was published
+};
+
+struct DerivedStats {
+    uint64_t inputWords = 0;      // Words that matched an input
+    uint64_t evaluations = 0;
+    uint64_t published = 0;
+};
+
+class DerivedEngine {
+public:
+    // Replaces the parameter set (null = none); inputs and values start over. Installs the registry transform and a
+    // polling demand for the input channels.
+    void SetProgram(std::shared_ptr<const DerivedProgram> program);
+    bool IsActive();
+    std::vector<DerivedValueInfo> Values();
+    DerivedStats Stats();
+
+private:
+    struct InputState {
+        uint32_t word = 0;
+        double value = 0.0;
+        int64_t timestampNs = 0;
+        bool seen = false;
+    };
+    struct ParameterState {
+        double value = 0.0;
+        long long timestampMs = 0;
+        uint64_t updates = 0;
+        bool dirty = false;
+    };
+
+    static void Transform(void* context, std::vector<ArincUpdateData>& batch);
+    static void Tick(void* context, int64_t nowNs, std::vector<ArincUpdateData>& batch);
+    void Apply(std::vector<ArincUpdateData>& batch);
+    void ApplyTick(int64_t nowNs, std::vector<ArincUpdateData>& batch);
+    // Caller holds mutex_
+    void MarkDirty(int id);
+    bool EvaluateDirty(int64_t nowNs, long long nowMs, std::vector<ArincUpdateData>& out);
+    double Evaluate(const DerivedParameter& parameter, int64_t nowNs);
+
+    std::mutex mutex_; // Guards everything below; held by the transform for one batch
+    std::once_flag installOnce_;
+    std::shared_ptr<const DerivedProgram> program_;
+    std::vector<InputState> inputs_;
+    std::vector<ParameterState> parameters_;
+    std::vector<double> stack_;
+    std::vector<int> dirty_;                 // Min-heap of parameter ids due for evaluation
+    std::vector<ArincUpdateData> scratch_;
+    int64_t lastTickNs_ = 0;
+    DerivedStats stats_;
+};
+
+DerivedEngine& Derived();
+
+#endif // DERIVED_PARAMS_H
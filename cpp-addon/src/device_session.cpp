@@ -0,0 +1,1501 @@
+#include "device_session.h"
+#include "dio_monitor.h"
+#include "error_aggregator.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <windows.h>
+#include <algorithm>
+#include <climits>
+
+// --- Timestamp Helpers ---
+long long steady_clock_to_epoch_ms(const std::chrono::steady_clock::time_point& tp) {
+    // This conversion assumes steady_clock's epoch is reasonably close to system_clock's epoch
+    // or that the difference is consistent. A more robust solution might calibrate at startup.
+    auto duration = tp.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    // A potentially more accurate way (if needed and C++20 available):
+    // return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count() +
+    //        std::chrono::duration_cast<std::chrono::milliseconds>(tp - std::chrono::steady_clock::now()).count();
+}
+
+int64_t HostNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// --- Reader Poll Scheduling ---
+// Demanded channels are polled at an interval that follows their word rate; undemanded ones only at the
+// background cadence, which still drains their lists and catches overflow. Every ListStatus is a bus transaction.
+const int64_t POLL_MIN_INTERVAL_US = 1000;          // Busiest demanded channel: every cycle
+const int64_t POLL_MAX_INTERVAL_US = 10000;         // Quiet demanded channel
+const int64_t POLL_BACKGROUND_INTERVAL_US = 250000; // Undemanded channel
+const double POLL_TARGET_WORDS = 256.0;             // Words to expect per poll: a quarter of the 1024-word list
+const double POLL_RATE_SMOOTHING = 0.3;             // EWMA weight of the newest rate sample
+const int EVENT_LOG_MAX_DRAIN = 1024;               // Entries read per cycle at most: the whole log as configured
+const int ERROR_COLLECT_INTERVAL_MS = 100;          // Merge thread: error notice cadence (see ErrorAggregator)
+const int RECONFIG_TIMEOUT_MS = 2000;               // ApplyReceiverConfig: wait for the reader to run the plan
+
+// --- Receive List Sizing (LIST_DEFAULT_WORDS / LIST_LIMIT_WORDS: receiver_profile.h) ---
+const int LIST_MAX_WORDS = 16384;      // Default cap for adaptive lists
+const double LIST_HEADROOM = 2.0;      // Adaptive lists hold this many poll intervals at the peak rate
+const int LIST_MAX_RESIZES = 4;        // Per channel and monitoring run: every resize leaks the old list's card memory
+
+// --- DeviceSession ---
+
+DeviceSession::DeviceSession(int index, int cardNum, int coreNum, HCARD hCard, HCORE hCore)
+    : index_(index), cardNum_(cardNum), coreNum_(coreNum), hCard_(hCard), hCore_(hCore),
+      maxListWords_(LIST_MAX_WORDS),
+      dio_(new DioMonitor(cardNum, coreNum, hCore, &monitoringActive_)),
+      errors_(new ErrorAggregator(cardNum, coreNum, hCore)),
+      suppressed_(new std::atomic<uint32_t>[STATS_MAX_CHANNELS * CHANGE_ONLY_LABELS]()) {}
+
+DeviceSession::~DeviceSession() {
+    dio_->Stop();
+    StopMonitoring();
+}
+
+void DeviceSession::Discover() {
+    channels_.clear();
+    INT rcvCount = 0;
+    INT xmtCount = 0;
+    BTI429_ChGetCount(&rcvCount, &xmtCount, hCore_);
+
+    // Channel numbers are not guaranteed to be contiguous by direction; probe until both counts are found
+    int foundRcv = 0, foundXmt = 0;
+    for (int ch = 0; ch < STATS_MAX_CHANNELS && (foundRcv < rcvCount || foundXmt < xmtCount); ++ch) {
+        bool rcv = BTI429_ChIsRcv(ch, hCore_) != 0;
+        bool xmt = BTI429_ChIsXmt(ch, hCore_) != 0;
+        if (!rcv && !xmt) continue;
+        channels_.push_back({ch, rcv, xmt});
+        if (rcv) ++foundRcv;
+        if (xmt) ++foundXmt;
+    }
+    receiveListAddrs_.assign(channels_.empty() ? 0 : channels_.back().channel + 1, 0);
+    receiveMsgAddrs_.assign(receiveListAddrs_.size(), 0);
+    listSizes_.assign(receiveListAddrs_.size(), LIST_DEFAULT_WORDS);
+    PublishLayout();
+    BTI_LOG_INFO("Card %d core %d: %d receive / %d transmit channels", cardNum_, coreNum_, foundRcv, foundXmt);
+}
+
+bool DeviceSession::IsRcvChannel(int channel) const {
+    for (const auto& ch : channels_) if (ch.channel == channel) return ch.receive;
+    return false;
+}
+
+bool DeviceSession::IsXmtChannel(int channel) const {
+    for (const auto& ch : channels_) if (ch.channel == channel) return ch.transmit;
+    return false;
+}
+
+bool DeviceSession::ConfigureReceivers(std::string* errorMessage, int* errorCode) {
+    SetupReport report;
+    bool success = ApplyReceiverProfile(ReceiverProfile(), &report);
+    *errorMessage = report.message;
+    *errorCode = report.errorCode;
+    return success;
+}
+
+bool DeviceSession::ApplyReceiverProfile(const ReceiverProfile& profile, SetupReport* report) {
+    TRACE_SCOPE("ApplyReceiverProfile");
+    std::lock_guard<std::mutex> setupLock(setupMutex_);
+    *report = SetupReport();
+    std::vector<int> receiveChannels;
+    for (const auto& chInfo : channels_) if (chInfo.receive) receiveChannels.push_back(chInfo.channel);
+
+    ReceiverLayout applied, target;
+    std::vector<int> listSizes;
+    PublishedLayout(&applied, &listSizes);
+    if (!ResolveProfile(profile, receiveChannels, listSizes, &target, &report->message)) {
+        report->errorCode = ERR_PARAM;
+        return false;
+    }
+    std::vector<SetupStep> plan = BuildSetupPlan(target, applied);
+
+    if (monitoringActive_.load()) {
+        // The reader owns the lists now; an unchanged layout is fine, changes go through ApplyReceiverConfig
+        for (const SetupStep& step : plan) {
+            if (step.kind != SetupStepKind::ListClear) {
+                report->message = "Receiver is monitoring; stop it or use applyReceiverConfig to change the configuration.";
+                report->errorCode = ERR_BUSY;
+                return false;
+            }
+        }
+        report->success = true;
+        report->channelsReused = (int)plan.size();
+        report->message = "Receiver already configured and monitoring.";
+        return true;
+    }
+    return RunSetupPlan(plan, target, false, report);
+}
+
+bool DeviceSession::ApplyReceiverConfig(const ReceiverProfile& changes, SetupReport* report) {
+    TRACE_SCOPE("ApplyReceiverConfig");
+    std::lock_guard<std::mutex> setupLock(setupMutex_);
+    *report = SetupReport();
+    std::vector<int> receiveChannels;
+    for (const auto& chInfo : channels_) if (chInfo.receive) receiveChannels.push_back(chInfo.channel);
+
+    {
+        // The layout a queued or running change leaves behind is not known yet
+        std::lock_guard<std::mutex> lock(reconfigMutex_);
+        if (reconfigRequest_) {
+            report->message = "A previous configuration change is still being applied.";
+            report->errorCode = ERR_BUSY;
+            return false;
+        }
+    }
+    ReceiverLayout applied, target;
+    std::vector<int> listSizes;
+    PublishedLayout(&applied, &listSizes);
+    if (!ResolveProfile(MergeProfile(applied, changes), receiveChannels, listSizes, &target, &report->message)) {
+        report->errorCode = ERR_PARAM;
+        return false;
+    }
+    std::vector<SetupStep> plan = BuildSetupPlan(target, applied, false);
+    if (plan.empty()) {
+        report->success = true;
+        report->message = "Receiver configuration unchanged.";
+        return true;
+    }
+    if (!monitoringActive_.load()) return RunSetupPlan(plan, target, false, report);
+
+    // The reader runs the plan between two cycles, quiescing only the channels it touches
+    auto request = std::make_shared<ReconfigRequest>();
+    request->plan = std::move(plan);
+    request->target = target;
+    std::unique_lock<std::mutex> lock(reconfigMutex_);
+    reconfigRequest_ = request;
+    reconfigPending_.store(true, std::memory_order_release);
+    if (!reconfigCv_.wait_for(lock, std::chrono::milliseconds(RECONFIG_TIMEOUT_MS), [&]() { return request->done; })) {
+        report->errorCode = ERR_BUSY;
+        if (!request->started) {
+            // Not taken yet: withdraw it, so nothing changes behind the caller's back
+            reconfigRequest_.reset();
+            reconfigPending_.store(false, std::memory_order_relaxed);
+            report->message = "Timed out waiting for the reader thread; the change was not applied.";
+            return false;
+        }
+        // Running: it finishes on its own and later calls are refused until then; Layout() shows the outcome
+        report->pending = true;
+        report->message = "The reader thread is still applying the change.";
+        return false;
+    }
+    *report = request->report;
+    return report->success;
+}
+
+// Runs plan on the calling thread and commits each finished channel to layout_. hot: the core keeps running (the
+// reader thread calls this). A channel is stopped (BTI429_ChStop: the others keep running while it is reconfigured)
+// and passed to quiesce only when its own steps begin, and restarted after its last one. If a step fails, that
+// channel is rebuilt to its previous layout, or left stopped if it had none or that fails too.
+bool DeviceSession::RunSetupPlan(const std::vector<SetupStep>& plan, const ReceiverLayout& target, bool hot, SetupReport* report,
+                                 const std::function<void(int)>& quiesce) {
+    if (layout_.channels.size() < target.channels.size()) layout_.channels.resize(target.channels.size());
+    int rebuilding = -1; // Channel whose steps are running; committed to layout_ once the next one starts
+    ChannelProfile previous; // rebuilding's layout before its ChConfig
+    auto stop = [&](int ch) {
+        if (!hot) return;
+        BTI429_ChStop(ch, hCore_);
+        if (quiesce) quiesce(ch);
+    };
+    auto commit = [&]() {
+        if (rebuilding >= 0) {
+            layout_.channels[rebuilding] = target.channels[rebuilding];
+            if (hot) BTI429_ChStart(rebuilding, hCore_);
+        }
+        rebuilding = -1;
+    };
+    auto planStart = std::chrono::steady_clock::now();
+    for (const SetupStep& step : plan) {
+        int ch = step.channel;
+        auto stepStart = std::chrono::steady_clock::now();
+        int result = ERR_NONE;
+        std::string failure;
+        switch (step.kind) {
+            case SetupStepKind::EventLogConfig:
+                result = BTICard_EventLogConfig((USHORT)step.flags, (USHORT)step.value, hCore_);
+                if (result == ERR_NONE) {
+                    layout_.eventLogSize = step.value;
+                } else {
+                    // Not fatal: channels still receive, only list/error/DIO events go missing
+                    BTI_LOG_WARN("Card %d core %d: BTICard_EventLogConfig failed (%d)", cardNum_, coreNum_, result);
+                }
+                break;
+            case SetupStepKind::ChDisable:
+                commit();
+                stop(ch);
+                result = BTI429_ChConfig(step.flags, ch, hCore_);
+                receiveListAddrs_[ch] = 0;
+                receiveMsgAddrs_[ch] = 0;
+                snapshotMsgAddrs_.erase(ch);
+                layout_.channels[ch] = ChannelProfile();
+                break;
+            case SetupStepKind::ChConfig:
+                commit();
+                stop(ch);
+                rebuilding = ch;
+                previous = layout_.channels[ch];
+                layout_.channels[ch] = ChannelProfile(); // Unconfigured until its last step succeeded
+                receiveListAddrs_[ch] = 0;
+                snapshotMsgAddrs_.erase(ch);
+                result = BTI429_ChConfig(step.flags, ch, hCore_);
+                if (result != ERR_NONE) {
+                    const char* errStr = BTICard_ErrDescStr(result, hCore_);
+                    failure = "Failed to configure channel " + std::to_string(ch) + ": " + (errStr ? errStr : "Unknown error");
+                }
+                break;
+            case SetupStepKind::FilterDefault: {
+                MSGADDR msgAddr = BTI429_FilterDefault(step.flags, ch, hCore_);
+                if (msgAddr == 0) {
+                    result = ERR_FAIL;
+                    failure = "Failed to create default filter for channel " + std::to_string(ch);
+                }
+                receiveMsgAddrs_[ch] = msgAddr;
+                break;
+            }
+            case SetupStepKind::ListRcvCreate: {
+                LISTADDR listAddr = BTI429_ListRcvCreate(step.flags, step.value, receiveMsgAddrs_[ch], hCore_);
+                if (listAddr == 0) {
+                    result = ERR_FAIL;
+                    failure = "Failed to create receive list for channel " + std::to_string(ch) + " (linked to default filter)";
+                    break;
+                }
+                receiveListAddrs_[ch] = listAddr;
+                listSizes_[ch] = step.value;
+                if (ChannelStats* chStats = StatsChannel(stats_, ch)) chStats->listSize.store((uint64_t)step.value, std::memory_order_relaxed);
+                break;
+            }
+            case SetupStepKind::FilterSkip:
+                if (BTI429_FilterSet(step.flags, step.value, SDIALL, ch, hCore_) == 0) {
+                    result = ERR_FAIL;
+                    failure = "Failed to set skip filter for label " + std::to_string(step.value) + " on channel " + std::to_string(ch);
+                }
+                break;
+            case SetupStepKind::FilterSnapshot: {
+                MSGADDR msgAddr = BTI429_FilterSet(step.flags, step.value, SDIALL, ch, hCore_);
+                if (msgAddr == 0) {
+                    result = ERR_FAIL;
+                    failure = "Failed to create snapshot record for label " + std::to_string(step.value) + " on channel " + std::to_string(ch);
+                    break;
+                }
+                snapshotMsgAddrs_[ch][step.value] = msgAddr;
+                break;
+            }
+            case SetupStepKind::FilterRestore:
+                for (int sdi = 0; sdi < 4 && result == ERR_NONE; ++sdi) {
+                    result = BTI429_FilterWr(receiveMsgAddrs_[ch], step.value, sdi, ch, hCore_);
+                }
+                if (result != ERR_NONE) {
+                    failure = "Failed to restore filter for label " + std::to_string(step.value) + " on channel " + std::to_string(ch);
+                }
+                break;
+            case SetupStepKind::ListClear:
+                commit();
+                if (receiveListAddrs_[ch] != 0) result = BTI429_ListClear(receiveListAddrs_[ch], hCore_);
+                report->channelsReused++;
+                break;
+        }
+        int64_t stepNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stepStart).count();
+        report->steps.push_back({step.kind, ch, step.value, result, stepNs});
+        if (step.kind == SetupStepKind::ChConfig) report->channelsConfigured++;
+
+        if (!failure.empty()) {
+            BTI_LOG_ERROR("Card %d core %d: %s", cardNum_, coreNum_, failure.c_str());
+            report->message = failure;
+            report->errorCode = result;
+            if (hot && rebuilding >= 0) {
+                // The restore plan starts from the unconfigured profile set above, so it never restores in turn
+                SetupReport restoreReport;
+                bool restored = false;
+                if (previous.channel >= 0) {
+                    ReceiverLayout restore = layout_, attempted = layout_;
+                    restore.channels[rebuilding] = previous;
+                    attempted.channels[rebuilding] = target.channels[rebuilding];
+                    restored = RunSetupPlan(BuildSetupPlan(restore, attempted, false), restore, true, &restoreReport, quiesce);
+                    report->steps.insert(report->steps.end(), restoreReport.steps.begin(), restoreReport.steps.end());
+                }
+                report->message += restored ? "; channel " + std::to_string(rebuilding) + " restored to its previous configuration"
+                                            : "; channel " + std::to_string(rebuilding) + " left stopped";
+                BTI_LOG_WARN("Card %d core %d: channel %d %s after failed reconfiguration", cardNum_, coreNum_, rebuilding,
+                    restored ? "restored" : "left stopped");
+            }
+            report->totalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - planStart).count();
+            PublishLayout();
+            return false;
+        }
+    }
+    commit();
+    PublishLayout();
+    report->totalNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - planStart).count();
+    report->success = true;
+    report->message = std::string(hot ? "Receiver reconfigured while monitoring (" : "Receiver initialized successfully (") +
+        std::to_string(report->channelsConfigured) + " channel(s) configured, " + std::to_string(report->channelsReused) + " reused).";
+    BTI_LOG_INFO("Card %d core %d: receiver setup ran %d step(s) in %.2f ms (%d configured, %d reused%s)", cardNum_, coreNum_,
+        (int)plan.size(), report->totalNs / 1e6, report->channelsConfigured, report->channelsReused, hot ? ", hot" : "");
+    return true;
+}
+
+ReceiverLayout DeviceSession::Layout() {
+    std::lock_guard<std::mutex> lock(layoutMutex_);
+    return publishedLayout_;
+}
+
+void DeviceSession::PublishLayout() {
+    if (layoutInvalid_.exchange(false)) layout_ = ReceiverLayout();
+    std::lock_guard<std::mutex> lock(layoutMutex_);
+    publishedLayout_ = layout_;
+    publishedListSizes_ = listSizes_;
+}
+
+void DeviceSession::PublishedLayout(ReceiverLayout* layout, std::vector<int>* listSizes) {
+    std::lock_guard<std::mutex> lock(layoutMutex_);
+    *layout = publishedLayout_;
+    *listSizes = publishedListSizes_;
+}
+
+void DeviceSession::InvalidateLayout() {
+    std::lock_guard<std::mutex> setupLock(setupMutex_);
+    {
+        std::lock_guard<std::mutex> lock(layoutMutex_);
+        publishedLayout_ = ReceiverLayout();
+    }
+    if (monitoringActive_.load()) {
+        // The reader owns layout_ and still holds the addresses; it will only see errors until a new setup
+        layoutInvalid_.store(true, std::memory_order_release);
+        return;
+    }
+    layout_ = ReceiverLayout();
+    std::fill(receiveListAddrs_.begin(), receiveListAddrs_.end(), 0);
+    std::fill(receiveMsgAddrs_.begin(), receiveMsgAddrs_.end(), 0);
+    snapshotMsgAddrs_.clear();
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    snapshot_.clear();
+}
+
+LISTADDR DeviceSession::CreateReceiveList(int channel, int words, std::string* errorMessage) {
+    // Create Default Filter FIRST; it counts hits so words dropped by a full list can be estimated
+    ULONG records = channel < (int)layout_.channels.size() ? layout_.channels[channel].records : 0;
+    MSGADDR defaultMsgAddr = BTI429_FilterDefault(MSGCRT429_HIT | records, channel, hCore_);
+    if (defaultMsgAddr == 0) {
+        *errorMessage = "Failed to create default filter for channel " + std::to_string(channel);
+        BTI_LOG_ERROR("BTI429_FilterDefault failed for channel %d", channel);
+        return 0;
+    }
+    BTI_LOG_DEBUG("Created default filter for channel %d with msg addr: %lu", channel, (unsigned long)defaultMsgAddr);
+
+    // Create Receive List, passing the message address from the default filter
+    ULONG listFlags = LISTCRT429_FIFO; // Use FIFO mode
+    LISTADDR listAddr = BTI429_ListRcvCreate(listFlags, words, defaultMsgAddr, hCore_);
+    if (listAddr == 0) {
+        *errorMessage = "Failed to create receive list for channel " + std::to_string(channel) + " (linked to default filter)";
+        BTI_LOG_ERROR("BTI429_ListRcvCreate failed for channel %d with flags: %lu msgAddr: %lu words: %d", channel, (unsigned long)listFlags, (unsigned long)defaultMsgAddr, words);
+        return 0;
+    }
+    receiveMsgAddrs_[channel] = defaultMsgAddr;
+    listSizes_[channel] = words;
+    if (ChannelStats* chStats = StatsChannel(stats_, channel)) chStats->listSize.store((uint64_t)words, std::memory_order_relaxed);
+    BTI_LOG_DEBUG("Created %d-word receive list for channel %d linked to msg %lu with list address: %lu", words, channel, (unsigned long)defaultMsgAddr, (unsigned long)listAddr);
+    return listAddr;
+}
+
+void DeviceSession::SetAdaptiveLists(bool enabled, int maxWords) {
+    maxListWords_.store(std::max(LIST_DEFAULT_WORDS, std::min(LIST_LIMIT_WORDS, maxWords)), std::memory_order_relaxed);
+    adaptiveLists_.store(enabled, std::memory_order_relaxed);
+}
+
+void DeviceSession::SetChangeOnly(std::shared_ptr<const ChangeOnlyConfig> config) {
+    std::lock_guard<std::mutex> lock(changeOnlyMutex_);
+    changeOnly_ = std::move(config);
+    changeOnlyVersion_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const ChangeOnlyConfig> DeviceSession::ChangeOnly() {
+    std::lock_guard<std::mutex> lock(changeOnlyMutex_);
+    return changeOnly_;
+}
+
+void DeviceSession::SetAlarms(std::shared_ptr<const AlarmConfig> config) {
+    std::lock_guard<std::mutex> lock(alarmMutex_);
+    alarms_ = std::move(config);
+    alarmVersion_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const AlarmConfig> DeviceSession::Alarms() {
+    std::lock_guard<std::mutex> lock(alarmMutex_);
+    return alarms_;
+}
+
+std::vector<AlarmTransition> DeviceSession::ActiveAlarms() {
+    std::lock_guard<std::mutex> lock(alarmMutex_);
+    return activeAlarms_;
+}
+
+std::vector<SnapshotRecord> DeviceSession::Snapshot() {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return snapshot_;
+}
+
+bool DeviceSession::StartMonitoring(std::string* errorMessage) {
+    if (monitoringActive_.load()) {
+        *errorMessage = "Monitoring is already active.";
+        return false;
+    }
+
+    ERRVAL startResult = BTICard_CardStart(hCore_);
+    if (startResult != ERR_NONE) {
+        const char* errStr = BTICard_ErrDescStr(startResult, hCore_);
+        *errorMessage = std::string("Failed to start card: ") + (errStr ? errStr : "Unknown error");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        watermarkNs_ = HostNowNs();
+    }
+    monitoringActive_.store(true);
+    try {
+        // Ensure previous thread is joined if somehow still exists
+        if (monitorThread_.joinable()) {
+            BTI_LOG_WARN("Previous monitor thread was still joinable. Joining now.");
+            monitorThread_.join();
+        }
+        readerRunning_.store(true);
+        monitorThread_ = std::thread(&DeviceSession::MonitorLoop, this);
+    } catch (const std::exception& e) {
+        readerRunning_.store(false);
+        monitoringActive_.store(false);
+        BTICard_CardStop(hCore_); // Attempt to stop card if thread creation failed
+        *errorMessage = std::string("Failed to start monitoring thread: ") + e.what();
+        return false;
+    }
+
+    Sessions().StartMerger();
+    *errorMessage = "ARINC monitoring started.";
+    return true;
+}
+
+void DeviceSession::StopMonitoring() {
+    bool wasActive = monitoringActive_.exchange(false);
+
+    if (monitorThread_.joinable()) {
+        BTI_LOG_DEBUG("Joining monitor thread (card %d core %d)...", cardNum_, coreNum_);
+        try {
+            monitorThread_.join();
+            BTI_LOG_DEBUG("Monitor thread joined.");
+        } catch (const std::system_error& e) {
+            BTI_LOG_ERROR("Error joining monitor thread: %s (%d)", e.what(), e.code().value());
+            // Proceed with stopping the card anyway
+        }
+    }
+    readerRunning_.store(false);
+    if (layoutInvalid_.load()) PublishLayout(); // Invalidated after the reader's last cycle
+
+    if (wasActive) {
+        // Stop the card
+        BTI_LOG_DEBUG("Stopping BTI Card...");
+        BTICard_CardStop(hCore_);
+        BTI_LOG_INFO("BTI Card stopped.");
+    }
+}
+
+int64_t DeviceSession::WatermarkNs() {
+    if (!readerRunning_.load()) return LLONG_MAX; // Nothing more will arrive; everything pending is final
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    return watermarkNs_;
+}
+
+void DeviceSession::TakeReady(int64_t watermarkNs, std::vector<ArincUpdateData>& out) {
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    while (!pending_.empty() && pending_.front().timestamp_ns <= watermarkNs) {
+        out.push_back(pending_.front());
+        pending_.pop_front();
+    }
+}
+
+// Never blocks: only counts; the merge thread turns the counts into notices
+void DeviceSession::RecordError(int channel, int code, const char* source) {
+    errors_->Record(channel, code, source);
+}
+
+// --- ARINC Monitoring Thread Loop ---
+void DeviceSession::MonitorLoop() {
+    HCORE hCore = hCore_;
+    const int MAX_READ_COUNT = 512; // How many words to read per channel check
+    // Never smaller than a list: a block read may return a full list's worth
+    std::vector<ULONG> readBuffer(MAX_READ_COUNT);
+    for (int words : listSizes_) if (words > (int)readBuffer.size()) readBuffer.resize(words);
+    std::vector<ArincUpdateData> cycleBatch;
+    std::vector<CardEvent> cycleEvents;
+
+    // Per-channel poll schedule (reader thread only)
+    struct ChannelPoll {
+        std::chrono::steady_clock::time_point next;
+        std::chrono::steady_clock::time_point last;
+        int64_t intervalUs = POLL_MIN_INTERVAL_US;
+        double wordsPerUs = 0.0; // Smoothed word rate
+        double peakWordsPerUs = 0.0;
+        // Loss accounting against the default filter's hit count, both counted from the same baseline
+        uint32_t lastHits = 0;
+        uint64_t hits = 0;
+        uint64_t wordsRead = 0;
+        int64_t lost = 0;
+        bool canGrow = true;
+        int resizes = 0;
+    };
+    std::vector<ChannelPoll> polls(receiveListAddrs_.size());
+    auto loopStart = std::chrono::steady_clock::now();
+    for (ChannelPoll& poll : polls) poll.next = poll.last = loopStart;
+    uint32_t lastDemandMask = DemandMask();
+
+    // Hit counts are 32-bit on the card; accumulate wrap-safe deltas
+    auto readHits = [&](int channel, ChannelPoll& poll) -> bool {
+        MSGFIELDS429 fields = {};
+        if (receiveMsgAddrs_[channel] == 0 || BTI429_MsgBlockRd(&fields, receiveMsgAddrs_[channel], hCore) == 0) return false;
+        poll.hits += (uint32_t)(fields.hitcount - poll.lastHits);
+        poll.lastHits = fields.hitcount;
+        return true;
+    };
+    for (int channel = 0; channel < (int)polls.size(); ++channel) {
+        if (receiveListAddrs_[channel] != 0 && readHits(channel, polls[channel])) polls[channel].hits = 0; // Baseline
+    }
+
+    // Report-on-change: what was last passed on per channel/label, reset whenever the rules are replaced
+    struct LastReport {
+        uint32_t maskedWord = 0;
+        int64_t reportNs = 0;
+        bool seen = false;
+    };
+    std::shared_ptr<const ChangeOnlyConfig> changeOnly;
+    uint64_t changeOnlyVersion = changeOnlyVersion_.load(std::memory_order_acquire) - 1; // Fetch on the first cycle
+    std::vector<LastReport> lastReports;
+
+    // Alarms see every word read, ahead of report-on-change; transitions go out at the end of the cycle
+    AlarmEvaluator alarms;
+    uint64_t alarmVersion = alarmVersion_.load(std::memory_order_acquire) - 1;
+    std::vector<AlarmTransition> cycleAlarms;
+
+    auto appendWords = [&](int channel, USHORT count) {
+        const ChangeOnlyRule* rules = changeOnly ? changeOnly->rules[channel] : nullptr;
+        ChannelStats* chStats = StatsChannel(stats_, channel);
+        for (USHORT i = 0; i < count; ++i) {
+            ULONG word = readBuffer[i];
+            int label = BTI429_FldGetLabel(word); // Label is bits 0-7
+            auto now = std::chrono::steady_clock::now();
+
+            // Update map
+            latestWords_[channel][label] = word;
+            lastUpdateTimes_[channel][label] = now;
+
+            int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            if (!alarms.Empty()) alarms.OnWord(channel, word, 0, nowNs, steady_clock_to_epoch_ms(now), &cycleAlarms);
+            if (rules && rules[label].enabled) {
+                const ChangeOnlyRule& rule = rules[label];
+                LastReport& last = lastReports[channel * CHANGE_ONLY_LABELS + label];
+                uint32_t masked = (uint32_t)word & ~rule.ignoreMask;
+                if (last.seen && masked == last.maskedWord &&
+                    (rule.heartbeatNs <= 0 || nowNs - last.reportNs < rule.heartbeatNs)) {
+                    suppressed_[channel * CHANGE_ONLY_LABELS + label].fetch_add(1, std::memory_order_relaxed);
+                    if (chStats) StatsAdd(chStats->wordsSuppressed);
+                    continue;
+                }
+                last.maskedWord = masked;
+                last.reportNs = nowNs;
+                last.seen = true;
+            }
+            cycleBatch.push_back({channel, label, word, steady_clock_to_epoch_ms(now), nowNs, cardNum_, coreNum_});
+        }
+    };
+    std::vector<std::pair<int, int>> listResizes; // channel -> words, applied at the end of the cycle
+
+    // Snapshot records in channel/label order, re-collected after every setup plan the reader runs; a record that
+    // survives the change keeps its last word (its new message starts with a zero timetag)
+    std::vector<MSGADDR> snapshotAddrs;
+    std::vector<SnapshotRecord> snapshotRecords;
+    std::vector<MSGFIELDS429> snapshotFields;
+    auto nextSnapshot = loopStart;
+    auto collectSnapshot = [&]() {
+        std::vector<SnapshotRecord> previous;
+        previous.swap(snapshotRecords);
+        snapshotAddrs.clear();
+        for (const auto& channelEntry : snapshotMsgAddrs_) {
+            for (const auto& labelEntry : channelEntry.second) {
+                SnapshotRecord record = {};
+                record.channel = (uint8_t)channelEntry.first;
+                record.label = (uint8_t)labelEntry.first;
+                auto kept = std::find_if(previous.begin(), previous.end(), [&](const SnapshotRecord& old) {
+                    return old.channel == record.channel && old.label == record.label;
+                });
+                if (kept != previous.end()) record = *kept;
+                snapshotAddrs.push_back(labelEntry.second);
+                snapshotRecords.push_back(record);
+            }
+        }
+        snapshotFields.assign(snapshotAddrs.size(), MSGFIELDS429());
+        std::lock_guard<std::mutex> lock(snapshotMutex_);
+        snapshot_ = snapshotRecords;
+    };
+    collectSnapshot();
+
+    // Last words of a list about to be replaced (the core or channel is stopped by then)
+    auto drainRemaining = [&](int channel, size_t& cycleWords) {
+        USHORT leftover = 0;
+        if (receiveListAddrs_[channel] == 0) return;
+        if (BTI429_ListDataBlkRd(readBuffer.data(), &leftover, receiveListAddrs_[channel], hCore) && leftover > 0) {
+            StatsRecordBlockRead(stats_, channel, leftover);
+            cycleWords += leftover;
+            appendWords(channel, leftover);
+        }
+    };
+    // A channel with a new message and list starts its loss accounting and schedule over
+    auto resetPoll = [&](int channel, std::chrono::steady_clock::time_point now) {
+        ChannelPoll& poll = polls[channel];
+        poll.lastHits = 0;
+        poll.hits = 0;
+        poll.wordsRead = 0;
+        poll.lost = 0;
+        poll.next = poll.last = now;
+        if (listSizes_[channel] > (int)readBuffer.size()) readBuffer.resize(listSizes_[channel]);
+    };
+
+    BTI_LOG_INFO("ARINC Monitor Thread Started (card %d core %d).", cardNum_, coreNum_);
+    TraceSetThreadName(("MonitorLoop card" + std::to_string(cardNum_) + "/core" + std::to_string(coreNum_)).c_str());
+#ifdef _WIN32
+    // Spread session readers across CPUs; a scheduling hint, not a hard affinity
+    unsigned cpuCount = std::thread::hardware_concurrency();
+    if (cpuCount > 1) SetThreadIdealProcessor(GetCurrentThread(), (DWORD)(index_ % cpuCount));
+#endif
+
+    while (monitoringActive_.load()) {
+        bool dataProcessedInCycle = false;
+        auto cycleStart = std::chrono::steady_clock::now();
+        int64_t cycleTraceStartNs = TraceEnabled() ? TraceNowNs() : -1;
+        size_t cycleWords = 0;
+        cycleBatch.clear();
+
+        uint64_t currentChangeOnly = changeOnlyVersion_.load(std::memory_order_acquire);
+        if (currentChangeOnly != changeOnlyVersion) {
+            changeOnly = ChangeOnly();
+            changeOnlyVersion = currentChangeOnly;
+            lastReports.assign(changeOnly ? STATS_MAX_CHANNELS * CHANGE_ONLY_LABELS : 0, LastReport());
+        }
+        uint64_t currentAlarms = alarmVersion_.load(std::memory_order_acquire);
+        if (currentAlarms != alarmVersion) {
+            alarmVersion = currentAlarms;
+            alarms.Reset(Alarms(), HostNowNs());
+            std::lock_guard<std::mutex> lock(alarmMutex_);
+            activeAlarms_.clear();
+        }
+        cycleAlarms.clear();
+
+        // 1. Drain the event log: bursts (list full, decoder errors) must not wait one entry per cycle
+        cycleEvents.clear();
+        INT logStatus;
+        {
+            TRACE_SCOPE("BTICard_EventLogStatus");
+            logStatus = BTICard_EventLogStatus(hCore);
+        }
+        if (logStatus == STAT_FULL) {
+            StatsAdd(stats_.eventLogOverflows); // The card discards entries while the log is full
+            BTI_LOG_WARN("Event log full on card %d core %d; events may have been lost.", cardNum_, coreNum_);
+        }
+        if (logStatus == STAT_PARTIAL || logStatus == STAT_FULL) {
+            TRACE_SCOPE_NAMED(drainTrace, "EventLogDrain");
+            // The log entries carry no time of their own: stamp the batch with one timer read at drain time
+            ULONG timeHigh = 0, timeLow = 0;
+            BTICard_Timer64Rd(&timeHigh, &timeLow, hCore);
+            uint64_t hwTime = ((uint64_t)timeHigh << 32) | timeLow;
+            auto drainTime = std::chrono::steady_clock::now();
+            int64_t drainNs = std::chrono::duration_cast<std::chrono::nanoseconds>(drainTime.time_since_epoch()).count();
+
+            for (int entry = 0; entry < EVENT_LOG_MAX_DRAIN; ++entry) {
+                USHORT eventType = 0;
+                ULONG eventInfo = 0;
+                INT eventChannel = -1;
+                if (BTICard_EventLogRd(&eventType, &eventInfo, &eventChannel, hCore) == 0) break; // Empty
+                cycleEvents.push_back({eventType, eventChannel, (uint32_t)eventInfo, hwTime,
+                    steady_clock_to_epoch_ms(drainTime), drainNs, cardNum_, coreNum_});
+
+                if (eventType == EVENTTYPE_429LIST) { // List full/empty
+                    if (ChannelStats* chStats = StatsChannel(stats_, eventChannel)) StatsAdd(chStats->listEvents);
+                    if (eventChannel >= 0 && eventChannel < (int)polls.size()) polls[eventChannel].next = cycleStart; // Drain it now
+                    BTI_LOG_WARN("ARINC List event on card %d core %d channel %d (Info: %u -> %s)", cardNum_, coreNum_, eventChannel, (unsigned)eventInfo, eventInfo == 0 ? "Empty?" : "Full?");
+                }
+                else if (eventType == EVENTTYPE_429ERR) { // Decoder error
+                    if (ChannelStats* chStats = StatsChannel(stats_, eventChannel)) StatsAdd(chStats->errEvents);
+                    RecordError(eventChannel, ERR_FAIL, "ARINC decoder error (see message activity)");
+                }
+                else if (eventType == EVENTTYPE_DIOEDGE) { // Discrete edge; channel is the DIO bank
+                    dio_->OnEdgeEvent(eventChannel, eventInfo);
+                }
+            }
+            drainTrace.SetArg("entries", cycleEvents.size());
+            if (!cycleEvents.empty()) {
+                dataProcessedInCycle = true; // Consider event log reads as activity
+                StatsAdd(stats_.eventLogEntries, cycleEvents.size());
+                StatsAdd(stats_.eventLogDrains);
+                StatsUpdateMax(stats_.eventLogMaxDrain, (uint64_t)cycleEvents.size());
+                std::vector<CardEvent>* events = new std::vector<CardEvent>(cycleEvents);
+                size_t eventCount = events->size();
+                if (!Sessions().DeliverEvents(events)) StatsAdd(stats_.eventsDropped, eventCount);
+            }
+        }
+
+        // 2. Check the receive lists that are due
+        uint32_t demandMask = DemandMask();
+        if (demandMask != lastDemandMask) {
+            // Newly demanded channels shouldn't wait out their background interval
+            for (int channel = 0; channel < (int)polls.size() && channel < 32; ++channel) {
+                if ((demandMask & ~lastDemandMask) & (1u << channel)) polls[channel].next = cycleStart;
+            }
+            lastDemandMask = demandMask;
+        }
+        for (int channel = 0; channel < (int)receiveListAddrs_.size(); ++channel) {
+            if (!monitoringActive_.load()) break; // Check flag again inside loop
+
+            LISTADDR listAddr = receiveListAddrs_[channel];
+            if (listAddr == 0) continue; // Skip if list wasn't created
+            ChannelPoll& poll = polls[channel];
+            if (cycleStart < poll.next) continue;
+            TRACE_SCOPE_ARG("PollChannel", "channel", channel);
+
+            int listStatus = BTI429_ListStatus(listAddr, hCore);
+            ChannelStats* chStats = StatsChannel(stats_, channel);
+            if (chStats) StatsAdd(chStats->statusPolls);
+            USHORT wordsThisPoll = 0;
+
+            if (listStatus < 0) {
+                // Error checking list status
+                if (chStats) StatsAdd(chStats->statusErrors);
+                RecordError(channel, listStatus, "Error checking list status");
+                continue; // Skip this channel on error
+            }
+
+            if (listStatus == STAT_FULL && chStats) StatsAdd(chStats->listFullCount);
+
+            // A full list holds listSize words; whatever the filter counted beyond those and the words read so far was dropped
+            int64_t lostThisPoll = 0;
+            if (listStatus == STAT_FULL && readHits(channel, poll)) {
+                int64_t lostEstimate = (int64_t)poll.hits - (int64_t)poll.wordsRead - listSizes_[channel];
+                if (lostEstimate > poll.lost) {
+                    lostThisPoll = lostEstimate - poll.lost;
+                    poll.lost = lostEstimate;
+                }
+            }
+
+            if (listStatus == STAT_PARTIAL || listStatus == STAT_FULL) {
+                dataProcessedInCycle = true;
+                USHORT countActuallyRead = 0; // Initialize to 0 before passing address
+                BOOL success = FALSE;
+                {
+                    TRACE_SCOPE_NAMED(blkRdTrace, "BTI429_ListDataBlkRd");
+                    success = BTI429_ListDataBlkRd(readBuffer.data(), &countActuallyRead, listAddr, hCore);
+                    blkRdTrace.SetArg("words", countActuallyRead);
+                }
+
+                if (success && countActuallyRead > 0) {
+                    wordsThisPoll = countActuallyRead;
+                    poll.wordsRead += countActuallyRead;
+                    StatsRecordBlockRead(stats_, channel, countActuallyRead);
+                    cycleWords += countActuallyRead;
+                    appendWords(channel, countActuallyRead);
+                } else if (!success) {
+                    // Handle read failure - check status again?
+                    if (chStats) StatsAdd(chStats->statusErrors);
+                    int postReadStatus = BTI429_ListStatus(listAddr, hCore);
+                    RecordError(channel, (postReadStatus < 0 ? postReadStatus : ERR_FAIL), "Error reading data block (ListDataBlkRd failed)");
+                }
+            }
+
+            if (lostThisPoll > 0) {
+                // Gap marker after the words that did make it, so consumers see where the stream has a hole
+                auto now = std::chrono::steady_clock::now();
+                int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+                cycleBatch.push_back({channel, ARINC_GAP_LABEL, (ULONG)std::min<int64_t>(lostThisPoll, 0xFFFFFFFF),
+                    steady_clock_to_epoch_ms(now), nowNs, cardNum_, coreNum_});
+                if (chStats) {
+                    StatsAdd(chStats->lostWords, (uint64_t)lostThisPoll);
+                    StatsAdd(chStats->gapMarkers);
+                }
+                RecordError(channel, ERR_FAIL, "Receive list overflow: words lost");
+            }
+
+            // Schedule the next poll: follow the word rate on demanded channels, background cadence otherwise
+            int64_t elapsedUs = std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(cycleStart - poll.last).count());
+            poll.wordsPerUs += POLL_RATE_SMOOTHING * ((double)wordsThisPoll / (double)elapsedUs - poll.wordsPerUs);
+            double arrivedPerUs = (double)(wordsThisPoll + lostThisPoll) / (double)elapsedUs; // What the bus delivered, lost words included
+            if (arrivedPerUs > poll.peakWordsPerUs) {
+                poll.peakWordsPerUs = arrivedPerUs;
+                if (chStats) StatsUpdateMax(chStats->peakWordsPerSec, (uint64_t)(arrivedPerUs * 1e6));
+            }
+            poll.last = cycleStart;
+            bool demanded = channel < 32 && (demandMask & (1u << channel));
+            if (!demanded) {
+                poll.intervalUs = POLL_BACKGROUND_INTERVAL_US;
+            } else if (listStatus == STAT_FULL || poll.wordsPerUs * POLL_MIN_INTERVAL_US >= POLL_TARGET_WORDS) {
+                poll.intervalUs = POLL_MIN_INTERVAL_US;
+            } else if (poll.wordsPerUs > 0.0) {
+                poll.intervalUs = std::min(POLL_MAX_INTERVAL_US, (int64_t)(POLL_TARGET_WORDS / poll.wordsPerUs));
+            } else {
+                poll.intervalUs = POLL_MAX_INTERVAL_US;
+            }
+            poll.next = cycleStart + std::chrono::microseconds(poll.intervalUs);
+            if (chStats) chStats->pollIntervalUs.store((uint64_t)poll.intervalUs, std::memory_order_relaxed);
+
+            // Adaptive lists: hold LIST_HEADROOM poll intervals at the peak rate; an overflow at least doubles the list
+            if (AdaptiveLists() && poll.canGrow) {
+                int words = listSizes_[channel];
+                double needed = poll.peakWordsPerUs * (double)poll.intervalUs * LIST_HEADROOM;
+                if (lostThisPoll > 0) needed = std::max(needed, 2.0 * words);
+                int maxWords = MaxListWords();
+                if (needed > (double)words && words < maxWords) {
+                    int target = words;
+                    while ((double)target < needed && target < maxWords) target *= 2;
+                    listResizes.push_back({channel, std::min(target, maxWords)});
+                }
+            }
+        }
+
+        // 2a. Snapshot refresh: every record in a few group reads; a moved timetag means a new word since the last tick
+        if (!snapshotAddrs.empty() && cycleStart >= nextSnapshot && monitoringActive_.load()) {
+            TRACE_SCOPE_ARG("SnapshotRefresh", "records", snapshotAddrs.size());
+            for (size_t first = 0; first < snapshotAddrs.size(); first += SNAPSHOT_GROUP_READ) {
+                int count = (int)std::min<size_t>(SNAPSHOT_GROUP_READ, snapshotAddrs.size() - first);
+                BTI429_MsgGroupBlockRd(&snapshotFields[first], &snapshotAddrs[first], count, hCore);
+                StatsAdd(stats_.snapshotGroupReads);
+            }
+            auto now = std::chrono::steady_clock::now();
+            int64_t nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+            uint64_t updated = 0;
+            for (size_t i = 0; i < snapshotRecords.size(); ++i) {
+                const MSGFIELDS429& fields = snapshotFields[i];
+                SnapshotRecord& record = snapshotRecords[i];
+                uint64_t timetag = ((uint64_t)(uint32_t)fields.timetagh << 32) | (uint32_t)fields.timetag;
+                if (timetag == 0 || timetag == record.timetag) continue;
+                record.word = (uint32_t)fields.msgdata;
+                record.activity = fields.msgact;
+                record.timetag = timetag;
+                record.hostNs = nowNs;
+                record.updates++;
+                updated++;
+                latestWords_[record.channel][record.label] = fields.msgdata;
+                lastUpdateTimes_[record.channel][record.label] = now;
+                if (!alarms.Empty()) alarms.OnWord(record.channel, record.word, timetag, nowNs, steady_clock_to_epoch_ms(now), &cycleAlarms);
+                cycleBatch.push_back({record.channel, record.label, fields.msgdata, steady_clock_to_epoch_ms(now), nowNs, cardNum_, coreNum_});
+            }
+            if (updated > 0) {
+                dataProcessedInCycle = true;
+                cycleWords += updated;
+                StatsAdd(stats_.snapshotUpdates, updated);
+                std::lock_guard<std::mutex> lock(snapshotMutex_);
+                snapshot_ = snapshotRecords;
+            }
+            StatsAdd(stats_.snapshotRefreshes);
+            nextSnapshot = cycleStart + std::chrono::microseconds(SnapshotInterval());
+        }
+
+        // 2b. Re-create lists that proved too small. Only the resized channel stops (BTI429_ChStop: a channel can be
+        // reconfigured while the others run); the driver cannot free a list, so the old one's card memory stays
+        // allocated until the next full setup, which is why resizes per channel are capped.
+        if (!listResizes.empty() && monitoringActive_.load()) {
+            TRACE_SCOPE_ARG("ResizeReceiveLists", "channels", listResizes.size());
+            for (const auto& resize : listResizes) {
+                int channel = resize.first;
+                int oldWords = listSizes_[channel];
+                ChannelPoll& poll = polls[channel];
+                bool wasRunning = BTI429_ChStop(channel, hCore) != FALSE;
+
+                // Words that arrived since this cycle's drain would otherwise stay behind in the old list
+                drainRemaining(channel, cycleWords);
+
+                std::string listError;
+                LISTADDR listAddr = CreateReceiveList(channel, resize.second, &listError);
+                if (listAddr == 0) {
+                    // The default filter may already point at a fresh message: link a list of the old size to it
+                    poll.canGrow = false;
+                    RecordError(channel, ERR_FAIL, "Receive list resize failed (card memory?)");
+                    listAddr = CreateReceiveList(channel, oldWords, &listError);
+                    if (listAddr == 0) RecordError(channel, ERR_FAIL, "Receive list lost after failed resize");
+                } else {
+                    if (ChannelStats* chStats = StatsChannel(stats_, channel)) StatsAdd(chStats->listResizes);
+                    if (channel < (int)layout_.channels.size()) layout_.channels[channel].listWords = resize.second;
+                    if (++poll.resizes >= LIST_MAX_RESIZES) poll.canGrow = false;
+                    BTI_LOG_INFO("Card %d core %d channel %d: receive list grown from %d to %d words (peak %.0f words/s); "
+                        "the old list's %d words of card memory are not released (resize %d of %d).",
+                        cardNum_, coreNum_, channel, oldWords, resize.second, poll.peakWordsPerUs * 1e6, oldWords,
+                        poll.resizes, LIST_MAX_RESIZES);
+                }
+                receiveListAddrs_[channel] = listAddr;
+                resetPoll(channel, cycleStart); // New message, new hit count
+                if (wasRunning) BTI429_ChStart(channel, hCore);
+            }
+            PublishLayout(); // Configuration diffs see every resize of this cycle or none
+            listResizes.clear();
+        }
+
+        // 2c. Hot reconfiguration (ApplyReceiverConfig): a channel in the plan stops only while its own steps run and
+        // is drained first; the others keep receiving into their lists and are drained on the next cycle as usual
+        if (layoutInvalid_.load(std::memory_order_acquire)) PublishLayout();
+        if (reconfigPending_.load(std::memory_order_acquire)) {
+            std::shared_ptr<ReconfigRequest> request;
+            {
+                std::lock_guard<std::mutex> lock(reconfigMutex_);
+                request = reconfigRequest_; // Stays outstanding until done
+                if (request) request->started = true;
+                reconfigPending_.store(false, std::memory_order_relaxed);
+            }
+            if (request) {
+                TRACE_SCOPE_ARG("HotReconfigure", "steps", request->plan.size());
+                std::vector<int> affected;
+                for (const SetupStep& step : request->plan) {
+                    if (step.channel >= 0 && std::find(affected.begin(), affected.end(), step.channel) == affected.end()) {
+                        affected.push_back(step.channel);
+                    }
+                }
+                RunSetupPlan(request->plan, request->target, true, &request->report,
+                    [&](int channel) { drainRemaining(channel, cycleWords); });
+                auto now = std::chrono::steady_clock::now();
+                for (int channel : affected) resetPoll(channel, now);
+                collectSnapshot();
+                {
+                    std::lock_guard<std::mutex> lock(reconfigMutex_);
+                    request->done = true;
+                    if (reconfigRequest_ == request) reconfigRequest_.reset();
+                }
+                reconfigCv_.notify_all();
+            }
+        }
+
+        // 2d. Alarms: staleness, then the cycle's transitions. List words carry no timetag; stamp them with one timer read.
+        if (!alarms.Empty()) {
+            auto now = std::chrono::steady_clock::now();
+            alarms.CheckStale(std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count(),
+                steady_clock_to_epoch_ms(now), &cycleAlarms);
+        }
+        if (!cycleAlarms.empty()) {
+            ULONG timeHigh = 0, timeLow = 0;
+            BTICard_Timer64Rd(&timeHigh, &timeLow, hCore);
+            uint64_t hwTime = ((uint64_t)timeHigh << 32) | timeLow;
+            for (AlarmTransition& transition : cycleAlarms) {
+                if (transition.hwTime == 0) transition.hwTime = hwTime;
+                transition.card = cardNum_;
+                transition.core = coreNum_;
+            }
+            {
+                std::lock_guard<std::mutex> lock(alarmMutex_);
+                activeAlarms_ = alarms.Active();
+                for (AlarmTransition& active : activeAlarms_) {
+                    if (active.hwTime == 0) active.hwTime = hwTime;
+                    active.card = cardNum_;
+                    active.core = coreNum_;
+                }
+            }
+            StatsAdd(stats_.alarmTransitions, cycleAlarms.size());
+            size_t alarmCount = cycleAlarms.size();
+            if (!Sessions().DeliverAlarms(new std::vector<AlarmTransition>(cycleAlarms))) StatsAdd(stats_.alarmsDropped, alarmCount);
+        }
+
+        // 3. Publish the cycle's words to the merge stage, with a watermark no later word can precede
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex_);
+            pending_.insert(pending_.end(), cycleBatch.begin(), cycleBatch.end());
+            watermarkNs_ = HostNowNs();
+        }
+        if (!cycleBatch.empty()) Sessions().NotifyDataReady();
+
+        StatsRecordCycle(stats_, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - cycleStart).count());
+        if (cycleTraceStartNs >= 0) {
+            TraceRecord({"MonitorCycle", 'X', cycleTraceStartNs, TraceNowNs() - cycleTraceStartNs, (int64_t)cycleWords, "words"});
+        }
+
+        // 4. Sleep until the next channel is due; the event log is still checked at least every 10 ms when idle (1 ms if busy)
+        auto wake = cycleStart + std::chrono::milliseconds(dataProcessedInCycle ? 1 : 10);
+        for (int channel = 0; channel < (int)polls.size(); ++channel) {
+            if (receiveListAddrs_[channel] != 0 && polls[channel].next < wake) wake = polls[channel].next;
+        }
+        if (!snapshotAddrs.empty() && nextSnapshot < wake) wake = nextSnapshot;
+        auto minWake = std::chrono::steady_clock::now() + std::chrono::microseconds(POLL_MIN_INTERVAL_US);
+        std::this_thread::sleep_until(std::max(wake, minWake));
+    }
+
+    {
+        // A change that arrived too late is not applied; its caller gets an error instead of waiting it out
+        std::lock_guard<std::mutex> lock(reconfigMutex_);
+        if (reconfigRequest_) {
+            reconfigRequest_->report.message = "Monitoring stopped before the configuration change was applied.";
+            reconfigRequest_->report.errorCode = ERR_BUSY;
+            reconfigRequest_->done = true;
+            reconfigRequest_.reset();
+        }
+        reconfigPending_.store(false, std::memory_order_relaxed);
+    }
+    reconfigCv_.notify_all();
+    BTI_LOG_INFO("ARINC Monitor Thread Exiting (card %d core %d).", cardNum_, coreNum_);
+}
+
+// --- Transmit ---
+
+int DeviceSession::StartTransmit(int channel, uint32_t arincWord, std::string* message) {
+    if (!channels_.empty() && !IsXmtChannel(channel)) {
+        *message = "Error: Channel " + std::to_string(channel) + " is not a transmit channel on this core.";
+        return ERR_PARAM;
+    }
+
+    std::lock_guard<std::mutex> lock(transmitMutex_);
+
+    // Check if already transmitting using find to avoid inserting if not present
+    if (isTransmitting_.count(channel) && isTransmitting_.at(channel)) {
+        BTI_LOG_ERROR("Already transmitting on channel %d", channel);
+        *message = "Error: Already transmitting on channel " + std::to_string(channel);
+        return ERR_BUSY;
+    }
+
+    BTI_LOG_INFO("Attempting to start transmission on channel %d...", channel);
+
+    // 1. Configure Channel for Transmit
+    // Assuming High Speed, Schedule Mode, Even Parity, Active
+    ULONG configFlags = CHCFG429_SCHEDULE | CHCFG429_HIGHSPEED | CHCFG429_PAREVEN | CHCFG429_ACTIVE;
+    BTI_LOG_DEBUG("Calling BTI429_ChConfig(0x%lx, %d, hCore=%p)", (unsigned long)configFlags, channel, (void*)hCore_);
+    ERRVAL configResult = BTI429_ChConfig(configFlags, channel, hCore_);
+    BTI_LOG_DEBUG("BTI429_ChConfig(Transmit) for Ch %d returned: %d", channel, (int)configResult);
+    if (configResult != ERR_NONE) {
+        std::string errorMsg = "Failed to configure channel " + std::to_string(channel) + " for transmit.";
+        BTI_LOG_ERROR("%s BTI Code: %d", errorMsg.c_str(), (int)configResult);
+        *message = errorMsg + " BTI Code: " + std::to_string(configResult);
+        return configResult;
+    }
+
+    // 2. Create Message Record
+    ULONG msgCreateFlags = MSGCRT429_DEFAULT; // Simple flags
+    BTI_LOG_DEBUG("Calling BTI429_MsgCreate(0x%lx, hCore=%p)", (unsigned long)msgCreateFlags, (void*)hCore_);
+    MSGADDR msgAddr = BTI429_MsgCreate(msgCreateFlags, hCore_);
+    BTI_LOG_DEBUG("BTI429_MsgCreate for Ch %d returned MSGADDR: %lu", channel, (unsigned long)msgAddr);
+    if (msgAddr == 0) {
+        std::string errorMsg = "Failed to create message record for channel " + std::to_string(channel) + ".";
+        BTI_LOG_ERROR("%s", errorMsg.c_str());
+        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCore_); // Attempt cleanup
+        *message = errorMsg;
+        return ERR_FAIL; // Generic failure for now
+    }
+    transmitMsgAddr_[channel] = msgAddr; // Store only on success
+
+    // 3. Create Transmit List (Circular, size 2 for 1 entry + loop)
+    ULONG listCreateFlags = LISTCRT429_CIRCULAR; // Circular mode
+    BTI_LOG_DEBUG("Calling BTI429_ListXmtCreate(0x%lx, Count=2, MsgAddr=%lu, hCore=%p)", (unsigned long)listCreateFlags, (unsigned long)msgAddr, (void*)hCore_);
+    LISTADDR listAddr = BTI429_ListXmtCreate(listCreateFlags, 2, msgAddr, hCore_);
+    BTI_LOG_DEBUG("BTI429_ListXmtCreate for Ch %d returned LISTADDR: %lu", channel, (unsigned long)listAddr);
+    if (listAddr == 0) {
+        std::string errorMsg = "Failed to create transmit list for channel " + std::to_string(channel) + ".";
+        BTI_LOG_ERROR("%s", errorMsg.c_str());
+        // TODO: Add BTI429_MsgRelease(msgAddr, hCore_) if available
+        transmitMsgAddr_.erase(channel);
+        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCore_); // Attempt cleanup
+        *message = errorMsg;
+        return ERR_FAIL; // Generic failure
+    }
+    transmitListAddr_[channel] = listAddr; // Store only on success
+
+    // 4. Write Word to List
+    BTI_LOG_DEBUG("Calling BTI429_ListDataWr(Word=0x%08x, ListAddr=%lu, hCore=%p)", (unsigned)arincWord, (unsigned long)listAddr, (void*)hCore_);
+    BOOL writeResult = BTI429_ListDataWr(arincWord, listAddr, hCore_);
+    BTI_LOG_DEBUG("BTI429_ListDataWr for Ch %d returned: %d", channel, (int)writeResult);
+    if (!writeResult) {
+        std::string errorMsg = "Failed to write data to transmit list for channel " + std::to_string(channel) + ".";
+        BTI_LOG_ERROR("%s", errorMsg.c_str());
+        // TODO: Add BTI429_ListRelease(listAddr, hCore_) if available
+        // TODO: Add BTI429_MsgRelease(msgAddr, hCore_) if available
+        transmitListAddr_.erase(channel);
+        transmitMsgAddr_.erase(channel);
+        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCore_); // Attempt cleanup
+        *message = errorMsg;
+        return ERR_FAIL; // Generic failure
+    }
+
+    // 5. Add Message/List to Schedule
+    BTI_LOG_DEBUG("Calling BTI429_SchedMsg(MsgAddr=%lu, Channel=%d, hCore=%p)", (unsigned long)msgAddr, channel, (void*)hCore_);
+    SCHNDX schedIndex = BTI429_SchedMsg(msgAddr, channel, hCore_);
+    BTI_LOG_DEBUG("BTI429_SchedMsg for Ch %d returned index: %d", channel, (int)schedIndex);
+    if (schedIndex < 0) {
+        ERRVAL err = schedIndex; // SchedMsg returns error code directly
+        std::string errorMsg = "Failed to schedule message for channel " + std::to_string(channel) + ".";
+        BTI_LOG_ERROR("%s BTI Code: %d", errorMsg.c_str(), (int)err);
+        // TODO: Add BTI429_ListRelease(listAddr, hCore_) if available
+        // TODO: Add BTI429_MsgRelease(msgAddr, hCore_) if available
+        transmitListAddr_.erase(channel);
+        transmitMsgAddr_.erase(channel);
+        BTI429_ChConfig(CHCFG429_INACTIVE, channel, hCore_); // Attempt cleanup
+        *message = errorMsg + " BTI Code: " + std::to_string(err);
+        return err;
+    }
+
+    // 6. Mark as transmitting (CardStart should already be active from receiver)
+    isTransmitting_[channel] = true;
+    BTI_LOG_INFO("Transmission successfully started on channel %d", channel);
+    *message = "Transmission started successfully on channel " + std::to_string(channel);
+    return ERR_NONE;
+}
+
+int DeviceSession::StopTransmit(int channel, std::string* message) {
+    std::lock_guard<std::mutex> lock(transmitMutex_);
+
+    // Check if we were actually transmitting on this channel
+    if (!isTransmitting_.count(channel) || !isTransmitting_.at(channel)) {
+        BTI_LOG_WARN("StopTransmit called for channel %d which is not marked as transmitting.", channel);
+        *message = "Warning: Channel " + std::to_string(channel) + " was not transmitting.";
+        return ERR_NONE; // Not an error, just wasn't transmitting
+    }
+
+    BTI_LOG_INFO("Attempting to stop transmission on channel %d...", channel);
+
+    // 1. Deactivate/Reconfigure the channel to stop transmission and release resources
+    //    Using CHCFG429_INACTIVE is simplest. Assumes receiver setup will handle re-enabling receive if needed.
+    ULONG inactiveFlags = CHCFG429_INACTIVE;
+    BTI_LOG_DEBUG("Calling BTI429_ChConfig(0x%lx, %d, hCore=%p) to stop transmission.", (unsigned long)inactiveFlags, channel, (void*)hCore_);
+    ERRVAL configResult = BTI429_ChConfig(inactiveFlags, channel, hCore_);
+    BTI_LOG_DEBUG("BTI429_ChConfig(Inactive) for Ch %d returned: %d", channel, (int)configResult);
+
+    // TODO: Explicitly release list/msg if BTI functions exist?
+
+    // 2. Clear internal state regardless of ChConfig result, as we are stopping logically
+    isTransmitting_.erase(channel);
+    transmitMsgAddr_.erase(channel);
+    transmitListAddr_.erase(channel);
+
+    if (configResult != ERR_NONE) {
+        // Log the error, but still report logical success to JS, as we cleared internal state
+        std::string errorMsg = "Error during ChConfig(Inactive) on channel " + std::to_string(channel) + ".";
+        BTI_LOG_WARN("%s BTI Code: %d", errorMsg.c_str(), (int)configResult);
+        *message = "Transmission stopped on channel " + std::to_string(channel) + " (with potential ChConfig warning: " + std::to_string(configResult) + ")";
+    } else {
+        BTI_LOG_INFO("Transmission stopped successfully on channel %d", channel);
+        *message = "Transmission stopped successfully on channel " + std::to_string(channel);
+    }
+    return ERR_NONE; // Report logical success
+}
+
+// --- SessionRegistry ---
+
+SessionRegistry& Sessions() {
+    static SessionRegistry* registry = new SessionRegistry(); // Never destroyed: threads may outlive static teardown
+    return *registry;
+}
+
+DeviceSession* SessionRegistry::Open(int cardNum, int coreNum, ERRVAL* result, std::string* errorMessage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& session : sessions_) {
+        if (session->CardNum() == cardNum && session->CoreNum() == coreNum) {
+            *result = ERR_NONE;
+            *errorMessage = "Hardware already initialized.";
+            return session.get();
+        }
+    }
+
+    HCARD hCard = nullptr;
+    auto cardIt = cards_.find(cardNum);
+    if (cardIt != cards_.end()) {
+        hCard = cardIt->second;
+    } else {
+        *result = BTICard_CardOpen(&hCard, cardNum);
+        if (*result != ERR_NONE || hCard == nullptr) {
+            const char* errStr = BTICard_ErrDescStr(*result, nullptr);
+            *errorMessage = errStr ? errStr : "Failed to open card.";
+            return nullptr;
+        }
+        cards_[cardNum] = hCard;
+    }
+
+    HCORE hCore = nullptr;
+    *result = BTICard_CoreOpen(&hCore, coreNum, hCard);
+    if (*result != ERR_NONE || hCore == nullptr) {
+        const char* errStr = BTICard_ErrDescStr(*result, hCard);
+        *errorMessage = errStr ? errStr : "Failed to open core.";
+        // Keep the card handle; it is closed by CloseAll
+        return nullptr;
+    }
+
+    // Optional Reset
+    BTICard_CardReset(hCore);
+
+    sessions_.push_back(std::make_unique<DeviceSession>(nextIndex_++, cardNum, coreNum, hCard, hCore));
+    DeviceSession* session = sessions_.back().get();
+    session->Discover();
+    if (defaultAlarms_) session->SetAlarms(defaultAlarms_);
+    ApplyDemand(session);
+    *result = ERR_NONE;
+    *errorMessage = "Hardware initialized successfully.";
+    return session;
+}
+
+DeviceSession* SessionRegistry::Find(HCORE hCore) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& session : sessions_) {
+        if (session->Core() == hCore) return session.get();
+    }
+    return nullptr;
+}
+
+DeviceSession* SessionRegistry::Default() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_.empty() ? nullptr : sessions_.front().get();
+}
+
+std::vector<DeviceSession*> SessionRegistry::All() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DeviceSession*> all;
+    for (auto& session : sessions_) all.push_back(session.get());
+    return all;
+}
+
+void SessionRegistry::WithSessions(const std::function<void(const std::vector<DeviceSession*>&)>& fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<DeviceSession*> all;
+    for (auto& session : sessions_) all.push_back(session.get());
+    fn(all);
+}
+
+void SessionRegistry::ApplyDemand(DeviceSession* session) {
+    uint32_t mask = 0;
+    for (const auto& entry : demands_) {
+        const ChannelDemand& demand = entry.second;
+        if (demand.card >= 0 && demand.card != session->CardNum()) continue;
+        if (demand.core >= 0 && demand.core != session->CoreNum()) continue;
+        mask |= demand.channelMask == 0 ? 0xFFFFFFFFu : demand.channelMask;
+    }
+    session->SetDemandMask(mask);
+}
+
+void SessionRegistry::SetDemand(const void* owner, int card, int core, uint32_t channelMask) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    demands_[owner] = ChannelDemand{card, core, channelMask};
+    for (auto& session : sessions_) ApplyDemand(session.get());
+}
+
+void SessionRegistry::ClearDemand(const void* owner) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (demands_.erase(owner) == 0) return;
+    for (auto& session : sessions_) ApplyDemand(session.get());
+}
+
+void SessionRegistry::SetAlarms(DeviceSession* session, std::shared_ptr<const AlarmConfig> config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t channelMask = config ? config->channelMask : 0;
+    if (session) {
+        session->SetAlarms(config);
+        demands_.erase(session);
+        if (channelMask) demands_[session] = ChannelDemand{session->CardNum(), session->CoreNum(), channelMask};
+    } else {
+        defaultAlarms_ = config;
+        for (auto& open : sessions_) {
+            open->SetAlarms(config);
+            demands_.erase(open.get());
+        }
+        demands_.erase(&defaultAlarms_);
+        if (channelMask) demands_[&defaultAlarms_] = ChannelDemand{-1, -1, channelMask};
+    }
+    for (auto& open : sessions_) ApplyDemand(open.get());
+}
+
+bool SessionRegistry::AnyMonitoring() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& session : sessions_) {
+        if (session->IsMonitoring()) return true;
+    }
+    return false;
+}
+
+ERRVAL SessionRegistry::CloseAll(std::string* errorMessage) {
+    for (DeviceSession* session : All()) {
+        session->Dio().Stop();
+        session->StopMonitoring();
+    }
+    StopMerger();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ERRVAL firstError = ERR_NONE;
+    for (auto& session : sessions_) demands_.erase(session.get()); // Its alarm rules go with it
+    sessions_.clear();
+    for (auto& card : cards_) {
+        BTI_LOG_INFO("CleanupHardware: Closing card %d...", card.first);
+        ERRVAL closeResult = BTICard_CardClose(card.second);
+        if (closeResult != ERR_NONE && firstError == ERR_NONE) {
+            const char* errStr = BTICard_ErrDescStr(closeResult, card.second);
+            *errorMessage = std::string("Error closing card: ") + (errStr ? errStr : "Unknown error");
+            firstError = closeResult;
+        }
+    }
+    cards_.clear();
+    nextIndex_ = 0;
+    return firstError;
+}
+
+void SessionRegistry::SetSinks(UpdateBatchSink updateSink, ErrorSink errorSink, void* context) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    updateSink_ = updateSink;
+    errorSink_ = errorSink;
+    sinkContext_ = context;
+}
+
+void SessionRegistry::ReportError(ArincErrorData* error) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    if (errorSink_) {
+        errorSink_(sinkContext_, error);
+    } else {
+        delete error;
+    }
+}
+
+void SessionRegistry::SetEventSink(EventBatchSink sink, void* context) {
+    std::lock_guard<std::mutex> lock(eventSinkMutex_);
+    eventSink_ = sink;
+    eventSinkContext_ = context;
+}
+
+void SessionRegistry::ClearEventSink(void* context) {
+    std::lock_guard<std::mutex> lock(eventSinkMutex_);
+    if (eventSinkContext_ != context) return;
+    eventSink_ = nullptr;
+    eventSinkContext_ = nullptr;
+}
+
+bool SessionRegistry::DeliverEvents(std::vector<CardEvent>* batch) {
+    std::lock_guard<std::mutex> lock(eventSinkMutex_);
+    if (eventSink_ && eventSink_(eventSinkContext_, batch)) return true;
+    delete batch;
+    return eventSink_ == nullptr; // No consumer is not a loss
+}
+
+void SessionRegistry::SetAlarmSink(AlarmBatchSink sink, void* context) {
+    std::lock_guard<std::mutex> lock(alarmSinkMutex_);
+    alarmSink_ = sink;
+    alarmSinkContext_ = context;
+}
+
+void SessionRegistry::ClearAlarmSink(void* context) {
+    std::lock_guard<std::mutex> lock(alarmSinkMutex_);
+    if (alarmSinkContext_ != context) return;
+    alarmSink_ = nullptr;
+    alarmSinkContext_ = nullptr;
+}
+
+bool SessionRegistry::DeliverAlarms(std::vector<AlarmTransition>* batch) {
+    std::lock_guard<std::mutex> lock(alarmSinkMutex_);
+    if (alarmSink_ && alarmSink_(alarmSinkContext_, batch)) return true;
+    delete batch;
+    return alarmSink_ == nullptr;
+}
+
+void SessionRegistry::DeliverExternal(std::vector<ArincUpdateData>* batch) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    if (batchTransform_) batchTransform_(batchTransformContext_, *batch);
+    if (batchTick_ && !batch->empty()) batchTick_(batchTransformContext_, batch->back().timestamp_ns, *batch);
+    for (const auto& tap : batchTaps_) tap.first(tap.second, *batch);
+    if (updateSink_) {
+        updateSink_(sinkContext_, batch);
+    } else {
+        delete batch;
+    }
+}
+
+void SessionRegistry::AddBatchTap(BatchTap tap, void* context) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    batchTaps_.emplace_back(tap, context);
+}
+
+void SessionRegistry::RemoveBatchTap(BatchTap tap, void* context) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    batchTaps_.erase(std::remove(batchTaps_.begin(), batchTaps_.end(), std::make_pair(tap, context)), batchTaps_.end());
+}
+
+void SessionRegistry::SetBatchTransform(BatchTransform transform, void* context, BatchTick tick) {
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    batchTransform_ = transform;
+    batchTransformContext_ = context;
+    batchTick_ = transform ? tick : nullptr;
+}
+
+void SessionRegistry::StartMerger() {
+    std::lock_guard<std::mutex> lock(mergeThreadMutex_);
+    if (mergeRunning_.load()) return;
+    mergeRunning_.store(true);
+    mergeThread_ = std::thread(&SessionRegistry::MergeLoop, this);
+}
+
+void SessionRegistry::StopMerger() {
+    {
+        std::lock_guard<std::mutex> lock(mergeThreadMutex_);
+        if (!mergeRunning_.load()) return;
+        mergeRunning_.store(false);
+    }
+    mergeCv_.notify_all();
+    if (mergeThread_.joinable()) mergeThread_.join(); // The loop flushes everything pending before exiting
+}
+
+// Emits every pending word at or below the minimum watermark of all running readers, in timestamp order, then ticks
+// the transform at that watermark
+void SessionRegistry::MergeOnce(bool flushAll, std::vector<ArincUpdateData>& merged) {
+    merged.clear();
+    size_t contributors = 0;
+    int64_t watermark = LLONG_MAX;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!flushAll) {
+            for (auto& session : sessions_) watermark = std::min(watermark, session->WatermarkNs());
+        }
+        for (auto& session : sessions_) {
+            size_t before = merged.size();
+            session->TakeReady(watermark, merged);
+            if (merged.size() != before) ++contributors;
+        }
+    }
+    // No running reader: nothing to tick at, and nothing left to emit once pending is empty
+    bool tick = watermark != LLONG_MAX && watermark > 0;
+    if (merged.empty() && !tick) return;
+
+    // Each session's run is already ordered; only interleave when more than one core contributed
+    if (contributors > 1) {
+        TRACE_SCOPE_ARG("MergeSort", "words", merged.size());
+        std::stable_sort(merged.begin(), merged.end(),
+            [](const ArincUpdateData& a, const ArincUpdateData& b) { return a.timestamp_ns < b.timestamp_ns; });
+    }
+
+    std::lock_guard<std::mutex> lock(sinkMutex_);
+    if (batchTransform_ && !merged.empty()) batchTransform_(batchTransformContext_, merged);
+    if (batchTick_ && tick) batchTick_(batchTransformContext_, watermark, merged);
+    if (merged.empty()) return;
+    for (const auto& tap : batchTaps_) tap.first(tap.second, merged);
+    if (updateSink_) {
+        updateSink_(sinkContext_, new std::vector<ArincUpdateData>(std::move(merged)));
+        merged.clear();
+    }
+}
+
+// Turns every session's error counts into the notices that are due and hands them to the error sink
+void SessionRegistry::CollectErrors() {
+    std::vector<ArincErrorData*> notices;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& session : sessions_) session->Errors().Collect(&notices);
+    }
+    for (ArincErrorData* notice : notices) ReportError(notice);
+}
+
+void SessionRegistry::MergeLoop() {
+    TraceSetThreadName("StreamMerge");
+    std::vector<ArincUpdateData> merged;
+    auto nextErrorCollect = std::chrono::steady_clock::now();
+    while (mergeRunning_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(mergeThreadMutex_);
+            mergeCv_.wait_for(lock, std::chrono::milliseconds(2));
+        }
+        MergeOnce(false, merged);
+        auto now = std::chrono::steady_clock::now();
+        if (now >= nextErrorCollect) {
+            CollectErrors();
+            nextErrorCollect = now + std::chrono::milliseconds(ERROR_COLLECT_INTERVAL_MS);
+        }
+    }
+    MergeOnce(true, merged);
+    CollectErrors();
+}
@@ -0,0 +1,424 @@
+#ifndef DEVICE_SESSION_H
+#define DEVICE_SESSION_H
+
+// One DeviceSession per opened BTI core. A session discovers its channels, owns its receive lists,
+// filters, transmit state, stats and reader thread. The SessionRegistry opens cards/cores, keeps
+// sessions keyed by core handle, and merges every session's words into one timestamp-ordered
+// stream that is handed to a single delivery sink (the JS data callback).
+// This layer has no N-API dependency and is process-wide; addon.cpp installs the sinks of the one
+// JS environment that owns the stream.
+
+#include "BTICARD.H"
+#include "BTI429.H"
+#include "alarm_engine.h"
+#include "bti_constants.h"
+#include "monitor_stats.h"
+#include "receiver_profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// --- Define Custom Error Codes (Negative to avoid BTI conflicts) ---
+const int ERR_HWINIT = -1001; // Custom: Hardware not initialized
+const int ERR_PARAM = -1002; // Custom: Invalid parameter passed
+const int ERR_BUSY = -1003;  // Custom: Resource/channel already busy
+const int ERR_INFO = 0; // Placeholder if info is treated like success
+
+// Helper structure for passing data to JS callbacks
+struct ArincUpdateData {
+    int channel;
+    int label;
+    ULONG word;
+    long long timestamp_ms; // Use epoch ms
+    int64_t timestamp_ns;   // Host steady-clock ns; the merge key across cores
+    int card;
+    int core;
+};
+
+// Gap marker in the word stream: `word` receivers lost on `channel` (their receive list was full) since the
+// previous marker of that channel. Placed after the words drained by the poll that detected the loss.
+const int ARINC_GAP_LABEL = -1;
+
+inline bool IsGapMarker(const ArincUpdateData& update) { return update.label == ARINC_GAP_LABEL; }
+
+// Derived parameter value (derived_params.h) in the word stream: a virtual card whose channel/label spell the
+// parameter id (id >> 8, id & 0xFF) and whose word holds the value as IEEE-754 float bits
+const int DERIVED_CARD = 0x7F;
+
+inline bool IsDerivedValue(const ArincUpdateData& update) { return update.card == DERIVED_CARD; }
+
+// Recorded DIO edge (DioMonitorConfig::recordEdges) in the word stream: a channel outside every real channel range,
+// label = DIO number, word bit 31 = new level and bits 0-30 = low bits of the card timer. Not label data: consumers
+// of ARINC values skip it like gap markers and derived values; captures and EveryWord subscribers keep it.
+const int DIO_CAPTURE_CHANNEL = 255;
+
+inline bool IsDioEdge(const ArincUpdateData& update) { return update.channel == DIO_CAPTURE_CHANNEL; }
+
+// What an error notification stands for; reader-side errors are aggregated (see ErrorAggregator)
+enum class ErrorNotice {
+    Single,   // One occurrence (daemon and capture client errors)
+    Raised,   // A (channel, code) started failing
+    Summary,  // It kept failing; count = occurrences since the previous notice
+    Cleared   // It stopped failing; count = occurrences in the whole episode
+};
+
+struct ArincErrorData {
+    int channel = -1; // Use -1 or similar for global errors
+    int status_code;
+    std::string message;
+    int card = -1;
+    int core = -1;
+    ErrorNotice notice = ErrorNotice::Single;
+    uint64_t count = 1;
+};
+
+// One decoded event log entry (BTICard_EventLogRd). Entries carry no time of their own: hwTime is the card's
+// Timer64 and timestamp_* the host time, both read once when the batch was drained.
+struct CardEvent {
+    USHORT type;   // EVENTTYPE_*
+    int channel;   // Channel, DIO bank... depending on type
+    uint32_t info; // Type-specific info word
+    uint64_t hwTime;
+    long long timestamp_ms;
+    int64_t timestamp_ns;
+    int card;
+    int core;
+};
+
+// Sinks take ownership of the heap-allocated argument; context is the pointer passed to SetSinks
+typedef void (*UpdateBatchSink)(void* context, std::vector<ArincUpdateData>* batch);
+typedef void (*ErrorSink)(void* context, ArincErrorData* error);
+// Taps only observe the batch, on the delivering thread (merge thread or capture client), before the sink gets it
+typedef void (*BatchTap)(void* context, const std::vector<ArincUpdateData>& batch);
+// Runs on the delivering thread before the taps and the sink, and may rewrite the batch (derived parameters)
+typedef void (*BatchTransform)(void* context, std::vector<ArincUpdateData>& batch);
+// Runs after the transform with the time the stream has reached, also when no word arrived, and may append to the
+// batch updates stamped at or before nowNs (derived parameters that read age())
+typedef void (*BatchTick)(void* context, int64_t nowNs, std::vector<ArincUpdateData>& batch);
+// Returns false if the batch could not be queued (it is then still owned, and freed, by the caller)
+typedef bool (*EventBatchSink)(void* context, std::vector<CardEvent>* batch);
+typedef bool (*AlarmBatchSink)(void* context, std::vector<AlarmTransition>* batch);
+
+struct ChannelInfo {
+    int channel;
+    bool receive;
+    bool transmit;
+};
+
+// Report-on-change: the reader drops a word whose value (outside ignoreMask) equals the last one it passed on for
+// that channel/label, unless heartbeatNs has elapsed since then. Applies to everything downstream of the session.
+const int CHANGE_ONLY_LABELS = 256;
+
+struct ChangeOnlyRule {
+    bool enabled = false;
+    uint32_t ignoreMask = 0;    // Bits left out of the comparison (e.g. parity)
+    int64_t heartbeatNs = 0;    // Pass an unchanged word on after this long; 0 = never
+};
+
+struct ChangeOnlyConfig {
+    ChangeOnlyRule rules[STATS_MAX_CHANNELS][CHANGE_ONLY_LABELS];
+};
+
+// Card-resident snapshot (ChannelProfile::snapshotLabels): one entry per snapshot message record, refreshed by the
+// reader with BTI429_MsgGroupBlockRd every snapshot interval. The card keeps one timetag/hit-count field per record,
+// so a refresh tells a new word by its timetag having moved; `updates` counts the refreshes that found one.
+const int SNAPSHOT_DEFAULT_INTERVAL_US = 50000;
+const int SNAPSHOT_MIN_INTERVAL_US = 1000;
+const int SNAPSHOT_GROUP_READ = 128;     // Records per MsgGroupBlockRd call
+
+#pragma pack(push, 1)
+struct SnapshotRecord {
+    uint32_t word;                       // Latest word (0 until the label was first seen)
+    uint8_t channel;
+    uint8_t label;
+    uint16_t activity;                   // MSGACT429_* of the latest word
+    uint64_t timetag;                    // Card timetag of the latest word (timetagh:timetag), 0 = never received
+    int64_t hostNs;                      // HostNowNs() of the refresh that first saw it
+    uint32_t updates;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+class DioMonitor;
+class ErrorAggregator;
+
+long long steady_clock_to_epoch_ms(const std::chrono::steady_clock::time_point& tp);
+int64_t HostNowNs();
+
+class DeviceSession {
+public:
+    DeviceSession(int index, int cardNum, int coreNum, HCARD hCard, HCORE hCore);
+    ~DeviceSession();
+
+    DeviceSession(const DeviceSession&) = delete;
+    DeviceSession& operator=(const DeviceSession&) = delete;
+
+    int Index() const { return index_; }
+    int CardNum() const { return cardNum_; }
+    int CoreNum() const { return coreNum_; }
+    HCARD Card() const { return hCard_; }
+    HCORE Core() const { return hCore_; }
+
+    // Channel discovery (BTI429_ChGetCount / ChIsRcv / ChIsXmt)
+    void Discover();
+    const std::vector<ChannelInfo>& Channels() const { return channels_; }
+    int ChannelCount() const { return (int)channels_.size(); }
+    bool IsRcvChannel(int channel) const;
+    bool IsXmtChannel(int channel) const;
+
+    // Receiver setup: event log, channel config, default filter and receive list per receive channel.
+    // ApplyReceiverProfile only runs the steps that differ from the layout the card already has (see receiver_profile.h);
+    // ConfigureReceivers applies the default profile. While monitoring, only a profile that changes nothing is accepted.
+    bool ApplyReceiverProfile(const ReceiverProfile& profile, SetupReport* report);
+    // Partial change (see MergeProfile) that may be applied while monitoring: the reader thread stops, re-programs
+    // and restarts only the channels whose configuration differs; the others keep streaming. Waits for the result:
+    // on a timeout a change the reader has not taken is withdrawn, a running one is reported pending. One change at
+    // a time; another is refused with ERR_BUSY until the outstanding one is done.
+    bool ApplyReceiverConfig(const ReceiverProfile& changes, SetupReport* report);
+    bool ConfigureReceivers(std::string* errorMessage, int* errorCode);
+    // The layout as of the last finished setup plan or list resize
+    ReceiverLayout Layout();
+    // The card was reset behind the session's back: its lists and filters are gone
+    void InvalidateLayout();
+
+    // Adaptive receive lists: when a channel's peak rate (or an overflow) shows its list can't absorb one poll
+    // interval with headroom, the reader thread stops that channel briefly and re-creates a larger list, up to maxWords
+    // and LIST_MAX_RESIZES times. Replaced lists stay allocated on the card until the next reset.
+    void SetAdaptiveLists(bool enabled, int maxWords);
+    bool AdaptiveLists() const { return adaptiveLists_.load(std::memory_order_relaxed); }
+    int MaxListWords() const { return maxListWords_.load(std::memory_order_relaxed); }
+
+    // Reader thread control; StartMonitoring also starts the core (BTICard_CardStart)
+    bool StartMonitoring(std::string* errorMessage);
+    void StopMonitoring();
+    bool IsMonitoring() const { return monitoringActive_.load(); }
+
+    // Transmit; returns ERR_NONE or an error/status code and fills message
+    int StartTransmit(int channel, uint32_t arincWord, std::string* message);
+    int StopTransmit(int channel, std::string* message);
+
+    MonitorStats& Stats() { return stats_; }
+
+    // Discrete edge monitor; the reader thread forwards its EVENTTYPE_DIOEDGE log entries to it
+    DioMonitor& Dio() { return *dio_; }
+    // Reader-side error counters; the merge thread collects their notices
+    ErrorAggregator& Errors() { return *errors_; }
+
+    // Report-on-change rules (null = every word is passed on); takes effect on the reader's next cycle
+    void SetChangeOnly(std::shared_ptr<const ChangeOnlyConfig> config);
+    std::shared_ptr<const ChangeOnlyConfig> ChangeOnly();
+    // Repeats dropped for channel/label since the session opened (wraps)
+    uint32_t SuppressedRepeats(int channel, int label) const {
+        return suppressed_[channel * CHANGE_ONLY_LABELS + label].load(std::memory_order_relaxed);
+    }
+
+    // Alarm rules (null = none); takes effect on the reader's next cycle, with every alarm cleared and staleness
+    // counted from then. ActiveAlarms() is the raising transition of each alarm active after the reader's last cycle.
+    void SetAlarms(std::shared_ptr<const AlarmConfig> config);
+    std::shared_ptr<const AlarmConfig> Alarms();
+    std::vector<AlarmTransition> ActiveAlarms();
+
+    // Snapshot records as of the reader's last refresh, in channel/label order
+    std::vector<SnapshotRecord> Snapshot();
+    void SetSnapshotInterval(int intervalUs) {
+        snapshotIntervalUs_.store(std::max(SNAPSHOT_MIN_INTERVAL_US, intervalUs), std::memory_order_relaxed);
+    }
+    int SnapshotInterval() const { return snapshotIntervalUs_.load(std::memory_order_relaxed); }
+
+    // Channels some consumer needs (bit per channel); set by the registry from the registered demands.
+    // Undemanded receive channels are only polled at the background cadence.
+    void SetDemandMask(uint32_t mask) { demandMask_.store(mask, std::memory_order_relaxed); }
+    uint32_t DemandMask() const { return demandMask_.load(std::memory_order_relaxed); }
+
+    // Merge-stage interface (called by the registry's merge thread)
+    int64_t WatermarkNs();
+    void TakeReady(int64_t watermarkNs, std::vector<ArincUpdateData>& out);
+
+private:
+    void MonitorLoop();
+    void RecordError(int channel, int code, const char* source);
+    // Default filter (hit counting) plus a FIFO receive list of `words` on channel; 0 on failure
+    LISTADDR CreateReceiveList(int channel, int words, std::string* errorMessage);
+    // hot: quiesce(channel) runs once the channel is stopped, before its first step
+    bool RunSetupPlan(const std::vector<SetupStep>& plan, const ReceiverLayout& target, bool hot, SetupReport* report,
+                      const std::function<void(int)>& quiesce = nullptr);
+    // Copies layout_/listSizes_ for other threads; called by their writer once they are consistent
+    void PublishLayout();
+    void PublishedLayout(ReceiverLayout* layout, std::vector<int>* listSizes);
+
+    const int index_;
+    const int cardNum_;
+    const int coreNum_;
+    const HCARD hCard_;
+    const HCORE hCore_;
+
+    std::vector<ChannelInfo> channels_;
+    std::vector<LISTADDR> receiveListAddrs_; // Indexed by channel number, 0 = no list
+    std::vector<MSGADDR> receiveMsgAddrs_;   // Default filter message per channel (its hit count feeds loss estimates)
+    std::vector<int> listSizes_;             // Receive list capacity in words per channel (same threads as layout_)
+    std::map<int, std::map<int, MSGADDR>> snapshotMsgAddrs_; // channel -> label -> snapshot message (same threads as layout_)
+    ReceiverLayout layout_;                  // What the card is configured as (JS thread, or the reader while it monitors)
+    std::mutex setupMutex_;                  // Serializes ApplyReceiverProfile / ApplyReceiverConfig / InvalidateLayout
+    // layout_ and listSizes_ as other threads see them; plans are diffed against this copy, never the working one
+    std::mutex layoutMutex_;
+    ReceiverLayout publishedLayout_;
+    std::vector<int> publishedListSizes_;
+    std::atomic<bool> layoutInvalid_{false}; // InvalidateLayout while monitoring: the reader resets layout_
+
+    // Hot reconfiguration handed to the reader thread
+    struct ReconfigRequest {
+        std::vector<SetupStep> plan;
+        ReceiverLayout target;
+        SetupReport report;
+        bool started = false;                // Guarded by reconfigMutex_; the reader took it and will finish it
+        bool done = false;                   // Guarded by reconfigMutex_
+    };
+    std::mutex reconfigMutex_;
+    std::condition_variable reconfigCv_;
+    std::shared_ptr<ReconfigRequest> reconfigRequest_; // Outstanding until done; at most one
+    std::atomic<bool> reconfigPending_{false};
+    std::atomic<bool> adaptiveLists_{false};
+    std::atomic<int> maxListWords_;
+
+    std::atomic<bool> monitoringActive_{false};
+    std::atomic<bool> readerRunning_{false}; // True from thread start until it has been joined
+    std::atomic<uint32_t> demandMask_{0};
+    std::thread monitorThread_;
+    MonitorStats stats_;
+    std::unique_ptr<DioMonitor> dio_;
+    std::unique_ptr<ErrorAggregator> errors_;
+    std::mutex changeOnlyMutex_;
+    std::shared_ptr<const ChangeOnlyConfig> changeOnly_;
+    std::atomic<uint64_t> changeOnlyVersion_{0};
+    std::unique_ptr<std::atomic<uint32_t>[]> suppressed_; // [channel * CHANGE_ONLY_LABELS + label]
+    std::mutex alarmMutex_;
+    std::shared_ptr<const AlarmConfig> alarms_;
+    std::atomic<uint64_t> alarmVersion_{0};
+    std::vector<AlarmTransition> activeAlarms_;  // Published by the reader when a cycle raised or cleared any
+    std::atomic<int> snapshotIntervalUs_{SNAPSHOT_DEFAULT_INTERVAL_US};
+    std::mutex snapshotMutex_;
+    std::vector<SnapshotRecord> snapshot_;   // Published by the reader after each refresh
+    std::map<int, std::map<int, ULONG>> latestWords_; // channel -> label -> word (reader thread only)
+    std::map<int, std::map<int, std::chrono::steady_clock::time_point>> lastUpdateTimes_; // channel -> label -> timestamp
+
+    // Words read but not yet taken by the merge thread; ordered by timestamp_ns within the session
+    std::mutex pendingMutex_;
+    std::deque<ArincUpdateData> pending_;
+    int64_t watermarkNs_ = 0; // No word read after this point will carry an earlier timestamp
+
+    // Transmit state
+    std::mutex transmitMutex_;
+    std::map<int, bool> isTransmitting_;
+    std::map<int, MSGADDR> transmitMsgAddr_;
+    std::map<int, LISTADDR> transmitListAddr_;
+};
+
+class SessionRegistry {
+public:
+    // Opens (or returns the already-open) session for cardNum/coreNum. Cards are opened once and shared by their cores.
+    DeviceSession* Open(int cardNum, int coreNum, ERRVAL* result, std::string* errorMessage);
+    DeviceSession* Find(HCORE hCore);
+    DeviceSession* Default(); // First session opened (the legacy single-core API targets it)
+    std::vector<DeviceSession*> All();
+    // Runs fn with every session while holding the registry lock, so a background thread can't race CloseAll
+    void WithSessions(const std::function<void(const std::vector<DeviceSession*>&)>& fn);
+    bool AnyMonitoring();
+
+    // Channel demand: each consumer (stream owner, subscriber, value table...) registers the channels it needs
+    // under its own owner key; channelMask 0 means all channels, card/core -1 any. Sessions poll the union.
+    void SetDemand(const void* owner, int card, int core, uint32_t channelMask);
+    void ClearDemand(const void* owner);
+
+    // Alarm rules (null = none) for one session, or with a null session for every open session and each one opened
+    // later, replacing their own. Demands the channels the rules read, so lazily polled channels are still checked.
+    void SetAlarms(DeviceSession* session, std::shared_ptr<const AlarmConfig> config);
+
+    // Stops every session and the merge thread, then closes all cores' cards. Returns the first close error.
+    ERRVAL CloseAll(std::string* errorMessage);
+
+    // Waits for any in-flight sink call, so the previous sinks' resources can be released on return
+    void SetSinks(UpdateBatchSink updateSink, ErrorSink errorSink, void* context);
+    void ReportError(ArincErrorData* error);
+    // Hands a batch from a source outside the registry (the capture daemon client) to the update sink
+    void DeliverExternal(std::vector<ArincUpdateData>* batch);
+    // Observers of every delivered batch, independent of the sink (value table, subscriber bus); same waiting rule as SetSinks
+    void AddBatchTap(BatchTap tap, void* context);
+    void RemoveBatchTap(BatchTap tap, void* context);
+    // At most one transform (null to remove) and its optional tick; same waiting rule as SetSinks. The merge thread
+    // ticks at its watermark on every pass; an external batch ticks at its last word.
+    void SetBatchTransform(BatchTransform transform, void* context, BatchTick tick = nullptr);
+    // Typed event log stream, one batch per reader cycle that drained entries; same waiting rule as SetSinks.
+    // ClearEventSink only clears the sink if it is still the one installed with context.
+    void SetEventSink(EventBatchSink sink, void* context);
+    void ClearEventSink(void* context);
+    // Returns false if a sink was installed but did not accept the batch (the events are lost)
+    bool DeliverEvents(std::vector<CardEvent>* batch);
+    // Alarm transitions, one batch per reader cycle that had any; same rules as the event sink
+    void SetAlarmSink(AlarmBatchSink sink, void* context);
+    void ClearAlarmSink(void* context);
+    bool DeliverAlarms(std::vector<AlarmTransition>* batch);
+
+    // Merge thread: started with the first monitoring session, stopped when none remain
+    void StartMerger();
+    void StopMerger();
+    void NotifyDataReady() { mergeCv_.notify_one(); }
+
+private:
+    void MergeLoop();
+    void MergeOnce(bool flushAll, std::vector<ArincUpdateData>& merged);
+    void CollectErrors();
+
+    std::mutex mutex_; // Guards sessions_ and cards_
+    std::vector<std::unique_ptr<DeviceSession>> sessions_;
+    std::map<int, HCARD> cards_; // cardNum -> handle
+    int nextIndex_ = 0;
+
+    struct ChannelDemand {
+        int card;
+        int core;
+        uint32_t channelMask;
+    };
+    std::map<const void*, ChannelDemand> demands_; // Guarded by mutex_
+    void ApplyDemand(DeviceSession* session); // Caller holds mutex_
+    // Rules given for every session (guarded by mutex_); their demand is keyed by this member, a session's own rules'
+    // by the session
+    std::shared_ptr<const AlarmConfig> defaultAlarms_;
+
+    std::mutex sinkMutex_;
+    UpdateBatchSink updateSink_ = nullptr;
+    ErrorSink errorSink_ = nullptr;
+    void* sinkContext_ = nullptr;
+    std::vector<std::pair<BatchTap, void*>> batchTaps_;
+    BatchTransform batchTransform_ = nullptr;
+    void* batchTransformContext_ = nullptr;
+    BatchTick batchTick_ = nullptr;
+    // Reader-side sinks have their own lock: the merge thread holds sinkMutex_ through the transform, taps and the
+    // update sink, and a reader must never wait on those
+    std::mutex eventSinkMutex_;
+    EventBatchSink eventSink_ = nullptr;
+    void* eventSinkContext_ = nullptr;
+    std::mutex alarmSinkMutex_; // Separate from the event sink's, so an event burst does not delay an alarm
+    AlarmBatchSink alarmSink_ = nullptr;
+    void* alarmSinkContext_ = nullptr;
+
+    std::mutex mergeThreadMutex_;
+    std::condition_variable mergeCv_;
+    std::atomic<bool> mergeRunning_{false};
+    std::thread mergeThread_;
+};
+
+SessionRegistry& Sessions();
+
+#endif // DEVICE_SESSION_H
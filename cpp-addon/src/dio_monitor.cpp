@@ -0,0 +1,323 @@
+#include "dio_monitor.h"
+#include "device_session.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// --- DIO Monitor Timing ---
+const int DIO_MIN_SAMPLE_INTERVAL_US = 100;
+const int DIO_CARD_IDLE_MS = 5;          // Monitor thread period while the card reports edges
+const int DIO_RESYNC_INTERVAL_MS = 100;  // Card mode: re-read states to catch edges the log missed
+const int DIO_BANK_SIZE = 8;             // ExtDIOMonConfig masks cover 8 discretes per bank
+const double DIO_PERIOD_SMOOTHING = 0.2; // EWMA weight of the newest period
+
+namespace {
+int BankOf(int dionum) { return (dionum - 1) / DIO_BANK_SIZE; }
+int BitOf(int dionum) { return (dionum - 1) % DIO_BANK_SIZE; }
+}
+
+DioMonitor::DioMonitor(int cardNum, int coreNum, HCORE hCore, const std::atomic<bool>* coreRunning)
+    : cardNum_(cardNum), coreNum_(coreNum), hCore_(hCore), coreRunning_(coreRunning) {
+    for (int i = 0; i < DIO_MAX_DISCRETES; ++i) {
+        rising_[i].store(0);
+        falling_[i].store(0);
+    }
+}
+
+DioMonitor::~DioMonitor() {
+    Stop();
+}
+
+bool DioMonitor::Start(const DioMonitorConfig& config, DioEdgeSink sink, void* context, std::string* errorMessage) {
+    if (running_.load()) {
+        *errorMessage = "DIO monitor is already running.";
+        return false;
+    }
+    if (config.dionums.empty() || (int)config.dionums.size() > DIO_MAX_DISCRETES) {
+        *errorMessage = "DIO monitor needs 1 to " + std::to_string(DIO_MAX_DISCRETES) + " discretes.";
+        return false;
+    }
+    for (int dionum : config.dionums) {
+        if (dionum < 1 || dionum > DIO_BANK_SIZE * 4) {
+            *errorMessage = "Invalid DIO number " + std::to_string(dionum) + ".";
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_); // The reader may still be in OnEdgeEvent from a previous run
+        config_ = config;
+        config_.sampleIntervalUs = std::max(config.sampleIntervalUs, DIO_MIN_SAMPLE_INTERVAL_US);
+    }
+    sink_ = sink;
+    sinkContext_ = context;
+    for (int i = 0; i < DIO_MAX_DISCRETES; ++i) {
+        rising_[i].store(0);
+        falling_[i].store(0);
+    }
+    unresolvedEvents_.store(0);
+
+    // Arm card edge monitoring per bank; a card without DIO monitoring falls back to sampling
+    bool cardEvents = false;
+    if (config_.mode != DioMonitorMode::Sampler) {
+        USHORT bankMasks[4] = {0, 0, 0, 0};
+        for (int dionum : config_.dionums) bankMasks[BankOf(dionum)] |= (USHORT)(1u << BitOf(dionum));
+        cardEvents = true;
+        if (!coreRunning_->load()) {
+            BTICard_EventLogConfig(LOGCFG_ENABLE, 1024, hCore_); // The reader enables it too when receivers are configured
+        }
+        for (int bank = 0; bank < 4 && cardEvents; ++bank) {
+            if (bankMasks[bank] == 0) continue;
+            ERRVAL result = BTICard_ExtDIOMonConfig(bankMasks[bank], bankMasks[bank], bank, hCore_);
+            if (result != ERR_NONE) {
+                const char* errStr = BTICard_ErrDescStr(result, hCore_);
+                BTI_LOG_WARN("ExtDIOMonConfig bank %d failed on card %d core %d: %s", bank, cardNum_, coreNum_,
+                    errStr ? errStr : "Unknown error");
+                cardEvents = false;
+            }
+        }
+        if (!cardEvents) {
+            for (int bank = 0; bank < 4; ++bank) {
+                if (bankMasks[bank] != 0) BTICard_ExtDIOMonConfig(0, 0, bank, hCore_);
+            }
+            if (config_.mode == DioMonitorMode::CardEvents) {
+                *errorMessage = "Card does not support DIO edge monitoring.";
+                return false;
+            }
+        }
+    }
+    cardEvents_.store(cardEvents);
+
+    uint64_t hwTime = 0;
+    uint32_t allMask = config_.dionums.size() >= 32 ? 0xFFFFFFFFu : ((1u << config_.dionums.size()) - 1);
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        state_.store(ReadStates(allMask, &hwTime));
+        stateValid_.store(true);
+        for (size_t i = 0; i < config_.dionums.size(); ++i) {
+            PulseState& pulse = pulses_[i];
+            pulse = PulseState();
+            std::memset(&pulse.record, 0, sizeof(pulse.record));
+            pulse.record.index = (uint8_t)i;
+            pulse.record.dionum = (uint8_t)config_.dionums[i];
+            pulse.record.level = (state_.load() >> i) & 1;
+        }
+    }
+
+    running_.store(true);
+    try {
+        thread_ = std::thread(&DioMonitor::MonitorLoop, this);
+    } catch (const std::exception& e) {
+        running_.store(false);
+        *errorMessage = std::string("Failed to start DIO monitor thread: ") + e.what();
+        return false;
+    }
+    BTI_LOG_INFO("DIO monitor started on card %d core %d (%s, %d discretes).", cardNum_, coreNum_,
+        cardEvents ? "card edge events" : "sampler", (int)config_.dionums.size());
+    *errorMessage = cardEvents ? "DIO monitor started (card edge events)." : "DIO monitor started (sampler).";
+    return true;
+}
+
+void DioMonitor::Stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    if (cardEvents_.exchange(false)) {
+        std::vector<int> banks;
+        for (int dionum : config_.dionums) {
+            if (std::find(banks.begin(), banks.end(), BankOf(dionum)) == banks.end()) banks.push_back(BankOf(dionum));
+        }
+        for (int bank : banks) BTICard_ExtDIOMonConfig(0, 0, bank, hCore_);
+    }
+    sampling_.store(false);
+    stateValid_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pending_.clear();
+    }
+    BTI_LOG_INFO("DIO monitor stopped on card %d core %d.", cardNum_, coreNum_);
+}
+
+DioMonitorStatus DioMonitor::Status() {
+    DioMonitorStatus status;
+    status.running = running_.load();
+    status.cardEvents = cardEvents_.load();
+    status.sampling = sampling_.load();
+    status.stateMask = state_.load();
+    status.stateValid = stateValid_.load();
+    if (status.running) {
+        status.dionums = config_.dionums;
+        for (size_t i = 0; i < config_.dionums.size(); ++i) {
+            status.risingEdges.push_back(rising_[i].load(std::memory_order_relaxed));
+            status.fallingEdges.push_back(falling_[i].load(std::memory_order_relaxed));
+        }
+    }
+    status.unresolvedEvents = unresolvedEvents_.load(std::memory_order_relaxed);
+    return status;
+}
+
+std::vector<DioPulseRecord> DioMonitor::PulseStats() {
+    std::vector<DioPulseRecord> records;
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (!running_.load()) return records;
+    for (size_t i = 0; i < config_.dionums.size(); ++i) {
+        DioPulseRecord record = pulses_[i].record;
+        record.risingEdges = rising_[i].load(std::memory_order_relaxed);
+        record.fallingEdges = falling_[i].load(std::memory_order_relaxed);
+        records.push_back(record);
+    }
+    return records;
+}
+
+// Reads the discretes selected by onlyMask (bit per configured index); the others keep their cached state
+uint32_t DioMonitor::ReadStates(uint32_t onlyMask, uint64_t* hwTime) {
+    TRACE_SCOPE("DioReadStates");
+    ULONG timeHigh = 0, timeLow = 0;
+    BTICard_Timer64Rd(&timeHigh, &timeLow, hCore_);
+    *hwTime = ((uint64_t)timeHigh << 32) | timeLow;
+
+    uint32_t states = state_.load(std::memory_order_relaxed) & ~onlyMask;
+    for (size_t i = 0; i < config_.dionums.size(); ++i) {
+        if (!(onlyMask & (1u << i))) continue;
+        if (BTICard_ExtDIORd(config_.dionums[i], hCore_)) states |= 1u << i;
+    }
+    return states;
+}
+
+// Caller holds stateMutex_
+void DioMonitor::EmitChanges(uint32_t readMask, uint32_t states, uint64_t hwTime, DioEdgeSource source) {
+    uint32_t changed = (states ^ state_.load(std::memory_order_relaxed)) & readMask;
+    state_.store(states, std::memory_order_release);
+    if (changed == 0) return;
+
+    auto now = std::chrono::steady_clock::now();
+    long long epochMs = steady_clock_to_epoch_ms(now);
+    int64_t hostNs = HostNowNs();
+    std::lock_guard<std::mutex> lock(pendingMutex_);
+    for (size_t i = 0; i < config_.dionums.size(); ++i) {
+        if (!(changed & (1u << i))) continue;
+        bool rising = (states & (1u << i)) != 0;
+        StatsAdd(rising ? rising_[i] : falling_[i]);
+        UpdatePulse(i, rising, hostNs);
+        pending_.push_back(DioEdgeEvent{(int)i, config_.dionums[i], rising, source, hwTime, epochMs, hostNs, cardNum_, coreNum_});
+    }
+}
+
+// An edge ends the pulse that started at the previous edge: a falling edge ends a high pulse, a rising one a low pulse
+void DioMonitor::UpdatePulse(size_t index, bool rising, int64_t hostNs) {
+    PulseState& pulse = pulses_[index];
+    DioPulseRecord& record = pulse.record;
+    record.level = rising ? 1 : 0;
+    if (pulse.lastEdgeNs != 0) {
+        double widthUs = (double)(hostNs - pulse.lastEdgeNs) / 1000.0;
+        bool endedHigh = !rising;
+        int bucket = widthUs < 1.0 ? 0 : std::min((int)std::log2(widthUs), DIO_PULSE_BUCKETS - 1);
+        (endedHigh ? record.highHistogram : record.lowHistogram)[bucket]++;
+        double& minUs = endedHigh ? record.minHighUs : record.minLowUs;
+        double& maxUs = endedHigh ? record.maxHighUs : record.maxLowUs;
+        if (minUs == 0.0 || widthUs < minUs) minUs = widthUs;
+        if (widthUs > maxUs) maxUs = widthUs;
+        if (widthUs < config_.glitchUs) {
+            record.glitches++;
+            pulse.lastRisingNs = 0; // The period around a glitch is not a real period
+        } else {
+            (endedHigh ? record.lastHighUs : record.lastLowUs) = widthUs;
+        }
+    }
+    pulse.lastEdgeNs = hostNs;
+    if (!rising) return;
+
+    if (pulse.lastRisingNs != 0) {
+        double periodUs = (double)(hostNs - pulse.lastRisingNs) / 1000.0;
+        record.periodUs = record.periodUs == 0.0 ? periodUs
+            : record.periodUs + DIO_PERIOD_SMOOTHING * (periodUs - record.periodUs);
+        record.frequencyHz = 1e6 / record.periodUs;
+        record.dutyCycle = std::min(1.0, record.lastHighUs / periodUs);
+    }
+    pulse.lastRisingNs = hostNs;
+}
+
+void DioMonitor::OnEdgeEvent(int bank, ULONG info) {
+    TRACE_SCOPE_ARG("DioEdgeEvent", "bank", bank);
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (!running_.load() || !cardEvents_.load()) return;
+    uint32_t bankMask = 0;
+    for (size_t i = 0; i < config_.dionums.size(); ++i) {
+        if (BankOf(config_.dionums[i]) == bank) bankMask |= 1u << i;
+    }
+    if (bankMask == 0) return;
+
+    uint64_t hwTime = 0;
+    uint32_t states = ReadStates(bankMask, &hwTime);
+    if (((states ^ state_.load(std::memory_order_relaxed)) & bankMask) == 0) {
+        StatsAdd(unresolvedEvents_); // The pulse ended before the read; the edge pair cancelled out
+        BTI_LOG_DEBUG("Unresolved DIO edge on card %d core %d bank %d (info 0x%lx).", cardNum_, coreNum_, bank, (unsigned long)info);
+        return;
+    }
+    EmitChanges(bankMask, states, hwTime, DioEdgeSource::CardEvent);
+}
+
+void DioMonitor::Flush() {
+    std::vector<DioEdgeEvent>* batch = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        if (pending_.empty()) return;
+        batch = new std::vector<DioEdgeEvent>();
+        batch->swap(pending_);
+    }
+    TRACE_SCOPE_ARG("DioFlush", "edges", batch->size());
+    if (config_.recordEdges) {
+        // Edge as a word: label = DIO number, bit 31 = new level, bits 0-30 = low bits of the card timer
+        std::vector<ArincUpdateData>* words = new std::vector<ArincUpdateData>();
+        words->reserve(batch->size());
+        for (const DioEdgeEvent& edge : *batch) {
+            ULONG word = (edge.rising ? 0x80000000u : 0u) | (ULONG)(edge.hwTime & 0x7FFFFFFFu);
+            words->push_back(ArincUpdateData{DIO_CAPTURE_CHANNEL, edge.dionum, word, edge.timestamp_ms, edge.timestamp_ns, edge.card, edge.core});
+        }
+        Sessions().DeliverExternal(words);
+    }
+    if (sink_) sink_(sinkContext_, batch);
+    else delete batch;
+}
+
+// --- DIO Monitor Thread ---
+// While the core runs and the card reports edges, the session reader forwards them and this thread only resyncs
+// and flushes; otherwise it samples every sampleIntervalUs.
+void DioMonitor::MonitorLoop() {
+    TraceSetThreadName(("DioMonitor card" + std::to_string(cardNum_) + "/core" + std::to_string(coreNum_)).c_str());
+    const uint32_t allMask = config_.dionums.size() >= 32 ? 0xFFFFFFFFu : ((1u << config_.dionums.size()) - 1);
+    const auto sampleInterval = std::chrono::microseconds(config_.sampleIntervalUs);
+    auto lastResync = std::chrono::steady_clock::now();
+    auto next = lastResync;
+
+    while (running_.load()) {
+        auto now = std::chrono::steady_clock::now();
+        bool cardMode = cardEvents_.load() && coreRunning_->load();
+        sampling_.store(!cardMode);
+
+        if (!cardMode || now - lastResync >= std::chrono::milliseconds(DIO_RESYNC_INTERVAL_MS)) {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            uint64_t hwTime = 0;
+            uint32_t states = ReadStates(allMask, &hwTime);
+            EmitChanges(allMask, states, hwTime, cardMode ? DioEdgeSource::Resync : DioEdgeSource::Sampler);
+            lastResync = now;
+        }
+        Flush();
+
+        if (cardMode) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(DIO_CARD_IDLE_MS));
+            next = std::chrono::steady_clock::now();
+        } else {
+            next += sampleInterval;
+            now = std::chrono::steady_clock::now();
+            if (next < now) next = now; // Don't burst to catch up after a stall
+            else if (config_.sampleIntervalUs >= 1000) std::this_thread::sleep_until(next);
+            else {
+                while (std::chrono::steady_clock::now() < next && running_.load()) std::this_thread::yield(); // Sleep granularity is ~1 ms
+            }
+        }
+    }
+    Flush();
+}
@@ -0,0 +1,156 @@
+#ifndef DIO_MONITOR_H
+#define DIO_MONITOR_H
+
+// Edge detection on a core's external discretes. Where the card supports it, BTICard_ExtDIOMonConfig arms
+// rising/falling edge monitoring and the session's reader thread hands EVENTTYPE_DIOEDGE log entries to
+// OnEdgeEvent. When the card can't monitor, or its core isn't running (the event log is only read while the
+// session monitors), the monitor's own thread samples the discretes at a fixed rate instead. Either way edges are
+// timestamped with the card's 64-bit timer when detected, batched, and handed to a sink; the current state is
+// cached so reading it costs no driver call.
+// Every edge also feeds per-discrete pulse statistics (high/low widths, period, frequency, duty cycle, glitches),
+// measured on the host steady clock at detection, so their resolution is the sample interval or event latency.
+
+#include "BTICARD.H"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const int DIO_MAX_DISCRETES = 16;
+const int DIO_PULSE_BUCKETS = 16;    // Pulse-width histogram: bucket k counts widths in [2^k, 2^(k+1)) us, the last is open-ended
+
+enum class DioMonitorMode {
+    Auto,        // Card edge monitoring when ExtDIOMonConfig succeeds, sampler otherwise
+    CardEvents,  // Require card edge monitoring
+    Sampler      // Always sample
+};
+
+enum class DioEdgeSource : uint8_t {
+    CardEvent = 0, // EVENTTYPE_DIOEDGE log entry
+    Sampler = 1,   // Native sampling sweep
+    Resync = 2     // Periodic check in card mode found a state the event log did not report
+};
+
+struct DioEdgeEvent {
+    int index;          // Position in the configured discrete list
+    int dionum;         // BTICard_ExtDIO* numbering
+    bool rising;
+    DioEdgeSource source;
+    uint64_t hwTime;    // BTICard_Timer64Rd value when the edge was detected
+    long long timestamp_ms; // Host epoch ms
+    int64_t timestamp_ns;   // Host steady-clock ns (same clock as ArincUpdateData)
+    int card;
+    int core;
+};
+
+struct DioMonitorConfig {
+    std::vector<int> dionums = {1, 2, 3, 4, 9, 10, 11, 12};
+    DioMonitorMode mode = DioMonitorMode::Auto;
+    int sampleIntervalUs = 1000;   // Sampler period; below 1000 the sampler spins instead of sleeping (costs a core)
+    int glitchUs = 1000;           // High or low pulses shorter than this count as glitches, not as periods
+    bool recordEdges = false;      // Also inject edges into the word stream (see IsDioEdge in device_session.h)
+};
+
+// Pulse statistics of one discrete, one packed record per configured discrete (little-endian, 224 bytes).
+// Widths and periods exclude glitches; min/max/histograms cover every completed pulse since Start.
+#pragma pack(push, 1)
+struct DioPulseRecord {
+    uint8_t index;
+    uint8_t dionum;
+    uint8_t level;          // Current state, 1 = on
+    uint8_t reserved0;
+    uint32_t glitches;
+    uint64_t risingEdges;
+    uint64_t fallingEdges;
+    double lastHighUs;      // Width of the last completed high (on) pulse
+    double lastLowUs;
+    double periodUs;        // Smoothed rising-to-rising interval, 0 until two rising edges were seen
+    double frequencyHz;     // 1e6 / periodUs
+    double dutyCycle;       // High share of the last full period, 0..1
+    double minHighUs;
+    double maxHighUs;
+    double minLowUs;
+    double maxLowUs;
+    uint32_t highHistogram[DIO_PULSE_BUCKETS];
+    uint32_t lowHistogram[DIO_PULSE_BUCKETS];
+};
+#pragma pack(pop)
+static_assert(sizeof(DioPulseRecord) == 224, "DioPulseRecord is a wire format; keep it 224 bytes");
+
+// Takes ownership of the batch
+typedef void (*DioEdgeSink)(void* context, std::vector<DioEdgeEvent>* edges);
+
+struct DioMonitorStatus {
+    bool running = false;
+    bool cardEvents = false;       // Card edge monitoring armed (used whenever the core is running)
+    bool sampling = false;         // Sampler currently active
+    uint32_t stateMask = 0;        // Bit per configured discrete, 1 = on
+    bool stateValid = false;
+    std::vector<int> dionums;
+    std::vector<uint64_t> risingEdges;
+    std::vector<uint64_t> fallingEdges;
+    uint64_t unresolvedEvents = 0; // Card edge events whose pulse was gone before the state could be read
+};
+
+class DioMonitor {
+public:
+    DioMonitor(int cardNum, int coreNum, HCORE hCore, const std::atomic<bool>* coreRunning);
+    ~DioMonitor();
+
+    DioMonitor(const DioMonitor&) = delete;
+    DioMonitor& operator=(const DioMonitor&) = delete;
+
+    bool Start(const DioMonitorConfig& config, DioEdgeSink sink, void* context, std::string* errorMessage);
+    // On return the sink will not be called again
+    void Stop();
+    bool IsRunning() const { return running_.load(); }
+    DioMonitorStatus Status();
+    // One record per configured discrete; empty when not running
+    std::vector<DioPulseRecord> PulseStats();
+
+    // Reader thread: an EVENTTYPE_DIOEDGE entry for bank `bank`
+    void OnEdgeEvent(int bank, ULONG info);
+
+private:
+    void MonitorLoop();
+    uint32_t ReadStates(uint32_t onlyMask, uint64_t* hwTime);
+    void EmitChanges(uint32_t readMask, uint32_t states, uint64_t hwTime, DioEdgeSource source);
+    void UpdatePulse(size_t index, bool rising, int64_t hostNs); // Caller holds stateMutex_
+    void Flush();
+
+    const int cardNum_;
+    const int coreNum_;
+    const HCORE hCore_;
+    const std::atomic<bool>* coreRunning_; // The owning session's monitoring flag
+
+    DioMonitorConfig config_;
+    DioEdgeSink sink_ = nullptr;
+    void* sinkContext_ = nullptr;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> cardEvents_{false};
+    std::atomic<bool> sampling_{false};
+    std::thread thread_;
+
+    std::mutex stateMutex_; // Serializes state diffs between the reader thread and the monitor thread
+    std::atomic<uint32_t> state_{0};
+    std::atomic<bool> stateValid_{false};
+    std::atomic<uint64_t> rising_[DIO_MAX_DISCRETES];
+    std::atomic<uint64_t> falling_[DIO_MAX_DISCRETES];
+    std::atomic<uint64_t> unresolvedEvents_{0};
+
+    struct PulseState {
+        DioPulseRecord record;
+        int64_t lastEdgeNs = 0;   // 0 = no edge seen yet
+        int64_t lastRisingNs = 0;
+    };
+    PulseState pulses_[DIO_MAX_DISCRETES]; // Guarded by stateMutex_
+
+    std::mutex pendingMutex_;
+    std::vector<DioEdgeEvent> pending_;
+};
+
+#endif // DIO_MONITOR_H
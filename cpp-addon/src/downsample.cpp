@@ -0,0 +1,158 @@
+#include "downsample.h"
+#include "capture_file.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <numeric>
+
+void AppendSeries(const SeriesSelector& selector, const std::vector<ArincUpdateData>& words, Series* series) {
+    for (const ArincUpdateData& update : words) {
+        if (!SeriesMatches(selector, update)) continue;
+        double timeMs = update.timestamp_ns / 1e6;
+        if (timeMs < selector.startMs || timeMs > selector.endMs) continue;
+        double value = DecodeWord((uint32_t)update.word, selector.decoding);
+        if (std::isnan(value)) continue;
+        series->timeMs.push_back(timeMs);
+        series->value.push_back(value);
+    }
+}
+
+bool ReadCaptureSeries(const std::string& path, const SeriesSelector& selector, int threads, Series* series,
+                       std::string* errorMessage) {
+    TRACE_SCOPE("ReadCaptureSeries");
+    CaptureFileReader reader;
+    if (!reader.Open(path, errorMessage)) return false;
+
+    // Blocks are in time order; only those overlapping the range are decoded, a few per thread at a time
+    const std::vector<CaptureBlockInfo>& blocks = reader.Blocks();
+    size_t first = 0, last = blocks.size();
+    while (first < last && blocks[first].lastNs / 1e6 < selector.startMs) ++first;
+    while (last > first && blocks[last - 1].firstNs / 1e6 > selector.endMs) --last;
+    threads = std::max(threads, 1);
+    size_t chunk = (size_t)threads * 4;
+    std::vector<std::vector<ArincUpdateData>> decoded;
+    for (size_t index = first; index < last; index += chunk) {
+        size_t count = std::min(chunk, last - index);
+        if (!reader.DecodeBlocks(index, count, threads, &decoded, errorMessage)) return false;
+        for (const auto& words : decoded) AppendSeries(selector, words, series);
+    }
+
+    // Files merged from several sources may interleave slightly; plots need time order
+    if (!std::is_sorted(series->timeMs.begin(), series->timeMs.end())) {
+        std::vector<size_t> order(series->timeMs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return series->timeMs[a] < series->timeMs[b]; });
+        Series sorted;
+        sorted.timeMs.reserve(order.size());
+        sorted.value.reserve(order.size());
+        for (size_t i : order) {
+            sorted.timeMs.push_back(series->timeMs[i]);
+            sorted.value.push_back(series->value[i]);
+        }
+        *series = std::move(sorted);
+    }
+    return true;
+}
+
+void MinMaxKernel(const double* values, size_t count, double* minOut, double* maxOut) {
+    // Four independent lanes, written as selects rather than branches, vectorize to packed min/max
+    double lo[4], hi[4];
+    for (int lane = 0; lane < 4; ++lane) lo[lane] = hi[lane] = values[0];
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        for (int lane = 0; lane < 4; ++lane) {
+            double v = values[i + lane];
+            lo[lane] = v < lo[lane] ? v : lo[lane];
+            hi[lane] = v > hi[lane] ? v : hi[lane];
+        }
+    }
+    for (; i < count; ++i) {
+        lo[0] = values[i] < lo[0] ? values[i] : lo[0];
+        hi[0] = values[i] > hi[0] ? values[i] : hi[0];
+    }
+    *minOut = std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3]));
+    *maxOut = std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]));
+}
+
+void DownsampleMinMax(const Series& series, double startMs, double endMs, int buckets, MinMaxSeries* out) {
+    out->timeMs.clear();
+    out->min.clear();
+    out->max.clear();
+    size_t n = series.timeMs.size();
+    if (n == 0 || buckets <= 0) return;
+    if (std::isnan(startMs)) startMs = series.timeMs.front();
+    if (std::isnan(endMs)) endMs = series.timeMs.back();
+    if (!(endMs > startMs)) endMs = startMs + 1.0; // A single instant: one bucket holds it
+    double width = (endMs - startMs) / buckets;
+
+    const double* times = series.timeMs.data();
+    size_t begin = std::lower_bound(times, times + n, startMs) - times;
+    for (int bucket = 0; bucket < buckets && begin < n; ++bucket) {
+        double bucketStart = startMs + bucket * width;
+        double bucketEnd = bucket == buckets - 1 ? endMs : bucketStart + width;
+        // Last bucket closed at endMs, the others half-open
+        size_t end = bucket == buckets - 1 ? std::upper_bound(times + begin, times + n, bucketEnd) - times
+                                           : std::lower_bound(times + begin, times + n, bucketEnd) - times;
+        if (end > begin) {
+            double lo, hi;
+            MinMaxKernel(series.value.data() + begin, end - begin, &lo, &hi);
+            out->timeMs.push_back(bucketStart);
+            out->min.push_back(lo);
+            out->max.push_back(hi);
+        }
+        begin = end;
+    }
+}
+
+void DownsampleLttb(const Series& series, int points, Series* out) {
+    size_t n = series.timeMs.size();
+    if (points < 3 || (size_t)points >= n) {
+        *out = series;
+        return;
+    }
+    const double* x = series.timeMs.data();
+    const double* y = series.value.data();
+    out->timeMs.assign(1, x[0]);
+    out->value.assign(1, y[0]);
+    out->timeMs.reserve(points);
+    out->value.reserve(points);
+
+    // Interior points in points - 2 equal-count buckets; the first and last point are always kept. Bounds are exact
+    // integer fractions of the interior, so the buckets tile 1..n - 2 with none empty (n - 2 > buckets); the last
+    // bucket looks ahead to the last point.
+    size_t buckets = (size_t)points - 2;
+    size_t interior = n - 2;
+    auto boundary = [&](size_t bucket) { return 1 + (uint64_t)bucket * interior / buckets; };
+    size_t previous = 0;
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+        size_t start = boundary(bucket);
+        size_t end = boundary(bucket + 1);
+        size_t nextStart = end;
+        size_t nextEnd = bucket + 1 < buckets ? boundary(bucket + 2) : n;
+        double meanX = 0.0, meanY = 0.0;
+        for (size_t i = nextStart; i < nextEnd; ++i) {
+            meanX += x[i];
+            meanY += y[i];
+        }
+        double nextCount = (double)(nextEnd - nextStart);
+        meanX /= nextCount;
+        meanY /= nextCount;
+
+        // Twice the triangle area (previous pick, candidate, next mean); the constant terms don't change the argmax
+        double ax = x[previous], ay = y[previous];
+        size_t pick = start;
+        double bestArea = -1.0;
+        for (size_t i = start; i < end; ++i) {
+            double area = std::fabs((ax - meanX) * (y[i] - ay) - (ax - x[i]) * (meanY - ay));
+            if (area > bestArea) {
+                bestArea = area;
+                pick = i;
+            }
+        }
+        out->timeMs.push_back(x[pick]);
+        out->value.push_back(y[pick]);
+        previous = pick;
+    }
+    out->timeMs.push_back(x[n - 1]);
+    out->value.push_back(y[n - 1]);
+}
@@ -0,0 +1,70 @@
+#ifndef DOWNSAMPLE_H
+#define DOWNSAMPLE_H
+
+// Plot downsampling of one label's decoded values. A series is pulled out of a capture file or the label history
+// (history_store.h) as parallel time/value arrays, then reduced to about one point per pixel:
+//
+//   min/max   equal-time buckets over [start, end]; each non-empty bucket keeps its min and max, so spikes survive
+//   LTTB      Largest-Triangle-Three-Buckets: keeps the first and last point and, per equal-count bucket, the point
+//             forming the largest triangle with the previous pick and the next bucket's mean; keeps the shape of a
+//             line plot with real samples
+//
+// Times are ms on the data stream's `timestamp` clock (fractional, from the word's ns stamp). The min/max kernel runs
+// over contiguous doubles with independent accumulators so the compiler vectorizes it (SSE2/AVX minpd/maxpd).
+
+#include "device_session.h"
+#include "label_decoder.h"
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SeriesSelector {
+    int card = -1;                // -1 = any
+    int core = -1;
+    int channel = -1;             // -1 = any
+    int label = 0;
+    int sdi = -1;                 // -1 = any
+    LabelDecoding decoding;
+    double startMs = -INFINITY;
+    double endMs = INFINITY;
+};
+
+// Words whose decoded value is NaN (invalid BCD) are left out
+struct Series {
+    std::vector<double> timeMs;
+    std::vector<double> value;
+};
+
+struct MinMaxSeries {
+    std::vector<double> timeMs;   // Bucket start
+    std::vector<double> min;
+    std::vector<double> max;
+};
+
+inline bool SeriesMatches(const SeriesSelector& selector, const ArincUpdateData& update) {
+    if (IsGapMarker(update) || IsDerivedValue(update) || IsDioEdge(update)) return false;
+    if (update.label != selector.label) return false;
+    if (selector.channel >= 0 && update.channel != selector.channel) return false;
+    if (selector.card >= 0 && update.card != selector.card) return false;
+    if (selector.core >= 0 && update.core != selector.core) return false;
+    return selector.sdi < 0 || WordSdi((uint32_t)update.word) == selector.sdi;
+}
+
+// Appends the selected words of words (in time order) to series
+void AppendSeries(const SeriesSelector& selector, const std::vector<ArincUpdateData>& words, Series* series);
+
+// Reads the selected label from a capture file, decoding blocks on up to `threads` threads and skipping blocks
+// outside the time range
+bool ReadCaptureSeries(const std::string& path, const SeriesSelector& selector, int threads, Series* series,
+                       std::string* errorMessage);
+
+// min/max of count (> 0) values
+void MinMaxKernel(const double* values, size_t count, double* minOut, double* maxOut);
+
+// series in time order; start/end NaN = the series' first/last time
+void DownsampleMinMax(const Series& series, double startMs, double endMs, int buckets, MinMaxSeries* out);
+void DownsampleLttb(const Series& series, int points, Series* out);
+
+#endif // DOWNSAMPLE_H
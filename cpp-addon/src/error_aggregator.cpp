@@ -0,0 +1,77 @@
+#include "error_aggregator.h"
+#include "native_log.h"
+
+ErrorAggregator::ErrorAggregator(int cardNum, int coreNum, HCORE hCore)
+    : cardNum_(cardNum), coreNum_(coreNum), hCore_(hCore) {}
+
+void ErrorAggregator::Record(int channel, int code, const char* source) {
+    int used = used_.load(std::memory_order_relaxed); // The reader is the only writer of used_
+    for (int i = 0; i < used; ++i) {
+        Slot& slot = slots_[i];
+        if (slot.channel == channel && slot.code == code && slot.source == source) {
+            slot.total.fetch_add(1, std::memory_order_relaxed);
+            slot.lastSeenNs.store(HostNowNs(), std::memory_order_relaxed);
+            return;
+        }
+    }
+    if (used == ERROR_AGG_SLOTS) {
+        StatsAdd(unkeyed_);
+        return;
+    }
+
+    // First occurrence of this key: the only time a description is looked up and a string built
+    Slot& slot = slots_[used];
+    slot.channel = channel;
+    slot.code = code;
+    slot.source = source;
+    const char* errStr = code < 0 ? BTICard_ErrDescStr(code, hCore_) : nullptr;
+    slot.message = std::string(source) + (errStr ? std::string(": ") + errStr : std::string());
+    slot.total.store(1, std::memory_order_relaxed);
+    slot.lastSeenNs.store(HostNowNs(), std::memory_order_relaxed);
+    used_.store(used + 1, std::memory_order_release);
+}
+
+void ErrorAggregator::Collect(std::vector<ArincErrorData*>* notices) {
+    int used = used_.load(std::memory_order_acquire);
+    int64_t nowNs = HostNowNs();
+    for (int i = 0; i < used; ++i) {
+        Slot& slot = slots_[i];
+        uint64_t total = slot.total.load(std::memory_order_relaxed);
+        uint64_t fresh = total - slot.reported;
+        bool active = slot.active.load(std::memory_order_relaxed);
+
+        ArincErrorData* notice = nullptr;
+        if (!active && fresh > 0) {
+            slot.active.store(true, std::memory_order_relaxed);
+            slot.episode = fresh;
+            notice = new ArincErrorData{slot.channel, slot.code, slot.message, cardNum_, coreNum_, ErrorNotice::Raised, fresh};
+            BTI_LOG_WARN("Card %d core %d channel %d: %s", cardNum_, coreNum_, slot.channel, slot.message.c_str());
+        } else if (active && fresh > 0 && nowNs - slot.lastNoticeNs >= ERROR_SUMMARY_INTERVAL_MS * 1000000) {
+            slot.episode += fresh;
+            notice = new ArincErrorData{slot.channel, slot.code,
+                slot.message + " (" + std::to_string(fresh) + " more)", cardNum_, coreNum_, ErrorNotice::Summary, fresh};
+        } else if (active && fresh == 0 &&
+                   nowNs - slot.lastSeenNs.load(std::memory_order_relaxed) >= ERROR_CLEAR_AFTER_MS * 1000000) {
+            slot.active.store(false, std::memory_order_relaxed);
+            notice = new ArincErrorData{slot.channel, slot.code,
+                slot.message + " cleared after " + std::to_string(slot.episode) + " occurrence(s)",
+                cardNum_, coreNum_, ErrorNotice::Cleared, slot.episode};
+            BTI_LOG_INFO("Card %d core %d channel %d: %s cleared.", cardNum_, coreNum_, slot.channel, slot.message.c_str());
+        }
+        if (!notice) continue;
+        slot.reported = total;
+        slot.lastNoticeNs = nowNs;
+        notices->push_back(notice);
+    }
+}
+
+std::vector<ErrorCounter> ErrorAggregator::Counters() const {
+    std::vector<ErrorCounter> counters;
+    int used = used_.load(std::memory_order_acquire);
+    for (int i = 0; i < used; ++i) {
+        const Slot& slot = slots_[i];
+        counters.push_back(ErrorCounter{slot.channel, slot.code, slot.source, slot.message,
+            slot.total.load(std::memory_order_relaxed), slot.active.load(std::memory_order_relaxed)});
+    }
+    return counters;
+}
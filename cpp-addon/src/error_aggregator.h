@@ -0,0 +1,71 @@
+#ifndef ERROR_AGGREGATOR_H
+#define ERROR_AGGREGATOR_H
+
+// Per-session error counting for the reader thread. Record() only bumps a fixed counter per
+// (channel, code, source); the description string is built once, on the first occurrence. The registry's merge
+// thread calls Collect() about every 100 ms and turns the counters into a few notices: Raised when a key starts
+// failing, Summary at most once a second while it keeps failing, Cleared once it has been quiet for a while.
+// A flapping channel therefore costs the JS thread a handful of callbacks, not one per occurrence.
+
+#include "device_session.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const int ERROR_AGG_SLOTS = 64;                   // Distinct (channel, code, source) keys per session
+const int64_t ERROR_SUMMARY_INTERVAL_MS = 1000;   // Min spacing of Summary notices per key
+const int64_t ERROR_CLEAR_AFTER_MS = 2000;        // Quiet time after which a key is reported Cleared
+
+struct ErrorCounter {
+    int channel;
+    int code;
+    std::string source;
+    std::string message;
+    uint64_t count;       // Occurrences since the session opened
+    bool active;          // Raised and not yet cleared
+};
+
+class ErrorAggregator {
+public:
+    ErrorAggregator(int cardNum, int coreNum, HCORE hCore);
+
+    ErrorAggregator(const ErrorAggregator&) = delete;
+    ErrorAggregator& operator=(const ErrorAggregator&) = delete;
+
+    // Reader thread only; source must be a string literal (it is part of the key)
+    void Record(int channel, int code, const char* source);
+    // Single collector thread (the merge thread); appends due notices
+    void Collect(std::vector<ArincErrorData*>* notices);
+    // Any thread
+    std::vector<ErrorCounter> Counters() const;
+    uint64_t Unkeyed() const { return unkeyed_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        // Written once by the reader before the slot is published through used_
+        int channel = -1;
+        int code = 0;
+        const char* source = nullptr;
+        std::string message;
+        // Reader thread -> any
+        std::atomic<uint64_t> total{0};
+        std::atomic<int64_t> lastSeenNs{0};
+        // Collector thread
+        std::atomic<bool> active{false};
+        uint64_t reported = 0;
+        uint64_t episode = 0;   // Occurrences since Raised
+        int64_t lastNoticeNs = 0;
+    };
+
+    const int cardNum_;
+    const int coreNum_;
+    const HCORE hCore_;
+    Slot slots_[ERROR_AGG_SLOTS];
+    std::atomic<int> used_{0};
+    std::atomic<uint64_t> unkeyed_{0}; // Occurrences dropped because every slot was taken
+};
+
+#endif // ERROR_AGGREGATOR_H
@@ -0,0 +1,205 @@
+#include "history_store.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <numeric>
+
+HistoryStore& History() {
+    static HistoryStore* store = new HistoryStore(); // Leaked, like the session registry it taps
+    return *store;
+}
+
+bool HistoryStore::Start(const HistoryConfig& config, std::string* errorMessage) {
+    if (config.maxAgeNs < 0 || config.maxSamples < HISTORY_MIN_CAPACITY ||
+        config.memoryLimitBytes < HISTORY_MIN_CAPACITY * HISTORY_SAMPLE_BYTES) {
+        *errorMessage = "History needs maxAge >= 0, maxSamples >= " + std::to_string(HISTORY_MIN_CAPACITY) +
+            " and room for one ring";
+        return false;
+    }
+    std::lock_guard<std::mutex> control(controlMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (config.maxSamples < config_.maxSamples || config.memoryLimitBytes < stats_.bytes) {
+            rings_.clear();
+            stats_.bytes = 0;
+        }
+        config_ = config;
+    }
+    if (!running_.exchange(true)) {
+        Sessions().AddBatchTap(&HistoryStore::Tap, this);
+        Sessions().SetDemand(this, -1, -1, 0); // History of a label nobody streams is still history
+    }
+    BTI_LOG_INFO("Label history: %lld s, %u samples per label, %llu MB.", (long long)(config.maxAgeNs / 1000000000LL),
+        (unsigned)config.maxSamples, (unsigned long long)(config.memoryLimitBytes >> 20));
+    return true;
+}
+
+void HistoryStore::Stop() {
+    std::lock_guard<std::mutex> control(controlMutex_);
+    if (!running_.exchange(false)) return;
+    Sessions().RemoveBatchTap(&HistoryStore::Tap, this); // Returns once no merge-thread append is in flight
+    Sessions().ClearDemand(this);
+    std::lock_guard<std::mutex> lock(mutex_);
+    rings_.clear();
+    stats_ = HistoryStats();
+    BTI_LOG_INFO("Label history stopped.");
+}
+
+void HistoryStore::Tap(void* context, const std::vector<ArincUpdateData>& batch) {
+    static_cast<HistoryStore*>(context)->Apply(batch);
+}
+
+void HistoryStore::Apply(const std::vector<ArincUpdateData>& batch) {
+    if (batch.empty()) return;
+    TRACE_SCOPE_ARG("HistoryAppend", "words", batch.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t lastKey = 0;
+    Ring* ring = nullptr;
+    for (const ArincUpdateData& update : batch) {
+        if (IsGapMarker(update) || IsDioEdge(update) || update.channel < 0 || update.channel > 0xFF) continue;
+        uint32_t key = ((uint32_t)(update.card & 0xFF) << 24) | ((uint32_t)(update.core & 0xFF) << 16) |
+                       ((uint32_t)update.channel << 8) | (uint32_t)(update.label & 0xFF);
+        if (!ring || key != lastKey) {
+            auto found = rings_.find(key);
+            if (found != rings_.end()) {
+                ring = found->second.get();
+            } else {
+                size_t capacity = std::min(HISTORY_MIN_CAPACITY, config_.maxSamples);
+                if (stats_.bytes + capacity * HISTORY_SAMPLE_BYTES > config_.memoryLimitBytes) {
+                    stats_.wordsRejected++;
+                    ring = nullptr;
+                    continue;
+                }
+                std::unique_ptr<Ring> created(new Ring());
+                Grow(*created, capacity);
+                ring = created.get();
+                rings_.emplace(key, std::move(created));
+            }
+            lastKey = key;
+        }
+        Append(*ring, update.timestamp_ns, (uint32_t)update.word);
+    }
+}
+
+void HistoryStore::Grow(Ring& ring, size_t capacity) {
+    // Re-lay the samples oldest first from slot 0
+    std::vector<int64_t> timesNs(capacity);
+    std::vector<uint32_t> words(capacity);
+    for (size_t i = 0; i < ring.count; ++i) {
+        timesNs[i] = ring.timesNs[ring.Slot(i)];
+        words[i] = ring.words[ring.Slot(i)];
+    }
+    stats_.bytes += (capacity - ring.Capacity()) * HISTORY_SAMPLE_BYTES;
+    ring.timesNs.swap(timesNs);
+    ring.words.swap(words);
+    ring.head = ring.count % capacity;
+}
+
+void HistoryStore::Append(Ring& ring, int64_t timeNs, uint32_t word) {
+    // Queries binary-search by time: keep each ring ordered even if a source's stamps step back
+    if (ring.count > 0) timeNs = std::max(timeNs, ring.TimeAt(ring.count - 1));
+    if (config_.maxAgeNs > 0) {
+        while (ring.count > 0 && ring.TimeAt(0) < timeNs - config_.maxAgeNs) ring.count--;
+    }
+    if (ring.count == ring.Capacity()) {
+        size_t grown = std::min<size_t>(ring.Capacity() * 2, config_.maxSamples);
+        if (grown > ring.Capacity() &&
+            stats_.bytes + (grown - ring.Capacity()) * HISTORY_SAMPLE_BYTES <= config_.memoryLimitBytes) {
+            Grow(ring, grown);
+            stats_.ringGrowths++;
+        } else {
+            if (grown > ring.Capacity()) stats_.evictedEarly++;
+            ring.count--; // Overwrite the oldest
+        }
+    }
+    ring.timesNs[ring.head] = timeNs;
+    ring.words[ring.head] = word;
+    ring.head = (ring.head + 1) % ring.Capacity();
+    ring.count++;
+    stats_.wordsStored++;
+}
+
+template <typename Fn>
+void HistoryStore::ForEachRing(int card, int core, int channel, int label, Fn fn) {
+    if (card >= 0 && core >= 0 && channel >= 0) {
+        auto found = rings_.find(((uint32_t)(card & 0xFF) << 24) | ((uint32_t)(core & 0xFF) << 16) |
+                                 ((uint32_t)(channel & 0xFF) << 8) | (uint32_t)(label & 0xFF));
+        if (found != rings_.end()) fn(*found->second);
+        return;
+    }
+    for (const auto& entry : rings_) {
+        uint32_t key = entry.first;
+        if ((int)(key & 0xFF) != label) continue;
+        if (channel >= 0 && (int)((key >> 8) & 0xFF) != channel) continue;
+        if (core >= 0 && (int)((key >> 16) & 0xFF) != core) continue;
+        if (card >= 0 ? (int)(key >> 24) != card : (int)(key >> 24) == DERIVED_CARD) continue; // Derived values only by card
+        fn(*entry.second);
+    }
+}
+
+void HistoryStore::Query(int card, int core, int channel, int label, int64_t startNs, int64_t endNs,
+                         std::vector<int64_t>* timesNs, std::vector<uint32_t>* words) {
+    TRACE_SCOPE("HistoryQuery");
+    timesNs->clear();
+    words->clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (config_.maxAgeNs > 0) startNs = std::max(startNs, HostNowNs() - config_.maxAgeNs);
+    int rings = 0;
+    ForEachRing(card, core, channel, label, [&](const Ring& ring) {
+        // First sample at or after startNs, by binary search over the ring's logical order
+        size_t low = 0, high = ring.count;
+        while (low < high) {
+            size_t mid = low + (high - low) / 2;
+            if (ring.TimeAt(mid) < startNs) low = mid + 1;
+            else high = mid;
+        }
+        for (size_t i = low; i < ring.count; ++i) {
+            size_t slot = ring.Slot(i);
+            if (ring.timesNs[slot] > endNs) break;
+            timesNs->push_back(ring.timesNs[slot]);
+            words->push_back(ring.words[slot]);
+        }
+        rings++;
+    });
+    if (rings > 1) {
+        std::vector<size_t> order(timesNs->size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return (*timesNs)[a] < (*timesNs)[b]; });
+        std::vector<int64_t> sortedTimes(order.size());
+        std::vector<uint32_t> sortedWords(order.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sortedTimes[i] = (*timesNs)[order[i]];
+            sortedWords[i] = (*words)[order[i]];
+        }
+        timesNs->swap(sortedTimes);
+        words->swap(sortedWords);
+    }
+}
+
+void HistoryStore::ReadSeries(const SeriesSelector& selector, Series* series) {
+    // Whole-ns bounds that contain the ms range
+    int64_t startNs = selector.startMs <= -9e12 ? INT64_MIN : (int64_t)std::floor(selector.startMs * 1e6);
+    int64_t endNs = selector.endMs >= 9e12 ? INT64_MAX : (int64_t)std::ceil(selector.endMs * 1e6);
+    std::vector<int64_t> timesNs;
+    std::vector<uint32_t> words;
+    Query(selector.card, selector.core, selector.channel, selector.label, startNs, endNs, &timesNs, &words);
+    series->timeMs.reserve(series->timeMs.size() + timesNs.size());
+    series->value.reserve(series->value.size() + timesNs.size());
+    for (size_t i = 0; i < timesNs.size(); ++i) {
+        if (selector.sdi >= 0 && WordSdi(words[i]) != selector.sdi) continue;
+        double value = DecodeWord(words[i], selector.decoding);
+        if (std::isnan(value)) continue;
+        series->timeMs.push_back(timesNs[i] / 1e6);
+        series->value.push_back(value);
+    }
+}
+
+HistoryStats HistoryStore::Stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    HistoryStats stats = stats_;
+    stats.rings = rings_.size();
+    stats.samples = 0;
+    for (const auto& entry : rings_) stats.samples += entry.second->count;
+    return stats;
+}
@@ -0,0 +1,90 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+// Native short-term history: a registry tap keeps the recent words of every card/core/channel/label in a ring of its
+// own, so trend views and downsampling (downsample.h) query the addon instead of buffering the stream in JS.
+//
+// A ring starts at HISTORY_MIN_CAPACITY samples and doubles while it is full of samples younger than maxAge, up to
+// maxSamples; after that its capacity is fixed and the oldest sample is overwritten. All rings together stay under
+// memoryLimitBytes: a ring that cannot grow within it overwrites early (counted in evictedEarly), and a new label
+// that does not fit is not recorded (wordsRejected). Samples older than maxAge are dropped as new ones arrive and
+// never returned.
+
+#include "device_session.h"
+#include "downsample.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+const int64_t HISTORY_DEFAULT_MAX_AGE_NS = 60000000000LL;
+const uint32_t HISTORY_DEFAULT_MAX_SAMPLES = 65536;
+const size_t HISTORY_DEFAULT_MEMORY_BYTES = (size_t)256 << 20;
+const uint32_t HISTORY_MIN_CAPACITY = 64;
+const size_t HISTORY_SAMPLE_BYTES = sizeof(int64_t) + sizeof(uint32_t);
+
+struct HistoryConfig {
+    int64_t maxAgeNs = HISTORY_DEFAULT_MAX_AGE_NS;  // 0 = count budget only
+    uint32_t maxSamples = HISTORY_DEFAULT_MAX_SAMPLES;
+    size_t memoryLimitBytes = HISTORY_DEFAULT_MEMORY_BYTES;
+};
+
+struct HistoryStats {
+    size_t rings = 0;
+    size_t samples = 0;
+    size_t bytes = 0;               // Sample storage allocated
+    uint64_t wordsStored = 0;
+    uint64_t wordsRejected = 0;     // New labels that did not fit the memory limit
+    uint64_t evictedEarly = 0;      // Samples overwritten within maxAge because the memory limit stopped a ring growing
+    uint64_t ringGrowths = 0;
+};
+
+class HistoryStore {
+public:
+    // Starts recording, or applies new budgets. Lowering maxSamples or the memory limit below what is held drops
+    // the stored history.
+    bool Start(const HistoryConfig& config, std::string* errorMessage);
+    void Stop(); // Removes the tap and frees every ring
+    bool IsRunning() const { return running_.load(); }
+
+    // Samples of channel/label with startNs <= time <= endNs, oldest first. card/core -1 = any card but the derived
+    // values' (rings of several cores are merged in time order).
+    void Query(int card, int core, int channel, int label, int64_t startNs, int64_t endNs,
+               std::vector<int64_t>* timesNs, std::vector<uint32_t>* words);
+    // The selected words as a decoded series for downsampling
+    void ReadSeries(const SeriesSelector& selector, Series* series);
+    HistoryStats Stats();
+
+private:
+    struct Ring {
+        std::vector<int64_t> timesNs;   // Capacity slots
+        std::vector<uint32_t> words;
+        size_t head = 0;                // Next slot written
+        size_t count = 0;
+        size_t Capacity() const { return timesNs.size(); }
+        size_t Slot(size_t index) const { return (head + Capacity() - count + index) % Capacity(); } // 0 = oldest
+        int64_t TimeAt(size_t index) const { return timesNs[Slot(index)]; }
+    };
+
+    static void Tap(void* context, const std::vector<ArincUpdateData>& batch);
+    void Apply(const std::vector<ArincUpdateData>& batch);
+    void Append(Ring& ring, int64_t timeNs, uint32_t word); // Caller holds mutex_
+    void Grow(Ring& ring, size_t capacity);                 // Caller holds mutex_
+    // Calls fn(ring) for every ring matching card/core/channel/label (-1 = any); caller holds mutex_
+    template <typename Fn> void ForEachRing(int card, int core, int channel, int label, Fn fn);
+
+    std::mutex controlMutex_; // Serializes Start/Stop
+    std::mutex mutex_;        // Guards everything below; held by the tap for one batch and by queries for one copy
+    HistoryConfig config_;
+    std::unordered_map<uint32_t, std::unique_ptr<Ring>> rings_; // card << 24 | core << 16 | channel << 8 | label
+    HistoryStats stats_;
+    std::atomic<bool> running_{false};
+};
+
+HistoryStore& History();
+
+#endif // HISTORY_STORE_H
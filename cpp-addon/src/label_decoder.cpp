@@ -0,0 +1,83 @@
+#include "label_decoder.h"
+
+#include <cmath>
+
+uint32_t WordField(uint32_t word, int msb, int lsb) {
+    int width = msb - lsb + 1;
+    uint32_t bits = word >> (lsb - 1);
+    return width >= 32 ? bits : bits & ((1u << width) - 1);
+}
+
+double DecodeWord(uint32_t word, const LabelDecoding& decoding) {
+    switch (decoding.format) {
+    case LabelFormat::Bnr: {
+        // Two's complement with the sign in bit 29, whatever the field's msb
+        int width = decoding.msb - decoding.lsb + 1;
+        double magnitude = (double)WordField(word, decoding.msb, decoding.lsb);
+        if (word & (1u << 28)) magnitude -= std::ldexp(1.0, width);
+        return magnitude * decoding.resolution;
+    }
+    case LabelFormat::Bcd: {
+        // Digits of four bits from the lsb up; the top digit may be narrower. SSM 3 (minus) negates.
+        double value = 0.0, scale = 1.0;
+        for (int bit = decoding.lsb; bit <= decoding.msb; bit += 4) {
+            int top = bit + 3 > decoding.msb ? decoding.msb : bit + 3;
+            uint32_t digit = WordField(word, top, bit);
+            if (digit > 9) return std::nan("");
+            value += digit * scale;
+            scale *= 10.0;
+        }
+        if (WordSsm(word) == 3) value = -value;
+        return value * decoding.resolution;
+    }
+    case LabelFormat::Discrete:
+        return (double)WordField(word, decoding.msb, decoding.lsb) * decoding.resolution;
+    case LabelFormat::Raw:
+    default:
+        return (double)WordField(word, 29, 11);
+    }
+}
+
+bool ParseLabelFormat(const std::string& name, LabelFormat* format) {
+    if (name == "raw") *format = LabelFormat::Raw;
+    else if (name == "bnr") *format = LabelFormat::Bnr;
+    else if (name == "bcd") *format = LabelFormat::Bcd;
+    else if (name == "discrete") *format = LabelFormat::Discrete;
+    else return false;
+    return true;
+}
+
+const char* LabelFormatName(LabelFormat format) {
+    switch (format) {
+    case LabelFormat::Bnr: return "bnr";
+    case LabelFormat::Bcd: return "bcd";
+    case LabelFormat::Discrete: return "discrete";
+    default: return "raw";
+    }
+}
+
+bool ValidateDecoding(const LabelDecoding& decoding, std::string* errorMessage) {
+    int maxBit = decoding.format == LabelFormat::Bnr ? 28 : 29;
+    if (decoding.lsb < 9 || decoding.msb > maxBit || decoding.msb < decoding.lsb) {
+        *errorMessage = "msb/lsb must satisfy 9 <= lsb <= msb <= " + std::to_string(maxBit);
+        return false;
+    }
+    if (!std::isfinite(decoding.resolution) || decoding.resolution == 0.0) {
+        *errorMessage = "resolution must be a non-zero number";
+        return false;
+    }
+    return true;
+}
+
+LabelDecoderTable::LabelDecoderTable()
+    : channel_(MAX_CHANNELS, std::vector<LabelDecoding>(256)), channelSet_(MAX_CHANNELS, std::vector<bool>(256, false)) {}
+
+void LabelDecoderTable::Add(const LabelDecodingRule& rule) {
+    if (rule.label < 0 || rule.label > 255) return;
+    if (rule.channel < 0) {
+        any_[rule.label] = rule.decoding;
+    } else if (rule.channel < MAX_CHANNELS) {
+        channel_[rule.channel][rule.label] = rule.decoding;
+        channelSet_[rule.channel][rule.label] = true;
+    }
+}
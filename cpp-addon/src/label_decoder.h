@@ -0,0 +1,67 @@
+#ifndef LABEL_DECODER_H
+#define LABEL_DECODER_H
+
+// Engineering-value decoding of ARINC 429 words, shared by the exporter and the native engines that work on values
+// rather than raw words. Bit numbers follow the ARINC convention used by BTI429_BNRGetData: bit 1 is the label LSB,
+// 9-10 the SDI, 11-29 data (29 = BNR sign), 30-31 the SSM, 32 parity. Nothing here calls the driver.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class LabelFormat { Raw, Bnr, Bcd, Discrete };
+
+struct LabelDecoding {
+    LabelFormat format = LabelFormat::Raw;
+    int msb = 28;                 // Highest data bit (BNR: excluding the sign bit 29)
+    int lsb = 11;
+    double resolution = 1.0;      // Weight of the lsb (BNR/Discrete) or of the least significant digit (BCD)
+};
+
+struct LabelDecodingRule {
+    int channel = -1;             // -1 = any channel
+    int label = 0;
+    LabelDecoding decoding;
+};
+
+inline int WordLabel(uint32_t word) { return (int)(word & 0xFF); }
+inline int WordSdi(uint32_t word) { return (int)((word >> 8) & 0x3); }
+inline int WordSsm(uint32_t word) { return (int)((word >> 29) & 0x3); }
+// ARINC words carry odd parity over all 32 bits
+inline bool WordParityOk(uint32_t word) {
+    word ^= word >> 16;
+    word ^= word >> 8;
+    word ^= word >> 4;
+    word ^= word >> 2;
+    word ^= word >> 1;
+    return (word & 1) != 0;
+}
+
+// Unsigned bits msb..lsb (ARINC numbering)
+uint32_t WordField(uint32_t word, int msb, int lsb);
+double DecodeWord(uint32_t word, const LabelDecoding& decoding);
+
+bool ParseLabelFormat(const std::string& name, LabelFormat* format);
+const char* LabelFormatName(LabelFormat format);
+// Checks bit ranges (1..29, msb >= lsb; BNR msb <= 28)
+bool ValidateDecoding(const LabelDecoding& decoding, std::string* errorMessage);
+
+// Decoding per channel/label; a channel rule wins over an any-channel rule, unknown labels decode as Raw 11..29
+class LabelDecoderTable {
+public:
+    LabelDecoderTable();
+    void Add(const LabelDecodingRule& rule);
+    const LabelDecoding& Lookup(int channel, int label) const {
+        if (channel >= 0 && channel < MAX_CHANNELS && channelSet_[channel][label]) return channel_[channel][label];
+        return any_[label];
+    }
+    double Decode(int channel, uint32_t word) const { return DecodeWord(word, Lookup(channel, WordLabel(word))); }
+
+private:
+    static const int MAX_CHANNELS = 32;
+    LabelDecoding any_[256];
+    std::vector<std::vector<LabelDecoding>> channel_;
+    std::vector<std::vector<bool>> channelSet_;
+};
+
+#endif // LABEL_DECODER_H
@@ -0,0 +1,120 @@
+#ifndef MONITOR_STATS_H
+#define MONITOR_STATS_H
+
+// Lock-free counters and gauges for the ARINC monitor pipeline.
+// MonitorStats is per device session (written by its reader thread); DeliveryStats is written by the
+// merge/delivery stage and the TSFN callback. Both are read by getMonitorStats().
+// All accesses use relaxed ordering: values are independent counters, not a consistent snapshot.
+
+#include <atomic>
+#include <cstdint>
+
+// --- Stats Dimensions ---
+const int STATS_MAX_CHANNELS = 32;        // Upper bound on channels tracked per core
+const int STATS_CYCLE_HIST_BUCKETS = 24;  // log2(us) buckets: [0] <1us, [i] 2^(i-1)..2^i us, last bucket is open-ended
+const int STATS_BLOCK_HIST_BUCKETS = 17;  // log2(words) buckets for BTI429_ListDataBlkRd sizes (USHORT counts)
+
+// Per-channel counters, padded to a cache line so the reader thread and JS polling don't false-share
+struct alignas(64) ChannelStats {
+    std::atomic<uint64_t> wordsRead{0};       // Words returned by ListDataBlkRd
+    std::atomic<uint64_t> blockReads{0};      // Non-empty ListDataBlkRd calls
+    std::atomic<uint64_t> lastBlockSize{0};   // Gauge: words in the most recent block read
+    std::atomic<uint64_t> maxBlockSize{0};    // High-water mark of block read size
+    std::atomic<uint64_t> listFullCount{0};   // ListStatus returned STAT_FULL
+    std::atomic<uint64_t> listEvents{0};      // EVENTTYPE_429LIST event log entries
+    std::atomic<uint64_t> errEvents{0};       // EVENTTYPE_429ERR event log entries
+    std::atomic<uint64_t> statusErrors{0};    // ListStatus / ListDataBlkRd failures
+    std::atomic<uint64_t> statusPolls{0};     // BTI429_ListStatus calls (bus transactions spent on this channel)
+    std::atomic<uint64_t> pollIntervalUs{0};  // Gauge: current poll interval (adaptive when demanded, background otherwise)
+    std::atomic<uint64_t> lostWords{0};       // Estimated words dropped by a full list (hit count minus words read)
+    std::atomic<uint64_t> gapMarkers{0};      // Gap markers emitted into the stream (polls that found new losses)
+    std::atomic<uint64_t> listSize{0};        // Gauge: receive list capacity in words
+    std::atomic<uint64_t> peakWordsPerSec{0}; // High-water mark of the word rate seen between two polls
+    std::atomic<uint64_t> listResizes{0};     // Receive lists re-created larger (adaptive lists)
+    std::atomic<uint64_t> wordsSuppressed{0}; // Unchanged repeats dropped by report-on-change
+};
+
+// Number of numeric fields in ChannelStats (keep in sync with the struct and GetMonitorStatsWrapped)
+const int STATS_CHANNEL_FIELDS = 16;
+
+struct MonitorStats {
+    ChannelStats channels[STATS_MAX_CHANNELS];
+
+    std::atomic<uint64_t> cycles{0};                 // Completed MonitorLoop iterations
+    std::atomic<uint64_t> lastCycleUs{0};            // Gauge: duration of the last cycle (excluding sleep)
+    std::atomic<uint64_t> maxCycleUs{0};             // High-water mark of cycle duration
+    std::atomic<uint64_t> cycleHistogram[STATS_CYCLE_HIST_BUCKETS];
+    std::atomic<uint64_t> blockSizeHistogram[STATS_BLOCK_HIST_BUCKETS];
+    std::atomic<uint64_t> eventLogEntries{0};        // All entries read via BTICard_EventLogRd
+    std::atomic<uint64_t> eventLogDrains{0};         // Cycles that drained at least one entry
+    std::atomic<uint64_t> eventLogMaxDrain{0};       // High-water mark of entries drained in one cycle
+    std::atomic<uint64_t> eventLogOverflows{0};      // Cycles that found the log full (the card drops entries meanwhile)
+    std::atomic<uint64_t> eventsDropped{0};          // Drained events the event sink could not queue
+    std::atomic<uint64_t> snapshotRefreshes{0};      // Snapshot refresh ticks
+    std::atomic<uint64_t> snapshotGroupReads{0};     // BTI429_MsgGroupBlockRd calls made by them
+    std::atomic<uint64_t> snapshotUpdates{0};        // Snapshot records found with a new word
+    std::atomic<uint64_t> alarmTransitions{0};       // Alarms raised or cleared
+    std::atomic<uint64_t> alarmsDropped{0};          // Transitions the alarm sink could not queue
+
+    MonitorStats() {
+        for (auto& b : cycleHistogram) b.store(0, std::memory_order_relaxed);
+        for (auto& b : blockSizeHistogram) b.store(0, std::memory_order_relaxed);
+    }
+};
+
+// Delivery stage counters, shared by all sessions (the merged stream has a single JS hand-off)
+struct DeliveryStats {
+    std::atomic<int64_t>  tsfnQueueDepth{0};         // Gauge: batches queued on tsfnDataUpdate, not yet run in JS
+    std::atomic<int64_t>  tsfnQueueDepthMax{0};      // High-water mark of tsfnQueueDepth
+    std::atomic<uint64_t> batchesQueued{0};          // Batches accepted by the TSFN
+    std::atomic<uint64_t> batchesDelivered{0};       // Batches handed to the JS data callback
+    std::atomic<uint64_t> wordsDelivered{0};         // Words handed to the JS data callback
+    std::atomic<uint64_t> wordsDropped{0};           // Words discarded (TSFN closing/failed/null)
+};
+
+// --- Helpers (inline, called on the hot path) ---
+
+// Index of the highest set bit + 1 (0 for value 0), clamped to the bucket count
+inline int StatsLog2Bucket(uint64_t value, int bucketCount) {
+    int bucket = 0;
+    while (value != 0 && bucket < bucketCount - 1) {
+        value >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Raise a high-water mark without a lock
+template <typename T>
+inline void StatsUpdateMax(std::atomic<T>& target, T value) {
+    T current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+inline void StatsAdd(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.fetch_add(amount, std::memory_order_relaxed);
+}
+
+inline void StatsRecordCycle(MonitorStats& stats, uint64_t elapsedUs) {
+    stats.cycles.fetch_add(1, std::memory_order_relaxed);
+    stats.lastCycleUs.store(elapsedUs, std::memory_order_relaxed);
+    StatsUpdateMax(stats.maxCycleUs, elapsedUs);
+    stats.cycleHistogram[StatsLog2Bucket(elapsedUs, STATS_CYCLE_HIST_BUCKETS)].fetch_add(1, std::memory_order_relaxed);
+}
+
+inline void StatsRecordBlockRead(MonitorStats& stats, int channel, uint64_t count) {
+    stats.blockSizeHistogram[StatsLog2Bucket(count, STATS_BLOCK_HIST_BUCKETS)].fetch_add(1, std::memory_order_relaxed);
+    if (channel < 0 || channel >= STATS_MAX_CHANNELS) return;
+    ChannelStats& ch = stats.channels[channel];
+    ch.wordsRead.fetch_add(count, std::memory_order_relaxed);
+    ch.blockReads.fetch_add(1, std::memory_order_relaxed);
+    ch.lastBlockSize.store(count, std::memory_order_relaxed);
+    StatsUpdateMax(ch.maxBlockSize, count);
+}
+
+inline ChannelStats* StatsChannel(MonitorStats& stats, int channel) {
+    return (channel >= 0 && channel < STATS_MAX_CHANNELS) ? &stats.channels[channel] : nullptr;
+}
+
+#endif // MONITOR_STATS_H
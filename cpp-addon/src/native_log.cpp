@@ -0,0 +1,290 @@
+#include "native_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// --- Logger State ---
+std::atomic<int> g_logMinLevel(static_cast<int>(LogLevel::Info));
+
+namespace {
+
+static_assert((LOG_RING_CAPACITY & (LOG_RING_CAPACITY - 1)) == 0, "LOG_RING_CAPACITY must be a power of two");
+
+// Single-producer (owning thread) / single-consumer (drain thread) ring
+struct LogRing {
+    LogRecord records[LOG_RING_CAPACITY];
+    std::atomic<uint32_t> head{0};       // Next slot to write, advanced by the owner
+    std::atomic<uint32_t> tail{0};       // Next slot to read, advanced by the drain thread
+    std::atomic<bool> ownerAlive{true};  // Cleared on thread exit; the drain thread retires the ring once empty
+    uint32_t threadId = 0;
+};
+
+std::mutex logRegistryMutex;                   // Guards logRings (thread registration and retirement only)
+std::vector<std::unique_ptr<LogRing>> logRings;
+uint32_t logNextThreadId = 1;
+
+std::atomic<LogSite*> logSuppressedSites(nullptr); // Intrusive list of sites that have hit their rate limit
+
+std::atomic<uint64_t> logWritten(0);
+std::atomic<uint64_t> logDropped(0);
+std::atomic<uint64_t> logSuppressed(0);
+std::atomic<uint64_t> logSinkDropped(0);
+
+std::mutex logSinkMutex;                       // Held while the drain thread calls the sink, so it can be swapped safely
+LogBatchSink logSink = nullptr;
+void* logSinkContext = nullptr;
+bool logEchoToConsole = true;
+
+std::mutex logThreadMutex;                     // Guards drain thread start/stop
+std::condition_variable logWakeCv;
+bool logRunning = false;
+std::thread* logDrainThread = nullptr;         // Heap-held so an unjoined thread never terminates the process at exit
+
+struct LogThreadHandle {
+    LogRing* ring = nullptr;
+    ~LogThreadHandle() {
+        if (ring) ring->ownerAlive.store(false, std::memory_order_release);
+        ring = nullptr;
+    }
+};
+
+thread_local LogThreadHandle t_logHandle;
+
+int64_t LogNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+LogRing* LogThreadRing() {
+    if (!t_logHandle.ring) {
+        auto ring = std::make_unique<LogRing>();
+        std::lock_guard<std::mutex> lock(logRegistryMutex);
+        ring->threadId = logNextThreadId++;
+        t_logHandle.ring = ring.get();
+        logRings.push_back(std::move(ring));
+    }
+    return t_logHandle.ring;
+}
+
+const char* LogBaseName(const char* path) {
+    const char* base = path;
+    for (const char* p = path; *p; ++p) {
+        if (*p == '/' || *p == '\\') base = p + 1;
+    }
+    return base;
+}
+
+// Returns false if the site has used up its budget for the current one-second window
+bool LogSiteAllow(LogSite& site, int64_t nowMs) {
+    if (site.maxPerSecond == 0) return true;
+    int64_t start = site.windowStartMs.load(std::memory_order_relaxed);
+    if (nowMs - start >= 1000 &&
+        site.windowStartMs.compare_exchange_strong(start, nowMs, std::memory_order_relaxed)) {
+        site.windowCount.store(0, std::memory_order_relaxed);
+    }
+    if (site.windowCount.fetch_add(1, std::memory_order_relaxed) < site.maxPerSecond) return true;
+
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    logSuppressed.fetch_add(1, std::memory_order_relaxed);
+    if (!site.registered.exchange(true, std::memory_order_acq_rel)) {
+        LogSite* headSite = logSuppressedSites.load(std::memory_order_relaxed);
+        do {
+            site.next = headSite;
+        } while (!logSuppressedSites.compare_exchange_weak(headSite, &site, std::memory_order_release, std::memory_order_relaxed));
+    }
+    return false;
+}
+
+// --- Drain Side ---
+
+// Moves every published record into the batch and retires rings of exited threads
+void LogCollect(std::vector<LogRecord>& batch) {
+    std::lock_guard<std::mutex> lock(logRegistryMutex);
+    for (auto it = logRings.begin(); it != logRings.end();) {
+        LogRing* ring = it->get();
+        bool ownerAlive = ring->ownerAlive.load(std::memory_order_acquire);
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            batch.push_back(ring->records[tail & (LOG_RING_CAPACITY - 1)]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        if (!ownerAlive && ring->head.load(std::memory_order_acquire) == tail) {
+            it = logRings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LogCollectSuppressed(std::vector<LogRecord>& batch) {
+    for (LogSite* site = logSuppressedSites.load(std::memory_order_acquire); site; site = site->next) {
+        uint32_t count = site->suppressed.exchange(0, std::memory_order_relaxed);
+        if (count == 0) continue;
+        LogRecord rec;
+        rec.timeMs = LogNowMs();
+        rec.file = site->file;
+        rec.line = site->line;
+        rec.threadId = 0;
+        rec.level = site->level;
+        rec.suppressed = count;
+        std::snprintf(rec.message, sizeof(rec.message), "Suppressed %u similar message(s) from %s:%d in the last second",
+            count, LogBaseName(site->file), site->line);
+        batch.push_back(rec);
+    }
+}
+
+void LogWriteConsole(const std::vector<LogRecord>& batch) {
+    bool wroteOut = false, wroteErr = false;
+    for (const LogRecord& rec : batch) {
+        bool isError = rec.level >= LogLevel::Warn;
+        std::fprintf(isError ? stderr : stdout, "[C++ Addon] [%s] %s\n", LogLevelName(rec.level), rec.message);
+        (isError ? wroteErr : wroteOut) = true;
+    }
+    if (wroteOut) std::fflush(stdout);
+    if (wroteErr) std::fflush(stderr);
+}
+
+void LogEmit(std::vector<LogRecord>& batch) {
+    if (batch.empty()) return;
+    // Rings are per thread; interleave them by time so the output reads chronologically
+    std::stable_sort(batch.begin(), batch.end(),
+        [](const LogRecord& a, const LogRecord& b) { return a.timeMs < b.timeMs; });
+
+    std::lock_guard<std::mutex> lock(logSinkMutex);
+    if (logSink) {
+        auto* sinkBatch = new std::vector<LogRecord>(batch);
+        if (!logSink(logSinkContext, sinkBatch)) {
+            logSinkDropped.fetch_add(sinkBatch->size(), std::memory_order_relaxed);
+            delete sinkBatch;
+        }
+        if (!logEchoToConsole) return;
+    }
+    LogWriteConsole(batch);
+}
+
+void LogDrainLoop() {
+    std::vector<LogRecord> batch;
+    batch.reserve(LOG_RING_CAPACITY);
+    auto lastSummary = std::chrono::steady_clock::now();
+    bool running = true;
+
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(logThreadMutex);
+            logWakeCv.wait_for(lock, std::chrono::milliseconds(20), [] { return !logRunning; });
+            running = logRunning;
+        }
+
+        batch.clear();
+        LogCollect(batch);
+        auto now = std::chrono::steady_clock::now();
+        if (!running || now - lastSummary >= std::chrono::seconds(1)) {
+            LogCollectSuppressed(batch);
+            lastSummary = now;
+        }
+        LogEmit(batch);
+    }
+}
+
+} // namespace
+
+// --- Producer Path ---
+
+void LogWrite(LogSite& site, const char* fmt, ...) {
+    int64_t nowMs = LogNowMs();
+    if (!LogSiteAllow(site, nowMs)) return;
+
+    LogRing* ring = LogThreadRing();
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= (uint32_t)LOG_RING_CAPACITY) {
+        logDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    LogRecord& rec = ring->records[head & (LOG_RING_CAPACITY - 1)];
+    rec.timeMs = nowMs;
+    rec.file = site.file;
+    rec.line = site.line;
+    rec.threadId = ring->threadId;
+    rec.level = site.level;
+    rec.suppressed = 0;
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(rec.message, sizeof(rec.message), fmt, args);
+    va_end(args);
+
+    ring->head.store(head + 1, std::memory_order_release);
+    logWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+// --- Control ---
+
+void LogSetMinLevel(LogLevel level) {
+    g_logMinLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void LogSetSink(LogBatchSink sink, void* context, bool echoToConsole) {
+    std::lock_guard<std::mutex> lock(logSinkMutex);
+    logSink = sink;
+    logSinkContext = sink ? context : nullptr;
+    logEchoToConsole = sink ? echoToConsole : true;
+}
+
+void LogClearSink(void* context) {
+    std::lock_guard<std::mutex> lock(logSinkMutex);
+    if (!logSink || logSinkContext != context) return;
+    logSink = nullptr;
+    logSinkContext = nullptr;
+    logEchoToConsole = true;
+}
+
+void LogStart() {
+    std::lock_guard<std::mutex> lock(logThreadMutex);
+    if (logRunning) return;
+    logRunning = true;
+    logDrainThread = new std::thread(LogDrainLoop);
+}
+
+void LogShutdown() {
+    std::thread* drainThread = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(logThreadMutex);
+        if (!logRunning) return;
+        logRunning = false;
+        drainThread = logDrainThread;
+        logDrainThread = nullptr;
+    }
+    logWakeCv.notify_all();
+    if (drainThread) {
+        drainThread->join(); // The loop does a final collect + suppressed summary before exiting
+        delete drainThread;
+    }
+}
+
+LogStats LogGetStats() {
+    LogStats stats;
+    stats.written = logWritten.load(std::memory_order_relaxed);
+    stats.dropped = logDropped.load(std::memory_order_relaxed);
+    stats.suppressed = logSuppressed.load(std::memory_order_relaxed);
+    stats.sinkDropped = logSinkDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+const char* LogLevelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info:  return "INFO";
+    case LogLevel::Warn:  return "WARN";
+    case LogLevel::Error: return "ERROR";
+    default:              return "OFF";
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef NATIVE_LOG_H
+#define NATIVE_LOG_H
+
+// Asynchronous, rate-limited logger for native code.
+// Producers format into their own single-producer ring (no locks, no console I/O on the calling thread);
+// a background drain thread writes records to the console or hands them to a sink (the JS log hook).
+// Each BTI_LOG_* call site has its own per-second budget; excess messages are counted and reported
+// as a single "suppressed" summary record once per second.
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class LogLevel : int { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+const int LOG_MESSAGE_MAX = 240;           // Bytes per message, including terminator (longer messages are truncated)
+const int LOG_RING_CAPACITY = 512;         // Records per producer thread (power of two)
+const uint32_t LOG_DEFAULT_RATE = 20;      // Messages per second per call site
+const uint32_t LOG_UNLIMITED_RATE = 0;     // For one-off lifecycle messages
+
+struct LogRecord {
+    int64_t timeMs;                 // Wall-clock epoch ms
+    const char* file;               // __FILE__ of the call site (string literal)
+    int line;
+    uint32_t threadId;              // Small per-thread id assigned by the logger
+    LogLevel level;
+    uint32_t suppressed;            // Non-zero for summary records: messages dropped by the rate limit
+    char message[LOG_MESSAGE_MAX];
+};
+
+// Per-call-site rate limit state (one static instance per BTI_LOG_* expansion)
+struct LogSite {
+    const char* file;
+    int line;
+    LogLevel level;
+    uint32_t maxPerSecond;                    // 0 = unlimited
+    std::atomic<int64_t> windowStartMs{0};
+    std::atomic<uint32_t> windowCount{0};
+    std::atomic<uint32_t> suppressed{0};      // Pending count, reported and cleared by the drain thread
+    std::atomic<bool> registered{false};      // Linked into the summary list on first suppression
+    LogSite* next = nullptr;
+
+    LogSite(const char* f, int l, LogLevel lv, uint32_t rate) : file(f), line(l), level(lv), maxPerSecond(rate) {}
+};
+
+struct LogStats {
+    uint64_t written;       // Records accepted into a ring
+    uint64_t dropped;       // Records lost because a ring was full
+    uint64_t suppressed;    // Records refused by per-site rate limits
+    uint64_t sinkDropped;   // Records the sink refused (JS queue full / closing)
+};
+
+// Takes ownership of the batch and returns true, or returns false and the logger deletes it.
+// context is the pointer passed to LogSetSink (the JS environment that installed the sink).
+typedef bool (*LogBatchSink)(void* context, std::vector<LogRecord>* batch);
+
+extern std::atomic<int> g_logMinLevel;
+
+inline bool LogLevelEnabled(LogLevel level) {
+    return static_cast<int>(level) >= g_logMinLevel.load(std::memory_order_relaxed);
+}
+
+void LogWrite(LogSite& site, const char* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+void LogSetMinLevel(LogLevel level);
+void LogSetSink(LogBatchSink sink, void* context, bool echoToConsole); // nullptr restores console-only output
+void LogClearSink(void* context); // Restores console-only output if the current sink was installed with context
+void LogStart();    // Starts the drain thread (idempotent)
+void LogShutdown(); // Flushes remaining records and joins the drain thread
+LogStats LogGetStats();
+const char* LogLevelName(LogLevel level);
+
+#define BTI_LOG_AT(level, rate, ...)                                                   \
+    do {                                                                               \
+        if (LogLevelEnabled(level)) {                                                  \
+            static LogSite btiLogSite_(__FILE__, __LINE__, level, rate);               \
+            LogWrite(btiLogSite_, __VA_ARGS__);                                        \
+        }                                                                              \
+    } while (0)
+
+#define BTI_LOG_DEBUG(...) BTI_LOG_AT(LogLevel::Debug, LOG_DEFAULT_RATE, __VA_ARGS__)
+#define BTI_LOG_INFO(...)  BTI_LOG_AT(LogLevel::Info, LOG_DEFAULT_RATE, __VA_ARGS__)
+#define BTI_LOG_WARN(...)  BTI_LOG_AT(LogLevel::Warn, LOG_DEFAULT_RATE, __VA_ARGS__)
+#define BTI_LOG_ERROR(...) BTI_LOG_AT(LogLevel::Error, LOG_DEFAULT_RATE, __VA_ARGS__)
+
+#endif // NATIVE_LOG_H
@@ -0,0 +1,175 @@
+#include "receiver_profile.h"
+
+#include <algorithm>
+
+namespace {
+// Records that can share the default message with hit counting (timetag and hit count share one field,
+// elapsed and max time another)
+const ULONG PROFILE_RECORD_FLAGS = MSGCRT429_ELAPSE | MSGCRT429_MAX | MSGCRT429_MIN;
+}
+
+bool ResolveProfile(const ReceiverProfile& profile, const std::vector<int>& receiveChannels,
+                    const std::vector<int>& currentListWords, ReceiverLayout* target, std::string* errorMessage) {
+    if (profile.eventLogSize < 1 || profile.eventLogSize > 0xFFFF) {
+        *errorMessage = "eventLogSize must be 1..65535";
+        return false;
+    }
+    int channelSlots = receiveChannels.empty() ? 0 : *std::max_element(receiveChannels.begin(), receiveChannels.end()) + 1;
+    target->eventLogSize = profile.eventLogSize;
+    target->channels.assign(channelSlots, ChannelProfile());
+
+    for (const ChannelProfile& requested : profile.channels) {
+        int ch = requested.channel;
+        std::string where = "Channel " + std::to_string(ch) + ": ";
+        if (std::find(receiveChannels.begin(), receiveChannels.end(), ch) == receiveChannels.end()) {
+            *errorMessage = where + "not a receive channel on this core";
+            return false;
+        }
+        if (target->channels[ch].channel >= 0) {
+            *errorMessage = where + "listed more than once";
+            return false;
+        }
+        if (requested.listWords != 0 && (requested.listWords < LIST_MIN_WORDS || requested.listWords > LIST_LIMIT_WORDS)) {
+            *errorMessage = where + "listWords must be " + std::to_string(LIST_MIN_WORDS) + ".." + std::to_string(LIST_LIMIT_WORDS);
+            return false;
+        }
+        if (requested.records & ~PROFILE_RECORD_FLAGS) {
+            *errorMessage = where + "only elapse, max and min records can be kept (hit counting uses the timetag field)";
+            return false;
+        }
+        if ((requested.records & MSGCRT429_ELAPSE) && (requested.records & MSGCRT429_MAX)) {
+            *errorMessage = where + "elapse and max records share a field; pick one";
+            return false;
+        }
+        ChannelProfile resolved = requested;
+        for (int label : resolved.skipLabels) {
+            if (label < 0 || label > 255) {
+                *errorMessage = where + "skipLabels must be 0..255";
+                return false;
+            }
+        }
+        for (int label : resolved.snapshotLabels) {
+            if (label < 0 || label > 255) {
+                *errorMessage = where + "snapshotLabels must be 0..255";
+                return false;
+            }
+        }
+        std::sort(resolved.skipLabels.begin(), resolved.skipLabels.end());
+        resolved.skipLabels.erase(std::unique(resolved.skipLabels.begin(), resolved.skipLabels.end()), resolved.skipLabels.end());
+        std::sort(resolved.snapshotLabels.begin(), resolved.snapshotLabels.end());
+        resolved.snapshotLabels.erase(std::unique(resolved.snapshotLabels.begin(), resolved.snapshotLabels.end()), resolved.snapshotLabels.end());
+        for (int label : resolved.snapshotLabels) {
+            if (std::binary_search(resolved.skipLabels.begin(), resolved.skipLabels.end(), label)) {
+                *errorMessage = where + "label " + std::to_string(label) + " is both skipped and in snapshotLabels";
+                return false;
+            }
+        }
+        if (resolved.snapshotOnly && resolved.snapshotLabels.empty()) {
+            *errorMessage = where + "snapshotOnly needs at least one snapshot label";
+            return false;
+        }
+        target->channels[ch] = resolved;
+    }
+
+    if (profile.allChannels) {
+        for (int ch : receiveChannels) {
+            if (target->channels[ch].channel < 0 &&
+                std::find(profile.removeChannels.begin(), profile.removeChannels.end(), ch) == profile.removeChannels.end()) {
+                target->channels[ch].channel = ch;
+            }
+        }
+    }
+    for (ChannelProfile& channel : target->channels) {
+        if (channel.channel >= 0 && channel.listWords == 0) {
+            channel.listWords = channel.channel < (int)currentListWords.size() ? currentListWords[channel.channel] : LIST_DEFAULT_WORDS;
+        }
+    }
+    return true;
+}
+
+std::vector<SetupStep> BuildSetupPlan(const ReceiverLayout& target, const ReceiverLayout& applied, bool clearUnchanged) {
+    std::vector<SetupStep> plan;
+    if (target.eventLogSize != applied.eventLogSize) {
+        plan.push_back({SetupStepKind::EventLogConfig, -1, LOGCFG_ENABLE, target.eventLogSize});
+    }
+
+    size_t channelSlots = std::max(target.channels.size(), applied.channels.size());
+    for (size_t i = 0; i < channelSlots; ++i) {
+        ChannelProfile none;
+        const ChannelProfile& want = i < target.channels.size() ? target.channels[i] : none;
+        const ChannelProfile& have = i < applied.channels.size() ? applied.channels[i] : none;
+        int ch = (int)i;
+        if (want.channel < 0) {
+            if (have.channel >= 0) plan.push_back({SetupStepKind::ChDisable, ch, CHCFG429_INACTIVE, 0});
+            continue;
+        }
+        if (want == have) {
+            if (clearUnchanged) plan.push_back({SetupStepKind::ListClear, ch, 0, want.listWords});
+            continue;
+        }
+        // A changed channel is rebuilt whole; labels it no longer skips or snapshots are pointed back at the new
+        // default message (which drops them on a snapshot-only channel)
+        plan.push_back({SetupStepKind::ChConfig, ch, ChannelConfigFlags(want), 0});
+        if (want.snapshotOnly) {
+            plan.push_back({SetupStepKind::FilterDefault, ch, MSGCRT429_SKIP, 0});
+        } else {
+            plan.push_back({SetupStepKind::FilterDefault, ch, MSGCRT429_HIT | want.records, 0});
+            plan.push_back({SetupStepKind::ListRcvCreate, ch, LISTCRT429_FIFO, want.listWords});
+        }
+        for (int label : want.skipLabels) plan.push_back({SetupStepKind::FilterSkip, ch, MSGCRT429_SKIP, label});
+        for (int label : want.snapshotLabels) plan.push_back({SetupStepKind::FilterSnapshot, ch, MSGCRT429_TIMETAG, label});
+        auto kept = [&](int label) {
+            return std::binary_search(want.skipLabels.begin(), want.skipLabels.end(), label) ||
+                std::binary_search(want.snapshotLabels.begin(), want.snapshotLabels.end(), label);
+        };
+        for (int label : have.skipLabels) {
+            if (!kept(label)) plan.push_back({SetupStepKind::FilterRestore, ch, 0, label});
+        }
+        for (int label : have.snapshotLabels) {
+            if (!kept(label)) plan.push_back({SetupStepKind::FilterRestore, ch, 0, label});
+        }
+    }
+    return plan;
+}
+
+ReceiverProfile MergeProfile(const ReceiverLayout& applied, const ReceiverProfile& changes) {
+    ReceiverProfile merged;
+    merged.eventLogSize = applied.eventLogSize > 0 ? applied.eventLogSize : changes.eventLogSize;
+    merged.allChannels = false;
+    auto listed = [](const std::vector<int>& channels, int ch) {
+        return std::find(channels.begin(), channels.end(), ch) != channels.end();
+    };
+    std::vector<int> changed;
+    for (const ChannelProfile& channel : changes.channels) changed.push_back(channel.channel);
+    for (const ChannelProfile& channel : applied.channels) {
+        if (channel.channel < 0 || listed(changed, channel.channel) || listed(changes.removeChannels, channel.channel)) continue;
+        merged.channels.push_back(channel);
+    }
+    for (const ChannelProfile& channel : changes.channels) {
+        if (!listed(changes.removeChannels, channel.channel)) merged.channels.push_back(channel);
+    }
+    return merged;
+}
+
+ULONG ChannelConfigFlags(const ChannelProfile& channel) {
+    ULONG flags = channel.speed == ChannelSpeed::Auto ? CHCFG429_AUTOSPEED :
+                  channel.speed == ChannelSpeed::High ? CHCFG429_HIGHSPEED : CHCFG429_LOWSPEED;
+    if (channel.logErrors) flags |= CHCFG429_LOGERR;
+    if (channel.selfTest) flags |= CHCFG429_SELFTEST;
+    return flags;
+}
+
+const char* SetupStepName(SetupStepKind kind) {
+    switch (kind) {
+        case SetupStepKind::EventLogConfig: return "EventLogConfig";
+        case SetupStepKind::ChConfig: return "ChConfig";
+        case SetupStepKind::ChDisable: return "ChDisable";
+        case SetupStepKind::FilterDefault: return "FilterDefault";
+        case SetupStepKind::ListRcvCreate: return "ListRcvCreate";
+        case SetupStepKind::FilterSkip: return "FilterSkip";
+        case SetupStepKind::FilterSnapshot: return "FilterSnapshot";
+        case SetupStepKind::FilterRestore: return "FilterRestore";
+        case SetupStepKind::ListClear: return "ListClear";
+    }
+    return "Unknown";
+}
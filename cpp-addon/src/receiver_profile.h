@@ -0,0 +1,111 @@
+#ifndef RECEIVER_PROFILE_H
+#define RECEIVER_PROFILE_H
+
+// Declarative receiver setup. A ReceiverProfile says what each receive channel should look like (speed, list size,
+// message records, labels dropped at the card); ResolveProfile validates it against a session once and fills in the
+// defaults, BuildSetupPlan diffs the result against the layout the card already has and returns only the driver
+// calls that change something. A session re-initialized with the profile it already runs only clears its lists.
+// MergeProfile turns a partial change (applyReceiverConfig) into a full profile, so the same diff yields the minimal
+// per-channel change set that a monitoring session applies channel by channel.
+//
+// Snapshot labels get a message record of their own (FilterSet with MSGCRT429_TIMETAG): the card keeps the latest
+// word and when it arrived, and the reader refreshes all of them with a few MsgGroupBlockRd calls instead of
+// draining every repeat through the receive list. snapshotOnly drops everything else at the card and creates no list.
+
+#include "BTICARD.H"
+#include "BTI429.H"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const int LIST_DEFAULT_WORDS = 1024;   // Initial receive list capacity per channel
+const int LIST_MIN_WORDS = 16;
+const int LIST_LIMIT_WORDS = 32768;    // ListDataBlkRd counts in a USHORT
+const int EVENT_LOG_DEFAULT_SIZE = 1024;
+
+enum class ChannelSpeed { Auto, High, Low };
+
+struct ChannelProfile {
+    int channel = -1;                 // -1 = channel not configured
+    ChannelSpeed speed = ChannelSpeed::Auto;
+    int listWords = 0;                // 0 = the session's current size (LIST_DEFAULT_WORDS, or what adaptive lists grew)
+    bool logErrors = true;            // Decoder errors in the event log
+    bool selfTest = false;            // Internal wraparound
+    ULONG records = 0;                // Extra MSGCRT429_* records on the default message (ELAPSE or MAX, MIN)
+    std::vector<int> skipLabels;      // Labels dropped by the card (sorted, unique once resolved)
+    std::vector<int> snapshotLabels;  // Labels kept in card-resident message records (sorted, unique once resolved)
+    bool snapshotOnly = false;        // No receive list: only the snapshot labels are received
+
+    bool operator==(const ChannelProfile& other) const {
+        return channel == other.channel && speed == other.speed && listWords == other.listWords &&
+            logErrors == other.logErrors && selfTest == other.selfTest && records == other.records &&
+            skipLabels == other.skipLabels && snapshotLabels == other.snapshotLabels && snapshotOnly == other.snapshotOnly;
+    }
+    bool operator!=(const ChannelProfile& other) const { return !(*this == other); }
+};
+
+struct ReceiverProfile {
+    int eventLogSize = EVENT_LOG_DEFAULT_SIZE;
+    bool allChannels = true;          // Receive channels missing from `channels` get defaults; false leaves them off
+    std::vector<ChannelProfile> channels;
+    std::vector<int> removeChannels;  // Channels to leave off even with allChannels; MergeProfile switches them off
+};
+
+// What a session's card-side receive setup is (or should be); channels are indexed by channel number
+struct ReceiverLayout {
+    int eventLogSize = 0;             // 0 = not configured
+    std::vector<ChannelProfile> channels;
+};
+
+enum class SetupStepKind {
+    EventLogConfig,   // value = log size
+    ChConfig,         // flags = CHCFG429_*
+    ChDisable,        // ChConfig(CHCFG429_INACTIVE) for a channel the profile no longer receives on
+    FilterDefault,    // flags = MSGCRT429_*
+    ListRcvCreate,    // value = words
+    FilterSkip,       // value = label
+    FilterSnapshot,   // value = label, flags = MSGCRT429_TIMETAG; the message address joins the session's snapshot set
+    FilterRestore,    // value = label, routed back to the default message (FilterWr for every SDI)
+    ListClear         // Unchanged channel: reuse its list (if any), drop the words left from before
+};
+
+struct SetupStep {
+    SetupStepKind kind;
+    int channel;      // -1 for core-wide steps
+    ULONG flags;
+    int value;
+};
+
+struct SetupStepResult {
+    SetupStepKind kind;
+    int channel;
+    int value;
+    int result;       // ERR_NONE or a driver error/status code
+    int64_t durationNs;
+};
+
+struct SetupReport {
+    bool success = false;
+    bool pending = false;             // Hot change still running when the caller stopped waiting
+    std::string message;
+    int errorCode = 0;
+    int channelsConfigured = 0;       // Channels whose steps ran
+    int channelsReused = 0;           // Channels found already configured as requested
+    int64_t totalNs = 0;
+    std::vector<SetupStepResult> steps;
+};
+
+// Validates profile against the session's receive channels and resolves its defaults into target
+bool ResolveProfile(const ReceiverProfile& profile, const std::vector<int>& receiveChannels,
+                    const std::vector<int>& currentListWords, ReceiverLayout* target, std::string* errorMessage);
+// Driver calls that turn `applied` into `target`, channel by channel in ascending order. Unchanged channels get a
+// ListClear unless clearUnchanged is false (hot changes leave them streaming).
+std::vector<SetupStep> BuildSetupPlan(const ReceiverLayout& target, const ReceiverLayout& applied, bool clearUnchanged = true);
+// Full profile: the configured channels of `applied`, with those in `changes` replaced or removed
+ReceiverProfile MergeProfile(const ReceiverLayout& applied, const ReceiverProfile& changes);
+
+ULONG ChannelConfigFlags(const ChannelProfile& channel);
+const char* SetupStepName(SetupStepKind kind);
+
+#endif // RECEIVER_PROFILE_H
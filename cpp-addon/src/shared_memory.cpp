@@ -0,0 +1,129 @@
+#include "shared_memory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size, std::string* errorMessage) {
+    Close();
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFFu), name.c_str());
+    if (mapping == nullptr) {
+        *errorMessage = "CreateFileMapping failed for " + name + " (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (view == nullptr) {
+        *errorMessage = "MapViewOfFile failed for " + name + " (error " + std::to_string(GetLastError()) + ")";
+        CloseHandle(mapping);
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = view;
+    size_ = size;
+    return true;
+}
+
+bool SharedMemoryRegion::Open(const std::string& name, std::string* errorMessage) {
+    Close();
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (mapping == nullptr) {
+        *errorMessage = "Shared memory " + name + " not found (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (view == nullptr) {
+        *errorMessage = "MapViewOfFile failed for " + name + " (error " + std::to_string(GetLastError()) + ")";
+        CloseHandle(mapping);
+        return false;
+    }
+    MEMORY_BASIC_INFORMATION info;
+    size_t size = VirtualQuery(view, &info, sizeof(info)) ? info.RegionSize : 0;
+    mapping_ = mapping;
+    data_ = view;
+    size_ = size;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle((HANDLE)mapping_);
+    data_ = nullptr;
+    mapping_ = nullptr;
+    size_ = 0;
+}
+
+#else
+
+namespace {
+// POSIX shm names are a single path component starting with '/'; map "Local\Name" style names onto that
+std::string PosixShmName(const std::string& name) {
+    std::string result = "/";
+    for (char c : name) result += (c == '\\' || c == '/') ? '_' : c;
+    return result;
+}
+}
+
+bool SharedMemoryRegion::Create(const std::string& name, size_t size, std::string* errorMessage) {
+    Close();
+    std::string posixName = PosixShmName(name);
+    int fd = shm_open(posixName.c_str(), O_CREAT | O_RDWR, 0660);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        *errorMessage = "shm_open failed for " + posixName + ": " + std::strerror(errno);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        *errorMessage = "mmap failed for " + posixName + ": " + std::strerror(errno);
+        return false;
+    }
+    data_ = view;
+    size_ = size;
+    posixName_ = posixName;
+    owner_ = true;
+    return true;
+}
+
+bool SharedMemoryRegion::Open(const std::string& name, std::string* errorMessage) {
+    Close();
+    std::string posixName = PosixShmName(name);
+    int fd = shm_open(posixName.c_str(), O_RDWR, 0);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        *errorMessage = "Shared memory " + posixName + " not found: " + std::strerror(errno);
+        if (fd >= 0) close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) {
+        *errorMessage = "mmap failed for " + posixName + ": " + std::strerror(errno);
+        return false;
+    }
+    data_ = view;
+    size_ = (size_t)st.st_size;
+    posixName_ = posixName;
+    owner_ = false;
+    return true;
+}
+
+void SharedMemoryRegion::Close() {
+    if (data_) munmap(data_, size_);
+    if (owner_) shm_unlink(posixName_.c_str());
+    data_ = nullptr;
+    size_ = 0;
+    owner_ = false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SHARED_MEMORY_H
+#define SHARED_MEMORY_H
+
+// Named shared-memory region: a pagefile-backed file mapping on Windows, shm_open + mmap elsewhere.
+// The creator sizes the region; openers map whatever size the creator chose.
+
+#include <cstddef>
+#include <string>
+
+class SharedMemoryRegion {
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion() { Close(); }
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    // Creates (or reuses) the named region with the given size, zero-filled when new
+    bool Create(const std::string& name, size_t size, std::string* errorMessage);
+    // Maps an existing region read/write
+    bool Open(const std::string& name, std::string* errorMessage);
+    void Close();
+
+    void* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    bool IsOpen() const { return data_ != nullptr; }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr; // HANDLE
+#else
+    std::string posixName_;
+    bool owner_ = false;
+#endif
+};
+
+#endif // SHARED_MEMORY_H
@@ -0,0 +1,176 @@
+#include "shm_publisher.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+int64_t EpochNowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+}
+
+bool ShmPublisher::Create(const std::string& name, std::string* errorMessage) {
+    if (!region_.Create(name, CAPSHM_TOTAL_SIZE, errorMessage)) return false;
+
+    header_ = static_cast<CapShmHeader*>(region_.Data());
+    std::memset(region_.Data(), 0, CAPSHM_TOTAL_SIZE); // A reused region may hold a previous run's data
+    header_->version = CAPSHM_VERSION;
+    header_->headerSize = CAPSHM_HEADER_SIZE;
+    header_->totalSize = (uint32_t)CAPSHM_TOTAL_SIZE;
+    header_->ringCapacity = CAPSHM_RING_CAPACITY;
+    header_->maxSessions = CAPSHM_MAX_SESSIONS;
+    header_->maxChannels = CAPSHM_MAX_CHANNELS;
+    header_->labels = CAPSHM_LABELS;
+#ifdef _WIN32
+    header_->daemonPid = GetCurrentProcessId();
+#else
+    header_->daemonPid = (uint32_t)getpid();
+#endif
+    header_->state = CAPSHM_STATE_STARTING;
+    header_->heartbeatMs = EpochNowMs();
+    writeIndex_ = 0;
+    for (auto& key : slotKeys_) key.store(0, std::memory_order_relaxed);
+    CAPSHM_BARRIER();
+    header_->magic = CAPSHM_MAGIC; // Last: readers treat the region as valid once the magic is set
+    return true;
+}
+
+void ShmPublisher::Close(uint32_t finalState) {
+    if (!header_) return;
+    header_->state = finalState;
+    header_->heartbeatMs = EpochNowMs();
+    header_ = nullptr;
+    region_.Close();
+}
+
+void ShmPublisher::SetState(uint32_t state) {
+    if (header_) header_->state = state;
+}
+
+void ShmPublisher::Heartbeat() {
+    if (header_) header_->heartbeatMs = EpochNowMs();
+}
+
+int ShmPublisher::SlotFor(int card, int core) const {
+    int key = ((card << 8) | core) + 1;
+    for (int i = 0; i < CAPSHM_MAX_SESSIONS; ++i) {
+        if (slotKeys_[i].load(std::memory_order_acquire) == key) return i;
+    }
+    return -1;
+}
+
+void ShmPublisher::PublishWords(const std::vector<ArincUpdateData>& batch, bool toRing) {
+    if (!header_ || batch.empty()) return;
+    TRACE_SCOPE_ARG("ShmPublish", "words", batch.size());
+
+    int lastCard = -1, lastCore = -1, slot = -1;
+    for (const ArincUpdateData& update : batch) {
+        if (toRing) {
+            CapShmWord* entry = CapShmRingSlot(header_, writeIndex_);
+            entry->seq = 0; // Invalidate first so a lapped reader can't accept a half-written slot
+            CAPSHM_BARRIER();
+            entry->timestampNs = update.timestamp_ns;
+            entry->timestampMs = update.timestamp_ms;
+            entry->word = (uint32_t)update.word;
+            entry->channel = (uint8_t)update.channel;
+            entry->label = IsGapMarker(update) ? 0 : (uint8_t)update.label;
+            entry->card = (uint8_t)update.card | (IsGapMarker(update) ? CAPSHM_WORD_GAP : 0);
+            entry->core = (uint8_t)update.core;
+            CAPSHM_BARRIER();
+            entry->seq = ++writeIndex_;
+        }
+
+        if (update.card != lastCard || update.core != lastCore) {
+            slot = SlotFor(update.card, update.core);
+            lastCard = update.card;
+            lastCore = update.core;
+        }
+        if (slot < 0 || update.channel < 0 || update.channel >= CAPSHM_MAX_CHANNELS || IsGapMarker(update)) continue;
+        CapShmValue* value = CapShmValueAt(header_, slot, update.channel, update.label & (CAPSHM_LABELS - 1));
+        uint32_t seq = value->seq;
+        value->seq = seq + 1; // Odd: update in progress
+        CAPSHM_BARRIER();
+        value->word = (uint32_t)update.word;
+        value->timestampMs = update.timestamp_ms;
+        value->timestampNs = update.timestamp_ns;
+        value->count = value->count + 1;
+        CAPSHM_BARRIER();
+        value->seq = seq + 2;
+    }
+
+    if (toRing) {
+        CAPSHM_BARRIER();
+        header_->writeIndex = writeIndex_;
+    }
+}
+
+void ShmPublisher::PublishError(const ArincErrorData& error) {
+    if (!header_) return;
+    uint32_t seq = header_->errorSeq;
+    header_->errorSeq = seq + 1;
+    CAPSHM_BARRIER();
+    header_->errorCode = error.status_code;
+    header_->errorChannel = error.channel;
+    header_->errorCard = error.card;
+    header_->errorCore = error.core;
+    std::strncpy(header_->errorText, error.message.c_str(), CAPSHM_ERROR_TEXT - 1);
+    header_->errorText[CAPSHM_ERROR_TEXT - 1] = '\0';
+    CAPSHM_BARRIER();
+    header_->errorSeq = seq + 2;
+    header_->errorCount = header_->errorCount + 1;
+}
+
+void ShmPublisher::PublishSessions(const std::vector<DeviceSession*>& sessions) {
+    if (!header_) return;
+    auto load = [](const std::atomic<uint64_t>& counter) { return counter.load(std::memory_order_relaxed); };
+
+    uint32_t count = 0;
+    for (DeviceSession* session : sessions) {
+        int slot = session->Index();
+        if (slot < 0 || slot >= CAPSHM_MAX_SESSIONS) {
+            BTI_LOG_AT(LogLevel::Warn, 1, "Session card %d core %d exceeds the %d shared-memory slots; not published.",
+                session->CardNum(), session->CoreNum(), CAPSHM_MAX_SESSIONS);
+            continue;
+        }
+        slotKeys_[slot].store(((session->CardNum() << 8) | session->CoreNum()) + 1, std::memory_order_release);
+
+        CapShmSession* block = CapShmSessionAt(header_, slot);
+        MonitorStats& stats = session->Stats();
+        uint32_t seq = block->seq;
+        block->seq = seq + 1;
+        CAPSHM_BARRIER();
+        block->card = session->CardNum();
+        block->core = session->CoreNum();
+        block->monitoring = session->IsMonitoring() ? 1 : 0;
+        block->channelCount = (uint32_t)session->ChannelCount();
+        block->rcvMask = 0;
+        block->xmtMask = 0;
+        for (const ChannelInfo& ch : session->Channels()) {
+            if (ch.channel >= 32) continue;
+            if (ch.receive) block->rcvMask |= 1u << ch.channel;
+            if (ch.transmit) block->xmtMask |= 1u << ch.channel;
+        }
+        block->cycles = load(stats.cycles);
+        block->lastCycleUs = load(stats.lastCycleUs);
+        block->maxCycleUs = load(stats.maxCycleUs);
+        block->eventLogEntries = load(stats.eventLogEntries);
+        for (int ch = 0; ch < CAPSHM_MAX_CHANNELS && ch < STATS_MAX_CHANNELS; ++ch) {
+            block->wordsRead[ch] = load(stats.channels[ch].wordsRead);
+            block->listFullCount[ch] = load(stats.channels[ch].listFullCount);
+            block->errEvents[ch] = load(stats.channels[ch].errEvents);
+        }
+        CAPSHM_BARRIER();
+        block->seq = seq + 2;
+        if ((uint32_t)slot + 1 > count) count = (uint32_t)slot + 1;
+    }
+    header_->sessionCount = count;
+}
@@ -0,0 +1,42 @@
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+// Writer side of the capture shared-memory region (layout in capture_shm.h).
+// PublishWords/PublishError are called from the registry's merge thread (the single ring/value writer);
+// PublishSessions, SetState and Heartbeat from the owning process's control thread.
+
+#include "capture_shm.h"
+#include "device_session.h"
+#include "shared_memory.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class ShmPublisher {
+public:
+    bool Create(const std::string& name, std::string* errorMessage);
+    void Close(uint32_t finalState);
+    bool IsOpen() const { return header_ != nullptr; }
+    CapShmHeader* Header() const { return header_; }
+
+    void SetState(uint32_t state);
+    void Heartbeat();
+    bool StopRequested() const { return header_ && header_->stopRequest != 0; }
+
+    // Appends the batch to the word ring (when toRing) and updates the current-value table
+    void PublishWords(const std::vector<ArincUpdateData>& batch, bool toRing);
+    void PublishError(const ArincErrorData& error);
+    // Republishes each session's stats block; also assigns the session slots used by PublishWords
+    void PublishSessions(const std::vector<DeviceSession*>& sessions);
+
+private:
+    int SlotFor(int card, int core) const;
+
+    SharedMemoryRegion region_;
+    CapShmHeader* header_ = nullptr;
+    uint64_t writeIndex_ = 0; // Merge thread only
+    std::atomic<int> slotKeys_[CAPSHM_MAX_SESSIONS]; // (card << 8 | core) + 1 per slot, 0 = unused
+};
+
+#endif // SHM_PUBLISHER_H
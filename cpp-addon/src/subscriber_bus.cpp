@@ -0,0 +1,185 @@
+#include "subscriber_bus.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+uint32_t LatestKey(const ArincUpdateData& update) {
+    return ((uint32_t)(update.card & 0xFF) << 24) | ((uint32_t)(update.core & 0xFF) << 16) |
+        ((uint32_t)(update.channel & 0xFF) << 8) | (uint32_t)(update.label & 0xFF);
+}
+}
+
+SubscriberBus& Bus() {
+    static SubscriberBus* bus = new SubscriberBus(); // Leaked, like the session registry it taps
+    return *bus;
+}
+
+bool SubscriberBus::Subscriber::Matches(const ArincUpdateData& update) const {
+    if (config.card >= 0 && update.card != config.card) return false;
+    if (config.core >= 0 && update.core != config.core) return false;
+    if (config.channelMask != 0 && (update.channel < 0 || update.channel >= 32 ||
+        !(config.channelMask & (1u << update.channel)))) return false;
+    // Gap markers carry no value, only that words are missing: they matter to EveryWord consumers alone
+    if (IsGapMarker(update)) return config.policy == DeliveryPolicy::EveryWord;
+    if (config.labels.any() && !config.labels.test(update.label & 0xFF)) return false;
+    return true;
+}
+
+// Called on the delivering thread; only filters and queues, never waits on the consumer
+void SubscriberBus::Subscriber::Enqueue(const std::vector<ArincUpdateData>& batch) {
+    uint64_t matched = 0;
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping) return;
+        for (const ArincUpdateData& update : batch) {
+            if (!Matches(update)) continue;
+            ++matched;
+            if (config.policy == DeliveryPolicy::EveryWord) {
+                queue.push_back(update);
+                if (queue.size() > config.maxQueue) {
+                    queue.pop_front();
+                    StatsAdd(wordsDropped);
+                }
+            } else {
+                auto result = latest.emplace(LatestKey(update), update);
+                if (!result.second) {
+                    result.first->second = update;
+                    if (config.policy == DeliveryPolicy::Coalesced) StatsAdd(wordsCoalesced);
+                }
+            }
+        }
+        size_t depth = config.policy == DeliveryPolicy::EveryWord ? queue.size() : latest.size();
+        StatsUpdateMax(queueDepthMax, (uint64_t)depth);
+        wake = config.policy == DeliveryPolicy::EveryWord && queue.size() >= config.batchSize;
+    }
+    if (matched) StatsAdd(wordsMatched, matched);
+    if (wake) cv.notify_one();
+}
+
+void SubscriberBus::Subscriber::DeliveryLoop() {
+    TraceSetThreadName(("Subscriber " + config.name).c_str());
+    const auto period = std::chrono::milliseconds(config.intervalMs);
+    auto nextDue = std::chrono::steady_clock::now() + period;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        std::vector<ArincUpdateData>* batch = nullptr;
+        if (config.policy == DeliveryPolicy::EveryWord) {
+            cv.wait_until(lock, nextDue, [this] { return stopping || queue.size() >= config.batchSize; });
+            if (stopping && (queue.empty() || !config.drainOnStop)) {
+                StatsAdd(wordsDropped, queue.size()); // A cancelled sink could not take them any more
+                queue.clear();
+                break;
+            }
+            if (!queue.empty()) {
+                size_t count = std::min(queue.size(), config.batchSize);
+                batch = new std::vector<ArincUpdateData>(queue.begin(), queue.begin() + count);
+                queue.erase(queue.begin(), queue.begin() + count);
+            }
+            nextDue = std::chrono::steady_clock::now() + period;
+        } else {
+            cv.wait_until(lock, nextDue, [this] { return stopping; });
+            if (stopping) break;
+            nextDue += period;
+            auto now = std::chrono::steady_clock::now();
+            if (nextDue < now) nextDue = now + period; // Don't burst to catch up after a stalled consumer
+            if (!latest.empty()) {
+                batch = new std::vector<ArincUpdateData>();
+                batch->reserve(latest.size());
+                for (const auto& entry : latest) batch->push_back(entry.second);
+                if (config.policy == DeliveryPolicy::Coalesced) latest.clear();
+            }
+        }
+        if (!batch) continue;
+
+        size_t words = batch->size();
+        lock.unlock();
+        {
+            TRACE_SCOPE_ARG("SubscriberDeliver", "words", words);
+            sink(context, batch); // May block on a slow consumer; only this subscriber waits
+        }
+        StatsAdd(wordsDelivered, words);
+        StatsAdd(batchesDelivered);
+        lock.lock();
+    }
+}
+
+void SubscriberBus::Tap(void* context, const std::vector<ArincUpdateData>& batch) {
+    SubscriberBus* bus = static_cast<SubscriberBus*>(context);
+    std::lock_guard<std::mutex> lock(bus->mutex_);
+    for (const auto& subscriber : bus->subscribers_) subscriber->Enqueue(batch);
+}
+
+int SubscriberBus::Subscribe(const SubscriberConfig& config, SubscriberSink sink, SubscriberCancel cancel, void* context) {
+    // Outside mutex_: the tap runs under the registry's sink lock and then takes mutex_
+    std::call_once(tapOnce_, [this] { Sessions().AddBatchTap(&SubscriberBus::Tap, this); });
+
+    auto subscriber = std::make_shared<Subscriber>();
+    subscriber->config = config;
+    subscriber->config.batchSize = std::max<size_t>(config.batchSize, 1);
+    subscriber->config.intervalMs = std::max(config.intervalMs, 1);
+    subscriber->config.maxQueue = std::max(config.maxQueue, subscriber->config.batchSize);
+    subscriber->sink = sink;
+    subscriber->cancel = cancel;
+    subscriber->context = context;
+    Sessions().SetDemand(subscriber.get(), config.card, config.core, config.channelMask); // Lazy polling follows the filter
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriber->id = nextId_++;
+    if (subscriber->config.name.empty()) subscriber->config.name = std::to_string(subscriber->id);
+    subscriber->thread = std::thread(&Subscriber::DeliveryLoop, subscriber.get());
+    subscribers_.push_back(subscriber);
+    BTI_LOG_DEBUG("Subscriber %d (%s) added.", subscriber->id, subscriber->config.name.c_str());
+    return subscriber->id;
+}
+
+bool SubscriberBus::Unsubscribe(int id, SubscriberStats* finalStats) {
+    std::shared_ptr<Subscriber> subscriber;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(subscribers_.begin(), subscribers_.end(),
+            [id](const std::shared_ptr<Subscriber>& s) { return s->id == id; });
+        if (it == subscribers_.end()) return false;
+        subscriber = *it;
+        subscribers_.erase(it); // The tap no longer reaches it once mutex_ is released
+    }
+    {
+        std::lock_guard<std::mutex> lock(subscriber->mutex);
+        subscriber->stopping = true;
+    }
+    subscriber->cv.notify_one();
+    if (subscriber->cancel) subscriber->cancel(subscriber->context);
+    if (subscriber->thread.joinable()) subscriber->thread.join();
+    Sessions().ClearDemand(subscriber.get());
+    if (finalStats) *finalStats = subscriber->Stats();
+    BTI_LOG_DEBUG("Subscriber %d (%s) removed.", id, subscriber->config.name.c_str());
+    return true;
+}
+
+SubscriberStats SubscriberBus::Subscriber::Stats() {
+    auto load = [](const std::atomic<uint64_t>& counter) { return counter.load(std::memory_order_relaxed); };
+    SubscriberStats stats;
+    stats.id = id;
+    stats.name = config.name;
+    stats.policy = config.policy;
+    stats.wordsMatched = load(wordsMatched);
+    stats.wordsDelivered = load(wordsDelivered);
+    stats.wordsDropped = load(wordsDropped);
+    stats.wordsCoalesced = load(wordsCoalesced);
+    stats.batchesDelivered = load(batchesDelivered);
+    stats.queueDepthMax = load(queueDepthMax);
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.queueDepth = config.policy == DeliveryPolicy::EveryWord ? queue.size() : latest.size();
+    return stats;
+}
+
+std::vector<SubscriberStats> SubscriberBus::Stats() {
+    std::vector<SubscriberStats> result;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& subscriber : subscribers_) result.push_back(subscriber->Stats());
+    return result;
+}
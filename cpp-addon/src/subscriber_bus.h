@@ -0,0 +1,108 @@
+#ifndef SUBSCRIBER_BUS_H
+#define SUBSCRIBER_BUS_H
+
+// Fan-out of the ingest stream to any number of independent subscribers (display, recorder, alarms,
+// network forwarder...). The bus taps the session registry: the delivering thread only filters each batch
+// into the matching subscribers' bounded queues. Every subscriber has its own delivery thread, so a slow
+// consumer backs up (and sheds from) its own queue only, never the other subscribers or the hardware reader.
+// This layer has no N-API dependency; addon.cpp supplies a sink that hands batches to the subscriber's JS callback.
+
+#include "device_session.h"
+
+#include <atomic>
+#include <bitset>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class DeliveryPolicy {
+    EveryWord,  // Every matching word in order; oldest words are dropped when the queue is full
+    Coalesced,  // Latest word per card/core/channel/label changed since the last delivery, every intervalMs
+    Snapshot    // Latest word of every label seen so far, every intervalMs (changed or not)
+};
+
+struct SubscriberConfig {
+    std::string name;                    // For stats/logs only
+    int card = -1;                       // -1 = any
+    int core = -1;                       // -1 = any
+    uint32_t channelMask = 0;            // Bit per channel; 0 = all channels
+    std::bitset<256> labels;             // Empty = all labels
+    DeliveryPolicy policy = DeliveryPolicy::EveryWord;
+    size_t batchSize = 512;              // Max words per delivered batch; EveryWord delivers early once this many are queued
+    int intervalMs = 20;                 // Max latency (EveryWord) or delivery period (Coalesced/Snapshot)
+    size_t maxQueue = 65536;             // EveryWord queue bound in words
+    bool drainOnStop = false;            // EveryWord: Unsubscribe delivers what is still queued (for sinks that never block)
+};
+
+// Delivery takes ownership of the batch and may block (that only stalls this subscriber)
+typedef void (*SubscriberSink)(void* context, std::vector<ArincUpdateData>* batch);
+// Called by Unsubscribe before it joins the delivery thread; must make a blocked SubscriberSink call return
+typedef void (*SubscriberCancel)(void* context);
+
+struct SubscriberStats {
+    int id = 0;
+    std::string name;
+    DeliveryPolicy policy = DeliveryPolicy::EveryWord;
+    uint64_t wordsMatched = 0;       // Words that passed the filter
+    uint64_t wordsDelivered = 0;
+    uint64_t wordsDropped = 0;       // EveryWord: shed from a full queue, or left queued at Unsubscribe
+    uint64_t wordsCoalesced = 0;     // Coalesced: superseded by a newer word before delivery
+    uint64_t batchesDelivered = 0;
+    uint64_t queueDepth = 0;
+    uint64_t queueDepthMax = 0;
+};
+
+class SubscriberBus {
+public:
+    // Returns the new subscription id (> 0)
+    int Subscribe(const SubscriberConfig& config, SubscriberSink sink, SubscriberCancel cancel, void* context);
+    // Stops the subscriber's delivery thread; on return its sink will not be called again. finalStats: its counters
+    // after the last delivery
+    bool Unsubscribe(int id, SubscriberStats* finalStats = nullptr);
+    std::vector<SubscriberStats> Stats();
+
+private:
+    struct Subscriber {
+        int id = 0;
+        SubscriberConfig config;
+        SubscriberSink sink = nullptr;
+        SubscriberCancel cancel = nullptr;
+        void* context = nullptr;
+
+        std::mutex mutex; // Guards the queues below
+        std::condition_variable cv;
+        std::deque<ArincUpdateData> queue;               // EveryWord
+        std::map<uint32_t, ArincUpdateData> latest;      // Coalesced (pending) / Snapshot (all seen)
+        bool stopping = false;
+        std::thread thread;
+
+        std::atomic<uint64_t> wordsMatched{0};
+        std::atomic<uint64_t> wordsDelivered{0};
+        std::atomic<uint64_t> wordsDropped{0};
+        std::atomic<uint64_t> wordsCoalesced{0};
+        std::atomic<uint64_t> batchesDelivered{0};
+        std::atomic<uint64_t> queueDepthMax{0};
+
+        bool Matches(const ArincUpdateData& update) const;
+        SubscriberStats Stats();
+        void Enqueue(const std::vector<ArincUpdateData>& batch);
+        void DeliveryLoop();
+    };
+
+    static void Tap(void* context, const std::vector<ArincUpdateData>& batch);
+
+    std::mutex mutex_; // Guards subscribers_; held by the tap while it fans a batch out
+    std::vector<std::shared_ptr<Subscriber>> subscribers_;
+    int nextId_ = 1;
+    std::once_flag tapOnce_; // The tap is installed on first Subscribe and stays (an empty bus costs one lock)
+};
+
+SubscriberBus& Bus();
+
+#endif // SUBSCRIBER_BUS_H
@@ -0,0 +1,205 @@
+#include "trace_events.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// --- Trace State ---
+std::atomic<bool> g_traceEnabled(false);
+
+namespace {
+
+struct TraceThreadBuffer {
+    std::vector<TraceEvent> events;        // Written only by the owning thread
+    std::atomic<size_t> count{0};          // Published prefix length (release on write, acquire on read)
+    std::atomic<uint64_t> dropped{0};      // Events lost because the buffer was full
+    std::atomic<uint32_t> generation{0};   // Trace session the contents belong to
+    std::atomic<bool> ownerAlive{true};    // Cleared when the owning thread exits, so the slot can be reused
+    uint32_t tid = 0;
+    std::string threadName;                // Guarded by traceRegistryMutex
+};
+
+std::mutex traceRegistryMutex;
+std::vector<std::unique_ptr<TraceThreadBuffer>> traceBuffers; // Kept until process exit; reused once stale
+std::atomic<uint32_t> traceGeneration{0};
+std::atomic<size_t> traceCapacity{0};
+std::atomic<int64_t> traceEpochNs{0};
+uint32_t traceNextTid = 1;
+
+// Marks the buffer free when its thread exits
+struct TraceThreadHandle {
+    TraceThreadBuffer* buffer = nullptr;
+    std::string pendingName;
+    ~TraceThreadHandle() {
+        if (buffer) buffer->ownerAlive.store(false, std::memory_order_release);
+    }
+};
+
+thread_local TraceThreadHandle t_traceHandle;
+
+int64_t SteadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns this thread's buffer, registering it or resetting it for a new trace session as needed
+TraceThreadBuffer* TraceThreadLocalBuffer() {
+    uint32_t generation = traceGeneration.load(std::memory_order_acquire);
+    TraceThreadBuffer* buf = t_traceHandle.buffer;
+
+    if (!buf) {
+        std::lock_guard<std::mutex> lock(traceRegistryMutex);
+        for (auto& candidate : traceBuffers) {
+            // Reuse a slot whose thread is gone and whose events belong to an older session
+            if (!candidate->ownerAlive.load(std::memory_order_acquire) &&
+                candidate->generation.load(std::memory_order_acquire) != generation) {
+                buf = candidate.get();
+                buf->ownerAlive.store(true, std::memory_order_release);
+                break;
+            }
+        }
+        if (!buf) {
+            traceBuffers.push_back(std::make_unique<TraceThreadBuffer>());
+            buf = traceBuffers.back().get();
+            buf->generation.store(generation - 1, std::memory_order_relaxed); // Force a reset below
+        }
+        buf->tid = traceNextTid++;
+        buf->threadName = t_traceHandle.pendingName;
+        t_traceHandle.buffer = buf;
+    }
+
+    if (buf->generation.load(std::memory_order_relaxed) != generation) {
+        // Owner-side reset; the writer only reads buffers whose generation matches the current session
+        buf->count.store(0, std::memory_order_relaxed);
+        buf->dropped.store(0, std::memory_order_relaxed);
+        buf->events.resize(traceCapacity.load(std::memory_order_relaxed));
+        buf->generation.store(generation, std::memory_order_release);
+    }
+    return buf;
+}
+
+void AppendJsonEvent(std::string& out, const TraceEvent& ev, uint32_t tid, bool& first) {
+    char line[320];
+    const double tsUs = ev.tsNs / 1000.0;
+    int n = 0;
+    switch (ev.phase) {
+    case 'X':
+        if (ev.argName) {
+            n = std::snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"bti\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"%s\":%lld}}",
+                ev.name, tsUs, ev.durNs / 1000.0, tid, ev.argName, (long long)ev.arg);
+        } else {
+            n = std::snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"bti\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                ev.name, tsUs, ev.durNs / 1000.0, tid);
+        }
+        break;
+    case 'C':
+        n = std::snprintf(line, sizeof(line),
+            "{\"name\":\"%s\",\"cat\":\"bti\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"%s\":%lld}}",
+            ev.name, tsUs, tid, ev.argName ? ev.argName : "value", (long long)ev.arg);
+        break;
+    case 's':
+    case 'f':
+        n = std::snprintf(line, sizeof(line),
+            "{\"name\":\"%s\",\"cat\":\"bti.flow\",\"ph\":\"%c\",\"id\":%lld,\"ts\":%.3f,\"pid\":1,\"tid\":%u%s}",
+            ev.name, ev.phase, (long long)ev.arg, tsUs, tid, ev.phase == 'f' ? ",\"bp\":\"e\"" : "");
+        break;
+    default: // 'i'
+        if (ev.argName) {
+            n = std::snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"bti\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"%s\":%lld}}",
+                ev.name, tsUs, tid, ev.argName, (long long)ev.arg);
+        } else {
+            n = std::snprintf(line, sizeof(line),
+                "{\"name\":\"%s\",\"cat\":\"bti\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                ev.name, tsUs, tid);
+        }
+        break;
+    }
+    if (n <= 0) return;
+    if (!first) out += ",\n";
+    first = false;
+    out.append(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1);
+}
+
+} // namespace
+
+// --- Record Path ---
+
+int64_t TraceNowNs() {
+    return SteadyNowNs() - traceEpochNs.load(std::memory_order_relaxed);
+}
+
+void TraceRecord(const TraceEvent& ev) {
+    TraceThreadBuffer* buf = TraceThreadLocalBuffer();
+    size_t n = buf->count.load(std::memory_order_relaxed);
+    if (n >= buf->events.size()) {
+        buf->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buf->events[n] = ev;
+    buf->count.store(n + 1, std::memory_order_release);
+}
+
+void TraceSetThreadName(const char* name) {
+    t_traceHandle.pendingName = name ? name : "";
+    if (t_traceHandle.buffer) {
+        std::lock_guard<std::mutex> lock(traceRegistryMutex);
+        t_traceHandle.buffer->threadName = t_traceHandle.pendingName;
+    }
+}
+
+// --- Control ---
+
+bool TraceStart(size_t eventsPerThread) {
+    if (eventsPerThread == 0) return false;
+    std::lock_guard<std::mutex> lock(traceRegistryMutex);
+    if (g_traceEnabled.load()) return false;
+    traceCapacity.store(eventsPerThread, std::memory_order_relaxed);
+    traceEpochNs.store(SteadyNowNs(), std::memory_order_relaxed);
+    traceGeneration.fetch_add(1, std::memory_order_acq_rel); // Invalidates every buffer; owners reset lazily
+    g_traceEnabled.store(true, std::memory_order_release);
+    return true;
+}
+
+void TraceStop() {
+    g_traceEnabled.store(false, std::memory_order_release);
+}
+
+std::string TraceToJson(size_t* eventCount, uint64_t* droppedCount) {
+    std::lock_guard<std::mutex> lock(traceRegistryMutex);
+    uint32_t generation = traceGeneration.load(std::memory_order_acquire);
+    size_t total = 0;
+    uint64_t dropped = 0;
+    bool first = false; // process_name metadata is always emitted first
+
+    std::string out;
+    out.reserve(1 << 16);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"bti_addon\"}}";
+
+    char meta[256];
+
+    for (auto& buf : traceBuffers) {
+        if (buf->generation.load(std::memory_order_acquire) != generation) continue;
+        size_t n = buf->count.load(std::memory_order_acquire);
+        dropped += buf->dropped.load(std::memory_order_relaxed);
+        if (!buf->threadName.empty()) {
+            std::snprintf(meta, sizeof(meta), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                buf->tid, buf->threadName.c_str());
+            out += meta;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            AppendJsonEvent(out, buf->events[i], buf->tid, first);
+        }
+        total += n;
+    }
+    out += "\n]}\n";
+
+    if (eventCount) *eventCount = total;
+    if (droppedCount) *droppedCount = dropped;
+    return out;
+}
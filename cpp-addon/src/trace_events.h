@@ -0,0 +1,85 @@
+#ifndef TRACE_EVENTS_H
+#define TRACE_EVENTS_H
+
+// Opt-in Chrome trace-event recorder for the addon's hot paths.
+// Each thread appends to its own fixed-size buffer (single producer, no locks on the record path);
+// the JSON writer reads the published prefix of every buffer. Output loads in chrome://tracing and Perfetto.
+// When tracing is off, a TRACE_* site costs one relaxed atomic load and a branch.
+// Define BTI_DISABLE_TRACING to compile the macros out entirely.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct TraceEvent {
+    const char* name;     // Must point to a string literal (stored by pointer, not copied)
+    char phase;           // 'X' complete, 'i' instant, 'C' counter, 's'/'f' flow start/finish
+    int64_t tsNs;         // Nanoseconds since the trace epoch (set by TraceStart)
+    int64_t durNs;        // Duration for 'X' events
+    int64_t arg;          // Numeric argument ('C' value, 's'/'f' flow id)
+    const char* argName;  // Optional argument name (string literal), nullptr for none
+};
+
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool TraceEnabled() { return g_traceEnabled.load(std::memory_order_relaxed); }
+
+int64_t TraceNowNs();
+void TraceRecord(const TraceEvent& ev);
+void TraceSetThreadName(const char* name);
+
+// Control (called from the JS thread)
+bool TraceStart(size_t eventsPerThread);
+void TraceStop();
+std::string TraceToJson(size_t* eventCount, uint64_t* droppedCount);
+
+// RAII 'X' event covering the enclosing scope
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* argName = nullptr, int64_t arg = 0)
+        : name_(name), argName_(argName), arg_(arg), startNs_(TraceEnabled() ? TraceNowNs() : -1) {}
+
+    ~TraceScope() {
+        if (startNs_ >= 0) {
+            TraceRecord({name_, 'X', startNs_, TraceNowNs() - startNs_, arg_, argName_});
+        }
+    }
+
+    // Attach/replace the argument once the value is known (e.g. words read)
+    void SetArg(const char* argName, int64_t arg) { argName_ = argName; arg_ = arg; }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    const char* argName_;
+    int64_t arg_;
+    int64_t startNs_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifndef BTI_DISABLE_TRACING
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, arg) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name, argName, (int64_t)(arg))
+#define TRACE_SCOPE_NAMED(var, name) TraceScope var(name)
+#define TRACE_INSTANT(name, argName, arg) \
+    do { if (TraceEnabled()) TraceRecord({name, 'i', TraceNowNs(), 0, (int64_t)(arg), argName}); } while (0)
+#define TRACE_COUNTER(name, value) \
+    do { if (TraceEnabled()) TraceRecord({name, 'C', TraceNowNs(), 0, (int64_t)(value), "value"}); } while (0)
+#define TRACE_FLOW(name, phase, id, tsNs) \
+    do { if (TraceEnabled()) TraceRecord({name, phase, (tsNs), 0, (int64_t)(id), nullptr}); } while (0)
+#else
+struct TraceScopeNoop { void SetArg(const char*, int64_t) {} };
+#define TRACE_SCOPE(name) do {} while (0)
+#define TRACE_SCOPE_ARG(name, argName, arg) do {} while (0)
+#define TRACE_SCOPE_NAMED(var, name) TraceScopeNoop var
+#define TRACE_INSTANT(name, argName, arg) do {} while (0)
+#define TRACE_COUNTER(name, value) do {} while (0)
+#define TRACE_FLOW(name, phase, id, tsNs) do {} while (0)
+#endif
+
+#endif // TRACE_EVENTS_H
@@ -0,0 +1,62 @@
+#include "value_table.h"
+#include "native_log.h"
+#include "trace_events.h"
+
+#include <chrono>
+
+namespace {
+const int HOUSEKEEPING_INTERVAL_MS = 100; // Stats blocks, session slots and heartbeat
+}
+
+CurrentValueTable& ValueTable() {
+    static CurrentValueTable* table = new CurrentValueTable(); // Leaked, like the session registry it taps
+    return *table;
+}
+
+bool CurrentValueTable::Start(const std::string& name, std::string* errorMessage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_.load()) {
+        *errorMessage = "Current-value table is already published as " + name_ + ".";
+        return false;
+    }
+    if (!publisher_.Create(name, errorMessage)) return false;
+
+    // Slots must be assigned before the first batch, or its words have no session entry to land in
+    Sessions().WithSessions([this](const std::vector<DeviceSession*>& sessions) { publisher_.PublishSessions(sessions); });
+    publisher_.SetState(CAPSHM_STATE_RUNNING);
+    name_ = name;
+    running_.store(true);
+    thread_ = std::thread(&CurrentValueTable::HousekeepingLoop, this);
+    Sessions().AddBatchTap(&CurrentValueTable::Tap, this);
+    Sessions().SetDemand(this, -1, -1, 0); // Every value stays current
+    BTI_LOG_INFO("Publishing current values to shared memory %s.", name.c_str());
+    return true;
+}
+
+void CurrentValueTable::Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_.exchange(false)) return;
+    Sessions().RemoveBatchTap(&CurrentValueTable::Tap, this); // Returns once no merge-thread write is in flight
+    Sessions().ClearDemand(this);
+    if (thread_.joinable()) thread_.join();
+    publisher_.Close(CAPSHM_STATE_STOPPED);
+    BTI_LOG_INFO("Stopped publishing current values to %s.", name_.c_str());
+}
+
+std::string CurrentValueTable::Name() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_.load() ? name_ : std::string();
+}
+
+void CurrentValueTable::Tap(void* context, const std::vector<ArincUpdateData>& batch) {
+    static_cast<CurrentValueTable*>(context)->publisher_.PublishWords(batch, false);
+}
+
+void CurrentValueTable::HousekeepingLoop() {
+    TraceSetThreadName("ValueTable");
+    while (running_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(HOUSEKEEPING_INTERVAL_MS));
+        Sessions().WithSessions([this](const std::vector<DeviceSession*>& sessions) { publisher_.PublishSessions(sessions); });
+        publisher_.Heartbeat();
+    }
+}
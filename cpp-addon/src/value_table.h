@@ -0,0 +1,39 @@
+#ifndef VALUE_TABLE_H
+#define VALUE_TABLE_H
+
+// In-process publisher of the shared-memory current-value table (layout in capture_shm.h, C reader in
+// capture_shm_reader.h). While started, the merge thread writes every word's channel/label entry under its
+// seqlock and a housekeeping thread refreshes the per-core stats blocks and the heartbeat, so other local
+// processes can sample live values without any call into this process. The word ring is not used
+// (writeIndex stays 0); readers that need every word attach to the capture daemon instead.
+
+#include "shm_publisher.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#define VALUE_TABLE_DEFAULT_NAME "Local\\BtiArincValues"
+
+class CurrentValueTable {
+public:
+    bool Start(const std::string& name, std::string* errorMessage);
+    void Stop();
+    bool IsPublishing() const { return running_.load(); }
+    std::string Name();
+
+private:
+    static void Tap(void* context, const std::vector<ArincUpdateData>& batch);
+    void HousekeepingLoop();
+
+    std::mutex mutex_; // Guards start/stop and name_
+    ShmPublisher publisher_;
+    std::string name_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+};
+
+CurrentValueTable& ValueTable();
+
+#endif // VALUE_TABLE_H
@@ -26,6 +26,24 @@ try {
     module_root: path.join(__dirname, 'cpp-addon') 
   }); 
   console.log("BTI Addon loaded successfully in main process.");
+
+  // Route native log records (drained off the capture threads) into the main-process log
+  if (typeof btiAddon.setLogHandler === 'function') {
+    const routeNativeLog = (records) => {
+      for (const rec of records) {
+        const line = `[C++ Addon] [${rec.level}] ${rec.message}`;
+        if (rec.levelValue >= 4) console.error(line);
+        else if (rec.levelValue === 3) console.warn(line);
+        else console.log(line);
+      }
+    };
+    try {
+      btiAddon.setLogHandler(routeNativeLog, { level: process.env.BTI_LOG_LEVEL || 'info' });
+    } catch (logError) {
+      console.warn("Invalid BTI_LOG_LEVEL, using default native log level:", logError.message);
+      btiAddon.setLogHandler(routeNativeLog);
+    }
+  }
 } catch (error) {
   console.error("Failed to load bti_addon in main process:", error);
   addonLoadError = error; 
@@ -305,13 +323,14 @@ ipcMain.handle('get-all-dio-states', async (event, hCore) => {
 });
 
 // Handle Hardware Initialization
-ipcMain.handle('initialize-hardware', async () => {
+ipcMain.handle('initialize-hardware', async (event, cardNum, coreNum) => {
   if (!btiAddon) {
     throw new Error('Addon not loaded');
   }
   try {
     console.log('Calling addon.initializeHardware...');
-    const result = btiAddon.initializeHardware(); // Assuming this is synchronous for now
+    // Card/core default to 0/0; call once per core to monitor several cores into one merged stream
+    const result = (cardNum === undefined) ? btiAddon.initializeHardware() : btiAddon.initializeHardware(cardNum, coreNum ?? 0);
     console.log('Addon initializeHardware result:', result);
     // if (result.success) {
     //   // Store handles globally if needed, though passing hCore around might be better
@@ -326,7 +345,7 @@ ipcMain.handle('initialize-hardware', async () => {
 });
 
 // Handle ARINC Receiver Initialization
-ipcMain.handle('initialize-receiver', async (event, hCore) => {
+ipcMain.handle('initialize-receiver', async (event, hCore, profile) => {
     if (!btiAddon) throw new Error('Addon not loaded');
     if (!hCore) throw new Error('Invalid core handle for receiver initialization.');
     try {
@@ -346,7 +365,9 @@ ipcMain.handle('initialize-receiver', async (event, hCore) => {
         };
 
         // Pass handle and callbacks to the addon function
-        const result = btiAddon.initializeReceiver(BigInt(hCore), onDataUpdate, onErrorUpdate);
+        const result = profile
+            ? btiAddon.initializeReceiver(BigInt(hCore), onDataUpdate, onErrorUpdate, profile)
+            : btiAddon.initializeReceiver(BigInt(hCore), onDataUpdate, onErrorUpdate);
         console.log('Addon initializeReceiver result:', result);
         return result;
     } catch (error) {
@@ -390,4 +411,374 @@ ipcMain.handle('stop-arinc-monitoring', async (event, hCore) => {
         return { success: false, message: error.message };
     }
 });
-// --- End IPC Handlers for ARINC Receiver Initialization, Start/Stop Monitoring, and Data/Error Forwarding ---
\ No newline at end of file
+// --- End IPC Handlers for ARINC Receiver Initialization, Start/Stop Monitoring, and Data/Error Forwarding ---
+
+// Handle Monitor Stats polling (cheap, intended for ~10 Hz)
+ipcMain.handle('get-monitor-stats', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getMonitorStats !== 'function') {
+        throw new Error('Addon not loaded or getMonitorStats missing');
+    }
+    return hCore ? btiAddon.getMonitorStats(BigInt(hCore)) : btiAddon.getMonitorStats();
+});
+
+// Channels the stream callbacks need polled promptly (e.g. the one on screen); null restores all
+ipcMain.handle('set-stream-channels', async (event, channels) => {
+    if (!btiAddon || typeof btiAddon.setStreamChannels !== 'function') {
+        throw new Error('Addon not loaded or setStreamChannels missing');
+    }
+    return btiAddon.setStreamChannels(channels ?? null);
+});
+
+// Pull mode: the renderer polls once per animation frame with the version it last saw.
+// The ArrayBuffer of packed 24-byte records crosses IPC without per-word objects.
+ipcMain.handle('get-changes-since', async (event, version) => {
+    if (!btiAddon || typeof btiAddon.getChangesSince !== 'function') {
+        throw new Error('Addon not loaded or getChangesSince missing');
+    }
+    return btiAddon.getChangesSince(version ?? 0);
+});
+
+// Derived parameters: compiled natively, changed values arrive in the data stream as { derived: true, id, value }
+ipcMain.handle('set-derived-parameters', async (event, parameters) => {
+    if (!btiAddon || typeof btiAddon.setDerivedParameters !== 'function') {
+        throw new Error('Addon not loaded or setDerivedParameters missing');
+    }
+    return btiAddon.setDerivedParameters(parameters || null);
+});
+
+ipcMain.handle('get-derived-values', async () => {
+    if (!btiAddon || typeof btiAddon.getDerivedValues !== 'function') {
+        throw new Error('Addon not loaded or getDerivedValues missing');
+    }
+    return btiAddon.getDerivedValues();
+});
+
+// Typed event log stream (list full/empty, decoder errors, DIO edges...): batches arrive on 'cardEventUpdate'.
+// enabled === false removes the handler.
+ipcMain.handle('set-event-handler', async (event, enabled) => {
+    if (!btiAddon || typeof btiAddon.setEventHandler !== 'function') {
+        throw new Error('Addon not loaded or setEventHandler missing');
+    }
+    if (enabled === false) return btiAddon.setEventHandler(null);
+    return btiAddon.setEventHandler((events) => {
+        if (!event.sender.isDestroyed()) event.sender.send('cardEventUpdate', events);
+    });
+});
+
+ipcMain.handle('get-error-counters', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getErrorCounters !== 'function') {
+        throw new Error('Addon not loaded or getErrorCounters missing');
+    }
+    return hCore ? btiAddon.getErrorCounters(BigInt(hCore)) : btiAddon.getErrorCounters();
+});
+
+// Configure several cores from one receiver profile in parallel (hCores omitted = every session); per-step timings in the result
+ipcMain.handle('prepare-receivers', async (event, profile, hCores) => {
+    if (!btiAddon || typeof btiAddon.prepareReceivers !== 'function') {
+        throw new Error('Addon not loaded or prepareReceivers missing');
+    }
+    const handles = Array.isArray(hCores) ? hCores.map((h) => BigInt(h)) : undefined;
+    return btiAddon.prepareReceivers(profile || null, handles);
+});
+
+// Change channels/filters/list sizes of one core, also while monitoring: only the changed channels pause
+ipcMain.handle('apply-receiver-config', async (event, hCore, changes) => {
+    if (!btiAddon || typeof btiAddon.applyReceiverConfig !== 'function') {
+        throw new Error('Addon not loaded or applyReceiverConfig missing');
+    }
+    return btiAddon.applyReceiverConfig(BigInt(hCore), changes);
+});
+
+// Grow receive lists that overflow or can't hold a poll interval at their peak rate; hCore omitted = every session
+ipcMain.handle('set-adaptive-lists', async (event, enabled, maxWords, hCore) => {
+    if (!btiAddon || typeof btiAddon.setAdaptiveLists !== 'function') {
+        throw new Error('Addon not loaded or setAdaptiveLists missing');
+    }
+    return btiAddon.setAdaptiveLists(hCore ? BigInt(hCore) : null, enabled !== false, maxWords);
+});
+
+// Report-on-change: drop unchanged repeats natively (rules null = off); hCore omitted = every session
+ipcMain.handle('set-change-only', async (event, rules, hCore) => {
+    if (!btiAddon || typeof btiAddon.setChangeOnly !== 'function') {
+        throw new Error('Addon not loaded or setChangeOnly missing');
+    }
+    return btiAddon.setChangeOnly(hCore ? BigInt(hCore) : null, rules || null);
+});
+
+ipcMain.handle('get-change-only-stats', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getChangeOnlyStats !== 'function') {
+        throw new Error('Addon not loaded or getChangeOnlyStats missing');
+    }
+    return btiAddon.getChangeOnlyStats(BigInt(hCore));
+});
+
+// Card-resident snapshot (profile snapshotLabels): refresh interval, hCore omitted = every session
+ipcMain.handle('set-snapshot-interval', async (event, intervalMs, hCore) => {
+    if (!btiAddon || typeof btiAddon.setSnapshotInterval !== 'function') {
+        throw new Error('Addon not loaded or setSnapshotInterval missing');
+    }
+    return btiAddon.setSnapshotInterval(hCore ? BigInt(hCore) : null, intervalMs);
+});
+
+ipcMain.handle('get-snapshot', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getSnapshot !== 'function') {
+        throw new Error('Addon not loaded or getSnapshot missing');
+    }
+    return btiAddon.getSnapshot(BigInt(hCore));
+});
+
+// Alarm rules evaluated by the readers (rules null = none); hCore omitted = every session
+ipcMain.handle('set-alarm-rules', async (event, rules, hCore) => {
+    if (!btiAddon || typeof btiAddon.setAlarmRules !== 'function') {
+        throw new Error('Addon not loaded or setAlarmRules missing');
+    }
+    return btiAddon.setAlarmRules(hCore ? BigInt(hCore) : null, rules || null);
+});
+
+ipcMain.handle('get-active-alarms', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getActiveAlarms !== 'function') {
+        throw new Error('Addon not loaded or getActiveAlarms missing');
+    }
+    return btiAddon.getActiveAlarms(BigInt(hCore));
+});
+
+// Alarm transitions arrive on 'alarmUpdate'; enabled === false removes the handler
+ipcMain.handle('set-alarm-handler', async (event, enabled) => {
+    if (!btiAddon || typeof btiAddon.setAlarmHandler !== 'function') {
+        throw new Error('Addon not loaded or setAlarmHandler missing');
+    }
+    if (enabled === false) return btiAddon.setAlarmHandler(null);
+    return btiAddon.setAlarmHandler((transitions) => {
+        if (!event.sender.isDestroyed()) event.sender.send('alarmUpdate', transitions);
+    });
+});
+
+// Native DIO edge monitor: edges arrive on 'dioEdgeUpdate' as (hCore, edges) instead of polling get-all-dio-states
+ipcMain.handle('start-dio-monitor', async (event, hCore, options) => {
+    if (!btiAddon || typeof btiAddon.startDioMonitor !== 'function') {
+        throw new Error('Addon not loaded or startDioMonitor missing');
+    }
+    const coreHandle = BigInt(hCore);
+    return btiAddon.startDioMonitor(coreHandle, (edges) => {
+        if (!event.sender.isDestroyed()) event.sender.send('dioEdgeUpdate', hCore, edges);
+    }, options);
+});
+
+ipcMain.handle('stop-dio-monitor', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.stopDioMonitor !== 'function') {
+        throw new Error('Addon not loaded or stopDioMonitor missing');
+    }
+    return btiAddon.stopDioMonitor(BigInt(hCore));
+});
+
+ipcMain.handle('get-dio-state', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getDioState !== 'function') {
+        throw new Error('Addon not loaded or getDioState missing');
+    }
+    return btiAddon.getDioState(BigInt(hCore));
+});
+
+ipcMain.handle('get-dio-pulse-stats', async (event, hCore) => {
+    if (!btiAddon || typeof btiAddon.getDioPulseStats !== 'function') {
+        throw new Error('Addon not loaded or getDioPulseStats missing');
+    }
+    return btiAddon.getDioPulseStats(BigInt(hCore));
+});
+
+// Native subscriber bus: each renderer subscription gets its own filter, policy and queue.
+// Batches arrive on 'arincSubscriberUpdate' as (id, dataBatch).
+ipcMain.handle('subscribe', async (event, options) => {
+    if (!btiAddon || typeof btiAddon.subscribe !== 'function') {
+        throw new Error('Addon not loaded or subscribe missing');
+    }
+    let id = 0;
+    const result = btiAddon.subscribe((dataBatch) => {
+        if (!event.sender.isDestroyed()) event.sender.send('arincSubscriberUpdate', id, dataBatch);
+    }, options);
+    id = result.id;
+    return result;
+});
+
+ipcMain.handle('unsubscribe', async (event, id) => {
+    if (!btiAddon || typeof btiAddon.unsubscribe !== 'function') {
+        throw new Error('Addon not loaded or unsubscribe missing');
+    }
+    return btiAddon.unsubscribe(id);
+});
+
+ipcMain.handle('get-subscriptions', async () => {
+    if (!btiAddon || typeof btiAddon.getSubscriptions !== 'function') {
+        throw new Error('Addon not loaded or getSubscriptions missing');
+    }
+    return btiAddon.getSubscriptions();
+});
+
+// Block-compressed capture files: record the ingest stream natively, read it back decoded on worker threads
+ipcMain.handle('start-capture-recording', async (event, path, options) => {
+    if (!btiAddon || typeof btiAddon.startCaptureRecording !== 'function') {
+        throw new Error('Addon not loaded or startCaptureRecording missing');
+    }
+    return btiAddon.startCaptureRecording(path, options);
+});
+
+ipcMain.handle('stop-capture-recording', async () => {
+    if (!btiAddon || typeof btiAddon.stopCaptureRecording !== 'function') {
+        throw new Error('Addon not loaded or stopCaptureRecording missing');
+    }
+    return btiAddon.stopCaptureRecording();
+});
+
+ipcMain.handle('get-capture-recording-stats', async () => {
+    if (!btiAddon || typeof btiAddon.getCaptureRecordingStats !== 'function') {
+        throw new Error('Addon not loaded or getCaptureRecordingStats missing');
+    }
+    return btiAddon.getCaptureRecordingStats();
+});
+
+ipcMain.handle('read-capture-file', async (event, path, options) => {
+    if (!btiAddon || typeof btiAddon.readCaptureFile !== 'function') {
+        throw new Error('Addon not loaded or readCaptureFile missing');
+    }
+    return btiAddon.readCaptureFile(path, options);
+});
+
+// Columnar export runs on addon worker threads; progress arrives on 'captureExportProgress'
+ipcMain.handle('export-capture-columnar', async (event, capturePath, outPath, options) => {
+    if (!btiAddon || typeof btiAddon.exportCaptureColumnar !== 'function') {
+        throw new Error('Addon not loaded or exportCaptureColumnar missing');
+    }
+    return btiAddon.exportCaptureColumnar(capturePath, outPath, options, (progress) => {
+        if (!event.sender.isDestroyed()) event.sender.send('captureExportProgress', outPath, progress);
+    });
+});
+
+// One label of a capture file reduced for plotting (min/max buckets or LTTB), returned as Float64Arrays
+ipcMain.handle('downsample-capture-file', async (event, path, options) => {
+    if (!btiAddon || typeof btiAddon.downsampleCaptureFile !== 'function') {
+        throw new Error('Addon not loaded or downsampleCaptureFile missing');
+    }
+    return btiAddon.downsampleCaptureFile(path, options);
+});
+
+// Native per-label history rings (options null = stop); queries return Float64Array/Uint32Array
+ipcMain.handle('set-history', async (event, options) => {
+    if (!btiAddon || typeof btiAddon.setHistory !== 'function') {
+        throw new Error('Addon not loaded or setHistory missing');
+    }
+    return btiAddon.setHistory(options || null);
+});
+
+ipcMain.handle('get-history', async (event, options) => {
+    if (!btiAddon || typeof btiAddon.getHistory !== 'function') {
+        throw new Error('Addon not loaded or getHistory missing');
+    }
+    return btiAddon.getHistory(options);
+});
+
+ipcMain.handle('get-history-stats', async () => {
+    if (!btiAddon || typeof btiAddon.getHistoryStats !== 'function') {
+        throw new Error('Addon not loaded or getHistoryStats missing');
+    }
+    return btiAddon.getHistoryStats();
+});
+
+ipcMain.handle('downsample-history', async (event, options) => {
+    if (!btiAddon || typeof btiAddon.downsampleHistory !== 'function') {
+        throw new Error('Addon not loaded or downsampleHistory missing');
+    }
+    return btiAddon.downsampleHistory(options);
+});
+
+// Shared-memory current-value table for other local tools (read with cpp-addon/src/capture_shm_reader.h)
+ipcMain.handle('start-value-publisher', async (event, name) => {
+    if (!btiAddon || typeof btiAddon.startValuePublisher !== 'function') {
+        throw new Error('Addon not loaded or startValuePublisher missing');
+    }
+    return btiAddon.startValuePublisher(name);
+});
+
+ipcMain.handle('stop-value-publisher', async () => {
+    if (!btiAddon || typeof btiAddon.stopValuePublisher !== 'function') {
+        throw new Error('Addon not loaded or stopValuePublisher missing');
+    }
+    return btiAddon.stopValuePublisher();
+});
+
+// --- Out-of-process capture daemon ---
+// The daemon owns the card I/O and survives UI stalls/crashes; the addon only maps its shared memory.
+let captureDaemonProcess = null;
+const CAPTURE_DAEMON_PATH = path.join(__dirname, 'cpp-addon', 'build', 'Release', 'bti_capture_daemon.exe');
+
+ipcMain.handle('start-capture-daemon', async (event, options = {}) => {
+    if (!btiAddon || typeof btiAddon.attachCaptureDaemon !== 'function') {
+        throw new Error('Addon not loaded or attachCaptureDaemon missing');
+    }
+    const name = options.name || undefined;
+    const onDataUpdate = (dataBatch) => {
+        if (!event.sender.isDestroyed()) event.sender.send('arincDataUpdate', dataBatch);
+    };
+    const onErrorUpdate = (errorInfo) => {
+        console.error('Capture daemon error:', errorInfo);
+        if (!event.sender.isDestroyed()) event.sender.send('arincErrorUpdate', errorInfo);
+    };
+
+    // Attach to an already running daemon first; otherwise launch one and wait for its shared memory
+    let result = btiAddon.attachCaptureDaemon(onDataUpdate, onErrorUpdate, name);
+    if (!result.success && !captureDaemonProcess) {
+        const args = [];
+        if (name) args.push('--name', name);
+        for (const core of options.cores || []) args.push('--core', `${core.card ?? 0}:${core.core ?? 0}`);
+        if (options.priority) args.push('--priority', options.priority);
+        const { spawn } = require('child_process');
+        captureDaemonProcess = spawn(CAPTURE_DAEMON_PATH, args, { detached: true, stdio: 'ignore', windowsHide: true });
+        captureDaemonProcess.on('exit', (code) => {
+            console.log(`Capture daemon exited with code ${code}`);
+            captureDaemonProcess = null;
+        });
+        captureDaemonProcess.unref(); // The daemon keeps capturing if the app exits
+        for (let attempt = 0; attempt < 30 && !result.success; ++attempt) {
+            await new Promise((resolve) => setTimeout(resolve, 100));
+            result = btiAddon.attachCaptureDaemon(onDataUpdate, onErrorUpdate, name);
+        }
+    }
+    return result;
+});
+
+ipcMain.handle('stop-capture-daemon', async () => {
+    if (!btiAddon || typeof btiAddon.stopCaptureDaemon !== 'function') {
+        throw new Error('Addon not loaded or stopCaptureDaemon missing');
+    }
+    const result = btiAddon.stopCaptureDaemon();
+    btiAddon.detachCaptureDaemon();
+    return result;
+});
+
+ipcMain.handle('get-capture-daemon-status', async () => {
+    if (!btiAddon || typeof btiAddon.getCaptureDaemonStatus !== 'function') {
+        throw new Error('Addon not loaded or getCaptureDaemonStatus missing');
+    }
+    return btiAddon.getCaptureDaemonStatus();
+});
+
+// Handle listing of open device sessions (one per initialized card/core)
+ipcMain.handle('list-sessions', async () => {
+    if (!btiAddon || typeof btiAddon.listSessions !== 'function') {
+        throw new Error('Addon not loaded or listSessions missing');
+    }
+    return btiAddon.listSessions();
+});
+
+// Handle native trace capture (Chrome trace-event JSON, open in chrome://tracing or Perfetto)
+ipcMain.handle('start-tracing', async (event, eventsPerThread) => {
+    if (!btiAddon || typeof btiAddon.startTracing !== 'function') {
+        throw new Error('Addon not loaded or startTracing missing');
+    }
+    return btiAddon.startTracing(eventsPerThread);
+});
+
+ipcMain.handle('stop-tracing', async (event, filePath) => {
+    if (!btiAddon || typeof btiAddon.stopTracing !== 'function') {
+        throw new Error('Addon not loaded or stopTracing missing');
+    }
+    return btiAddon.stopTracing(filePath);
+});
@@ -18,13 +18,84 @@ contextBridge.exposeInMainWorld('electronAPI', {
   // --- Expose the NEW getAllDioStates function ---
   getAllDioStates: (hCore) => ipcRenderer.invoke('get-all-dio-states', hCore),
   // Expose hardware initialization
-  initializeHardware: () => ipcRenderer.invoke('initialize-hardware'),
+  initializeHardware: (cardNum, coreNum) => ipcRenderer.invoke('initialize-hardware', cardNum, coreNum),
   // Expose ARINC receiver initialization
-  initializeReceiver: (hCore) => ipcRenderer.invoke('initialize-receiver', hCore),
+  // Optional profile: { eventLogSize, allChannels, channels: [{ channel, speed, listWords, logErrors, selfTest, records, skipLabels }] }
+  initializeReceiver: (hCore, profile) => ipcRenderer.invoke('initialize-receiver', hCore, profile),
+  prepareReceivers: (profile, hCores) => ipcRenderer.invoke('prepare-receivers', profile, hCores),
+  // Hot change: { channels: [{ channel, speed, listWords, skipLabels, ..., enabled }] }; untouched fields keep their value
+  applyReceiverConfig: (hCore, changes) => ipcRenderer.invoke('apply-receiver-config', hCore, changes),
   // Expose ARINC monitoring start
   startArincMonitoring: (hCore) => ipcRenderer.invoke('start-arinc-monitoring', hCore),
   // Expose ARINC monitoring stop
   stopArincMonitoring: (hCore) => ipcRenderer.invoke('stop-arinc-monitoring', hCore),
+  // Expose pipeline instrumentation counters (poll at ~10 Hz)
+  getMonitorStats: (hCore) => ipcRenderer.invoke('get-monitor-stats', hCore),
+  // Lazy polling: channels the data callback needs promptly; others are only polled in the background
+  setStreamChannels: (channels) => ipcRenderer.invoke('set-stream-channels', channels),
+  // Open device sessions (card/core, handles, discovered channels)
+  listSessions: () => ipcRenderer.invoke('list-sessions'),
+  // Pull mode: getChangesSince(version) -> { version, count, recordSize, buffer } (records changed after version)
+  getChangesSince: (version) => ipcRenderer.invoke('get-changes-since', version),
+  // Derived parameters: setDerivedParameters([{ name, expr, inputs: [{ name, channel, label, format, msb, lsb, resolution }] }] | null)
+  // -> { names } (id order); values arrive as { derived: true, id, value } data updates
+  setDerivedParameters: (parameters) => ipcRenderer.invoke('set-derived-parameters', parameters),
+  getDerivedValues: () => ipcRenderer.invoke('get-derived-values'),
+  // Typed event log stream on/off; batches arrive through onCardEventUpdate
+  setEventHandler: (enabled) => ipcRenderer.invoke('set-event-handler', enabled),
+  // Per channel/code error totals; arincErrorUpdate only carries raised/summary/cleared notices for them
+  getErrorCounters: (hCore) => ipcRenderer.invoke('get-error-counters', hCore),
+  // Re-create receive lists larger when they overflow (gap markers: { channel, gap: true, lostWords } in data updates)
+  setAdaptiveLists: (enabled, maxWords, hCore) => ipcRenderer.invoke('set-adaptive-lists', enabled, maxWords, hCore),
+  // Report-on-change: setChangeOnly([{ channel, labels, ignoreMask, heartbeatMs }] | null, hCore); repeats counted per label
+  setChangeOnly: (rules, hCore) => ipcRenderer.invoke('set-change-only', rules, hCore),
+  getChangeOnlyStats: (hCore) => ipcRenderer.invoke('get-change-only-stats', hCore),
+  // Card-resident snapshot of the profile's snapshotLabels: getSnapshot(hCore) -> { count, recordSize, buffer } (32-byte records)
+  setSnapshotInterval: (intervalMs, hCore) => ipcRenderer.invoke('set-snapshot-interval', intervalMs, hCore),
+  getSnapshot: (hCore) => ipcRenderer.invoke('get-snapshot', hCore),
+  // Alarms: setAlarmRules([{ kind: 'range'|'ssm'|'rate'|'stale'|'parity', channel, label, sdi, format, msb, lsb, resolution,
+  // low, high, hysteresis, maxRate, ssm: [state], staleMs }] | null, hCore); transitions arrive through onAlarmUpdate
+  setAlarmRules: (rules, hCore) => ipcRenderer.invoke('set-alarm-rules', rules, hCore),
+  getActiveAlarms: (hCore) => ipcRenderer.invoke('get-active-alarms', hCore),
+  setAlarmHandler: (enabled) => ipcRenderer.invoke('set-alarm-handler', enabled),
+  // Native DIO edge monitor: startDioMonitor(hCore, { dionums, mode: 'auto'|'card'|'sampler', sampleIntervalUs, glitchUs, recordEdges })
+  startDioMonitor: (hCore, options) => ipcRenderer.invoke('start-dio-monitor', hCore, options),
+  stopDioMonitor: (hCore) => ipcRenderer.invoke('stop-dio-monitor', hCore),
+  getDioState: (hCore) => ipcRenderer.invoke('get-dio-state', hCore),
+  // Pulse width/period/duty/glitch stats: { count, recordSize, buffer } (224-byte records, see addon.cpp)
+  getDioPulseStats: (hCore) => ipcRenderer.invoke('get-dio-pulse-stats', hCore),
+  // Subscriber bus: subscribe({ name, card, core, channels, labels, policy: 'every'|'coalesced'|'snapshot', batchSize, intervalMs, maxQueue })
+  subscribe: (options) => ipcRenderer.invoke('subscribe', options),
+  unsubscribe: (id) => ipcRenderer.invoke('unsubscribe', id),
+  getSubscriptions: () => ipcRenderer.invoke('get-subscriptions'),
+  // Capture files: startCaptureRecording(path, { card, core, channels, labels, blockWords }), stats include compressionRatio
+  startCaptureRecording: (path, options) => ipcRenderer.invoke('start-capture-recording', path, options),
+  stopCaptureRecording: () => ipcRenderer.invoke('stop-capture-recording'),
+  getCaptureRecordingStats: () => ipcRenderer.invoke('get-capture-recording-stats'),
+  // readCaptureFile(path, { threads, firstBlock, blockCount }) -> { count, recordSize, buffer } (24-byte records, see addon.cpp)
+  readCaptureFile: (path, options) => ipcRenderer.invoke('read-capture-file', path, options),
+  // exportCaptureColumnar(capturePath, outPath, { threads, decode: [{ channel, label, format: 'bnr'|'bcd'|'discrete', msb, lsb, resolution }] })
+  exportCaptureColumnar: (capturePath, outPath, options) => ipcRenderer.invoke('export-capture-columnar', capturePath, outPath, options),
+  // downsampleCaptureFile(path, { channel, label, format, msb, lsb, resolution, startMs, endMs, width, mode: 'minmax'|'lttb' })
+  // -> { count, time, min, max } (minmax) or { count, time, value } (lttb), Float64Arrays
+  downsampleCaptureFile: (path, options) => ipcRenderer.invoke('downsample-capture-file', path, options),
+  // Label history: setHistory({ maxAgeSeconds, maxSamples, memoryLimitMB } | null);
+  // getHistory({ channel, label, card, core, seconds | startMs, endMs }) -> { count, time: Float64Array, word: Uint32Array }
+  setHistory: (options) => ipcRenderer.invoke('set-history', options),
+  getHistory: (options) => ipcRenderer.invoke('get-history', options),
+  getHistoryStats: () => ipcRenderer.invoke('get-history-stats'),
+  // Same options and result as downsampleCaptureFile, from the history; seconds = the last N seconds
+  downsampleHistory: (options) => ipcRenderer.invoke('downsample-history', options),
+  // Shared-memory current-value table for other local processes; name defaults to Local\\BtiArincValues
+  startValuePublisher: (name) => ipcRenderer.invoke('start-value-publisher', name),
+  stopValuePublisher: () => ipcRenderer.invoke('stop-value-publisher'),
+  // Out-of-process capture: startCaptureDaemon({ name, cores: [{ card, core }], priority }) attaches (launching if needed)
+  startCaptureDaemon: (options) => ipcRenderer.invoke('start-capture-daemon', options),
+  stopCaptureDaemon: () => ipcRenderer.invoke('stop-capture-daemon'),
+  getCaptureDaemonStatus: () => ipcRenderer.invoke('get-capture-daemon-status'),
+  // Native trace capture; stopTracing(filePath) writes the trace, stopTracing() returns it as JSON
+  startTracing: (eventsPerThread) => ipcRenderer.invoke('start-tracing', eventsPerThread),
+  stopTracing: (filePath) => ipcRenderer.invoke('stop-tracing', filePath),
 
   // Listener for ARINC Data Updates from Main
   onArincDataUpdate: (callback) => {
@@ -39,6 +110,56 @@ contextBridge.exposeInMainWorld('electronAPI', {
     };
   },
 
+  // Listener for subscriber bus batches: callback(id, dataBatch)
+  onArincSubscriberUpdate: (callback) => {
+    const channel = 'arincSubscriberUpdate';
+    ipcRenderer.removeAllListeners(channel);
+    ipcRenderer.on(channel, (event, ...args) => callback(...args));
+    return () => {
+      ipcRenderer.removeListener(channel, callback);
+    };
+  },
+
+  // Listener for event log batches: callback(events) with { type, typeValue, channel, info, hwTime, timestamp, card, core }
+  onCardEventUpdate: (callback) => {
+    const channel = 'cardEventUpdate';
+    ipcRenderer.removeAllListeners(channel);
+    ipcRenderer.on(channel, (event, ...args) => callback(...args));
+    return () => {
+      ipcRenderer.removeListener(channel, callback);
+    };
+  },
+
+  // Listener for alarm transitions: callback(transitions) with { rule, kind, active, channel, label, word, value, hwTime, timestamp, card, core }
+  onAlarmUpdate: (callback) => {
+    const channel = 'alarmUpdate';
+    ipcRenderer.removeAllListeners(channel);
+    ipcRenderer.on(channel, (event, ...args) => callback(...args));
+    return () => {
+      ipcRenderer.removeListener(channel, callback);
+    };
+  },
+
+  // Listener for export progress: callback(outPath, { rowsDone, rowsTotal, bytesWritten })
+  onCaptureExportProgress: (callback) => {
+    const channel = 'captureExportProgress';
+    ipcRenderer.removeAllListeners(channel);
+    ipcRenderer.on(channel, (event, ...args) => callback(...args));
+    return () => {
+      ipcRenderer.removeListener(channel, callback);
+    };
+  },
+
+  // Listener for DIO edge batches from startDioMonitor: callback(hCore, edges)
+  onDioEdgeUpdate: (callback) => {
+    const channel = 'dioEdgeUpdate';
+    ipcRenderer.removeAllListeners(channel);
+    ipcRenderer.on(channel, (event, ...args) => callback(...args));
+    return () => {
+      ipcRenderer.removeListener(channel, callback);
+    };
+  },
+
   // Listener for ARINC Error/Status Updates from Main
   onArincErrorUpdate: (callback) => {
     const channel = 'arincErrorUpdate';
@@ -154,6 +154,13 @@ function handleArincDataUpdate(updates) {
     // console.log(`Handling ${updates.length} ARINC updates`);
     const now = Date.now(); // Use a consistent timestamp for the batch if not provided
     updates.forEach(update => {
+        if (update.gap) {
+            console.warn(`ARINC channel ${update.channel}: ${update.lostWords} word(s) lost (receive list overflow)`);
+            return;
+        }
+        if (update.derived || update.dioEdge) {
+            return; // Derived parameters and recorded DIO edges have no channel/label row in this table
+        }
         if (update.channel === undefined || update.label === undefined || update.word === undefined) {
             console.error('Invalid ARINC update received:', update);
             return;